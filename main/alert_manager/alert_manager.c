@@ -24,6 +24,8 @@
 
 static const char *TAG = "alert_manager";
 
+#define ALERT_MANAGER_HISTORY_BATCH 4U  /**< History entries copied per mutex hold when streaming */
+
 // =============================================================================
 // Private structures and state
 // =============================================================================
@@ -38,6 +40,7 @@ typedef struct {
     alert_entry_t  history[ALERT_MANAGER_MAX_HISTORY]; /**< Alert history circular buffer */
     size_t         history_head;          /**< History buffer write index */
     size_t         history_count;         /**< Number of entries in history */
+    uint32_t       history_written;       /**< Entries ever added, kept across clears */
     uint32_t       next_alert_id;         /**< Monotonic alert ID counter */
     alert_statistics_t stats;             /**< Runtime statistics */
     uint64_t       last_trigger_time_ms[256]; /**< Debounce timestamps per alert type */
@@ -301,6 +304,7 @@ static void alert_manager_add_to_history(const alert_entry_t *alert)
     if (s_state.history_count < ALERT_MANAGER_MAX_HISTORY) {
         s_state.history_count++;
     }
+    s_state.history_written++;
 }
 
 /**
@@ -1025,68 +1029,89 @@ esp_err_t alert_manager_get_active_alerts_json(char *buffer, size_t buffer_size,
 }
 
 /**
- * @brief Get alert history as JSON
+ * @brief Stream alert history as JSON (most recent first)
  */
-esp_err_t alert_manager_get_history_json(char *buffer, size_t buffer_size, size_t *out_length, size_t limit)
+esp_err_t alert_manager_write_history_json(json_writer_t *writer, size_t limit)
 {
-    if (buffer == NULL || out_length == NULL) {
+    if (writer == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    size_t max_alerts = (limit == 0) ? ALERT_MANAGER_MAX_HISTORY : limit;
-    if (max_alerts > ALERT_MANAGER_MAX_HISTORY) {
-        max_alerts = ALERT_MANAGER_MAX_HISTORY;
-    }
-
-    alert_entry_t *alerts = malloc(max_alerts * sizeof(alert_entry_t));
-    if (alerts == NULL) {
-        return ESP_ERR_NO_MEM;
+    if (xSemaphoreTake(s_state.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
     }
+    size_t count = s_state.history_count;
+    uint32_t written_at_start = s_state.history_written;
+    xSemaphoreGive(s_state.mutex);
 
-    size_t count = 0;
-    esp_err_t err = alert_manager_get_history(alerts, max_alerts, &count);
-    if (err != ESP_OK) {
-        free(alerts);
-        return err;
+    if (limit != 0 && limit < count) {
+        count = limit;
     }
 
-    cJSON *root = cJSON_CreateArray();
-    if (root == NULL) {
-        free(alerts);
-        return ESP_ERR_NO_MEM;
-    }
+    json_writer_printf(writer, "[");
 
-    for (size_t i = 0; i < count; i++) {
-        cJSON *alert_obj = cJSON_CreateObject();
-        cJSON_AddNumberToObject(alert_obj, "id", alerts[i].alert_id);
-        cJSON_AddNumberToObject(alert_obj, "timestamp_ms", (double)alerts[i].timestamp_ms);
-        cJSON_AddNumberToObject(alert_obj, "type", alerts[i].type);
-        cJSON_AddNumberToObject(alert_obj, "severity", alerts[i].severity);
-        cJSON_AddNumberToObject(alert_obj, "status", alerts[i].status);
-        cJSON_AddNumberToObject(alert_obj, "trigger_value", alerts[i].trigger_value);
-        cJSON_AddNumberToObject(alert_obj, "threshold_value", alerts[i].threshold_value);
-        cJSON_AddStringToObject(alert_obj, "message", alerts[i].message);
-        cJSON_AddItemToArray(root, alert_obj);
+    // Copy a few entries per mutex hold instead of the whole history, and
+    // format them unlocked. Entries are addressed by push sequence; once the
+    // next one has been overwritten or cleared, older ones are gone too.
+    alert_entry_t batch[ALERT_MANAGER_HISTORY_BATCH];
+    size_t emitted = 0;
+    bool history_lost = false;
+    while (emitted < count && !history_lost && json_writer_ok(writer)) {
+        if (xSemaphoreTake(s_state.mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+        size_t copied = 0;
+        while (copied < ALERT_MANAGER_HISTORY_BATCH && emitted + copied < count) {
+            uint32_t age = (s_state.history_written - written_at_start) + (uint32_t)(emitted + copied) + 1U;
+            if (age > s_state.history_count) {
+                history_lost = true;
+                break;
+            }
+            size_t history_index = (s_state.history_head + ALERT_MANAGER_MAX_HISTORY - age) % ALERT_MANAGER_MAX_HISTORY;
+            memcpy(&batch[copied++], &s_state.history[history_index], sizeof(alert_entry_t));
+        }
+        xSemaphoreGive(s_state.mutex);
+
+        for (size_t i = 0; i < copied; i++) {
+            const alert_entry_t *alert = &batch[i];
+            json_writer_printf(writer,
+                               "%s{\"id\":%lu,\"timestamp_ms\":%llu,\"type\":%d,\"severity\":%d,"
+                               "\"status\":%d,\"trigger_value\":%.3f,\"threshold_value\":%.3f,\"message\":",
+                               (emitted + i == 0) ? "" : ",",
+                               (unsigned long)alert->alert_id,
+                               (unsigned long long)alert->timestamp_ms,
+                               (int)alert->type,
+                               (int)alert->severity,
+                               (int)alert->status,
+                               (double)alert->trigger_value,
+                               (double)alert->threshold_value);
+            json_writer_string(writer, alert->message);
+            json_writer_printf(writer, "}");
+        }
+        emitted += copied;
     }
 
-    free(alerts);
-
-    char *json_str = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+    json_writer_printf(writer, "]");
+    return writer->error;
+}
 
-    if (json_str == NULL) {
-        return ESP_ERR_NO_MEM;
+/**
+ * @brief Get alert history as JSON
+ */
+esp_err_t alert_manager_get_history_json(char *buffer, size_t buffer_size, size_t *out_length, size_t limit)
+{
+    if (buffer == NULL || buffer_size == 0 || out_length == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    // Utiliser snprintf pour sécurité (évite buffer overflow)
-    int written = snprintf(buffer, buffer_size, "%s", json_str);
-    free(json_str);
-
-    if (written < 0 || (size_t)written >= buffer_size) {
-        ESP_LOGW(TAG, "JSON history truncated: needed %d bytes, had %zu", written, buffer_size);
-        return ESP_ERR_INVALID_SIZE;
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, buffer_size, NULL, NULL);
+    esp_err_t err = alert_manager_write_history_json(&writer, limit);
+    if (err == ESP_OK) {
+        err = json_writer_finish(&writer, out_length);
     }
-
-    *out_length = (size_t)written;
-    return ESP_OK;
+    if (err == ESP_ERR_INVALID_SIZE) {
+        ESP_LOGW(TAG, "JSON history truncated: buffer of %zu bytes too small", buffer_size);
+    }
+    return err;
 }
@@ -44,6 +44,7 @@
 
 #include "esp_err.h"
 #include "event_bus.h"
+#include "json_writer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -343,6 +344,18 @@ esp_err_t alert_manager_get_active_alerts_json(char *buffer, size_t buffer_size,
  */
 esp_err_t alert_manager_get_history_json(char *buffer, size_t buffer_size, size_t *out_length, size_t limit);
 
+/**
+ * @brief Stream alert history as JSON, most recent first
+ *
+ * Same document as alert_manager_get_history_json(). Entries are copied a
+ * few at a time, so the mutex is never held while @p writer flushes.
+ *
+ * @param writer Destination
+ * @param limit Max alerts to return (0 = all)
+ * @return ESP_OK on success, or the writer's error
+ */
+esp_err_t alert_manager_write_history_json(json_writer_t *writer, size_t limit);
+
 #ifdef __cplusplus
 }
 #endif
@@ -109,7 +109,9 @@ static esp_err_t init_bms_services(event_bus_publish_fn_t publish_hook,
     can_victron_init();
     ESP_LOGI(TAG, "  - CAN Victron initialized");
 
-    // Initialize CAN publisher
+    // Initialize CAN publisher (hooks first: init starts the publisher task)
+    can_publisher_set_bus_load_provider(can_victron_get_bus_occupancy);
+    can_publisher_set_batch_publisher(can_victron_publish_frames);
     can_publisher_init(publish_hook, frame_publisher);
     ESP_LOGI(TAG, "  - CAN publisher initialized");
 
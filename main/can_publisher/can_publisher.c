@@ -1,6 +1,7 @@
 #include "can_publisher.h"
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_err.h"
@@ -18,6 +19,7 @@
 #include "sdkconfig.h"
 
 #include "app_events.h"
+#include "can_victron.h"
 #include "config_manager.h"
 #include "conversion_table.h"
 #include "cvl_controller.h"
@@ -25,6 +27,9 @@
 
 #define CAN_PUBLISHER_EVENT_TIMEOUT_MS 50U
 #define CAN_PUBLISHER_LOCK_TIMEOUT_MS  50U
+#define CAN_PUBLISHER_SLOT_READ_RETRIES 4U
+#define CAN_PUBLISHER_SHAPING_WINDOW_MS 1000U
+#define CAN_PUBLISHER_TX_RETRY_MS 20U
 
 // CAN configuration defaults are now centralized in can_config_defaults.h
 
@@ -36,6 +41,7 @@ static const char *TAG = "can_pub";
 
 static event_bus_publish_fn_t s_event_publisher = NULL;
 static can_publisher_frame_publish_fn_t s_frame_publisher = NULL;
+static can_publisher_frame_batch_publish_fn_t s_batch_publisher = NULL;
 static can_publisher_buffer_t s_frame_buffer = {
     .slots = {0},
     .slot_valid = {0},
@@ -46,8 +52,8 @@ static can_publisher_registry_t s_registry = {
     .channel_count = 0,
     .buffer = &s_frame_buffer,
 };
-static SemaphoreHandle_t s_buffer_mutex = NULL;
 static SemaphoreHandle_t s_event_mutex = NULL;  // Replaced portMUX_TYPE for consistent synchronization
+static SemaphoreHandle_t s_stats_mutex = NULL;
 static TaskHandle_t s_publish_task_handle = NULL;
 static bool s_listener_registered = false;
 
@@ -56,15 +62,87 @@ static volatile bool s_task_should_exit = false;
 static uint32_t s_publish_interval_ms = CONFIG_TINYBMS_CAN_PUBLISHER_PERIOD_MS;
 static can_publisher_frame_t s_event_frames[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
 static size_t s_event_frame_index = 0;
+static uint32_t s_torn_reads = 0;
+static uint32_t s_skipped_reads = 0;
 static TickType_t s_channel_period_ticks[CAN_PUBLISHER_MAX_BUFFER_SLOTS] = {0};
+static can_publisher_priority_t s_channel_priority[CAN_PUBLISHER_MAX_BUFFER_SLOTS] = {0};
 static TickType_t s_channel_deadlines[CAN_PUBLISHER_MAX_BUFFER_SLOTS] = {0};
 
+// Min-heap of channel indexes ordered by s_channel_deadlines. Owned by the
+// publisher task once started (built by init before the task exists).
+static uint8_t s_schedule_heap[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+static size_t s_schedule_heap_size = 0;
+
+// Frames collected during one scheduler pass when a batch publisher is
+// installed. Owned by the publisher task; accounting waits for the driver to
+// report how many frames actually left.
+typedef struct {
+    can_victron_tx_frame_t frames[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    can_publisher_frame_t events[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    uint8_t channel[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    uint32_t arrival_us[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    uint32_t claimed;               // One bit per batch entry carrying a pending change
+    size_t count;
+} can_publisher_batch_t;
+
+static can_publisher_batch_t s_batch;
+
+// Transmit cost of one scheduler pass, folded into s_dispatch_stats once the
+// pass ends. s_dispatch_stats is written by the publisher task and read by
+// status queries under s_stats_mutex.
+typedef struct {
+    uint32_t calls;
+    uint32_t frames;
+    uint64_t elapsed_us;
+} can_publisher_pass_cost_t;
+
+static can_publisher_dispatch_stats_t s_dispatch_stats;
+
+// Per-channel jitter accounting, written by the publisher task.
+typedef struct {
+    uint64_t last_dispatch_us;
+    uint64_t last_tx_us;            // Any transmission, including out-of-band ones
+    uint64_t jitter_sum_us;
+    uint32_t jitter_samples;
+    uint64_t change_latency_sum_us;
+    can_publisher_channel_stats_t stats;
+} can_publisher_channel_schedule_t;
+
+static can_publisher_channel_schedule_t s_channel_schedule[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+
+// Critical channels whose encoded bytes changed and have not reached the
+// driver yet, one bit per channel. The listener stores the arrival time and
+// then sets the bit; whichever path transmits the channel first (out of band
+// or on its deadline) claims the bit before loading the slot, so a sample
+// stored while the frame is in flight marks the channel again.
+_Static_assert(CAN_PUBLISHER_MAX_BUFFER_SLOTS <= 32U, "change mask holds one bit per channel");
+static uint32_t s_change_pending = 0;
+static uint32_t s_change_arrival_us[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+
+// Bus-load aware shaping. The flag and occupancy are written by the publisher
+// task and read by status queries under s_stats_mutex.
+_Static_assert(CONFIG_TINYBMS_CAN_SHAPING_RELEASE_PCT < CONFIG_TINYBMS_CAN_SHAPING_THRESHOLD_PCT,
+               "TX shaping needs a release level below its threshold");
+static can_publisher_bus_load_fn_t s_bus_load_provider = NULL;
+static bool s_shaping_active = false;
+static float s_bus_occupancy_pct = 0.0f;
+static TickType_t s_next_shaping_sample = 0;
+
+// Dirty tracking for channels encoded from slow-changing inputs. Only touched
+// from the TinyBMS listener (and init/deinit), so no lock is required.
+static can_publisher_identity_inputs_t s_identity_inputs;
+static bool s_identity_inputs_valid = false;
+static uint32_t s_config_generation_seen = 0;
+
 static const config_manager_can_settings_t *can_publisher_get_settings(void);
 static bool can_publisher_periodic_mode_enabled(void);
-static TickType_t can_publisher_publish_buffer(can_publisher_registry_t *registry, TickType_t now);
+static TickType_t can_publisher_publish_due(can_publisher_registry_t *registry, TickType_t now);
 static bool can_publisher_store_frame(can_publisher_buffer_t *buffer,
                                       size_t index,
                                       const can_publisher_frame_t *frame);
+static esp_err_t can_publisher_load_frame(can_publisher_buffer_t *buffer,
+                                          size_t index,
+                                          can_publisher_frame_t *out_frame);
 static void can_publisher_task(void *context);
 
 static TickType_t can_publisher_ms_to_ticks(uint32_t period_ms)
@@ -76,22 +154,286 @@ static TickType_t can_publisher_ms_to_ticks(uint32_t period_ms)
     return ticks;
 }
 
-static uint64_t can_publisher_timestamp_ms(void)
+static uint64_t can_publisher_timestamp_us(void)
 {
 #ifdef ESP_PLATFORM
-    return (uint64_t)(esp_timer_get_time() / 1000ULL);
+    return (uint64_t)esp_timer_get_time();
 #else
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    return (uint64_t)tv.tv_sec * 1000ULL + (uint64_t)(tv.tv_usec / 1000ULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
 #endif
 }
 
+static uint64_t can_publisher_timestamp_ms(void)
+{
+    return can_publisher_timestamp_us() / 1000ULL;
+}
+
+static bool can_publisher_deadline_before(size_t a, size_t b)
+{
+    // Signed difference keeps the ordering correct across tick counter wrap.
+    int32_t diff = (int32_t)(s_channel_deadlines[a] - s_channel_deadlines[b]);
+    if (diff != 0) {
+        return diff < 0;
+    }
+    // Same tick: critical frames go out first.
+    return (s_channel_priority[a] == CAN_PUBLISHER_PRIORITY_CRITICAL) &&
+           (s_channel_priority[b] != CAN_PUBLISHER_PRIORITY_CRITICAL);
+}
+
+static void can_publisher_heap_swap(size_t a, size_t b)
+{
+    uint8_t tmp = s_schedule_heap[a];
+    s_schedule_heap[a] = s_schedule_heap[b];
+    s_schedule_heap[b] = tmp;
+}
+
+static void can_publisher_heap_sift_up(size_t pos)
+{
+    while (pos > 0) {
+        size_t parent = (pos - 1U) / 2U;
+        if (!can_publisher_deadline_before(s_schedule_heap[pos], s_schedule_heap[parent])) {
+            break;
+        }
+        can_publisher_heap_swap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void can_publisher_heap_sift_down(size_t pos)
+{
+    for (;;) {
+        size_t left = (2U * pos) + 1U;
+        size_t right = left + 1U;
+        size_t smallest = pos;
+
+        if (left < s_schedule_heap_size &&
+            can_publisher_deadline_before(s_schedule_heap[left], s_schedule_heap[smallest])) {
+            smallest = left;
+        }
+        if (right < s_schedule_heap_size &&
+            can_publisher_deadline_before(s_schedule_heap[right], s_schedule_heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            return;
+        }
+        can_publisher_heap_swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+// Moves a channel to a new deadline and restores the heap ordering.
+static void can_publisher_heap_reschedule(size_t index, TickType_t deadline)
+{
+    for (size_t pos = 0; pos < s_schedule_heap_size; ++pos) {
+        if (s_schedule_heap[pos] == index) {
+            s_channel_deadlines[index] = deadline;
+            can_publisher_heap_sift_up(pos);
+            can_publisher_heap_sift_down(pos);
+            return;
+        }
+    }
+}
+
+// Records a transmission of the channel. next_period_ms is the period applied
+// to the upcoming interval; jitter is measured against the previous one.
+static void can_publisher_record_dispatch(size_t index, uint32_t next_period_ms)
+{
+    can_publisher_channel_schedule_t *schedule = &s_channel_schedule[index];
+    uint64_t now_us = can_publisher_timestamp_us();
+
+    if (s_stats_mutex != NULL &&
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+
+    can_publisher_channel_stats_t *stats = &schedule->stats;
+    if (schedule->last_dispatch_us != 0U) {
+        uint64_t interval_us = now_us - schedule->last_dispatch_us;
+        uint64_t period_us = (uint64_t)stats->effective_period_ms * 1000ULL;
+        uint64_t jitter_us = (interval_us > period_us) ? (interval_us - period_us) : (period_us - interval_us);
+        if (jitter_us > UINT32_MAX) {
+            jitter_us = UINT32_MAX;
+        }
+
+        stats->last_jitter_us = (uint32_t)jitter_us;
+        if (stats->last_jitter_us > stats->max_jitter_us) {
+            stats->max_jitter_us = stats->last_jitter_us;
+        }
+        schedule->jitter_sum_us += jitter_us;
+        ++schedule->jitter_samples;
+        stats->avg_jitter_us = (uint32_t)(schedule->jitter_sum_us / schedule->jitter_samples);
+
+        if (interval_us > UINT32_MAX) {
+            interval_us = UINT32_MAX;
+        }
+        if (stats->avg_interval_us == 0U) {
+            stats->avg_interval_us = (uint32_t)interval_us;
+        } else {
+            // EWMA with alpha = 1/8
+            int64_t delta = (int64_t)interval_us - (int64_t)stats->avg_interval_us;
+            stats->avg_interval_us = (uint32_t)((int64_t)stats->avg_interval_us + (delta / 8));
+        }
+    }
+    schedule->last_dispatch_us = now_us;
+    stats->effective_period_ms = next_period_ms;
+    ++stats->frames_sent;
+
+    if (s_stats_mutex != NULL) {
+        xSemaphoreGive(s_stats_mutex);
+    }
+}
+
+static void can_publisher_mark_change(size_t index, uint32_t arrival_us)
+{
+    uint32_t bit = 1UL << index;
+    if ((__atomic_load_n(&s_change_pending, __ATOMIC_RELAXED) & bit) != 0U) {
+        // An older change is still waiting: latency counts from that one
+        return;
+    }
+    s_change_arrival_us[index] = arrival_us;
+    __atomic_fetch_or(&s_change_pending, bit, __ATOMIC_RELEASE);
+}
+
+// Clears the channel's pending bit before its slot is loaded. Returns true when
+// a change was pending, with its arrival time in out_arrival_us.
+static bool can_publisher_claim_change(size_t index, uint32_t *out_arrival_us)
+{
+    uint32_t bit = 1UL << index;
+    uint32_t previous = __atomic_fetch_and(&s_change_pending, ~bit, __ATOMIC_ACQ_REL);
+    if ((previous & bit) == 0U) {
+        return false;
+    }
+    *out_arrival_us = s_change_arrival_us[index];
+    return true;
+}
+
+// Puts back a claimed change whose frame did not reach the driver.
+static void can_publisher_restore_change(size_t index, uint32_t arrival_us)
+{
+    can_publisher_mark_change(index, arrival_us);
+}
+
+// Called once a changed frame has been handed to the driver.
+static void can_publisher_record_change(size_t index, uint32_t arrival_us, bool on_change)
+{
+    uint32_t latency_us = (uint32_t)can_publisher_timestamp_us() - arrival_us;
+
+    if (s_stats_mutex != NULL &&
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+
+    can_publisher_channel_schedule_t *schedule = &s_channel_schedule[index];
+    can_publisher_channel_stats_t *stats = &schedule->stats;
+    if (on_change) {
+        ++stats->on_change_frames;
+    }
+    stats->change_latency_last_us = latency_us;
+    if (latency_us > stats->change_latency_max_us) {
+        stats->change_latency_max_us = latency_us;
+    }
+    schedule->change_latency_sum_us += latency_us;
+    ++stats->change_latency_count;
+    stats->change_latency_avg_us = (uint32_t)(schedule->change_latency_sum_us / stats->change_latency_count);
+
+    if (s_stats_mutex != NULL) {
+        xSemaphoreGive(s_stats_mutex);
+    }
+}
+
 void can_publisher_set_event_publisher(event_bus_publish_fn_t publisher)
 {
     s_event_publisher = publisher;
 }
 
+// Both hooks are read by the publisher task without a lock, so they can only
+// change while the task is not running.
+void can_publisher_set_bus_load_provider(can_publisher_bus_load_fn_t provider)
+{
+    if (s_publish_task_handle != NULL) {
+        ESP_LOGW(TAG, "Bus load provider must be installed before can_publisher_init()");
+        return;
+    }
+    s_bus_load_provider = provider;
+}
+
+void can_publisher_set_batch_publisher(can_publisher_frame_batch_publish_fn_t publisher)
+{
+    if (s_publish_task_handle != NULL) {
+        ESP_LOGW(TAG, "Batch publisher must be installed before can_publisher_init()");
+        return;
+    }
+    s_batch_publisher = publisher;
+}
+
+void can_publisher_get_shaping_status(can_publisher_shaping_status_t *out_status)
+{
+    if (out_status == NULL) {
+        return;
+    }
+
+    if (s_stats_mutex != NULL &&
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) == pdTRUE) {
+        out_status->active = s_shaping_active;
+        out_status->bus_occupancy_pct = s_bus_occupancy_pct;
+        xSemaphoreGive(s_stats_mutex);
+    } else {
+        out_status->active = s_shaping_active;
+        out_status->bus_occupancy_pct = s_bus_occupancy_pct;
+    }
+}
+
+// Samples bus occupancy at most once per shaping window and toggles shaping
+// with hysteresis between the threshold and release levels.
+static void can_publisher_update_shaping(TickType_t now)
+{
+    if (s_bus_load_provider == NULL || (int32_t)(now - s_next_shaping_sample) < 0) {
+        return;
+    }
+    s_next_shaping_sample = now + can_publisher_ms_to_ticks(CAN_PUBLISHER_SHAPING_WINDOW_MS);
+
+    float occupancy = 0.0f;
+    if (s_bus_load_provider(CAN_PUBLISHER_SHAPING_WINDOW_MS, &occupancy) != ESP_OK) {
+        return;
+    }
+
+    bool active = s_shaping_active;
+    if (!active && occupancy >= (float)CONFIG_TINYBMS_CAN_SHAPING_THRESHOLD_PCT) {
+        active = true;
+    } else if (active && occupancy <= (float)CONFIG_TINYBMS_CAN_SHAPING_RELEASE_PCT) {
+        active = false;
+    }
+
+    if (active != s_shaping_active) {
+        ESP_LOGI(TAG,
+                 "CAN bus occupancy %.1f%%: %s low-priority channels",
+                 (double)occupancy,
+                 active ? "stretching" : "restoring");
+    }
+
+    if (s_stats_mutex != NULL &&
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) == pdTRUE) {
+        s_shaping_active = active;
+        s_bus_occupancy_pct = occupancy;
+        xSemaphoreGive(s_stats_mutex);
+    } else {
+        s_shaping_active = active;
+        s_bus_occupancy_pct = occupancy;
+    }
+}
+
+static TickType_t can_publisher_effective_period_ticks(size_t index)
+{
+    TickType_t period = s_channel_period_ticks[index];
+    if (s_shaping_active && s_channel_priority[index] == CAN_PUBLISHER_PRIORITY_LOW) {
+        period *= (TickType_t)CONFIG_TINYBMS_CAN_SHAPING_STRETCH_FACTOR;
+    }
+    return period;
+}
+
 static void can_publisher_publish_event(const can_publisher_frame_t *frame)
 {
     if (s_event_publisher == NULL || frame == NULL) {
@@ -129,15 +471,51 @@ static void can_publisher_publish_event(const can_publisher_frame_t *frame)
     }
 }
 
-static void can_publisher_dispatch_frame(const can_publisher_channel_t *channel,
-                                         const can_publisher_frame_t *frame)
+static void can_publisher_free_event_frames(void *context)
 {
-    if (channel == NULL || frame == NULL) {
+    free(context);
+}
+
+// One APP_EVENT_ID_CAN_FRAME_READY for a whole batch: the payload is an array
+// of frames, released by the bus once every subscriber is done with it.
+static void can_publisher_publish_batch_event(const can_publisher_frame_t *frames, size_t count)
+{
+    if (s_event_publisher == NULL || frames == NULL || count == 0) {
+        return;
+    }
+
+    size_t size = count * sizeof(*frames);
+    can_publisher_frame_t *copy = malloc(size);
+    if (copy == NULL) {
+        ESP_LOGW(TAG, "No memory for CAN batch event (%u frames)", (unsigned)count);
         return;
     }
+    memcpy(copy, frames, size);
+
+    event_bus_event_t event = {
+        .id = APP_EVENT_ID_CAN_FRAME_READY,
+        .payload = copy,
+        .payload_size = size,
+        .dispose = can_publisher_free_event_frames,
+        .dispose_context = copy,
+    };
+
+    // The bus disposes of the copy on every path
+    if (!s_event_publisher(&event, pdMS_TO_TICKS(CAN_PUBLISHER_EVENT_TIMEOUT_MS))) {
+        ESP_LOGW(TAG, "Failed to publish CAN batch event (%u frames)", (unsigned)count);
+    }
+}
+
+static esp_err_t can_publisher_dispatch_frame(const can_publisher_channel_t *channel,
+                                              const can_publisher_frame_t *frame)
+{
+    if (channel == NULL || frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    esp_err_t err = ESP_OK;
     if (s_frame_publisher != NULL) {
-        esp_err_t err = s_frame_publisher(channel->can_id, frame->data, frame->dlc, channel->description);
+        err = s_frame_publisher(channel->can_id, frame->data, frame->dlc, channel->description);
         if (err != ESP_OK) {
             ESP_LOGW(TAG, "Failed to publish CAN frame 0x%08" PRIX32 ": %s",
                      channel->can_id,
@@ -146,6 +524,7 @@ static void can_publisher_dispatch_frame(const can_publisher_channel_t *channel,
     }
 
     can_publisher_publish_event(frame);
+    return err;
 }
 
 void can_publisher_init(event_bus_publish_fn_t publisher,
@@ -173,18 +552,68 @@ void can_publisher_init(event_bus_publish_fn_t publisher,
     s_frame_buffer.capacity = s_registry.channel_count;
     memset(s_frame_buffer.slots, 0, sizeof(s_frame_buffer.slots));
     memset(s_frame_buffer.slot_valid, 0, sizeof(s_frame_buffer.slot_valid));
+    memset(s_frame_buffer.slot_sequence, 0, sizeof(s_frame_buffer.slot_sequence));
+    __atomic_store_n(&s_torn_reads, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_skipped_reads, 0U, __ATOMIC_RELAXED);
     memset(s_event_frames, 0, sizeof(s_event_frames));
     s_event_frame_index = 0;
+    s_identity_inputs_valid = false;
+    s_config_generation_seen = config_manager_get_generation();
+    __atomic_store_n(&s_change_pending, 0U, __ATOMIC_RELAXED);
+    memset(s_change_arrival_us, 0, sizeof(s_change_arrival_us));
 
     TickType_t now_ticks = xTaskGetTickCount();
+    memset(s_channel_schedule, 0, sizeof(s_channel_schedule));
+    memset(&s_batch, 0, sizeof(s_batch));
+    memset(&s_dispatch_stats, 0, sizeof(s_dispatch_stats));
+    s_schedule_heap_size = 0;
+    s_shaping_active = false;
+    s_bus_occupancy_pct = 0.0f;
+    s_next_shaping_sample = now_ticks;
+
+    TickType_t shortest_period = 0;
+    for (size_t i = 0; i < s_registry.channel_count; ++i) {
+        uint32_t period_ms = s_registry.channels[i].period_ms;
+        if (period_ms == 0U) {
+            period_ms = (s_publish_interval_ms > 0U) ? s_publish_interval_ms : 1000U;
+        }
+        s_channel_period_ticks[i] = can_publisher_ms_to_ticks(period_ms);
+        if (shortest_period == 0 || s_channel_period_ticks[i] < shortest_period) {
+            shortest_period = s_channel_period_ticks[i];
+        }
+    }
+
+    // Channels sharing a period form one class and start on the same deadline,
+    // so they keep falling due together and leave in a single batch. Only the
+    // classes are staggered across the shortest period.
+    TickType_t period_classes[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    size_t channel_class[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    size_t class_count = 0;
+    for (size_t i = 0; i < s_registry.channel_count; ++i) {
+        size_t class_index = 0;
+        while (class_index < class_count && period_classes[class_index] != s_channel_period_ticks[i]) {
+            ++class_index;
+        }
+        if (class_index == class_count) {
+            period_classes[class_count++] = s_channel_period_ticks[i];
+        }
+        channel_class[i] = class_index;
+    }
+
     for (size_t i = 0; i < s_registry.channel_count; ++i) {
         const can_publisher_channel_t *channel = &s_registry.channels[i];
         uint32_t period_ms = channel->period_ms;
         if (period_ms == 0U) {
             period_ms = (s_publish_interval_ms > 0U) ? s_publish_interval_ms : 1000U;
         }
-        s_channel_period_ticks[i] = can_publisher_ms_to_ticks(period_ms);
-        s_channel_deadlines[i] = now_ticks;
+        s_channel_deadlines[i] = now_ticks + (TickType_t)((shortest_period * channel_class[i]) / class_count);
+        s_channel_priority[i] = channel->priority;
+        s_channel_schedule[i].stats.can_id = channel->can_id;
+        s_channel_schedule[i].stats.period_ms = period_ms;
+        s_channel_schedule[i].stats.effective_period_ms = period_ms;
+        s_schedule_heap[s_schedule_heap_size] = (uint8_t)i;
+        can_publisher_heap_sift_up(s_schedule_heap_size);
+        ++s_schedule_heap_size;
         ESP_LOGI(TAG,
                  "Channel %zu PGN 0x%03X scheduled every %u ms",
                  i,
@@ -192,13 +621,6 @@ void can_publisher_init(event_bus_publish_fn_t publisher,
                  (unsigned)period_ms);
     }
 
-    if (s_buffer_mutex == NULL) {
-        s_buffer_mutex = xSemaphoreCreateMutex();
-        if (s_buffer_mutex == NULL) {
-            ESP_LOGE(TAG, "Failed to create CAN publisher buffer mutex");
-        }
-    }
-
     if (s_event_mutex == NULL) {
         s_event_mutex = xSemaphoreCreateMutex();
         if (s_event_mutex == NULL) {
@@ -206,6 +628,13 @@ void can_publisher_init(event_bus_publish_fn_t publisher,
         }
     }
 
+    if (s_stats_mutex == NULL) {
+        s_stats_mutex = xSemaphoreCreateMutex();
+        if (s_stats_mutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create CAN publisher stats mutex");
+        }
+    }
+
     esp_err_t err = uart_bms_register_listener(can_publisher_on_bms_update, &s_registry);
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "Unable to register TinyBMS listener: %s", esp_err_to_name(err));
@@ -235,6 +664,35 @@ void can_publisher_init(event_bus_publish_fn_t publisher,
     }
 }
 
+static uint32_t can_publisher_collect_dirty_inputs(const uart_bms_live_data_t *data)
+{
+    uint32_t dirty = CAN_PUBLISHER_INPUT_LIVE;
+
+    can_publisher_identity_inputs_t identity;
+    can_publisher_conversion_capture_identity(data, &identity);
+    if (!s_identity_inputs_valid || memcmp(&identity, &s_identity_inputs, sizeof(identity)) != 0) {
+        s_identity_inputs = identity;
+        s_identity_inputs_valid = true;
+        dirty |= CAN_PUBLISHER_INPUT_IDENTITY;
+    }
+
+    uint32_t generation = config_manager_get_generation();
+    if (generation != s_config_generation_seen) {
+        s_config_generation_seen = generation;
+        dirty |= CAN_PUBLISHER_INPUT_CONFIG;
+    }
+
+    return dirty;
+}
+
+static bool can_publisher_channel_needs_encode(const can_publisher_channel_t *channel, uint32_t dirty_inputs)
+{
+    if (channel->inputs == 0U || (channel->inputs & CAN_PUBLISHER_INPUT_LIVE) != 0U) {
+        return true;
+    }
+    return (channel->inputs & dirty_inputs) != 0U;
+}
+
 void can_publisher_on_bms_update(const uart_bms_live_data_t *data, void *context)
 {
     can_publisher_registry_t *registry = (can_publisher_registry_t *)context;
@@ -247,11 +705,14 @@ void can_publisher_on_bms_update(const uart_bms_live_data_t *data, void *context
         return;
     }
 
+    uint32_t arrival_us = (uint32_t)can_publisher_timestamp_us();
     can_publisher_cvl_prepare(data);
 
     uint64_t timestamp_ms = (data->timestamp_ms > 0U) ? data->timestamp_ms : can_publisher_timestamp_ms();
 
     bool periodic = can_publisher_periodic_mode_enabled() && (s_publish_task_handle != NULL);
+    uint32_t dirty_inputs = can_publisher_collect_dirty_inputs(data);
+    bool wake_publisher = false;
 
     for (size_t i = 0; i < registry->channel_count; ++i) {
         const can_publisher_channel_t *channel = &registry->channels[i];
@@ -260,6 +721,22 @@ void can_publisher_on_bms_update(const uart_bms_live_data_t *data, void *context
             continue;
         }
 
+        // Static frames keep their cached bytes until one of their inputs
+        // changes. This listener is the only writer of slot_valid, so the
+        // unlocked read is safe. In periodic mode the scheduler keeps resending
+        // the cached slot on its own deadline.
+        if (i < registry->buffer->capacity && registry->buffer->slot_valid[i] &&
+            !can_publisher_channel_needs_encode(channel, dirty_inputs)) {
+            if (!periodic) {
+                can_publisher_frame_t cached = {0};
+                if (can_publisher_load_frame(registry->buffer, i, &cached) == ESP_OK) {
+                    cached.timestamp_ms = timestamp_ms;
+                    (void)can_publisher_dispatch_frame(channel, &cached);
+                }
+            }
+            continue;
+        }
+
         can_publisher_frame_t frame = {
             .id = channel->can_id,
             .dlc = (channel->dlc > 8U) ? 8U : channel->dlc,
@@ -273,15 +750,36 @@ void can_publisher_on_bms_update(const uart_bms_live_data_t *data, void *context
             continue;
         }
 
+        // Single writer, so the previous bytes can be compared unlocked
+        bool changed = (channel->priority == CAN_PUBLISHER_PRIORITY_CRITICAL) &&
+                       (i < registry->buffer->capacity) &&
+                       (!registry->buffer->slot_valid[i] ||
+                        memcmp(registry->buffer->slots[i].data, frame.data, sizeof(frame.data)) != 0);
+
         bool stored = can_publisher_store_frame(registry->buffer, i, &frame);
         if (!stored) {
             continue;
         }
 
         if (!periodic) {
-            can_publisher_dispatch_frame(channel, &frame);
+            // Sent inline: no pending bit, the latency is known right away
+            if (can_publisher_dispatch_frame(channel, &frame) == ESP_OK && changed) {
+                can_publisher_record_change(i, arrival_us, false);
+            }
+            continue;
+        }
+
+        if (changed) {
+            can_publisher_mark_change(i, arrival_us);
+            wake_publisher = true;
         }
     }
+
+    // Let the scheduler send changed critical frames ahead of their deadline
+    TaskHandle_t task = s_publish_task_handle;
+    if (periodic && wake_publisher && task != NULL) {
+        xTaskNotifyGive(task);
+    }
 }
 
 void can_publisher_deinit(void)
@@ -295,6 +793,7 @@ void can_publisher_deinit(void)
     // Arrêt propre de la tâche avec flag
     if (s_publish_task_handle != NULL) {
         s_task_should_exit = true;  // Signaler arrêt
+        xTaskNotifyGive(s_publish_task_handle);
 
         // Attendre que tâche confirme arrêt (max 1s)
         for (int i = 0; i < 20 && s_publish_task_handle != NULL; i++) {
@@ -308,16 +807,16 @@ void can_publisher_deinit(void)
         }
     }
 
-    if (s_buffer_mutex != NULL) {
-        vSemaphoreDelete(s_buffer_mutex);
-        s_buffer_mutex = NULL;
-    }
-
     if (s_event_mutex != NULL) {
         vSemaphoreDelete(s_event_mutex);
         s_event_mutex = NULL;
     }
 
+    if (s_stats_mutex != NULL) {
+        vSemaphoreDelete(s_stats_mutex);
+        s_stats_mutex = NULL;
+    }
+
     memset(&s_frame_buffer, 0, sizeof(s_frame_buffer));
     s_registry.buffer = &s_frame_buffer;
     s_registry.channel_count = 0;
@@ -326,12 +825,24 @@ void can_publisher_deinit(void)
     memset(s_event_frames, 0, sizeof(s_event_frames));
     s_event_frame_index = 0;
     memset(s_channel_period_ticks, 0, sizeof(s_channel_period_ticks));
+    memset(s_channel_priority, 0, sizeof(s_channel_priority));
+    s_shaping_active = false;
+    s_bus_occupancy_pct = 0.0f;
     memset(s_channel_deadlines, 0, sizeof(s_channel_deadlines));
+    memset(s_schedule_heap, 0, sizeof(s_schedule_heap));
+    s_schedule_heap_size = 0;
+    memset(s_channel_schedule, 0, sizeof(s_channel_schedule));
+    memset(&s_batch, 0, sizeof(s_batch));
+    memset(&s_dispatch_stats, 0, sizeof(s_dispatch_stats));
+    __atomic_store_n(&s_change_pending, 0U, __ATOMIC_RELAXED);
+    memset(s_change_arrival_us, 0, sizeof(s_change_arrival_us));
+    s_identity_inputs_valid = false;
 
     const config_manager_can_settings_t *settings = can_publisher_get_settings();
     s_publish_interval_ms = settings->publisher.period_ms;
 
     s_frame_publisher = NULL;
+    s_batch_publisher = NULL;
     s_event_publisher = NULL;
 
     can_publisher_cvl_init();
@@ -342,6 +853,8 @@ static bool can_publisher_periodic_mode_enabled(void)
     return (s_publish_interval_ms > 0U);
 }
 
+// Single writer: only the TinyBMS listener stores frames, so the sequence
+// counter can be bumped without a compare-and-swap.
 static bool can_publisher_store_frame(can_publisher_buffer_t *buffer,
                                       size_t index,
                                       const can_publisher_frame_t *frame)
@@ -350,101 +863,322 @@ static bool can_publisher_store_frame(can_publisher_buffer_t *buffer,
         return false;
     }
 
-    if (s_buffer_mutex != NULL) {
-        if (xSemaphoreTake(s_buffer_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) != pdTRUE) {
-            ESP_LOGW(TAG, "Timed out acquiring CAN publisher buffer lock");
-            return false;
-        }
-
-        buffer->slots[index] = *frame;
-        buffer->slot_valid[index] = true;
-        s_channel_deadlines[index] = xTaskGetTickCount();
-        xSemaphoreGive(s_buffer_mutex);
-        return true;
-    }
+    uint32_t *sequence = &buffer->slot_sequence[index];
+    uint32_t start = __atomic_load_n(sequence, __ATOMIC_RELAXED);
 
+    __atomic_store_n(sequence, start + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
     buffer->slots[index] = *frame;
     buffer->slot_valid[index] = true;
-    s_channel_deadlines[index] = xTaskGetTickCount();
+    __atomic_store_n(sequence, start + 2U, __ATOMIC_RELEASE);
     return true;
 }
 
-static TickType_t can_publisher_publish_buffer(can_publisher_registry_t *registry, TickType_t now)
+static esp_err_t can_publisher_load_frame(can_publisher_buffer_t *buffer,
+                                          size_t index,
+                                          can_publisher_frame_t *out_frame)
 {
-    if (registry == NULL || registry->channels == NULL || registry->buffer == NULL) {
-        return 1;
+    if (buffer == NULL || out_frame == NULL || index >= buffer->capacity) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    can_publisher_buffer_t *buffer = registry->buffer;
+    const uint32_t *sequence = &buffer->slot_sequence[index];
+    for (uint32_t attempt = 0; attempt < CAN_PUBLISHER_SLOT_READ_RETRIES; ++attempt) {
+        uint32_t before = __atomic_load_n(sequence, __ATOMIC_ACQUIRE);
+        if ((before & 1U) == 0U) {
+            bool valid = buffer->slot_valid[index];
+            can_publisher_frame_t copy = buffer->slots[index];
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(sequence, __ATOMIC_RELAXED) == before) {
+                if (!valid) {
+                    return ESP_ERR_NOT_FOUND;
+                }
+                *out_frame = copy;
+                return ESP_OK;
+            }
+        }
+        __atomic_fetch_add(&s_torn_reads, 1U, __ATOMIC_RELAXED);
+    }
 
-    if (buffer->capacity == 0) {
-        return 1;
+    __atomic_fetch_add(&s_skipped_reads, 1U, __ATOMIC_RELAXED);
+    return ESP_ERR_TIMEOUT;
+}
+
+void can_publisher_get_buffer_diagnostics(can_publisher_buffer_diagnostics_t *out_diagnostics)
+{
+    if (out_diagnostics == NULL) {
+        return;
     }
 
-    TickType_t next_delay = 0;
-    bool have_delay = false;
+    out_diagnostics->torn_reads = __atomic_load_n(&s_torn_reads, __ATOMIC_RELAXED);
+    out_diagnostics->skipped_reads = __atomic_load_n(&s_skipped_reads, __ATOMIC_RELAXED);
+}
 
-    for (size_t i = 0; i < registry->channel_count; ++i) {
-        const can_publisher_channel_t *channel = &registry->channels[i];
-        can_publisher_frame_t frame = {0};
-        bool has_frame = false;
+void can_publisher_get_dispatch_stats(can_publisher_dispatch_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return;
+    }
 
-        if (s_buffer_mutex != NULL) {
-            if (xSemaphoreTake(s_buffer_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) == pdTRUE) {
-                if (buffer->slot_valid[i]) {
-                    frame = buffer->slots[i];
-                    has_frame = true;
-                }
-                xSemaphoreGive(s_buffer_mutex);
-            } else {
-                ESP_LOGW(TAG, "Timed out acquiring CAN publisher buffer for read");
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (s_stats_mutex == NULL ||
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+    *out_stats = s_dispatch_stats;
+    xSemaphoreGive(s_stats_mutex);
+}
+
+static void can_publisher_record_pass(const can_publisher_pass_cost_t *cost)
+{
+    if (cost->calls == 0U) {
+        return;
+    }
+    if (s_stats_mutex != NULL &&
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
+
+    uint32_t elapsed_us = (cost->elapsed_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)cost->elapsed_us;
+    ++s_dispatch_stats.passes;
+    s_dispatch_stats.frames += cost->frames;
+    s_dispatch_stats.publisher_calls += cost->calls;
+    s_dispatch_stats.last_dispatch_us = elapsed_us;
+    if (elapsed_us > s_dispatch_stats.max_dispatch_us) {
+        s_dispatch_stats.max_dispatch_us = elapsed_us;
+    }
+    s_dispatch_stats.total_dispatch_us += cost->elapsed_us;
+
+    if (s_stats_mutex != NULL) {
+        xSemaphoreGive(s_stats_mutex);
+    }
+}
+
+// Transmits the collected batch and accounts only for the frames the driver
+// accepted. The rest keep their pending change and are retried shortly.
+static void can_publisher_flush_batch(TickType_t now, can_publisher_pass_cost_t *cost)
+{
+    size_t count = s_batch.count;
+    if (count == 0) {
+        return;
+    }
+
+    size_t sent = 0;
+    uint64_t start_us = can_publisher_timestamp_us();
+    esp_err_t err = s_batch_publisher(s_batch.frames, count, &sent);
+    cost->elapsed_us += can_publisher_timestamp_us() - start_us;
+    ++cost->calls;
+    if (sent > count) {
+        sent = count;
+    }
+    cost->frames += (uint32_t)sent;
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG,
+                 "Failed to publish CAN batch: %u/%u frames sent: %s",
+                 (unsigned)sent,
+                 (unsigned)count,
+                 esp_err_to_name(err));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t index = s_batch.channel[i];
+        bool claimed = (s_batch.claimed & (1UL << i)) != 0U;
+        if (i < sent) {
+            TickType_t period = can_publisher_effective_period_ticks(index);
+            can_publisher_record_dispatch(index, (uint32_t)(period * portTICK_PERIOD_MS));
+            s_channel_schedule[index].last_tx_us = can_publisher_timestamp_us();
+            if (claimed) {
+                can_publisher_record_change(index, s_batch.arrival_us[i], false);
             }
-        } else if (buffer->slot_valid[i]) {
-            frame = buffer->slots[i];
-            has_frame = true;
+        } else {
+            if (claimed) {
+                can_publisher_restore_change(index, s_batch.arrival_us[i]);
+            }
+            can_publisher_heap_reschedule(index, now + can_publisher_ms_to_ticks(CAN_PUBLISHER_TX_RETRY_MS));
         }
+    }
 
-        TickType_t deadline = s_channel_deadlines[i];
-        if (deadline == 0) {
-            deadline = now;
+    start_us = can_publisher_timestamp_us();
+    can_publisher_publish_batch_event(s_batch.events, sent);
+    cost->elapsed_us += can_publisher_timestamp_us() - start_us;
+    s_batch.count = 0;
+    s_batch.claimed = 0;
+}
+
+// Sends critical channels whose bytes changed ahead of their deadline. A
+// channel transmitted less than the guard ago is held back. A successful send
+// restarts the channel's period so the regular deadline does not repeat the
+// same bytes right after it. Returns the delay until a held-back change may go
+// out (portMAX_DELAY when none is waiting).
+static TickType_t can_publisher_publish_changes(can_publisher_registry_t *registry,
+                                                TickType_t now,
+                                                can_publisher_pass_cost_t *cost)
+{
+    uint32_t pending = __atomic_load_n(&s_change_pending, __ATOMIC_ACQUIRE);
+    if (pending == 0U) {
+        return portMAX_DELAY;
+    }
+
+    const uint64_t guard_us = (uint64_t)CONFIG_TINYBMS_CAN_ON_CHANGE_GUARD_MS * 1000ULL;
+    TickType_t wait = portMAX_DELAY;
+
+    for (size_t index = 0; index < registry->channel_count; ++index) {
+        if ((pending & (1UL << index)) == 0U) {
+            continue;
         }
 
-        bool due = (now >= deadline);
+        can_publisher_channel_schedule_t *schedule = &s_channel_schedule[index];
+        uint64_t now_us = can_publisher_timestamp_us();
+        uint64_t since_us = now_us - schedule->last_tx_us;
+        if (schedule->last_tx_us != 0U && since_us < guard_us) {
+            TickType_t ticks = can_publisher_ms_to_ticks((uint32_t)((guard_us - since_us + 999U) / 1000U));
+            if (ticks < wait) {
+                wait = ticks;
+            }
+            continue;
+        }
 
-        if (due && has_frame) {
-            can_publisher_dispatch_frame(channel, &frame);
-            // Éviter dérive: incrémenter depuis deadline précédente
-            s_channel_deadlines[i] += s_channel_period_ticks[i];
-            // Si deadline dans le passé (ex: après longue pause), resynchroniser
-            if ((int32_t)(now - s_channel_deadlines[i]) > 0) {
-                s_channel_deadlines[i] = now + s_channel_period_ticks[i];
+        uint32_t arrival_us = 0;
+        if (!can_publisher_claim_change(index, &arrival_us)) {
+            continue;
+        }
+
+        can_publisher_frame_t frame = {0};
+        if (can_publisher_load_frame(registry->buffer, index, &frame) != ESP_OK) {
+            can_publisher_restore_change(index, arrival_us);
+            wait = 1;
+            continue;
+        }
+        uint64_t start_us = can_publisher_timestamp_us();
+        esp_err_t tx_err = can_publisher_dispatch_frame(&registry->channels[index], &frame);
+        cost->elapsed_us += can_publisher_timestamp_us() - start_us;
+        ++cost->calls;
+        if (tx_err != ESP_OK) {
+            // Driver refused the frame: retry after the guard, not every tick
+            can_publisher_restore_change(index, arrival_us);
+            TickType_t ticks = can_publisher_ms_to_ticks(CONFIG_TINYBMS_CAN_ON_CHANGE_GUARD_MS);
+            if (ticks < wait) {
+                wait = ticks;
             }
-            deadline = s_channel_deadlines[i];
-        } else if (due && !has_frame) {
-            // Éviter dérive: incrémenter depuis deadline précédente
-            s_channel_deadlines[i] += s_channel_period_ticks[i];
-            // Si deadline dans le passé (ex: après longue pause), resynchroniser
-            if ((int32_t)(now - s_channel_deadlines[i]) > 0) {
-                s_channel_deadlines[i] = now + s_channel_period_ticks[i];
+            continue;
+        }
+
+        ++cost->frames;
+        TickType_t period = can_publisher_effective_period_ticks(index);
+        can_publisher_record_dispatch(index, (uint32_t)(period * portTICK_PERIOD_MS));
+        schedule->last_tx_us = can_publisher_timestamp_us();
+        can_publisher_record_change(index, arrival_us, true);
+        can_publisher_heap_reschedule(index, now + period);
+    }
+
+    return wait;
+}
+
+// Dispatches every channel whose deadline has passed and returns the delay
+// until the earliest remaining deadline. With a batch publisher installed the
+// due frames are collected and transmitted together at the end of the pass.
+// A frame the driver refuses is retried after CAN_PUBLISHER_TX_RETRY_MS.
+static TickType_t can_publisher_publish_due(can_publisher_registry_t *registry, TickType_t now)
+{
+    if (registry == NULL || registry->channels == NULL || registry->buffer == NULL ||
+        s_schedule_heap_size == 0) {
+        uint32_t default_period = (s_publish_interval_ms > 0U) ? s_publish_interval_ms : 1000U;
+        return can_publisher_ms_to_ticks(default_period);
+    }
+
+    can_publisher_update_shaping(now);
+    can_publisher_pass_cost_t cost = {0};
+    TickType_t change_wait = can_publisher_publish_changes(registry, now, &cost);
+
+    const bool batching = (s_batch_publisher != NULL);
+    bool slot_busy = false;
+
+    for (;;) {
+        size_t index = s_schedule_heap[0];
+        if ((int32_t)(s_channel_deadlines[index] - now) > 0) {
+            break;
+        }
+
+        uint32_t arrival_us = 0;
+        bool change_claimed = can_publisher_claim_change(index, &arrival_us);
+
+        can_publisher_frame_t frame = {0};
+        esp_err_t err = can_publisher_load_frame(registry->buffer, index, &frame);
+        if (err == ESP_ERR_TIMEOUT) {
+            // Writer kept the slot busy: keep the deadline and retry next tick.
+            if (change_claimed) {
+                can_publisher_restore_change(index, arrival_us);
             }
-            deadline = s_channel_deadlines[i];
+            slot_busy = true;
+            break;
+        }
+        TickType_t period = can_publisher_effective_period_ticks(index);
+        bool retry = false;
+        if (err == ESP_OK) {
+            const can_publisher_channel_t *channel = &registry->channels[index];
+            if (batching && s_batch.count < CAN_PUBLISHER_MAX_BUFFER_SLOTS) {
+                // Accounted for by can_publisher_flush_batch() once sent
+                size_t entry_index = s_batch.count++;
+                can_victron_tx_frame_t *entry = &s_batch.frames[entry_index];
+                entry->can_id = channel->can_id;
+                entry->length = (frame.dlc > 8U) ? 8U : frame.dlc;
+                memcpy(entry->data, frame.data, sizeof(entry->data));
+                entry->description = channel->description;
+                s_batch.events[entry_index] = frame;
+                s_batch.channel[entry_index] = (uint8_t)index;
+                s_batch.arrival_us[entry_index] = arrival_us;
+                if (change_claimed) {
+                    s_batch.claimed |= 1UL << entry_index;
+                }
+            } else {
+                uint64_t start_us = can_publisher_timestamp_us();
+                esp_err_t tx_err = can_publisher_dispatch_frame(channel, &frame);
+                cost.elapsed_us += can_publisher_timestamp_us() - start_us;
+                ++cost.calls;
+                if (tx_err == ESP_OK) {
+                    ++cost.frames;
+                    can_publisher_record_dispatch(index, (uint32_t)(period * portTICK_PERIOD_MS));
+                    s_channel_schedule[index].last_tx_us = can_publisher_timestamp_us();
+                    if (change_claimed) {
+                        can_publisher_record_change(index, arrival_us, false);
+                    }
+                } else {
+                    if (change_claimed) {
+                        can_publisher_restore_change(index, arrival_us);
+                    }
+                    retry = true;
+                }
+            }
+        } else if (change_claimed) {
+            can_publisher_restore_change(index, arrival_us);
         }
 
-        TickType_t delta = (deadline > now) ? (deadline - now) : 0;
-        if (!have_delay || delta < next_delay) {
-            next_delay = delta;
-            have_delay = true;
+        if (retry) {
+            s_channel_deadlines[index] = now + can_publisher_ms_to_ticks(CAN_PUBLISHER_TX_RETRY_MS);
+        } else {
+            // Éviter dérive: incrémenter depuis deadline précédente
+            s_channel_deadlines[index] += period;
+            // Si deadline dans le passé (ex: après longue pause), resynchroniser
+            if ((int32_t)(now - s_channel_deadlines[index]) >= 0) {
+                s_channel_deadlines[index] = now + period;
+            }
         }
+        can_publisher_heap_sift_down(0);
     }
 
-    if (!have_delay) {
-        uint32_t default_period = (s_publish_interval_ms > 0U) ? s_publish_interval_ms : 1000U;
-        next_delay = can_publisher_ms_to_ticks(default_period);
-    } else if (next_delay == 0) {
-        next_delay = 1;
+    if (batching) {
+        can_publisher_flush_batch(now, &cost);
+    }
+    can_publisher_record_pass(&cost);
+    if (slot_busy) {
+        return 1;
     }
 
-    return next_delay;
+    int32_t remaining = (int32_t)(s_channel_deadlines[s_schedule_heap[0]] - now);
+    if (remaining < 1) {
+        remaining = 1;
+    }
+    return ((TickType_t)remaining < change_wait) ? (TickType_t)remaining : change_wait;
 }
 
 static void can_publisher_task(void *context)
@@ -452,19 +1186,39 @@ static void can_publisher_task(void *context)
     can_publisher_registry_t *registry = (can_publisher_registry_t *)context;
 
     while (!s_task_should_exit) {
-        TickType_t now = xTaskGetTickCount();
-        TickType_t delay_ticks = can_publisher_publish_buffer(registry, now);
-        if (delay_ticks == 0) {
-            taskYIELD();
-        } else {
-            vTaskDelay(delay_ticks);
-        }
+        TickType_t delay_ticks = can_publisher_publish_due(registry, xTaskGetTickCount());
+        // Woken early by the listener when a critical frame changes
+        (void)ulTaskNotifyTake(pdTRUE, delay_ticks);
     }
 
     s_publish_task_handle = NULL;  // Signaler sortie
     vTaskDelete(NULL);
 }
 
+size_t can_publisher_get_channel_stats(can_publisher_channel_stats_t *out_stats, size_t capacity)
+{
+    if (out_stats == NULL || capacity == 0) {
+        return 0;
+    }
+
+    size_t count = s_registry.channel_count;
+    if (count > capacity) {
+        count = capacity;
+    }
+
+    if (s_stats_mutex == NULL ||
+        xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(CAN_PUBLISHER_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        out_stats[i] = s_channel_schedule[i].stats;
+    }
+
+    xSemaphoreGive(s_stats_mutex);
+    return count;
+}
+
 static const config_manager_can_settings_t *can_publisher_get_settings(void)
 {
     static const config_manager_can_settings_t defaults = {
@@ -10,24 +10,29 @@
  *
  * @section can_publisher_thread_safety Thread Safety
  *
- * The CAN publisher uses multiple mutexes for different resources:
- * - s_buffer_mutex: Protects frame buffer (s_frame_buffer)
+ * The frame buffer (s_frame_buffer) is lock-free: each slot is a seqlock with
+ * a single writer (the TinyBMS listener). Readers retry when they observe a
+ * write in progress and give up after a few attempts, deferring the channel
+ * to the next tick. Other resources use mutexes:
  * - s_event_mutex: Protects event frame slots (s_event_frames)
+ * - s_stats_mutex: Protects per-channel scheduling statistics
  *
  * **Protected Resources**:
  * - s_frame_buffer - Buffered frames waiting for publication
- * - s_event_frames[] - Pre-allocated event buffers (8 slots)
+ * - s_event_frames[] - Pre-allocated event buffers (one per channel)
  * - s_event_frame_index - Current event slot index
  *
  * **Thread-Safe Functions** (all public functions are thread-safe):
  * - can_publisher_init() - Initializes mutexes and registers BMS listener
  * - can_publisher_deinit() - Cleans up resources in safe order
  * - can_publisher_publish_frame() - Thread-safe frame publication
- * - Internal: can_publisher_on_bms_update() - Encodes frames (mutex-protected)
+ * - Internal: can_publisher_on_bms_update() - Encodes frames (sole slot writer)
  *
  * **Concurrency Pattern**:
  * - BMS callback thread: Generates frames from UART data
- * - Publisher task thread: Schedules periodic frame publication
+ * - Publisher task thread: Schedules periodic frame publication. Channel
+ *   deadlines live in a min-heap owned by this task, so each wake only
+ *   touches the channels that are actually due.
  * - Event bus subscribers: Receive frame ready notifications
  *
  * **Synchronization Approach**:
@@ -62,8 +67,11 @@
 extern "C" {
 #endif
 
-/** Maximum number of buffered CAN frames retained for event publication. */
-#define CAN_PUBLISHER_MAX_BUFFER_SLOTS 8U
+/**
+ * Number of buffered CAN frames, one per Victron channel. Must match the size
+ * of g_can_publisher_channels (enforced at compile time in conversion_table.c).
+ */
+#define CAN_PUBLISHER_MAX_BUFFER_SLOTS 19U
 
 /**
  * @brief Lightweight representation of a CAN frame scheduled for publication.
@@ -81,6 +89,29 @@ typedef struct {
 typedef bool (*can_publisher_fill_frame_fn_t)(const uart_bms_live_data_t *bms_data,
                                                can_publisher_frame_t *out_frame);
 
+/**
+ * @brief Inputs a channel encoder reads, used to skip re-encoding unchanged frames.
+ *
+ * Channels whose mask contains ::CAN_PUBLISHER_INPUT_LIVE (or is empty) are
+ * encoded on every TinyBMS sample. Other channels are encoded once and their
+ * cached bytes reused until one of their inputs changes.
+ */
+typedef enum {
+    CAN_PUBLISHER_INPUT_LIVE = (1U << 0),     /**< Per-sample telemetry, CVL state and energy counters. */
+    CAN_PUBLISHER_INPUT_IDENTITY = (1U << 1), /**< TinyBMS identification registers, versions and serial. */
+    CAN_PUBLISHER_INPUT_CONFIG = (1U << 2),   /**< CAN identity strings from the gateway configuration. */
+} can_publisher_input_t;
+
+/**
+ * @brief Scheduling priority of a channel under bus load.
+ */
+typedef enum {
+    CAN_PUBLISHER_PRIORITY_NORMAL = 0, /**< Keeps its period; default for telemetry frames. */
+    CAN_PUBLISHER_PRIORITY_LOW,        /**< Stretched while the bus is congested (identification strings). */
+    CAN_PUBLISHER_PRIORITY_CRITICAL,   /**< Never stretched, wins deadline ties and is also sent out of
+                                            band when its bytes change (CVL/CCL/DCL, alarms). */
+} can_publisher_priority_t;
+
 /**
  * @brief CAN channel description used by the publisher registry.
  */
@@ -91,6 +122,8 @@ typedef struct {
     can_publisher_fill_frame_fn_t fill_fn;   /**< Encoder translating TinyBMS fields. */
     const char *description;                 /**< Human readable description of the channel. */
     uint32_t period_ms;                      /**< Dispatch period for the channel (0 = inherit global). */
+    uint32_t inputs;                         /**< ::can_publisher_input_t mask read by \p fill_fn (0 = always encode). */
+    can_publisher_priority_t priority;       /**< Behaviour under bus load. */
 } can_publisher_channel_t;
 
 /**
@@ -101,12 +134,37 @@ typedef esp_err_t (*can_publisher_frame_publish_fn_t)(uint32_t can_id,
                                                       size_t length,
                                                       const char *description);
 
+/* Batch element, defined by the driver (can_victron_tx_frame_t). */
+struct can_victron_tx_frame;
+
+/**
+ * @brief Batch transmit hook receiving every frame due in one scheduler pass.
+ *
+ * Frames are sent in order. @p out_sent receives how many of them reached the
+ * driver, so only those are accounted for; the rest are retried shortly.
+ */
+typedef esp_err_t (*can_publisher_frame_batch_publish_fn_t)(const struct can_victron_tx_frame *frames,
+                                                            size_t count,
+                                                            size_t *out_sent);
+
+/**
+ * @brief Bus occupancy probe used for TX shaping.
+ *
+ * @param window_ms          Trailing window length in milliseconds
+ * @param out_occupancy_pct  Measured occupancy in percent
+ */
+typedef esp_err_t (*can_publisher_bus_load_fn_t)(uint32_t window_ms, float *out_occupancy_pct);
+
 /**
  * @brief Shared buffer storing the most recent frames prepared for each channel.
+ *
+ * Each slot is guarded by a sequence counter that is odd while the writer
+ * updates it, so readers copy frames without taking a lock.
  */
 typedef struct {
     can_publisher_frame_t slots[CAN_PUBLISHER_MAX_BUFFER_SLOTS]; /**< Storage for prepared frames. */
     bool slot_valid[CAN_PUBLISHER_MAX_BUFFER_SLOTS];             /**< Whether the slot contains data. */
+    uint32_t slot_sequence[CAN_PUBLISHER_MAX_BUFFER_SLOTS];      /**< Seqlock counter per slot. */
     size_t capacity;                                            /**< Number of usable slots. */
 } can_publisher_buffer_t;
 
@@ -119,12 +177,113 @@ typedef struct {
     can_publisher_buffer_t *buffer;          /**< Pointer to the shared circular buffer. */
 } can_publisher_registry_t;
 
+/**
+ * @brief Scheduling statistics of a periodic channel.
+ *
+ * Jitter is the absolute difference between the measured interval separating
+ * two transmissions of the channel and its configured period. Out-of-band
+ * frames are excluded from the jitter and interval figures.
+ *
+ * Change latency applies to ::CAN_PUBLISHER_PRIORITY_CRITICAL channels: time
+ * from the TinyBMS sample that changed the encoded bytes to the first frame
+ * carrying them being handed to the CAN driver.
+ */
+typedef struct {
+    uint32_t can_id;          /**< CAN identifier of the channel. */
+    uint32_t period_ms;       /**< Configured dispatch period. */
+    uint32_t effective_period_ms; /**< Period currently applied (stretched under bus load). */
+    uint32_t frames_sent;     /**< Frames dispatched by the periodic scheduler. */
+    uint32_t avg_interval_us; /**< Smoothed measured interval between transmissions (0 = unknown). */
+    uint32_t last_jitter_us;  /**< Jitter of the most recent transmission. */
+    uint32_t max_jitter_us;   /**< Largest jitter observed since init. */
+    uint32_t avg_jitter_us;   /**< Mean jitter over all measured intervals. */
+    uint32_t on_change_frames;       /**< Out-of-band frames sent because the payload changed. */
+    uint32_t change_latency_count;   /**< Payload changes that reached the driver. */
+    uint32_t change_latency_last_us; /**< Latency of the most recent change. */
+    uint32_t change_latency_max_us;  /**< Largest change latency since init. */
+    uint32_t change_latency_avg_us;  /**< Mean change latency since init. */
+} can_publisher_channel_stats_t;
+
 void can_publisher_set_event_publisher(event_bus_publish_fn_t publisher);
 void can_publisher_init(event_bus_publish_fn_t publisher,
                         can_publisher_frame_publish_fn_t frame_publisher);
 void can_publisher_deinit(void);
 void can_publisher_on_bms_update(const uart_bms_live_data_t *data, void *context);
 
+/**
+ * @brief State of the bus-load aware TX shaping.
+ */
+typedef struct {
+    bool active;             /**< Low-priority channels are currently stretched. */
+    float bus_occupancy_pct; /**< Last occupancy sample reported by the bus load probe. */
+} can_publisher_shaping_status_t;
+
+/**
+ * @brief Install the probe used to measure bus occupancy (NULL disables shaping).
+ *
+ * Must be called before can_publisher_init(): the publisher task reads the
+ * hook without locking, so later calls are ignored while it runs.
+ */
+void can_publisher_set_bus_load_provider(can_publisher_bus_load_fn_t provider);
+
+/**
+ * @brief Install a batch transmit hook used by the periodic scheduler.
+ *
+ * When set, frames falling due together are handed over in one call instead
+ * of one frame publisher call each. NULL restores per-frame dispatch. Like
+ * can_publisher_set_bus_load_provider(), install it before can_publisher_init().
+ */
+void can_publisher_set_batch_publisher(can_publisher_frame_batch_publish_fn_t publisher);
+
+/**
+ * @brief Read the current TX shaping state.
+ */
+void can_publisher_get_shaping_status(can_publisher_shaping_status_t *out_status);
+
+/**
+ * @brief Lock-free frame buffer diagnostics.
+ */
+typedef struct {
+    uint32_t torn_reads;    /**< Slot copies discarded because the writer raced the reader. */
+    uint32_t skipped_reads; /**< Dispatches deferred after exhausting read retries. */
+} can_publisher_buffer_diagnostics_t;
+
+/**
+ * @brief Read the frame buffer contention counters.
+ */
+void can_publisher_get_buffer_diagnostics(can_publisher_buffer_diagnostics_t *out_diagnostics);
+
+/**
+ * @brief Transmit cost of the periodic scheduler.
+ *
+ * Counts scheduler passes that handed at least one frame to a publisher,
+ * scheduled or out of band. Each publisher call takes the CAN driver TX lock
+ * once, so publisher_calls per frame shows what batching saves. Dispatch time
+ * covers the publisher calls and the CAN_FRAME_READY events.
+ */
+typedef struct {
+    uint32_t passes;            /**< Scheduler passes that called a publisher. */
+    uint32_t frames;            /**< Frames accepted by the driver during those passes. */
+    uint32_t publisher_calls;   /**< Frame or batch publisher calls (TX lock acquisitions). */
+    uint32_t last_dispatch_us;  /**< Dispatch time of the most recent pass. */
+    uint32_t max_dispatch_us;   /**< Longest pass dispatch time since init. */
+    uint64_t total_dispatch_us; /**< Cumulative dispatch time since init. */
+} can_publisher_dispatch_stats_t;
+
+/**
+ * @brief Read the scheduler transmit cost counters.
+ */
+void can_publisher_get_dispatch_stats(can_publisher_dispatch_stats_t *out_stats);
+
+/**
+ * @brief Copy per-channel scheduling statistics.
+ *
+ * @param out_stats Destination array
+ * @param capacity  Number of entries available in @p out_stats
+ * @return Number of entries written
+ */
+size_t can_publisher_get_channel_stats(can_publisher_channel_stats_t *out_stats, size_t capacity);
+
 #ifdef __cplusplus
 }
 #endif
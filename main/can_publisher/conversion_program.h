@@ -0,0 +1,59 @@
+#pragma once
+
+/**
+ * @file conversion_program.h
+ * @brief Table-driven encoder program for linear Victron PGNs
+ *
+ * PGNs whose fields are plain scaled copies of TinyBMS values are not
+ * hand-coded: tools/gen_can_program.py reads docs/UART_CAN_mapping.json and
+ * emits conversion_program_generated.h, a packed list of field operations
+ * executed by a single interpreter loop in conversion_table.c.
+ *
+ * Each operation reads one source value, computes
+ * `lrint((value + offset) * scale)`, clamps it to [min, max] and ORs the
+ * result into the little-endian payload at [bit_offset, bit_offset + bit_width).
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Where an operation reads its input value.
+ */
+typedef enum {
+    CAN_PROGRAM_SOURCE_F32 = 0,    /**< float field of uart_bms_live_data_t at source_offset. */
+    CAN_PROGRAM_SOURCE_U16 = 1,    /**< uint16_t field of uart_bms_live_data_t at source_offset. */
+    CAN_PROGRAM_SOURCE_REG_U32 = 2,/**< Two TinyBMS registers (low word first) at address source_offset;
+                                        the operation is skipped when they are missing. */
+} can_program_source_t;
+
+/**
+ * @brief One field of a program frame (20 bytes).
+ */
+typedef struct {
+    uint16_t source_offset; /**< Struct offset or register address, see ::can_program_source_t. */
+    uint8_t source;         /**< ::can_program_source_t */
+    uint8_t bit_offset;     /**< First payload bit (0-63). */
+    uint8_t bit_width;      /**< Field width in bits (1-32). */
+    uint8_t reserved[3];
+    float offset;           /**< Added to the value before scaling, in source units. */
+    float scale;            /**< Source units to CAN units. */
+    int32_t min;            /**< Clamp range of the encoded integer. */
+    int32_t max;
+} can_program_op_t;
+
+/**
+ * @brief Operations encoding one CAN identifier.
+ */
+typedef struct {
+    uint16_t can_id;
+    uint8_t first_op;       /**< Index of the first operation in the op table. */
+    uint8_t op_count;
+} can_program_frame_t;
+
+#ifdef __cplusplus
+}
+#endif
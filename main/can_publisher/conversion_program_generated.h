@@ -0,0 +1,48 @@
+// Generated by tools/gen_can_program.py from docs/UART_CAN_mapping.json. Do not edit.
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "conversion_program.h"
+#include "uart_bms.h"
+
+static_assert(sizeof(((uart_bms_live_data_t *)0)->mosfet_temperature_c) == 4U, "mosfet_temperature_c type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->pack_current_a) == 4U, "pack_current_a type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->pack_temperature_max_c) == 4U, "pack_temperature_max_c type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->pack_temperature_min_c) == 4U, "pack_temperature_min_c type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->pack_voltage_v) == 4U, "pack_voltage_v type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->state_of_charge_pct) == 4U, "state_of_charge_pct type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->state_of_health_pct) == 4U, "state_of_health_pct type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->max_cell_mv) == 2U, "max_cell_mv type changed, regenerate the CAN program");
+static_assert(sizeof(((uart_bms_live_data_t *)0)->min_cell_mv) == 2U, "min_cell_mv type changed, regenerate the CAN program");
+
+#define CAN_PROGRAM_FRAME_COUNT 3U
+
+static const can_program_op_t s_can_program_ops[] = {
+    // 0x355 SOC/SOH/High res SOC
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, state_of_charge_pct), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 0U, .bit_width = 16U, .offset = 0.0f, .scale = 1.0f, .min = 0, .max = 100}, // SOC
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, state_of_health_pct), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 16U, .bit_width = 16U, .offset = 0.0f, .scale = 1.0f, .min = 0, .max = 100}, // SOH
+    {.source_offset = 0x002EU, .source = CAN_PROGRAM_SOURCE_REG_U32, .bit_offset = 32U, .bit_width = 16U, .offset = 0.0f, .scale = 0.0001f, .min = 0, .max = 10000}, // High res SOC
+    // 0x356 Voltage/Current/Temp
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, pack_voltage_v), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 0U, .bit_width = 16U, .offset = 0.0f, .scale = 100.0f, .min = 0, .max = 65535}, // Voltage
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, pack_current_a), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 16U, .bit_width = 16U, .offset = 0.0f, .scale = 10.0f, .min = -32768, .max = 32767}, // Current
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, mosfet_temperature_c), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 32U, .bit_width = 16U, .offset = 0.0f, .scale = 10.0f, .min = -32768, .max = 32767}, // Temp
+    // 0x373 Min cell V/Max cell V/Min temp/Max temp
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, min_cell_mv), .source = CAN_PROGRAM_SOURCE_U16, .bit_offset = 0U, .bit_width = 16U, .offset = 0.0f, .scale = 1.0f, .min = 0, .max = 65535}, // Min cell V
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, max_cell_mv), .source = CAN_PROGRAM_SOURCE_U16, .bit_offset = 16U, .bit_width = 16U, .offset = 0.0f, .scale = 1.0f, .min = 0, .max = 65535}, // Max cell V
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, pack_temperature_min_c), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 32U, .bit_width = 16U, .offset = 273.15f, .scale = 1.0f, .min = 0, .max = 65535}, // Min temp
+    {.source_offset = (uint16_t)offsetof(uart_bms_live_data_t, pack_temperature_max_c), .source = CAN_PROGRAM_SOURCE_F32, .bit_offset = 48U, .bit_width = 16U, .offset = 273.15f, .scale = 1.0f, .min = 0, .max = 65535}, // Max temp
+};
+
+static const can_program_frame_t s_can_program_frames[CAN_PROGRAM_FRAME_COUNT] = {
+    {.can_id = 0x355U, .first_op = 0U, .op_count = 3U},
+    {.can_id = 0x356U, .first_op = 3U, .op_count = 3U},
+    {.can_id = 0x373U, .first_op = 6U, .op_count = 4U},
+};
+
+// Channel registry rows, expanded in conversion_table.c
+#define CAN_PROGRAM_CHANNELS(fill) \
+    {.pgn = 0x355U, .can_id = 0x355U, .dlc = 8, .fill_fn = (fill), .description = "Victron SOC/SOH/High res SOC", .period_ms = 1000U, .inputs = CAN_PUBLISHER_INPUT_LIVE}, \
+    {.pgn = 0x356U, .can_id = 0x356U, .dlc = 8, .fill_fn = (fill), .description = "Victron Voltage/Current/Temp", .period_ms = 1000U, .inputs = CAN_PUBLISHER_INPUT_LIVE}, \
+    {.pgn = 0x373U, .can_id = 0x373U, .dlc = 8, .fill_fn = (fill), .description = "Victron Min cell V/Max cell V/Min temp/Max temp", .period_ms = 1000U, .inputs = CAN_PUBLISHER_INPUT_LIVE},
@@ -22,6 +22,7 @@
 
 #include "conversion_table.h"
 
+#include <assert.h>
 #include <float.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -42,6 +43,8 @@
 #include "cvl_controller.h"
 #include "storage/nvs_energy.h"
 #include "can_config_defaults.h"
+#include "uart_bms_protocol.h"
+#include "conversion_program_generated.h"
 
 // =============================================================================
 // VICTRON CAN PROTOCOL DEFINITIONS
@@ -82,10 +85,14 @@ static const char *TAG = "can_conv";
 // These variables track cumulative energy in/out and are protected by s_energy_mutex
 // to prevent race conditions between BMS updates and CAN frame encoding.
 
-static double s_energy_charged_wh = 0.0;
-static double s_energy_discharged_wh = 0.0;
-static double s_energy_last_persist_charged_wh = 0.0;
-static double s_energy_last_persist_discharged_wh = 0.0;
+// Fixed-point accumulators: whole mWh plus a sub-mWh remainder in nJ
+// (always below NVS_ENERGY_NJ_PER_MWH), integrated from mV x mA x ms.
+static uint64_t s_energy_charged_mwh = 0;
+static uint64_t s_energy_discharged_mwh = 0;
+static uint64_t s_energy_charged_remainder_nj = 0;
+static uint64_t s_energy_discharged_remainder_nj = 0;
+static uint64_t s_energy_last_persist_charged_mwh = 0;
+static uint64_t s_energy_last_persist_discharged_mwh = 0;
 static uint64_t s_energy_last_timestamp_ms = 0;
 static uint64_t s_energy_last_persist_ms = 0;
 static bool s_energy_dirty = false;
@@ -94,6 +101,8 @@ static bool s_energy_storage_ready = false;
 // Mutex to protect energy counter access
 static SemaphoreHandle_t s_energy_mutex = NULL;
 
+static void update_energy_counters(const uart_bms_live_data_t *data);
+
 static const config_manager_can_settings_t *conversion_get_can_settings(void)
 {
     static const config_manager_can_settings_t defaults = {
@@ -122,8 +131,15 @@ static const config_manager_can_settings_t *conversion_get_can_settings(void)
     return (settings != NULL) ? settings : &defaults;
 }
 
-#define ENERGY_PERSIST_MIN_DELTA_WH   10.0
-#define ENERGY_PERSIST_INTERVAL_MS    60000U
+#define ENERGY_PERSIST_MIN_DELTA_MWH  10000U
+#define ENERGY_PERSIST_INTERVAL_MS    300000U
+
+// Bounds keeping the fixed-point integrator inside uint64_t:
+// 1000 V x 2000 A x 1 h stays below 2^64 nJ.
+#define ENERGY_MAX_WH                 1.0e12
+#define ENERGY_MAX_INPUT_V            1000.0f
+#define ENERGY_MAX_INPUT_A            2000.0f
+#define ENERGY_MAX_INTEGRATION_MS     3600000U
 
 #define TINY_REGISTER_BATTERY_CAPACITY 0x0132U
 #define TINY_REGISTER_HARDWARE_VERSION 0x01F4U
@@ -163,23 +179,50 @@ static bool ensure_energy_storage_ready(void)
     return true;
 }
 
-static void set_energy_state_internal(double charged_wh, double discharged_wh, bool persisted)
+static void energy_from_wh(double wh, uint64_t *mwh, uint64_t *remainder_nj)
 {
-    if (!(charged_wh > 0.0) || !isfinite(charged_wh)) {
-        charged_wh = 0.0;
+    *mwh = 0;
+    *remainder_nj = 0;
+    if (!(wh > 0.0) || !isfinite(wh)) {
+        return;
     }
-    if (!(discharged_wh > 0.0) || !isfinite(discharged_wh)) {
-        discharged_wh = 0.0;
+    if (wh > ENERGY_MAX_WH) {
+        wh = ENERGY_MAX_WH;
     }
 
+    double total_mwh = wh * 1000.0;
+    double whole = floor(total_mwh);
+    uint64_t remainder = (uint64_t)((total_mwh - whole) * (double)NVS_ENERGY_NJ_PER_MWH);
+    *mwh = (uint64_t)whole;
+    *remainder_nj = (remainder < NVS_ENERGY_NJ_PER_MWH) ? remainder : (NVS_ENERGY_NJ_PER_MWH - 1U);
+}
+
+static double energy_to_wh(uint64_t mwh, uint64_t remainder_nj)
+{
+    return ((double)mwh + (double)remainder_nj / (double)NVS_ENERGY_NJ_PER_MWH) / 1000.0;
+}
+
+static void energy_accumulate(uint64_t *mwh, uint64_t *remainder_nj, uint64_t energy_nj)
+{
+    // remainder < NJ_PER_MWH, so the sum only overflows for absurd inputs
+    // already rejected by update_energy_counters().
+    uint64_t total_nj = *remainder_nj + energy_nj;
+    *mwh += total_nj / NVS_ENERGY_NJ_PER_MWH;
+    *remainder_nj = total_nj % NVS_ENERGY_NJ_PER_MWH;
+}
+
+static void set_energy_state_internal(const nvs_energy_state_t *state, bool persisted)
+{
     if (s_energy_mutex != NULL && xSemaphoreTake(s_energy_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        s_energy_charged_wh = charged_wh;
-        s_energy_discharged_wh = discharged_wh;
+        s_energy_charged_mwh = state->charged_mwh;
+        s_energy_discharged_mwh = state->discharged_mwh;
+        s_energy_charged_remainder_nj = state->charged_remainder_nj % NVS_ENERGY_NJ_PER_MWH;
+        s_energy_discharged_remainder_nj = state->discharged_remainder_nj % NVS_ENERGY_NJ_PER_MWH;
         s_energy_last_timestamp_ms = 0;
 
         if (persisted) {
-            s_energy_last_persist_charged_wh = charged_wh;
-            s_energy_last_persist_discharged_wh = discharged_wh;
+            s_energy_last_persist_charged_mwh = state->charged_mwh;
+            s_energy_last_persist_discharged_mwh = state->discharged_mwh;
             s_energy_dirty = false;
         } else {
             s_energy_dirty = true;
@@ -191,16 +234,32 @@ static void set_energy_state_internal(double charged_wh, double discharged_wh, b
     }
 }
 
+static bool snapshot_energy_state(nvs_energy_state_t *state)
+{
+    if (s_energy_mutex == NULL || xSemaphoreTake(s_energy_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+
+    state->charged_mwh = s_energy_charged_mwh;
+    state->discharged_mwh = s_energy_discharged_mwh;
+    state->charged_remainder_nj = (uint32_t)s_energy_charged_remainder_nj;
+    state->discharged_remainder_nj = (uint32_t)s_energy_discharged_remainder_nj;
+
+    xSemaphoreGive(s_energy_mutex);
+    return true;
+}
+
 static esp_err_t persist_energy_state_internal(void)
 {
     if (!ensure_energy_storage_ready()) {
         return ESP_FAIL;
     }
 
-    nvs_energy_state_t state = {
-        .charged_wh = (s_energy_charged_wh > 0.0) ? s_energy_charged_wh : 0.0,
-        .discharged_wh = (s_energy_discharged_wh > 0.0) ? s_energy_discharged_wh : 0.0,
-    };
+    nvs_energy_state_t state = {0};
+    if (!snapshot_energy_state(&state)) {
+        ESP_LOGW(TAG, "Failed to acquire energy mutex in persist_energy_state_internal");
+        return ESP_ERR_TIMEOUT;
+    }
 
     esp_err_t err = nvs_energy_store(&state);
     if (err != ESP_OK) {
@@ -208,15 +267,16 @@ static esp_err_t persist_energy_state_internal(void)
         return err;
     }
 
-    s_energy_last_persist_charged_wh = state.charged_wh;
-    s_energy_last_persist_discharged_wh = state.discharged_wh;
+    s_energy_last_persist_charged_mwh = state.charged_mwh;
+    s_energy_last_persist_discharged_mwh = state.discharged_mwh;
     s_energy_dirty = false;
     return ESP_OK;
 }
 
 void can_publisher_conversion_reset_state(void)
 {
-    set_energy_state_internal(0.0, 0.0, true);
+    const nvs_energy_state_t zero = {0};
+    set_energy_state_internal(&zero, true);
     s_energy_last_persist_ms = 0;
 
     if (ensure_energy_storage_ready()) {
@@ -242,16 +302,26 @@ void can_publisher_conversion_ingest_sample(const uart_bms_live_data_t *sample)
 
 void can_publisher_conversion_set_energy_state(double charged_wh, double discharged_wh)
 {
-    set_energy_state_internal(charged_wh, discharged_wh, false);
+    uint64_t charged_remainder = 0;
+    uint64_t discharged_remainder = 0;
+    nvs_energy_state_t state = {0};
+    energy_from_wh(charged_wh, &state.charged_mwh, &charged_remainder);
+    energy_from_wh(discharged_wh, &state.discharged_mwh, &discharged_remainder);
+    state.charged_remainder_nj = (uint32_t)charged_remainder;
+    state.discharged_remainder_nj = (uint32_t)discharged_remainder;
+    set_energy_state_internal(&state, false);
 }
 
 void can_publisher_conversion_get_energy_state(double *charged_wh, double *discharged_wh)
 {
+    nvs_energy_state_t state = {0};
+    (void)snapshot_energy_state(&state);
+
     if (charged_wh != NULL) {
-        *charged_wh = s_energy_charged_wh;
+        *charged_wh = energy_to_wh(state.charged_mwh, state.charged_remainder_nj);
     }
     if (discharged_wh != NULL) {
-        *discharged_wh = s_energy_discharged_wh;
+        *discharged_wh = energy_to_wh(state.discharged_mwh, state.discharged_remainder_nj);
     }
 }
 
@@ -264,12 +334,12 @@ esp_err_t can_publisher_conversion_restore_energy_state(void)
     nvs_energy_state_t state = {0};
     esp_err_t err = nvs_energy_load(&state);
     if (err == ESP_OK) {
-        set_energy_state_internal(state.charged_wh, state.discharged_wh, true);
+        set_energy_state_internal(&state, true);
         s_energy_last_persist_ms = 0;
         ESP_LOGI(TAG,
-                 "Restored energy counters charged=%.1f Wh discharged=%.1f Wh",
-                 state.charged_wh,
-                 state.discharged_wh);
+                 "Restored energy counters charged=%" PRIu64 " mWh discharged=%" PRIu64 " mWh",
+                 state.charged_mwh,
+                 state.discharged_mwh);
     } else if (err != ESP_ERR_NOT_FOUND) {
         ESP_LOGW(TAG, "Failed to load energy counters: %s", esp_err_to_name(err));
     }
@@ -301,9 +371,9 @@ static void maybe_persist_energy(uint64_t timestamp_ms)
         }
     }
 
-    double delta_in = fabs(s_energy_charged_wh - s_energy_last_persist_charged_wh);
-    double delta_out = fabs(s_energy_discharged_wh - s_energy_last_persist_discharged_wh);
-    if (delta_in < ENERGY_PERSIST_MIN_DELTA_WH && delta_out < ENERGY_PERSIST_MIN_DELTA_WH) {
+    uint64_t delta_in = s_energy_charged_mwh - s_energy_last_persist_charged_mwh;
+    uint64_t delta_out = s_energy_discharged_mwh - s_energy_last_persist_discharged_mwh;
+    if (delta_in < ENERGY_PERSIST_MIN_DELTA_MWH && delta_out < ENERGY_PERSIST_MIN_DELTA_MWH) {
         return;
     }
 
@@ -365,16 +435,6 @@ static uint16_t encode_u16_scaled(float value, float scale, float offset, uint16
     return (uint16_t)rounded;
 }
 
-static int16_t encode_i16_scaled(float value, float scale)
-{
-    double scaled = (double)value * (double)scale;
-    if (!isfinite(scaled)) {
-        return 0;
-    }
-    long rounded = lrint(scaled);
-    return clamp_i16((int32_t)rounded);
-}
-
 static uint8_t encode_2bit_field(uint8_t current, size_t index, uint8_t level)
 {
     size_t shift = (index & 0x3U) * 2U;
@@ -439,6 +499,15 @@ static bool find_register_value(const uart_bms_live_data_t *data, uint16_t addre
         return false;
     }
 
+    // Decoded samples keep register words in poll order: the direct-mapped poll
+    // index is the slot, so the common path is a single table access.
+    size_t slot = uart_bms_protocol_poll_index(address);
+    if (slot < data->register_count && data->registers[slot].address == address) {
+        *out_value = data->registers[slot].raw_value;
+        return true;
+    }
+
+    // Hand-built or truncated samples may list registers in any order.
     for (size_t i = 0; i < data->register_count; ++i) {
         if (data->registers[i].address == address) {
             *out_value = data->registers[i].raw_value;
@@ -536,16 +605,13 @@ static void copy_ascii_padded(uint8_t *dest, size_t length, const char *source,
     }
 }
 
-static uint32_t encode_energy_wh(double energy_wh)
+// Victron reports energy in 100 Wh units, rounded to nearest
+static uint32_t encode_energy_mwh(uint64_t energy_mwh)
 {
-    if (!(energy_wh > 0.0)) {
-        return 0U;
-    }
+    uint64_t scaled = (energy_mwh + 50000U) / 100000U;
+    return (scaled > UINT32_MAX) ? UINT32_MAX : (uint32_t)scaled;
+}
 
-    double scaled = energy_wh / 100.0;
-    if (!isfinite(scaled) || scaled < 0.0) {
-        return 0U;
-    }
 // =============================================================================
 // VICTRON PGN ENCODERS
 // =============================================================================
@@ -554,12 +620,6 @@ static uint32_t encode_energy_wh(double energy_wh)
 // Most encoders are thread-safe as they only read from the input data parameter.
 // Exception: encode_energy_counters() uses mutex-protected energy counters.
 
-    if (scaled > 4294967295.0) {
-        scaled = 4294967295.0;
-    }
-    return (uint32_t)(scaled + 0.5);
-}
-
 static bool encode_battery_identification(const uart_bms_live_data_t *data,
                                           can_publisher_frame_t *frame)
 {
@@ -621,12 +681,16 @@ static void update_energy_counters(const uart_bms_live_data_t *data)
         return;
     }
 
-    // Validate input data before acquiring mutex
-    double voltage = (double)data->pack_voltage_v;
-    double current = (double)data->pack_current_a;
-    if (!isfinite(voltage) || !isfinite(current) || voltage <= 0.1) {
+    // Validate input data before acquiring mutex, then scale once to mV/mA
+    float voltage = data->pack_voltage_v;
+    float current = data->pack_current_a;
+    if (!isfinite(voltage) || !isfinite(current) || voltage <= 0.1f ||
+        fabsf(voltage) > ENERGY_MAX_INPUT_V || fabsf(current) > ENERGY_MAX_INPUT_A) {
         return;
     }
+    int64_t voltage_mv = (int64_t)lroundf(voltage * 1000.0f);
+    int64_t current_ma = (int64_t)lroundf(current * 1000.0f);
+    int64_t power_uw = voltage_mv * current_ma;
 
     // Acquire mutex for all energy counter modifications
     if (xSemaphoreTake(s_energy_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
@@ -653,25 +717,24 @@ static void update_energy_counters(const uart_bms_live_data_t *data)
     if (delta_ms > 60000U) {
         ESP_LOGW(TAG, "Energy integration gap %" PRIu64 " ms", delta_ms);
     }
-
-    double hours = (double)delta_ms / 3600000.0;
-    double power_w = voltage * current;
-    if (power_w >= 0.0) {
-        s_energy_charged_wh += power_w * hours;
-    } else {
-        s_energy_discharged_wh += (-power_w) * hours;
+    if (delta_ms > ENERGY_MAX_INTEGRATION_MS) {
+        delta_ms = ENERGY_MAX_INTEGRATION_MS;
     }
 
-    if (s_energy_charged_wh < 0.0) {
-        s_energy_charged_wh = 0.0;
-    }
-    if (s_energy_discharged_wh < 0.0) {
-        s_energy_discharged_wh = 0.0;
+    // uW x ms = nJ
+    if (power_uw >= 0) {
+        energy_accumulate(&s_energy_charged_mwh,
+                          &s_energy_charged_remainder_nj,
+                          (uint64_t)power_uw * delta_ms);
+    } else {
+        energy_accumulate(&s_energy_discharged_mwh,
+                          &s_energy_discharged_remainder_nj,
+                          (uint64_t)(-power_uw) * delta_ms);
     }
 
-    double delta_in = fabs(s_energy_charged_wh - s_energy_last_persist_charged_wh);
-    double delta_out = fabs(s_energy_discharged_wh - s_energy_last_persist_discharged_wh);
-    if (delta_in >= ENERGY_PERSIST_MIN_DELTA_WH || delta_out >= ENERGY_PERSIST_MIN_DELTA_WH) {
+    uint64_t delta_in = s_energy_charged_mwh - s_energy_last_persist_charged_mwh;
+    uint64_t delta_out = s_energy_discharged_mwh - s_energy_last_persist_discharged_mwh;
+    if (delta_in >= ENERGY_PERSIST_MIN_DELTA_MWH || delta_out >= ENERGY_PERSIST_MIN_DELTA_MWH) {
         s_energy_dirty = true;
     }
 
@@ -680,6 +743,36 @@ static void update_energy_counters(const uart_bms_live_data_t *data)
     maybe_persist_energy(current_ts);
 }
 
+void can_publisher_conversion_capture_identity(const uart_bms_live_data_t *sample,
+                                               can_publisher_identity_inputs_t *out_inputs)
+{
+    if (out_inputs == NULL) {
+        return;
+    }
+
+    // Zero the whole struct, padding included, so snapshots compare with memcmp().
+    memset(out_inputs, 0, sizeof(*out_inputs));
+    if (sample == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < CAN_PUBLISHER_IDENTITY_REGISTER_COUNT; ++i) {
+        uint16_t address = (uint16_t)(CAN_PUBLISHER_IDENTITY_REGISTER_BASE + (uint16_t)i);
+        if (find_register_value(sample, address, &out_inputs->registers[i])) {
+            out_inputs->register_present_mask |= (uint16_t)(1U << i);
+        }
+    }
+
+    out_inputs->internal_firmware_version = sample->internal_firmware_version;
+    out_inputs->hardware_version = sample->hardware_version;
+    out_inputs->hardware_changes_version = sample->hardware_changes_version;
+    out_inputs->firmware_version = sample->firmware_version;
+    out_inputs->firmware_flags = sample->firmware_flags;
+    out_inputs->battery_capacity_ah = sample->battery_capacity_ah;
+    memcpy(out_inputs->serial_number, sample->serial_number, sizeof(out_inputs->serial_number));
+    out_inputs->serial_length = sample->serial_length;
+}
+
 static const char *resolve_manufacturer_string(const uart_bms_live_data_t *data)
 {
     static char buffer[17];
@@ -868,68 +961,6 @@ static bool encode_charge_limits(const uart_bms_live_data_t *data, can_publisher
     return true;
 }
 
-static bool encode_soc_soh(const uart_bms_live_data_t *data, can_publisher_frame_t *frame)
-{
-    if (data == NULL || frame == NULL) {
-        return false;
-    }
-
-    memset(frame->data, 0, sizeof(frame->data));
-
-    uint16_t soc_raw = encode_u16_scaled(data->state_of_charge_pct, 1.0f, 0.0f, 0U, 100U);
-    uint16_t soh_raw = encode_u16_scaled(data->state_of_health_pct, 1.0f, 0.0f, 0U, 100U);
-
-    frame->data[0] = (uint8_t)(soc_raw & 0xFFU);
-    frame->data[1] = (uint8_t)((soc_raw >> 8U) & 0xFFU);
-    frame->data[2] = (uint8_t)(soh_raw & 0xFFU);
-    frame->data[3] = (uint8_t)((soh_raw >> 8U) & 0xFFU);
-
-    uint16_t soc_register_words[2] = {0};
-    if (read_register_block(data, 0x002EU, 2U, soc_register_words) == 2U) {
-        uint32_t soc_register_raw = (uint32_t)soc_register_words[0] |
-                                    ((uint32_t)soc_register_words[1] << 16U);
-        double high_res_scaled = (double)soc_register_raw * 0.0001;
-        long high_res_rounded = lrint(high_res_scaled);
-
-        uint16_t high_res_value = 0U;
-        if (high_res_rounded <= 0L) {
-            high_res_value = 0U;
-        } else if (high_res_rounded >= 10000L) {
-            high_res_value = 10000U;
-        } else {
-            high_res_value = (uint16_t)high_res_rounded;
-        }
-
-        frame->data[4] = (uint8_t)(high_res_value & 0xFFU);
-        frame->data[5] = (uint8_t)((high_res_value >> 8U) & 0xFFU);
-    }
-
-    return true;
-}
-
-static bool encode_voltage_current_temperature(const uart_bms_live_data_t *data,
-                                               can_publisher_frame_t *frame)
-{
-    if (data == NULL || frame == NULL) {
-        return false;
-    }
-
-    memset(frame->data, 0, sizeof(frame->data));
-
-    uint16_t voltage_raw = encode_u16_scaled(data->pack_voltage_v, 100.0f, 0.0f, 0U, 0xFFFFU);
-    int16_t current_raw = encode_i16_scaled(data->pack_current_a, 10.0f);
-    int16_t temperature_raw = encode_i16_scaled(data->mosfet_temperature_c, 10.0f);
-
-    frame->data[0] = (uint8_t)(voltage_raw & 0xFFU);
-    frame->data[1] = (uint8_t)((voltage_raw >> 8U) & 0xFFU);
-    frame->data[2] = (uint8_t)(current_raw & 0xFFU);
-    frame->data[3] = (uint8_t)((current_raw >> 8U) & 0xFFU);
-    frame->data[4] = (uint8_t)(temperature_raw & 0xFFU);
-    frame->data[5] = (uint8_t)((temperature_raw >> 8U) & 0xFFU);
-
-    return true;
-}
-
 static bool encode_alarm_status(const uart_bms_live_data_t *data, can_publisher_frame_t *frame)
 {
     if (data == NULL || frame == NULL) {
@@ -1133,33 +1164,6 @@ static bool encode_module_status_counts(const uart_bms_live_data_t *data, can_pu
     return true;
 }
 
-static bool encode_cell_voltage_temperature_extremes(const uart_bms_live_data_t *data,
-                                                     can_publisher_frame_t *frame)
-{
-    if (data == NULL || frame == NULL) {
-        return false;
-    }
-
-    memset(frame->data, 0, sizeof(frame->data));
-
-    uint16_t min_mv = data->min_cell_mv;
-    uint16_t max_mv = data->max_cell_mv;
-
-    uint16_t min_k = encode_u16_scaled(data->pack_temperature_min_c, 1.0f, 273.15f, 0U, 0xFFFFU);
-    uint16_t max_k = encode_u16_scaled(data->pack_temperature_max_c, 1.0f, 273.15f, 0U, 0xFFFFU);
-
-    frame->data[0] = (uint8_t)(min_mv & 0xFFU);
-    frame->data[1] = (uint8_t)((min_mv >> 8U) & 0xFFU);
-    frame->data[2] = (uint8_t)(max_mv & 0xFFU);
-    frame->data[3] = (uint8_t)((max_mv >> 8U) & 0xFFU);
-    frame->data[4] = (uint8_t)(min_k & 0xFFU);
-    frame->data[5] = (uint8_t)((min_k >> 8U) & 0xFFU);
-    frame->data[6] = (uint8_t)(max_k & 0xFFU);
-    frame->data[7] = (uint8_t)((max_k >> 8U) & 0xFFU);
-
-    return true;
-}
-
 static void encode_identifier_string(const char *text, can_publisher_frame_t *frame)
 {
     memset(frame->data, 0, sizeof(frame->data));
@@ -1260,19 +1264,13 @@ static bool encode_energy_counters(const uart_bms_live_data_t *data, can_publish
     memset(frame->data, 0, sizeof(frame->data));
 
     // Read energy counters with mutex protection
-    double charged_wh = 0.0;
-    double discharged_wh = 0.0;
-
-    if (s_energy_mutex != NULL && xSemaphoreTake(s_energy_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        charged_wh = s_energy_charged_wh;
-        discharged_wh = s_energy_discharged_wh;
-        xSemaphoreGive(s_energy_mutex);
-    } else {
+    nvs_energy_state_t state = {0};
+    if (!snapshot_energy_state(&state)) {
         ESP_LOGW(TAG, "Failed to acquire energy mutex in encode_energy_counters");
     }
 
-    uint32_t energy_in_raw = encode_energy_wh(charged_wh);
-    uint32_t energy_out_raw = encode_energy_wh(discharged_wh);
+    uint32_t energy_in_raw = encode_energy_mwh(state.charged_mwh);
+    uint32_t energy_out_raw = encode_energy_mwh(state.discharged_mwh);
 
     frame->data[0] = (uint8_t)(energy_in_raw & 0xFFU);
     frame->data[1] = (uint8_t)((energy_in_raw >> 8U) & 0xFFU);
@@ -1332,6 +1330,82 @@ static bool encode_battery_family(const uart_bms_live_data_t *data, can_publishe
     const char *resolved = resolve_battery_family_string(data);
     return encode_ascii_field(data, resolved, TINY_REGISTER_BATTERY_FAMILY, 0U, frame);
 }
+// =============================================================================
+// TABLE-DRIVEN ENCODER
+// =============================================================================
+// Linear PGNs are described by conversion_program_generated.h (generated from
+// docs/UART_CAN_mapping.json by tools/gen_can_program.py) and encoded here.
+
+static const can_program_frame_t *find_program_frame(uint32_t can_id)
+{
+    for (size_t i = 0; i < CAN_PROGRAM_FRAME_COUNT; ++i) {
+        if (s_can_program_frames[i].can_id == can_id) {
+            return &s_can_program_frames[i];
+        }
+    }
+    return NULL;
+}
+
+static bool encode_program_frame(const uart_bms_live_data_t *data, can_publisher_frame_t *frame)
+{
+    if (data == NULL || frame == NULL) {
+        return false;
+    }
+
+    const can_program_frame_t *program = find_program_frame(frame->id);
+    if (program == NULL) {
+        return false;
+    }
+
+    const uint8_t *base = (const uint8_t *)data;
+    const can_program_op_t *op = &s_can_program_ops[program->first_op];
+    uint64_t payload = 0;
+
+    for (uint8_t i = 0; i < program->op_count; ++i, ++op) {
+        double value = 0.0;
+        switch (op->source) {
+            case CAN_PROGRAM_SOURCE_F32: {
+                float field;
+                memcpy(&field, base + op->source_offset, sizeof(field));
+                value = (double)field;
+                break;
+            }
+            case CAN_PROGRAM_SOURCE_U16: {
+                uint16_t field;
+                memcpy(&field, base + op->source_offset, sizeof(field));
+                value = (double)field;
+                break;
+            }
+            case CAN_PROGRAM_SOURCE_REG_U32: {
+                uint16_t words[2];
+                if (read_register_block(data, op->source_offset, 2U, words) != 2U) {
+                    continue;
+                }
+                value = (double)((uint32_t)words[0] | ((uint32_t)words[1] << 16U));
+                break;
+            }
+            default:
+                continue;
+        }
+
+        double scaled = (value + (double)op->offset) * (double)op->scale;
+        long rounded = isfinite(scaled) ? lrint(scaled) : 0L;
+        if (rounded < (long)op->min) {
+            rounded = op->min;
+        } else if (rounded > (long)op->max) {
+            rounded = op->max;
+        }
+
+        uint64_t mask = (op->bit_width >= 32U) ? 0xFFFFFFFFULL : ((1ULL << op->bit_width) - 1ULL);
+        payload |= ((uint64_t)(uint32_t)(int32_t)rounded & mask) << op->bit_offset;
+    }
+
+    for (size_t i = 0; i < sizeof(frame->data); ++i) {
+        frame->data[i] = (uint8_t)(payload >> (8U * i));
+    }
+    return true;
+}
+
 // =============================================================================
 // CAN CHANNEL REGISTRY
 // =============================================================================
@@ -1350,23 +1424,11 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_charge_limits,
         .description = "Victron charge/discharge limits",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
+        .priority = CAN_PUBLISHER_PRIORITY_CRITICAL,
     },
-    {
-        .pgn = VICTRON_PGN_SOC_SOH,
-        .can_id = VICTRON_PGN_SOC_SOH,
-        .dlc = 8,
-        .fill_fn = encode_soc_soh,
-        .description = "Victron SOC/SOH",
-        .period_ms = 1000U,
-    },
-    {
-        .pgn = VICTRON_PGN_VOLTAGE_CURRENT,
-        .can_id = VICTRON_PGN_VOLTAGE_CURRENT,
-        .dlc = 8,
-        .fill_fn = encode_voltage_current_temperature,
-        .description = "Victron voltage/current/temperature",
-        .period_ms = 1000U,
-    },
+    // 0x355 SOC/SOH, 0x356 voltage/current/temperature, 0x373 cell extremes
+    CAN_PROGRAM_CHANNELS(encode_program_frame)
     {
         .pgn = VICTRON_PGN_ALARMS,
         .can_id = VICTRON_PGN_ALARMS,
@@ -1374,6 +1436,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_alarm_status,
         .description = "Victron alarm summary",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
+        .priority = CAN_PUBLISHER_PRIORITY_CRITICAL,
     },
     {
         .pgn = VICTRON_PGN_MANUFACTURER,
@@ -1382,6 +1446,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_manufacturer_string,
         .description = "Victron manufacturer string",
         .period_ms = 2000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY | CAN_PUBLISHER_INPUT_CONFIG,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_BATTERY_INFO,
@@ -1390,6 +1456,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_battery_identification,
         .description = "Victron battery identification",
         .period_ms = 2000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_BMS_NAME_PART1,
@@ -1398,6 +1466,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_battery_name_part1,
         .description = "Victron battery info part 1",
         .period_ms = 2000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY | CAN_PUBLISHER_INPUT_CONFIG,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_BMS_NAME_PART2,
@@ -1406,6 +1476,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_battery_name_part2,
         .description = "Victron battery info part 2",
         .period_ms = 2000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY | CAN_PUBLISHER_INPUT_CONFIG,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_MODULE_STATUS,
@@ -1414,14 +1486,7 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_module_status_counts,
         .description = "Victron module status counts",
         .period_ms = 1000U,
-    },
-    {
-        .pgn = VICTRON_PGN_CELL_EXTREMES,
-        .can_id = VICTRON_PGN_CELL_EXTREMES,
-        .dlc = 8,
-        .fill_fn = encode_cell_voltage_temperature_extremes,
-        .description = "Victron cell voltage & temperature extremes",
-        .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
     },
     {
         .pgn = VICTRON_PGN_MIN_CELL_ID,
@@ -1430,6 +1495,7 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_min_cell_identifier,
         .description = "Victron min cell identifier",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
     },
     {
         .pgn = VICTRON_PGN_MAX_CELL_ID,
@@ -1438,6 +1504,7 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_max_cell_identifier,
         .description = "Victron max cell identifier",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
     },
     {
         .pgn = VICTRON_PGN_MIN_TEMP_ID,
@@ -1446,6 +1513,7 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_min_temp_identifier,
         .description = "Victron min temperature identifier",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
     },
     {
         .pgn = VICTRON_PGN_MAX_TEMP_ID,
@@ -1454,6 +1522,7 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_max_temp_identifier,
         .description = "Victron max temperature identifier",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
     },
     {
         .pgn = VICTRON_PGN_ENERGY_COUNTERS,
@@ -1462,6 +1531,7 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_energy_counters,
         .description = "Victron energy counters",
         .period_ms = 1000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
     },
     {
         .pgn = VICTRON_PGN_INSTALLED_CAP,
@@ -1470,6 +1540,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_installed_capacity,
         .description = "Victron installed capacity",
         .period_ms = 5000U,
+        .inputs = CAN_PUBLISHER_INPUT_LIVE,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_SERIAL_PART1,
@@ -1478,6 +1550,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_serial_number_part1,
         .description = "Victron serial number part 1",
         .period_ms = 5000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY | CAN_PUBLISHER_INPUT_CONFIG,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_SERIAL_PART2,
@@ -1486,6 +1560,8 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_serial_number_part2,
         .description = "Victron serial number part 2",
         .period_ms = 5000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY | CAN_PUBLISHER_INPUT_CONFIG,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
     {
         .pgn = VICTRON_PGN_BATTERY_FAMILY,
@@ -1494,8 +1570,14 @@ const can_publisher_channel_t g_can_publisher_channels[] = {
         .fill_fn = encode_battery_family,
         .description = "Victron battery family",
         .period_ms = 5000U,
+        .inputs = CAN_PUBLISHER_INPUT_IDENTITY | CAN_PUBLISHER_INPUT_CONFIG,
+        .priority = CAN_PUBLISHER_PRIORITY_LOW,
     },
 };
 
 const size_t g_can_publisher_channel_count =
     sizeof(g_can_publisher_channels) / sizeof(g_can_publisher_channels[0]);
+
+static_assert((sizeof(g_can_publisher_channels) / sizeof(g_can_publisher_channels[0])) ==
+                  CAN_PUBLISHER_MAX_BUFFER_SLOTS,
+              "CAN_PUBLISHER_MAX_BUFFER_SLOTS must match the channel table size");
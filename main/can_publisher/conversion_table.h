@@ -11,16 +11,17 @@
  *
  * **Energy Counter Protection**:
  * The module uses s_energy_mutex to protect cumulative energy counters:
- * - s_energy_charged_wh - Total energy charged (Wh)
- * - s_energy_discharged_wh - Total energy discharged (Wh)
+ * - s_energy_charged_mwh / s_energy_charged_remainder_nj - Total energy charged
+ * - s_energy_discharged_mwh / s_energy_discharged_remainder_nj - Total energy discharged
+ *   (fixed point: whole mWh plus sub-mWh remainder in nJ, integrated from mV x mA x ms)
  * - Related persistence state variables
  *
  * **Thread-Safe Functions** (mutex-protected energy operations):
  * - can_publisher_conversion_ingest_sample() - Integrate incoming TinyBMS sample
  * - can_publisher_conversion_set_energy_state() - Atomic state update
  * - can_publisher_conversion_get_energy_state() - Atomic state read
- * - can_publisher_conversion_persist_energy_state() - NVS write
- * - can_publisher_conversion_restore_energy_state() - NVS read
+ * - can_publisher_conversion_persist_energy_state() - NVS blob write (skipped when unchanged)
+ * - can_publisher_conversion_restore_energy_state() - NVS blob read
  * - Internal: update_energy_counters() - Integration calculation
  * - Internal: encode_energy_counters() - CAN frame encoding
  *
@@ -66,10 +67,36 @@
 extern "C" {
 #endif
 
+/** First TinyBMS register read by the identification encoders. */
+#define CAN_PUBLISHER_IDENTITY_REGISTER_BASE  0x01F4U
+/** Number of consecutive identification registers (0x01F4 - 0x01FF). */
+#define CAN_PUBLISHER_IDENTITY_REGISTER_COUNT 12U
+
+/**
+ * @brief Snapshot of the sample fields read by ::CAN_PUBLISHER_INPUT_IDENTITY channels.
+ *
+ * Two snapshots compare equal with memcmp() exactly when the identification
+ * encoders would produce the same frames for both samples.
+ */
+typedef struct {
+    uint16_t registers[CAN_PUBLISHER_IDENTITY_REGISTER_COUNT];
+    uint16_t register_present_mask;
+    uint16_t internal_firmware_version;
+    uint8_t hardware_version;
+    uint8_t hardware_changes_version;
+    uint8_t firmware_version;
+    uint8_t firmware_flags;
+    float battery_capacity_ah;
+    char serial_number[UART_BMS_SERIAL_NUMBER_MAX_LENGTH + 1];
+    uint8_t serial_length;
+} can_publisher_identity_inputs_t;
+
 extern const can_publisher_channel_t g_can_publisher_channels[];
 extern const size_t g_can_publisher_channel_count;
 
 void can_publisher_conversion_reset_state(void);
+void can_publisher_conversion_capture_identity(const uart_bms_live_data_t *sample,
+                                               can_publisher_identity_inputs_t *out_inputs);
 void can_publisher_conversion_ingest_sample(const uart_bms_live_data_t *sample);
 void can_publisher_conversion_set_energy_state(double charged_wh, double discharged_wh);
 void can_publisher_conversion_get_energy_state(double *charged_wh, double *discharged_wh);
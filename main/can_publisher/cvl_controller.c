@@ -8,6 +8,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "config_manager.h"
+
 #ifndef CVL_DEFAULT_SERIES_CELLS
 #define CVL_DEFAULT_SERIES_CELLS 16U
 #endif
@@ -67,6 +69,24 @@ static can_publisher_cvl_result_t s_cvl_result = {
 static bool s_cvl_has_result = false;
 static bool s_cvl_initialised = false;
 
+// Incremental evaluation: the config snapshot is rebuilt only when one of the
+// fields it derives from changes, and cvl_compute_limits() is skipped while
+// its inputs are unchanged and the previous evaluation was a fixed point.
+typedef struct {
+    uint32_t config_generation;
+    uint16_t overvoltage_cutoff_mv;
+    uint16_t series_cell_count;
+    float fallback_pack_voltage_v;
+} cvl_config_key_t;
+
+static cvl_config_key_t s_cvl_config_key;
+static cvl_config_snapshot_t s_cvl_config;
+static bool s_cvl_config_valid = false;
+static cvl_inputs_t s_cvl_last_inputs;
+static bool s_cvl_settled = false;
+static uint32_t s_cvl_evaluations = 0;
+static uint32_t s_cvl_skipped = 0;
+
 static float safe_float(float value)
 {
     if (!isfinite(value)) {
@@ -105,6 +125,10 @@ void can_publisher_cvl_init(void)
     s_cvl_result.result.imbalance_hold_active = false;
     s_cvl_result.result.cell_protection_active = false;
     s_cvl_has_result = false;
+    s_cvl_config_valid = false;
+    s_cvl_settled = false;
+    s_cvl_evaluations = 0;
+    s_cvl_skipped = 0;
     s_cvl_initialised = true;
 }
 
@@ -127,6 +151,37 @@ static cvl_config_snapshot_t cvl_controller_load_config(const uart_bms_live_data
     return config;
 }
 
+static const cvl_config_snapshot_t *cvl_controller_get_config(const uart_bms_live_data_t *data, bool *out_changed)
+{
+    cvl_config_key_t key = {
+        .config_generation = config_manager_get_generation(),
+        .overvoltage_cutoff_mv = data->overvoltage_cutoff_mv,
+        .series_cell_count = data->series_cell_count,
+        // Pack voltage only feeds the snapshot when no cutoff is reported
+        .fallback_pack_voltage_v = (data->overvoltage_cutoff_mv > 0U) ? 0.0f : data->pack_voltage_v,
+    };
+
+    *out_changed = !s_cvl_config_valid || memcmp(&key, &s_cvl_config_key, sizeof(key)) != 0;
+    if (*out_changed) {
+        s_cvl_config = cvl_controller_load_config(data);
+        s_cvl_config_key = key;
+        s_cvl_config_valid = true;
+    }
+    return &s_cvl_config;
+}
+
+// Clears the input fields cvl_compute_limits() cannot observe for the given
+// runtime state, so noise on them does not force a recomputation.
+static void cvl_controller_mask_unused_inputs(cvl_inputs_t *inputs,
+                                              const cvl_config_snapshot_t *config,
+                                              const cvl_runtime_state_t *runtime)
+{
+    inputs->pack_voltage_v = 0.0f;
+    if (!runtime->cell_protection_active && inputs->max_cell_voltage_v < config->cell_safety_threshold_v) {
+        inputs->pack_current_a = 0.0f;
+    }
+}
+
 static void cvl_controller_prepare_inputs(const uart_bms_live_data_t *data, cvl_inputs_t *inputs)
 {
     if (inputs == NULL) {
@@ -187,10 +242,31 @@ void can_publisher_cvl_prepare(const uart_bms_live_data_t *data)
 
     cvl_inputs_t inputs;
     cvl_controller_prepare_inputs(data, &inputs);
-    cvl_config_snapshot_t config = cvl_controller_load_config(data);
+    bool config_changed = false;
+    const cvl_config_snapshot_t *config = cvl_controller_get_config(data, &config_changed);
+    cvl_controller_mask_unused_inputs(&inputs, config, &s_cvl_runtime);
+
+    bool inputs_changed = memcmp(&inputs, &s_cvl_last_inputs, sizeof(inputs)) != 0;
+    if (s_cvl_has_result && s_cvl_settled && !config_changed && !inputs_changed) {
+        s_cvl_skipped++;
+        if (s_cvl_state_mutex != NULL &&
+            xSemaphoreTake(s_cvl_state_mutex, pdMS_TO_TICKS(CVL_STATE_LOCK_TIMEOUT_MS)) == pdTRUE) {
+            s_cvl_result.timestamp_ms = data->timestamp_ms;
+            xSemaphoreGive(s_cvl_state_mutex);
+        }
+        return;
+    }
 
     cvl_computation_result_t result;
-    cvl_compute_limits(&inputs, &config, &s_cvl_runtime, &result);
+    cvl_compute_limits(&inputs, config, &s_cvl_runtime, &result);
+    s_cvl_evaluations++;
+    s_cvl_last_inputs = inputs;
+
+    // Same inputs and same runtime state give the same result, so the next
+    // identical sample can reuse it.
+    s_cvl_settled = (result.state == s_cvl_runtime.state) &&
+                    (result.cvl_voltage_v == s_cvl_runtime.cvl_voltage_v) &&
+                    (result.cell_protection_active == s_cvl_runtime.cell_protection_active);
 
     if (s_cvl_state_mutex != NULL &&
         xSemaphoreTake(s_cvl_state_mutex, pdMS_TO_TICKS(CVL_STATE_LOCK_TIMEOUT_MS)) == pdTRUE) {
@@ -226,3 +302,11 @@ bool can_publisher_cvl_get_latest(can_publisher_cvl_result_t *out_result)
     return success;
 }
 
+void can_publisher_cvl_get_stats(can_publisher_cvl_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return;
+    }
+    out_stats->evaluations = s_cvl_evaluations;
+    out_stats->skipped = s_cvl_skipped;
+}
@@ -15,9 +15,18 @@ typedef struct {
     cvl_computation_result_t result;
 } can_publisher_cvl_result_t;
 
+/**
+ * @brief Incremental evaluation counters.
+ */
+typedef struct {
+    uint32_t evaluations; /**< Samples that ran cvl_compute_limits(). */
+    uint32_t skipped;     /**< Samples that reused the previous result. */
+} can_publisher_cvl_stats_t;
+
 void can_publisher_cvl_init(void);
 void can_publisher_cvl_prepare(const uart_bms_live_data_t *data);
 bool can_publisher_cvl_get_latest(can_publisher_cvl_result_t *out_result);
+void can_publisher_cvl_get_stats(can_publisher_cvl_stats_t *out_stats);
 
 #ifdef __cplusplus
 }
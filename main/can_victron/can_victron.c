@@ -1,15 +1,15 @@
 #include "can_victron.h"
+#include "can_victron_capture.h"
 
 #include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_err.h"
 #include "esp_log.h"
 #ifdef ESP_PLATFORM
-#include "driver/gpio.h"
-#include "driver/twai.h"
 #include "esp_timer.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
@@ -22,24 +22,26 @@
 #include "config_manager.h"
 #include "app_events.h"
 #include "can_config_defaults.h"
+#include "can_victron_driver.h"
+#include "can_victron_occupancy.h"
 
 #define CAN_VICTRON_EVENT_BUFFERS 4
 #define CAN_VICTRON_JSON_SIZE     256
+#define CAN_VICTRON_BATCH_JSON_SIZE 1536
 
 #define CAN_VICTRON_KEEPALIVE_ID         0x305U
 #define CAN_VICTRON_KEEPALIVE_DLC        8U
 #define CAN_VICTRON_HANDSHAKE_ID         0x307U
 #define CAN_VICTRON_TASK_STACK           4096
 #define CAN_VICTRON_TASK_PRIORITY        (tskIDLE_PRIORITY + 6)
-#define CAN_VICTRON_TASK_DELAY_MS        50U
-#define CAN_VICTRON_RX_TIMEOUT_MS        10U
+#define CAN_VICTRON_IDLE_WAIT_MS         500U
+#define CAN_VICTRON_EXIT_TIMEOUT_MS      1000U
 #define CAN_VICTRON_TX_TIMEOUT_MS        50U
 #define CAN_VICTRON_LOCK_TIMEOUT_MS      50U
-#define CAN_VICTRON_TWAI_TX_QUEUE_LEN    16
-#define CAN_VICTRON_TWAI_RX_QUEUE_LEN    16
+#define CAN_VICTRON_TX_QUEUE_LEN         16
+#define CAN_VICTRON_RX_QUEUE_LEN         16
 
-#define CAN_VICTRON_METRIC_BUFFER_SIZE   256U
-#define CAN_VICTRON_OCCUPANCY_WINDOW_MS  60000U
+#define CAN_VICTRON_OCCUPANCY_WINDOW_MS  (CAN_VICTRON_OCCUPANCY_SLOTS * 1000U)
 #define CAN_VICTRON_BITRATE_BPS          500000U
 
 // CAN configuration defaults are now centralized in can_config_defaults.h
@@ -55,20 +57,25 @@ typedef enum {
 
 static const char *TAG = "can_victron";
 
+#ifdef ESP_PLATFORM
+static const uint32_t s_occupancy_windows_s[CAN_VICTRON_OCCUPANCY_WINDOW_COUNT] = {1U, 10U, 60U};
+#endif
+
 static event_bus_publish_fn_t s_event_publisher = NULL;
 static char s_can_raw_events[CAN_VICTRON_EVENT_BUFFERS][CAN_VICTRON_JSON_SIZE];
 static char s_can_decoded_events[CAN_VICTRON_EVENT_BUFFERS][CAN_VICTRON_JSON_SIZE];
 static size_t s_next_event_slot = 0;
 static portMUX_TYPE s_event_slot_lock = portMUX_INITIALIZER_UNLOCKED;
 
-#ifdef ESP_PLATFORM
-typedef struct {
-    uint64_t timestamp;
-    uint32_t bits;
-} can_victron_metric_sample_t;
-#endif
+// TX mutex hold time, written while holding s_twai_mutex
+static uint32_t s_tx_lock_hold_last_us = 0;
+static uint32_t s_tx_lock_hold_max_us = 0;
+static uint64_t s_tx_lock_hold_total_us = 0;
+static uint32_t s_tx_lock_acquisitions = 0;
+static uint32_t s_tx_batch_count = 0;
 
 #ifdef ESP_PLATFORM
+static const can_victron_driver_t *s_driver = NULL;
 static SemaphoreHandle_t s_twai_mutex = NULL;
 static SemaphoreHandle_t s_driver_state_mutex = NULL;  // Protects s_driver_started
 static SemaphoreHandle_t s_keepalive_mutex = NULL;     // Protects keepalive variables
@@ -85,23 +92,30 @@ static uint64_t s_tx_frame_count = 0;
 static uint64_t s_rx_frame_count = 0;
 static uint64_t s_tx_byte_count = 0;
 static uint64_t s_rx_byte_count = 0;
-static can_victron_metric_sample_t s_metric_samples[CAN_VICTRON_METRIC_BUFFER_SIZE];
-static size_t s_metric_head = 0;
-static size_t s_metric_count = 0;
+static can_victron_occupancy_wheel_t s_occupancy;  // Protected by s_stats_mutex
 static uint32_t s_bus_off_count = 0;
+static uint32_t s_bus_recovery_count = 0;
 static twai_state_t s_last_twai_state = TWAI_STATE_STOPPED;
 #endif
 
 // Flag pour terminaison propre de la tâche
 static volatile bool s_task_should_exit = false;
+static volatile bool s_task_exited = false;
+static uint32_t s_rx_task_wakeups = 0;
+
+// Keepalive request (0x305 RTR) to response transmit latency, protected by s_keepalive_mutex
+static uint32_t s_keepalive_response_last_us = 0;
+static uint32_t s_keepalive_response_max_us = 0;
+static uint64_t s_keepalive_response_total_us = 0;
+static uint32_t s_keepalive_response_count = 0;
 
 static esp_err_t can_victron_start_driver(void);
 static void can_victron_stop_driver(void);
 static bool can_victron_is_driver_started(void);
-static void can_victron_send_keepalive(uint64_t now);
-static void can_victron_process_keepalive_rx(bool remote_request, uint64_t now);
+static esp_err_t can_victron_send_keepalive(uint64_t now);
+static void can_victron_process_keepalive_rx(bool remote_request, uint64_t now, int64_t rx_us);
 static void can_victron_service_keepalive(uint64_t now);
-static void can_victron_handle_rx_message(const twai_message_t *message);
+static void can_victron_handle_rx_message(const can_victron_driver_frame_t *message, int64_t rx_us);
 static void can_victron_task(void *context);
 static void can_victron_reset_stats(void);
 static void can_victron_record_frame(can_victron_direction_t direction, uint64_t timestamp, size_t dlc);
@@ -195,36 +209,25 @@ static void can_victron_reset_stats(void)
         s_rx_frame_count = 0;
         s_tx_byte_count = 0;
         s_rx_byte_count = 0;
-        s_metric_head = 0;
-        s_metric_count = 0;
-        memset(s_metric_samples, 0, sizeof(s_metric_samples));
+        can_victron_occupancy_reset(&s_occupancy);
         xSemaphoreGive(s_stats_mutex);
     } else {
         s_tx_frame_count = 0;
         s_rx_frame_count = 0;
         s_tx_byte_count = 0;
         s_rx_byte_count = 0;
-        s_metric_head = 0;
-        s_metric_count = 0;
-        memset(s_metric_samples, 0, sizeof(s_metric_samples));
+        can_victron_occupancy_reset(&s_occupancy);
     }
     s_bus_off_count = 0;
+    s_bus_recovery_count = 0;
     s_last_twai_state = TWAI_STATE_STOPPED;
 }
 
-static void can_victron_record_frame(can_victron_direction_t direction, uint64_t timestamp, size_t dlc)
+static void can_victron_record_sample_locked(can_victron_direction_t direction, uint64_t timestamp, size_t dlc)
 {
-    if (s_stats_mutex == NULL) {
-        return;
-    }
-
     uint32_t payload_bytes = (dlc > 8U) ? 8U : (uint32_t)dlc;
     uint32_t bits = 47U + payload_bytes * 8U;
 
-    if (xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
-        return;
-    }
-
     if (direction == CAN_VICTRON_DIRECTION_TX) {
         s_tx_frame_count++;
         s_tx_byte_count += payload_bytes;
@@ -233,16 +236,52 @@ static void can_victron_record_frame(can_victron_direction_t direction, uint64_t
         s_rx_byte_count += payload_bytes;
     }
 
-    size_t index = s_metric_head;
-    s_metric_samples[index].timestamp = timestamp;
-    s_metric_samples[index].bits = bits;
-    s_metric_head = (index + 1U) % CAN_VICTRON_METRIC_BUFFER_SIZE;
-    if (s_metric_count < CAN_VICTRON_METRIC_BUFFER_SIZE) {
-        s_metric_count++;
+    can_victron_occupancy_add(&s_occupancy, timestamp, bits);
+}
+
+static void can_victron_record_frame(can_victron_direction_t direction, uint64_t timestamp, size_t dlc)
+{
+    if (s_stats_mutex == NULL) {
+        return;
+    }
+
+    if (xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return;
+    }
+
+    can_victron_record_sample_locked(direction, timestamp, dlc);
+
+    xSemaphoreGive(s_stats_mutex);
+}
+
+static void can_victron_record_tx_batch(const can_victron_tx_frame_t *frames, size_t count, uint64_t timestamp)
+{
+    if (s_stats_mutex == NULL || count == 0) {
+        return;
+    }
+
+    if (xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        can_victron_record_sample_locked(CAN_VICTRON_DIRECTION_TX, timestamp, frames[i].length);
     }
 
     xSemaphoreGive(s_stats_mutex);
 }
+
+static void can_victron_record_lock_hold(int64_t start_us)
+{
+    int64_t held = esp_timer_get_time() - start_us;
+    uint32_t held_us = (held > 0) ? (uint32_t)held : 0U;
+    s_tx_lock_hold_last_us = held_us;
+    if (held_us > s_tx_lock_hold_max_us) {
+        s_tx_lock_hold_max_us = held_us;
+    }
+    s_tx_lock_hold_total_us += held_us;
+    s_tx_lock_acquisitions++;
+}
 #else
 static void can_victron_reset_stats(void)
 {
@@ -254,6 +293,13 @@ static void can_victron_record_frame(can_victron_direction_t direction, uint64_t
     (void)timestamp;
     (void)dlc;
 }
+
+static void can_victron_record_tx_batch(const can_victron_tx_frame_t *frames, size_t count, uint64_t timestamp)
+{
+    (void)frames;
+    (void)count;
+    (void)timestamp;
+}
 #endif
 
 static esp_err_t can_victron_emit_events(uint32_t can_id,
@@ -359,6 +405,126 @@ static esp_err_t can_victron_emit_events(uint32_t can_id,
     return ESP_OK;
 }
 
+static void can_victron_batch_free(void *context)
+{
+    free(context);
+}
+
+// Each batch payload is allocated on its own and freed by the bus, so a split
+// batch never overwrites a buffer a subscriber is still reading.
+static char *can_victron_batch_begin(uint64_t timestamp, size_t *offset)
+{
+    char *payload = malloc(CAN_VICTRON_BATCH_JSON_SIZE);
+    if (payload == NULL) {
+        ESP_LOGW(TAG, "No memory for CAN batch event");
+        return NULL;
+    }
+
+    *offset = 0;
+    if (!can_victron_json_append(payload,
+                                 CAN_VICTRON_BATCH_JSON_SIZE,
+                                 offset,
+                                 "{\"type\":\"can_batch\",\"direction\":\"tx\",\"timestamp_ms\":%" PRIu64 ",\"frames\":[",
+                                 timestamp)) {
+        free(payload);
+        return NULL;
+    }
+    return payload;
+}
+
+// Appends one frame object, leaving room for the closing "]}". The offset is
+// rolled back when the frame does not fit.
+static bool can_victron_batch_append(char *payload, size_t *offset, bool first, const can_victron_tx_frame_t *frame)
+{
+    const size_t limit = CAN_VICTRON_BATCH_JSON_SIZE - 2U;
+    size_t cursor = *offset;
+    const char *label = (frame->description != NULL) ? frame->description : "";
+
+    if (!can_victron_json_append(payload,
+                                 limit,
+                                 &cursor,
+                                 "%s{\"id\":\"%08" PRIX32 "\",\"dlc\":%u,\"data\":\"",
+                                 first ? "" : ",",
+                                 frame->can_id,
+                                 (unsigned)frame->length)) {
+        return false;
+    }
+    for (size_t i = 0; i < frame->length; ++i) {
+        if (!can_victron_json_append(payload, limit, &cursor, "%02X", (unsigned)frame->data[i])) {
+            return false;
+        }
+    }
+    if (!can_victron_json_append(payload, limit, &cursor, "\",\"description\":\"%s\"}", label)) {
+        return false;
+    }
+
+    *offset = cursor;
+    return true;
+}
+
+// Hands the payload over to the bus, which frees it on every path.
+static void can_victron_batch_publish(char *payload, size_t offset)
+{
+    if (!can_victron_json_append(payload, CAN_VICTRON_BATCH_JSON_SIZE, &offset, "]}")) {
+        free(payload);
+        return;
+    }
+
+    event_bus_event_t event = {
+        .id = APP_EVENT_ID_CAN_FRAME_BATCH,
+        .payload = payload,
+        .payload_size = offset + 1,
+        .dispose = can_victron_batch_free,
+        .dispose_context = payload,
+    };
+
+    if (!s_event_publisher(&event, pdMS_TO_TICKS(50))) {
+        ESP_LOGW(TAG, "Failed to publish CAN event %u", (unsigned)APP_EVENT_ID_CAN_FRAME_BATCH);
+    }
+}
+
+// One event for a whole TX batch instead of a raw and a decoded event per
+// frame. Overflowing batches are split across several events.
+static void can_victron_emit_batch_event(const can_victron_tx_frame_t *frames, size_t count, uint64_t timestamp)
+{
+    if (s_event_publisher == NULL || count == 0) {
+        return;
+    }
+
+    size_t offset = 0;
+    size_t in_payload = 0;
+    char *payload = can_victron_batch_begin(timestamp, &offset);
+    if (payload == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (frames[i].length > 8U) {
+            continue;
+        }
+        if (can_victron_batch_append(payload, &offset, in_payload == 0, &frames[i])) {
+            ++in_payload;
+            continue;
+        }
+        if (in_payload == 0) {
+            continue;  // A single frame larger than the buffer (oversized description)
+        }
+
+        can_victron_batch_publish(payload, offset);
+        payload = can_victron_batch_begin(timestamp, &offset);
+        if (payload == NULL) {
+            return;
+        }
+        in_payload = can_victron_batch_append(payload, &offset, true, &frames[i]) ? 1U : 0U;
+    }
+
+    if (in_payload > 0) {
+        can_victron_batch_publish(payload, offset);
+    } else {
+        free(payload);
+    }
+}
+
 static void can_victron_publish_demo_frames(void)
 {
     static const uint8_t k_demo_status[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
@@ -443,25 +609,23 @@ static esp_err_t can_victron_start_driver(void)
     s_twai_tx_gpio = tx_gpio;
     s_twai_rx_gpio = rx_gpio;
 
-    twai_general_config_t g_config =
-        TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)s_twai_tx_gpio,
-                                    (gpio_num_t)s_twai_rx_gpio,
-                                    TWAI_MODE_NORMAL);
-    g_config.tx_queue_len = CAN_VICTRON_TWAI_TX_QUEUE_LEN;
-    g_config.rx_queue_len = CAN_VICTRON_TWAI_RX_QUEUE_LEN;
-
-    twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
-    // Accepter toutes les trames pour éviter de filtrer les messages Victron
-    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
-
-    esp_err_t err = twai_driver_install(&g_config, &t_config, &f_config);
-    if (err != ESP_OK) {
-        return err;
-    }
+    can_victron_driver_config_t driver_config = {
+        .tx_gpio = s_twai_tx_gpio,
+        .rx_gpio = s_twai_rx_gpio,
+        .interface = CONFIG_TINYBMS_CAN_SOCKETCAN_IFACE,
+        .bitrate_bps = CAN_VICTRON_BITRATE_BPS,
+        .tx_queue_len = CAN_VICTRON_TX_QUEUE_LEN,
+        .rx_queue_len = CAN_VICTRON_RX_QUEUE_LEN,
+#if !CONFIG_TINYBMS_CAN_RX_ACCEPT_ALL
+        // 0x305 and 0x307 only differ in bit 1, which is left as don't care
+        .rx_filter_id = CAN_VICTRON_KEEPALIVE_ID,
+        .rx_filter_mask = 0x7FFU & ~(uint32_t)(CAN_VICTRON_KEEPALIVE_ID ^ CAN_VICTRON_HANDSHAKE_ID),
+#endif
+    };
 
-    err = twai_start();
+    s_driver = can_victron_driver_default();
+    esp_err_t err = s_driver->start(&driver_config);
     if (err != ESP_OK) {
-        (void)twai_driver_uninstall();
         return err;
     }
 
@@ -502,8 +666,7 @@ static void can_victron_stop_driver(void)
         return;
     }
 
-    (void)twai_stop();
-    (void)twai_driver_uninstall();
+    s_driver->stop();
 
     if (s_stats_mutex != NULL && xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
         s_last_twai_state = TWAI_STATE_STOPPED;
@@ -523,10 +686,10 @@ static bool can_victron_is_driver_started(void)
     return started;
 }
 
-static void can_victron_send_keepalive(uint64_t now)
+static esp_err_t can_victron_send_keepalive(uint64_t now)
 {
     if (!can_victron_is_driver_started()) {
-        return;
+        return ESP_ERR_INVALID_STATE;
     }
 
     uint8_t payload[CAN_VICTRON_KEEPALIVE_DLC] = {0x00};
@@ -544,9 +707,26 @@ static void can_victron_send_keepalive(uint64_t now)
     } else {
         ESP_LOGW(TAG, "Failed to transmit keepalive: %s", esp_err_to_name(err));
     }
+    return err;
+}
+
+static void can_victron_record_keepalive_response(int64_t rx_us)
+{
+    int64_t elapsed = esp_timer_get_time() - rx_us;
+    uint32_t latency_us = (elapsed > 0) ? (uint32_t)elapsed : 0U;
+
+    if (s_keepalive_mutex != NULL && xSemaphoreTake(s_keepalive_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        s_keepalive_response_last_us = latency_us;
+        if (latency_us > s_keepalive_response_max_us) {
+            s_keepalive_response_max_us = latency_us;
+        }
+        s_keepalive_response_total_us += latency_us;
+        s_keepalive_response_count++;
+        xSemaphoreGive(s_keepalive_mutex);
+    }
 }
 
-static void can_victron_process_keepalive_rx(bool remote_request, uint64_t now)
+static void can_victron_process_keepalive_rx(bool remote_request, uint64_t now, int64_t rx_us)
 {
     bool was_not_ok = false;
 
@@ -566,7 +746,9 @@ static void can_victron_process_keepalive_rx(bool remote_request, uint64_t now)
 
     if (remote_request) {
         ESP_LOGD(TAG, "Victron keepalive request received");
-        can_victron_send_keepalive(now);
+        if (can_victron_send_keepalive(now) == ESP_OK) {
+            can_victron_record_keepalive_response(rx_us);
+        }
     }
 }
 
@@ -610,7 +792,7 @@ static void can_victron_service_keepalive(uint64_t now)
 
     // Envoyer keepalive si interval atteint
     if ((now - last_tx) >= interval) {
-        can_victron_send_keepalive(now);
+        (void)can_victron_send_keepalive(now);
     }
 
     // Gérer timeout
@@ -618,26 +800,92 @@ static void can_victron_service_keepalive(uint64_t now)
         ESP_LOGW(TAG,
                  "Victron keepalive timeout after %" PRIu64 " ms",
                  now - last_rx);
-        can_victron_send_keepalive(now);
+        (void)can_victron_send_keepalive(now);
     }
 }
 
-static void can_victron_handle_rx_message(const twai_message_t *message)
+// Time until the keepalive service next has something to do, bounded so the
+// task still checks the exit flag and the capture spill regularly.
+static uint32_t can_victron_next_service_delay_ms(uint64_t now)
+{
+    const config_manager_can_settings_t *settings = can_victron_get_settings();
+    uint32_t interval = can_victron_effective_interval_ms(settings);
+    uint32_t retry = can_victron_effective_retry_ms(settings);
+    uint32_t timeout = can_victron_effective_timeout_ms(settings);
+
+    bool keepalive_ok = false;
+    uint64_t last_tx = now;
+    uint64_t last_rx = now;
+    if (s_keepalive_mutex != NULL && xSemaphoreTake(s_keepalive_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        keepalive_ok = s_keepalive_ok;
+        last_tx = s_last_keepalive_tx_ms;
+        last_rx = s_last_keepalive_rx_ms;
+        xSemaphoreGive(s_keepalive_mutex);
+    }
+
+    if (!keepalive_ok && retry > 0U && retry < interval) {
+        interval = retry;
+    }
+
+    uint64_t wait = CAN_VICTRON_IDLE_WAIT_MS;
+    uint64_t tx_due = last_tx + interval;
+    wait = (tx_due > now) ? ((tx_due - now < wait) ? tx_due - now : wait) : 0U;
+    if (keepalive_ok && timeout > 0U) {
+        uint64_t rx_due = last_rx + timeout + 1U;
+        uint64_t rx_wait = (rx_due > now) ? rx_due - now : 0U;
+        if (rx_wait < wait) {
+            wait = rx_wait;
+        }
+    }
+    return (uint32_t)wait;
+}
+
+static void can_victron_record_bus_events(uint32_t events)
+{
+    if ((events & (CAN_VICTRON_DRIVER_EVENT_BUS_OFF | CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED)) == 0U) {
+        return;
+    }
+
+    if ((events & CAN_VICTRON_DRIVER_EVENT_BUS_OFF) != 0U) {
+        ESP_LOGW(TAG, "CAN bus-off, recovery started");
+    }
+    if ((events & CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED) != 0U) {
+        ESP_LOGI(TAG, "CAN bus recovered");
+    }
+
+    if (s_stats_mutex != NULL && xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        if ((events & CAN_VICTRON_DRIVER_EVENT_BUS_OFF) != 0U) {
+            s_bus_off_count++;
+            s_last_twai_state = TWAI_STATE_BUS_OFF;
+        }
+        if ((events & CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED) != 0U) {
+            s_bus_recovery_count++;
+            s_last_twai_state = TWAI_STATE_RUNNING;
+        }
+        xSemaphoreGive(s_stats_mutex);
+    }
+}
+
+static void can_victron_handle_rx_message(const can_victron_driver_frame_t *message, int64_t rx_us)
 {
     if (message == NULL) {
         return;
     }
 
-    const bool is_remote = (message->flags & TWAI_MSG_FLAG_RTR) != 0U;
-    const bool is_extended = (message->flags & TWAI_MSG_FLAG_EXTD) != 0U;
+    const bool is_remote = message->rtr;
+    const bool is_extended = message->extended;
     const uint32_t identifier = message->identifier;
-    const size_t dlc = message->data_length_code;
+    const size_t dlc = message->dlc;
     const size_t data_length = is_remote ? 0U : dlc;
     const uint8_t *payload = is_remote ? NULL : message->data;
     uint64_t timestamp = can_victron_timestamp_ms();
 
+    if (!is_extended) {
+        can_victron_capture_record(true, identifier, payload, (uint8_t)dlc, is_remote, timestamp);
+    }
+
     if (!is_extended && identifier == CAN_VICTRON_KEEPALIVE_ID) {
-        can_victron_process_keepalive_rx(is_remote, timestamp);
+        can_victron_process_keepalive_rx(is_remote, timestamp, rx_us);
 
         const char *desc = is_remote ? "Victron keepalive request" : "Victron keepalive";
         (void)can_victron_emit_events(identifier,
@@ -675,31 +923,50 @@ static void can_victron_task(void *context)
 {
     (void)context;
     while (!s_task_should_exit) {  // Vérifier flag de terminaison
-        uint64_t now = can_victron_timestamp_ms();
+        if (!can_victron_is_driver_started()) {
+            vTaskDelay(pdMS_TO_TICKS(CAN_VICTRON_IDLE_WAIT_MS));
+            continue;
+        }
 
-        if (can_victron_is_driver_started()) {
-            twai_message_t message = {0};
-            while (!s_task_should_exit) {  // Vérifier flag aussi dans boucle interne
-                esp_err_t rx = twai_receive(&message, pdMS_TO_TICKS(CAN_VICTRON_RX_TIMEOUT_MS));
-                if (rx == ESP_OK) {
-                    can_victron_handle_rx_message(&message);
-                } else if (rx == ESP_ERR_TIMEOUT) {
-                    break;
-                } else {
-                    ESP_LOGW(TAG, "CAN receive error: %s", esp_err_to_name(rx));
-                    break;
-                }
+        // Bloquer jusqu'à une trame acceptée par le filtre ou la prochaine échéance keepalive
+        uint32_t wait_ms = can_victron_next_service_delay_ms(can_victron_timestamp_ms());
+        uint32_t events = 0;
+        esp_err_t err = s_driver->wait_rx(wait_ms, &events);
+        s_rx_task_wakeups++;
+
+        if (err == ESP_OK) {
+            can_victron_record_bus_events(events);
+        }
+
+        if (err == ESP_OK && (events & CAN_VICTRON_DRIVER_EVENT_RX) != 0U) {
+            int64_t rx_us = esp_timer_get_time();
+            if ((events & CAN_VICTRON_DRIVER_EVENT_RX_OVERRUN) != 0U) {
+                ESP_LOGW(TAG, "CAN RX queue full, frames dropped");
             }
 
-            if (!s_task_should_exit) {
-                can_victron_service_keepalive(now);
+            can_victron_driver_frame_t message = {0};
+            while (!s_task_should_exit) {
+                esp_err_t rx = s_driver->receive(&message);
+                if (rx != ESP_OK) {
+                    if (rx != ESP_ERR_TIMEOUT) {
+                        ESP_LOGW(TAG, "CAN receive error: %s", esp_err_to_name(rx));
+                    }
+                    break;
+                }
+                can_victron_handle_rx_message(&message, rx_us);
             }
+        } else if (err != ESP_OK && err != ESP_ERR_TIMEOUT) {
+            // Driver arrêté pendant l'attente
+            vTaskDelay(pdMS_TO_TICKS(10));
         }
 
-        vTaskDelay(pdMS_TO_TICKS(CAN_VICTRON_TASK_DELAY_MS));
+        if (!s_task_should_exit) {
+            can_victron_service_keepalive(can_victron_timestamp_ms());
+        }
     }
 
     ESP_LOGI(TAG, "CAN task exiting");
+    s_task_exited = true;
     vTaskDelete(NULL);
 }
 #endif  // ESP_PLATFORM
@@ -725,6 +992,13 @@ esp_err_t can_victron_get_status(can_victron_status_t *status)
         status->keepalive_ok = s_keepalive_ok;
         status->last_keepalive_tx_ms = s_last_keepalive_tx_ms;
         status->last_keepalive_rx_ms = s_last_keepalive_rx_ms;
+        status->keepalive_response_last_us = s_keepalive_response_last_us;
+        status->keepalive_response_max_us = s_keepalive_response_max_us;
+        status->keepalive_response_count = s_keepalive_response_count;
+        if (s_keepalive_response_count > 0U) {
+            status->keepalive_response_avg_us =
+                (uint32_t)(s_keepalive_response_total_us / s_keepalive_response_count);
+        }
         xSemaphoreGive(s_keepalive_mutex);
     } else {
         status->keepalive_ok = s_keepalive_ok;
@@ -732,10 +1006,8 @@ esp_err_t can_victron_get_status(can_victron_status_t *status)
         status->last_keepalive_rx_ms = s_last_keepalive_rx_ms;
     }
 
-    can_victron_metric_sample_t local_samples[CAN_VICTRON_METRIC_BUFFER_SIZE];
-    memset(local_samples, 0, sizeof(local_samples));
-    size_t local_count = 0;
-    size_t local_head = 0;
+    can_victron_occupancy_window_t windows[CAN_VICTRON_OCCUPANCY_WINDOW_COUNT];
+    memset(windows, 0, sizeof(windows));
 
     uint32_t local_bus_off_count = s_bus_off_count;
     twai_state_t local_last_state = s_last_twai_state;
@@ -745,9 +1017,13 @@ esp_err_t can_victron_get_status(can_victron_status_t *status)
         status->rx_frame_count = s_rx_frame_count;
         status->tx_byte_count = s_tx_byte_count;
         status->rx_byte_count = s_rx_byte_count;
-        local_count = s_metric_count;
-        local_head = s_metric_head;
-        memcpy(local_samples, s_metric_samples, sizeof(local_samples));
+        can_victron_occupancy_advance(&s_occupancy, status->timestamp_ms);
+        for (size_t i = 0; i < CAN_VICTRON_OCCUPANCY_WINDOW_COUNT; ++i) {
+            can_victron_occupancy_get(&s_occupancy,
+                                      s_occupancy_windows_s[i],
+                                      CAN_VICTRON_BITRATE_BPS,
+                                      &windows[i]);
+        }
         local_bus_off_count = s_bus_off_count;
         local_last_state = s_last_twai_state;
         xSemaphoreGive(s_stats_mutex);
@@ -758,43 +1034,28 @@ esp_err_t can_victron_get_status(can_victron_status_t *status)
         status->rx_byte_count = s_rx_byte_count;
     }
 
-    uint64_t window_start = (status->timestamp_ms > CAN_VICTRON_OCCUPANCY_WINDOW_MS)
-                                ? status->timestamp_ms - CAN_VICTRON_OCCUPANCY_WINDOW_MS
-                                : 0;
-    uint64_t total_bits = 0;
-
-    if (local_count > 0) {
-        for (size_t i = 0; i < local_count; ++i) {
-            size_t index = (local_head + CAN_VICTRON_METRIC_BUFFER_SIZE - local_count + i) % CAN_VICTRON_METRIC_BUFFER_SIZE;
-            const can_victron_metric_sample_t *sample = &local_samples[index];
-            if (sample->timestamp == 0 || sample->bits == 0) {
-                continue;
-            }
-            if (sample->timestamp < window_start) {
-                continue;
-            }
-            total_bits += sample->bits;
-        }
-    }
-
-    double occupancy = 0.0;
-    if (CAN_VICTRON_OCCUPANCY_WINDOW_MS > 0U) {
-        occupancy = (double)total_bits /
-                    ((double)CAN_VICTRON_BITRATE_BPS * ((double)CAN_VICTRON_OCCUPANCY_WINDOW_MS / 1000.0));
+    for (size_t i = 0; i < CAN_VICTRON_OCCUPANCY_WINDOW_COUNT; ++i) {
+        status->occupancy[i].window_s = s_occupancy_windows_s[i];
+        status->occupancy[i].covered_s = windows[i].window_s;
+        status->occupancy[i].occupancy_pct = windows[i].occupancy_pct;
+        status->occupancy[i].frames_per_s = windows[i].frames_per_s;
     }
-    if (occupancy < 0.0) {
-        occupancy = 0.0;
-    }
-    if (occupancy > 1.0) {
-        occupancy = 1.0;
-    }
-    status->bus_occupancy_pct = (float)(occupancy * 100.0);
+    status->bus_occupancy_pct = windows[CAN_VICTRON_OCCUPANCY_WINDOW_COUNT - 1U].occupancy_pct;
 
     status->bus_state = local_last_state;
     status->bus_off_count = local_bus_off_count;
-
-    twai_status_info_t info = {0};
-    if (status->driver_started && twai_get_status_info(&info) == ESP_OK) {
+    status->tx_lock_hold_last_us = s_tx_lock_hold_last_us;
+    status->tx_lock_hold_max_us = s_tx_lock_hold_max_us;
+    status->tx_lock_hold_total_us = s_tx_lock_hold_total_us;
+    status->tx_lock_acquisitions = s_tx_lock_acquisitions;
+    status->tx_batch_count = s_tx_batch_count;
+    status->rx_task_wakeups = s_rx_task_wakeups;
+    status->rx_filter_enabled = !CONFIG_TINYBMS_CAN_RX_ACCEPT_ALL;
+
+    status->bus_recovery_count = s_bus_recovery_count;
+
+    can_victron_driver_status_t info = {0};
+    if (status->driver_started && s_driver != NULL && s_driver->get_status(&info) == ESP_OK) {
         status->tx_error_counter = info.tx_error_counter;
         status->rx_error_counter = info.rx_error_counter;
         status->tx_failed_count = info.tx_failed_count;
@@ -804,19 +1065,12 @@ esp_err_t can_victron_get_status(can_victron_status_t *status)
 
         status->bus_state = info.state;
 
+        // Bus-off transitions are counted by the CAN task from driver events
         if (s_stats_mutex != NULL && xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            if (info.state == TWAI_STATE_BUS_OFF && s_last_twai_state != TWAI_STATE_BUS_OFF) {
-                s_bus_off_count++;
-            }
             s_last_twai_state = info.state;
-            status->bus_off_count = s_bus_off_count;
             xSemaphoreGive(s_stats_mutex);
         } else {
-            if (info.state == TWAI_STATE_BUS_OFF && s_last_twai_state != TWAI_STATE_BUS_OFF) {
-                s_bus_off_count++;
-            }
             s_last_twai_state = info.state;
-            status->bus_off_count = s_bus_off_count;
         }
     }
 #else
@@ -829,6 +1083,37 @@ esp_err_t can_victron_get_status(can_victron_status_t *status)
     return ESP_OK;
 }
 
+esp_err_t can_victron_get_bus_occupancy(uint32_t window_ms, float *out_occupancy_pct)
+{
+    if (out_occupancy_pct == NULL || window_ms == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_occupancy_pct = 0.0f;
+
+#ifdef ESP_PLATFORM
+    if (s_stats_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint64_t now = can_victron_timestamp_ms();
+    can_victron_occupancy_window_t window;
+
+    if (xSemaphoreTake(s_stats_mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    can_victron_occupancy_advance(&s_occupancy, now);
+    can_victron_occupancy_get(&s_occupancy, (window_ms + 999U) / 1000U, CAN_VICTRON_BITRATE_BPS, &window);
+
+    xSemaphoreGive(s_stats_mutex);
+
+    *out_occupancy_pct = window.occupancy_pct;
+#endif
+
+    return ESP_OK;
+}
+
 void can_victron_set_event_publisher(event_bus_publish_fn_t publisher)
 {
     s_event_publisher = publisher;
@@ -863,10 +1148,9 @@ esp_err_t can_victron_publish_frame(uint32_t can_id,
         return ESP_ERR_INVALID_STATE;
     }
 
-    twai_message_t message = {
+    can_victron_driver_frame_t message = {
         .identifier = can_id,
-        .flags = 0,
-        .data_length_code = (uint8_t)dlc,
+        .dlc = (uint8_t)dlc,
     };
 
     if (data_length > 0U) {
@@ -881,7 +1165,9 @@ esp_err_t can_victron_publish_frame(uint32_t can_id,
         }
     }
 
-    esp_err_t tx_err = twai_transmit(&message, pdMS_TO_TICKS(CAN_VICTRON_TX_TIMEOUT_MS));
+    int64_t lock_start_us = esp_timer_get_time();
+    esp_err_t tx_err = s_driver->transmit(&message, CAN_VICTRON_TX_TIMEOUT_MS);
+    can_victron_record_lock_hold(lock_start_us);
 
     if (mutex != NULL) {
         xSemaphoreGive(mutex);
@@ -897,6 +1183,7 @@ esp_err_t can_victron_publish_frame(uint32_t can_id,
 #endif
 
     uint64_t timestamp = can_victron_timestamp_ms();
+    can_victron_capture_record(false, can_id, data, (uint8_t)dlc, false, timestamp);
     return can_victron_emit_events(can_id,
                                    data,
                                    dlc,
@@ -906,6 +1193,85 @@ esp_err_t can_victron_publish_frame(uint32_t can_id,
                                    timestamp);
 }
 
+esp_err_t can_victron_publish_frames(const can_victron_tx_frame_t *frames, size_t count, size_t *out_sent)
+{
+    if (out_sent != NULL) {
+        *out_sent = 0;
+    }
+    if (count == 0) {
+        return ESP_OK;
+    }
+    if (frames == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (frames[i].can_id > 0x7FFU || frames[i].length > 8U) {
+            ESP_LOGE(TAG,
+                     "Invalid CAN frame 0x%08" PRIX32 " (dlc %u) in batch",
+                     frames[i].can_id,
+                     (unsigned)frames[i].length);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    size_t sent = count;
+    esp_err_t result = ESP_OK;
+
+#ifdef ESP_PLATFORM
+    if (!can_victron_is_driver_started()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    SemaphoreHandle_t mutex = s_twai_mutex;
+    if (mutex != NULL) {
+        if (xSemaphoreTake(mutex, pdMS_TO_TICKS(CAN_VICTRON_LOCK_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGW(TAG, "Timed out acquiring CAN TX mutex");
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    // The whole cycle is queued under one lock acquisition; the controller TX
+    // queue absorbs the burst so each call normally returns without blocking.
+    int64_t lock_start_us = esp_timer_get_time();
+    for (sent = 0; sent < count; ++sent) {
+        can_victron_driver_frame_t message = {
+            .identifier = frames[sent].can_id,
+            .dlc = frames[sent].length,
+        };
+        memcpy(message.data, frames[sent].data, frames[sent].length);
+
+        result = s_driver->transmit(&message, CAN_VICTRON_TX_TIMEOUT_MS);
+        if (result != ESP_OK) {
+            ESP_LOGW(TAG,
+                     "Failed to transmit CAN frame 0x%08" PRIX32 ": %s (%u/%u sent)",
+                     frames[sent].can_id,
+                     esp_err_to_name(result),
+                     (unsigned)sent,
+                     (unsigned)count);
+            break;
+        }
+    }
+    can_victron_record_lock_hold(lock_start_us);
+    s_tx_batch_count++;
+
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+#endif
+
+    uint64_t timestamp = can_victron_timestamp_ms();
+    for (size_t i = 0; i < sent; ++i) {
+        can_victron_capture_record(false, frames[i].can_id, frames[i].data, frames[i].length, false, timestamp);
+    }
+    can_victron_record_tx_batch(frames, sent, timestamp);
+    can_victron_emit_batch_event(frames, sent, timestamp);
+    if (out_sent != NULL) {
+        *out_sent = sent;
+    }
+    return result;
+}
+
 void can_victron_init(void)
 {
 #ifdef ESP_PLATFORM
@@ -964,7 +1330,8 @@ void can_victron_init(void)
             uint64_t now = can_victron_timestamp_ms();
             can_victron_send_keepalive(now);
             ESP_LOGI(TAG,
-                     "Victron CAN driver ready (TX=%d RX=%d)",
+                     "Victron CAN driver ready (%s, TX=%d RX=%d)",
+                     s_driver->name,
                      s_twai_tx_gpio,
                      s_twai_rx_gpio);
         }
@@ -975,6 +1342,10 @@ void can_victron_init(void)
     if (!can_victron_is_driver_started()) {
         can_victron_publish_demo_frames();
     }
+
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL
+    (void)can_victron_capture_start_spill_task();
+#endif
 #else
     ESP_LOGI(TAG, "Victron CAN monitor initialised (host mode)");
     can_victron_reset_stats();
@@ -987,27 +1358,30 @@ void can_victron_deinit(void)
     ESP_LOGI(TAG, "Deinitializing CAN Victron...");
 
 #ifdef ESP_PLATFORM
-    // Signal task to exit
+    // Signal task to exit; it may be blocked on TWAI alerts for up to
+    // CAN_VICTRON_IDLE_WAIT_MS
     s_task_should_exit = true;
 
-    // Give task time to exit cleanly
-    vTaskDelay(pdMS_TO_TICKS(200));
+    if (s_can_task_handle != NULL) {
+        uint32_t waited_ms = 0;
+        while (!s_task_exited && waited_ms < CAN_VICTRON_EXIT_TIMEOUT_MS) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            waited_ms += 10U;
+        }
+        if (!s_task_exited) {
+            ESP_LOGW(TAG, "CAN task did not exit within %u ms", (unsigned)CAN_VICTRON_EXIT_TIMEOUT_MS);
+        }
+    }
+
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL
+    can_victron_capture_stop_spill_task();
+#endif
 
-    // Stop TWAI driver (utiliser helper thread-safe)
+    // Stop the controller (utiliser helper thread-safe)
     if (can_victron_is_driver_started()) {
-        // Acquérir mutex TWAI avant stop
+        // Acquérir mutex TX avant stop
         if (s_twai_mutex != NULL && xSemaphoreTake(s_twai_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            esp_err_t err = twai_stop();
-            if (err != ESP_OK) {
-                ESP_LOGW(TAG, "Failed to stop TWAI: %s", esp_err_to_name(err));
-            }
-
-            err = twai_driver_uninstall();
-            if (err != ESP_OK) {
-                ESP_LOGW(TAG, "Failed to uninstall TWAI driver: %s", esp_err_to_name(err));
-            } else {
-                ESP_LOGI(TAG, "TWAI driver uninstalled");
-            }
+            s_driver->stop();
 
             xSemaphoreGive(s_twai_mutex);
 
@@ -1043,10 +1417,16 @@ void can_victron_deinit(void)
     // Reset state
     s_can_task_handle = NULL;
     s_task_should_exit = false;
+    s_task_exited = false;
+    s_rx_task_wakeups = 0;
     s_driver_started = false;
     s_keepalive_ok = false;
     s_last_keepalive_tx_ms = 0;
     s_last_keepalive_rx_ms = 0;
+    s_keepalive_response_last_us = 0;
+    s_keepalive_response_max_us = 0;
+    s_keepalive_response_total_us = 0;
+    s_keepalive_response_count = 0;
     s_event_publisher = NULL;
     s_next_event_slot = 0;
     memset(s_can_raw_events, 0, sizeof(s_can_raw_events));
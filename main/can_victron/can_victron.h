@@ -11,7 +11,8 @@
  * @section can_victron_thread_safety Thread Safety
  *
  * The CAN Victron module uses multiple mutexes for thread safety:
- * - s_twai_mutex: Protects TWAI hardware access
+ * - s_twai_mutex: Protects controller access (TWAI or SocketCAN backend,
+ *   see can_victron_driver.h)
  * - s_driver_state_mutex: Protects driver start/stop state flag
  *
  * **Protected Resources**:
@@ -22,6 +23,7 @@
  * **Thread-Safe Functions** (all public functions):
  * - can_victron_init() - Initializes mutexes, starts driver, creates task
  * - can_victron_publish_frame() - Thread-safe frame transmission
+ * - can_victron_publish_frames() - Thread-safe batch transmission (one lock per batch)
  * - can_victron_set_event_publisher() - Sets event callback (init only)
  * - Internal: can_victron_is_driver_started() - Mutex-protected state read
  *
@@ -58,6 +60,10 @@
 #include "esp_err.h"
 
 #ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_LINUX)
 #include "driver/twai.h"
 #else
 typedef enum {
@@ -71,6 +77,18 @@ typedef enum {
 
 #include "event_bus.h"
 
+#define CAN_VICTRON_OCCUPANCY_WINDOW_COUNT 3U
+
+/**
+ * @brief Bus occupancy and frame rate over one trailing window.
+ */
+typedef struct {
+    uint32_t window_s;          /**< Nominal window (1, 10 or 60 s). */
+    uint32_t covered_s;         /**< Completed seconds actually covered (less than window_s after boot). */
+    float occupancy_pct;
+    float frames_per_s;         /**< TX + RX frames per second. */
+} can_victron_occupancy_stat_t;
+
 typedef struct {
     bool driver_started;
     bool keepalive_ok;
@@ -91,11 +109,34 @@ typedef struct {
     uint32_t arbitration_lost_count;
     uint32_t bus_error_count;
     uint32_t bus_off_count;
+    uint32_t bus_recovery_count;    /**< Bus-off recoveries completed by the controller. */
     twai_state_t bus_state;
-    float bus_occupancy_pct;
+    float bus_occupancy_pct;        /**< Occupancy over the last 60 completed seconds. */
     uint32_t occupancy_window_ms;
+    can_victron_occupancy_stat_t occupancy[CAN_VICTRON_OCCUPANCY_WINDOW_COUNT]; /**< 1 s, 10 s and 60 s windows. */
+    uint32_t tx_lock_hold_last_us;  /**< TX mutex hold time of the last single or batch transmit. */
+    uint32_t tx_lock_hold_max_us;   /**< Longest TX mutex hold time since init. */
+    uint64_t tx_lock_hold_total_us; /**< Cumulative TX mutex hold time since init. */
+    uint32_t tx_lock_acquisitions;  /**< TX mutex acquisitions, one per single frame or batch. */
+    uint32_t tx_batch_count;        /**< Batches submitted through can_victron_publish_frames(). */
+    uint32_t keepalive_response_last_us; /**< 0x305 request to keepalive response latency (last). */
+    uint32_t keepalive_response_max_us;  /**< Worst keepalive response latency since init. */
+    uint32_t keepalive_response_avg_us;  /**< Mean keepalive response latency. */
+    uint32_t keepalive_response_count;   /**< Keepalive requests answered. */
+    uint32_t rx_task_wakeups;       /**< Times the RX task woke up (frame alert or keepalive deadline). */
+    bool rx_filter_enabled;         /**< Hardware acceptance filter limits RX to 0x305/0x307. */
 } can_victron_status_t;
 
+/**
+ * @brief Standard-identifier frame submitted through can_victron_publish_frames().
+ */
+typedef struct can_victron_tx_frame {
+    uint32_t can_id;            /**< 11-bit CAN identifier. */
+    uint8_t length;             /**< Payload length, at most eight bytes. */
+    uint8_t data[8];            /**< Frame payload. */
+    const char *description;    /**< Label used in the batch event (may be NULL). */
+} can_victron_tx_frame_t;
+
 void can_victron_init(void);
 void can_victron_deinit(void);
 void can_victron_set_event_publisher(event_bus_publish_fn_t publisher);
@@ -103,4 +144,30 @@ esp_err_t can_victron_publish_frame(uint32_t can_id,
                                     const uint8_t *data,
                                     size_t length,
                                     const char *description);
+
+/**
+ * @brief Transmit a burst of frames under a single TX lock acquisition.
+ *
+ * Statistics are updated once for the whole batch and a single
+ * APP_EVENT_ID_CAN_FRAME_BATCH event replaces the per-frame raw and decoded
+ * events. Transmission stops at the first TWAI error; frames sent before it
+ * are still accounted for.
+ *
+ * @param frames   Frames to send, in order
+ * @param count    Number of entries in \p frames
+ * @param out_sent Optional, receives the number of leading frames queued
+ * @return ESP_OK when every frame was queued, or the first transmit error
+ */
+esp_err_t can_victron_publish_frames(const can_victron_tx_frame_t *frames, size_t count, size_t *out_sent);
 esp_err_t can_victron_get_status(can_victron_status_t *status);
+
+/**
+ * @brief Measure bus occupancy over a short trailing window.
+ *
+ * Cheaper than can_victron_get_status() (no sample copy), intended for
+ * periodic polling by the CAN publisher's TX shaping.
+ *
+ * @param window_ms          Trailing window length in milliseconds
+ * @param out_occupancy_pct  Occupancy in percent of the nominal bitrate
+ */
+esp_err_t can_victron_get_bus_occupancy(uint32_t window_ms, float *out_occupancy_pct);
@@ -0,0 +1,397 @@
+#include "can_victron_capture.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "can_config_defaults.h"
+#include "history_fs.h"
+
+#define CAN_VICTRON_CAPTURE_DEPTH       CONFIG_TINYBMS_CAN_CAPTURE_DEPTH
+#define CAN_VICTRON_CAPTURE_COPY_CHUNK  32U
+#define CAN_VICTRON_CAPTURE_SPILL_FILE  "can_capture.bin"
+#define CAN_VICTRON_CAPTURE_SPILL_OLD   "can_capture.old"
+#define CAN_VICTRON_CAPTURE_SPILL_STACK 3072
+#define CAN_VICTRON_CAPTURE_SPILL_PRIORITY (tskIDLE_PRIORITY + 1)
+#define CAN_VICTRON_CAPTURE_SPILL_POLL_MS 1000U
+#define CAN_VICTRON_CAPTURE_SPILL_EXIT_MS 1000U
+
+static_assert(sizeof(can_victron_capture_record_t) == 16U, "capture record must stay 16 bytes");
+static_assert(sizeof(can_victron_capture_file_header_t) == 16U, "capture header must stay 16 bytes");
+
+static const char *TAG = "can_capture";
+
+#if CAN_VICTRON_CAPTURE_DEPTH > 0
+// A power-of-two depth keeps N % depth continuous when the counter wraps
+static_assert((CAN_VICTRON_CAPTURE_DEPTH & (CAN_VICTRON_CAPTURE_DEPTH - 1)) == 0,
+              "CONFIG_TINYBMS_CAN_CAPTURE_DEPTH must be a power of two");
+static can_victron_capture_record_t s_ring[CAN_VICTRON_CAPTURE_DEPTH];
+#endif
+// Absolute count of recorded frames, modulo 2^32; record N lives at
+// s_ring[N % depth]. s_ring_full tells whether the oldest record is
+// s_written - depth, which stays right after the counter wraps.
+static uint32_t s_written = 0;
+static bool s_ring_full = false;
+// Spill cursor and counters: guarded by s_capture_lock like the ring
+static uint32_t s_spill_next = 0;
+static uint32_t s_spilled = 0;
+static uint32_t s_spill_lost = 0;
+static uint32_t s_spill_errors = 0;
+static portMUX_TYPE s_capture_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL && CAN_VICTRON_CAPTURE_DEPTH > 0
+// Flash appends run in their own low-priority task so LittleFS stalls never
+// delay the CAN task's RX servicing and keepalive.
+static TaskHandle_t s_spill_task = NULL;
+static volatile bool s_spill_should_exit = false;
+static volatile bool s_spill_exited = false;
+#endif
+
+void can_victron_capture_record(bool rx,
+                                uint32_t can_id,
+                                const uint8_t *data,
+                                uint8_t dlc,
+                                bool rtr,
+                                uint64_t timestamp_ms)
+{
+#if CAN_VICTRON_CAPTURE_DEPTH > 0
+    can_victron_capture_record_t record = {
+        .timestamp_ms = (uint32_t)timestamp_ms,
+        .can_id = (uint16_t)(can_id & 0x7FFU),
+        .flags = (uint8_t)((rx ? CAN_VICTRON_CAPTURE_FLAG_RX : 0U) | (rtr ? CAN_VICTRON_CAPTURE_FLAG_RTR : 0U)),
+        .dlc = (dlc > 8U) ? 8U : dlc,
+    };
+    if (data != NULL && !rtr) {
+        memcpy(record.data, data, record.dlc);
+    }
+
+    portENTER_CRITICAL(&s_capture_lock);
+    s_ring[s_written % CAN_VICTRON_CAPTURE_DEPTH] = record;
+    s_written++;
+    if ((s_written % CAN_VICTRON_CAPTURE_DEPTH) == 0U) {
+        s_ring_full = true;
+    }
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL
+    bool wake_spill = (s_written - s_spill_next) == (CAN_VICTRON_CAPTURE_DEPTH / 2U);
+#endif
+    portEXIT_CRITICAL(&s_capture_lock);
+
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL
+    TaskHandle_t spill_task = s_spill_task;
+    if (wake_spill && spill_task != NULL) {
+        xTaskNotifyGive(spill_task);
+    }
+#endif
+#else
+    (void)rx;
+    (void)can_id;
+    (void)data;
+    (void)dlc;
+    (void)rtr;
+    (void)timestamp_ms;
+#endif
+}
+
+#if CAN_VICTRON_CAPTURE_DEPTH > 0
+// Copies up to max_count records starting at absolute index *cursor. Records
+// already overwritten are skipped and counted in *out_lost. Each chunk is
+// copied under the spinlock so recording is never blocked for long; *cursor
+// and *out_lost are only touched under it, so s_spill_next may be passed.
+static size_t can_victron_capture_copy(uint32_t *cursor,
+                                       can_victron_capture_record_t *out,
+                                       size_t max_count,
+                                       uint32_t *out_lost)
+{
+    size_t copied = 0;
+    while (copied < max_count) {
+        portENTER_CRITICAL(&s_capture_lock);
+        uint32_t written = s_written;
+        uint32_t oldest = s_ring_full ? written - CAN_VICTRON_CAPTURE_DEPTH : 0U;
+        if ((int32_t)(*cursor - oldest) < 0) {
+            if (out_lost != NULL) {
+                *out_lost += oldest - *cursor;
+            }
+            *cursor = oldest;
+        }
+        size_t pending = (size_t)(written - *cursor);
+        size_t chunk = max_count - copied;
+        if (chunk > pending) {
+            chunk = pending;
+        }
+        if (chunk > CAN_VICTRON_CAPTURE_COPY_CHUNK) {
+            chunk = CAN_VICTRON_CAPTURE_COPY_CHUNK;
+        }
+        for (size_t i = 0; i < chunk; ++i) {
+            out[copied + i] = s_ring[(*cursor + (uint32_t)i) % CAN_VICTRON_CAPTURE_DEPTH];
+        }
+        *cursor += (uint32_t)chunk;
+        portEXIT_CRITICAL(&s_capture_lock);
+
+        if (chunk == 0) {
+            break;
+        }
+        copied += chunk;
+    }
+    return copied;
+}
+#endif
+
+size_t can_victron_capture_snapshot(can_victron_capture_record_t *out, size_t capacity)
+{
+#if CAN_VICTRON_CAPTURE_DEPTH > 0
+    if (out == NULL || capacity == 0) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_capture_lock);
+    uint32_t written = s_written;
+    bool full = s_ring_full;
+    portEXIT_CRITICAL(&s_capture_lock);
+
+    size_t available = full ? CAN_VICTRON_CAPTURE_DEPTH : written;
+    size_t count = (available < capacity) ? available : capacity;
+    uint32_t cursor = written - (uint32_t)count;
+    return can_victron_capture_copy(&cursor, out, count, NULL);
+#else
+    (void)out;
+    (void)capacity;
+    return 0;
+#endif
+}
+
+size_t can_victron_capture_format_candump(const can_victron_capture_record_t *record,
+                                          const char *interface,
+                                          char *buffer,
+                                          size_t buffer_size)
+{
+    if (record == NULL || buffer == NULL || buffer_size < CAN_VICTRON_CAPTURE_CANDUMP_LINE_MAX) {
+        return 0;
+    }
+
+    const char *iface = (interface != NULL) ? interface : "can0";
+    int written = snprintf(buffer,
+                           buffer_size,
+                           "(%" PRIu32 ".%03" PRIu32 "000) %s %03" PRIX16 "#",
+                           record->timestamp_ms / 1000U,
+                           record->timestamp_ms % 1000U,
+                           iface,
+                           record->can_id);
+    if (written < 0 || (size_t)written >= buffer_size) {
+        return 0;
+    }
+
+    size_t offset = (size_t)written;
+    if ((record->flags & CAN_VICTRON_CAPTURE_FLAG_RTR) != 0U) {
+        buffer[offset++] = 'R';
+    } else {
+        static const char hex[] = "0123456789ABCDEF";
+        size_t dlc = (record->dlc > 8U) ? 8U : record->dlc;
+        if (offset + dlc * 2U + 2U > buffer_size) {
+            return 0;
+        }
+        for (size_t i = 0; i < dlc; ++i) {
+            buffer[offset++] = hex[record->data[i] >> 4U];
+            buffer[offset++] = hex[record->data[i] & 0x0FU];
+        }
+    }
+    buffer[offset++] = '\n';
+    buffer[offset] = '\0';
+    return offset;
+}
+
+void can_victron_capture_fill_header(can_victron_capture_file_header_t *header)
+{
+    if (header == NULL) {
+        return;
+    }
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CAN_VICTRON_CAPTURE_MAGIC, sizeof(header->magic));
+    header->version = CAN_VICTRON_CAPTURE_VERSION;
+    header->record_size = (uint16_t)sizeof(can_victron_capture_record_t);
+}
+
+esp_err_t can_victron_capture_spill(bool force)
+{
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL && CAN_VICTRON_CAPTURE_DEPTH > 0
+    if (!history_fs_is_mounted()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_capture_lock);
+    uint32_t pending = s_written - s_spill_next;
+    portEXIT_CRITICAL(&s_capture_lock);
+    if (pending == 0 || (!force && pending < (CAN_VICTRON_CAPTURE_DEPTH / 2U))) {
+        return ESP_OK;
+    }
+
+    char path[96];
+    char old_path[96];
+    const char *mount = history_fs_mount_point();
+    if (snprintf(path, sizeof(path), "%s/%s", mount, CAN_VICTRON_CAPTURE_SPILL_FILE) >= (int)sizeof(path) ||
+        snprintf(old_path, sizeof(old_path), "%s/%s", mount, CAN_VICTRON_CAPTURE_SPILL_OLD) >= (int)sizeof(old_path)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Keep at most two files of CONFIG_TINYBMS_CAN_CAPTURE_SPILL_MAX_BYTES each
+    struct stat st;
+    bool exists = (stat(path, &st) == 0);
+    if (exists && (size_t)st.st_size >= (size_t)CONFIG_TINYBMS_CAN_CAPTURE_SPILL_MAX_BYTES) {
+        (void)remove(old_path);
+        if (rename(path, old_path) != 0) {
+            ESP_LOGW(TAG, "Unable to rotate %s", path);
+        }
+        exists = false;
+    }
+
+    FILE *file = fopen(path, "ab");
+    if (file == NULL) {
+        portENTER_CRITICAL(&s_capture_lock);
+        s_spill_errors++;
+        portEXIT_CRITICAL(&s_capture_lock);
+        return ESP_FAIL;
+    }
+
+    esp_err_t result = ESP_OK;
+    if (!exists) {
+        can_victron_capture_file_header_t header;
+        can_victron_capture_fill_header(&header);
+        if (fwrite(&header, sizeof(header), 1, file) != 1) {
+            result = ESP_FAIL;
+        }
+    }
+
+    can_victron_capture_record_t chunk[CAN_VICTRON_CAPTURE_COPY_CHUNK];
+    while (result == ESP_OK) {
+        size_t count = can_victron_capture_copy(&s_spill_next, chunk, CAN_VICTRON_CAPTURE_COPY_CHUNK, &s_spill_lost);
+        if (count == 0) {
+            break;
+        }
+        if (fwrite(chunk, sizeof(chunk[0]), count, file) != count) {
+            result = ESP_FAIL;
+            break;
+        }
+        portENTER_CRITICAL(&s_capture_lock);
+        s_spilled += (uint32_t)count;
+        portEXIT_CRITICAL(&s_capture_lock);
+    }
+
+    if (fclose(file) != 0) {
+        result = ESP_FAIL;
+    }
+    if (result != ESP_OK) {
+        portENTER_CRITICAL(&s_capture_lock);
+        s_spill_errors++;
+        portEXIT_CRITICAL(&s_capture_lock);
+        ESP_LOGW(TAG, "Failed to spill CAN capture to %s", path);
+    }
+    return result;
+#else
+    (void)force;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void can_victron_capture_get_stats(can_victron_capture_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return;
+    }
+
+    memset(out_stats, 0, sizeof(*out_stats));
+    out_stats->depth = CAN_VICTRON_CAPTURE_DEPTH;
+
+    portENTER_CRITICAL(&s_capture_lock);
+    out_stats->recorded = s_written;
+    out_stats->available = s_ring_full ? CAN_VICTRON_CAPTURE_DEPTH : s_written;
+    out_stats->spilled = s_spilled;
+    out_stats->spill_lost = s_spill_lost;
+    out_stats->spill_errors = s_spill_errors;
+    portEXIT_CRITICAL(&s_capture_lock);
+}
+
+void can_victron_capture_clear(void)
+{
+    portENTER_CRITICAL(&s_capture_lock);
+    s_written = 0;
+    s_ring_full = false;
+    s_spill_next = 0;
+    s_spilled = 0;
+    s_spill_lost = 0;
+    s_spill_errors = 0;
+    portEXIT_CRITICAL(&s_capture_lock);
+}
+
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL && CAN_VICTRON_CAPTURE_DEPTH > 0
+static void can_victron_capture_spill_task(void *context)
+{
+    (void)context;
+
+    while (!s_spill_should_exit) {
+        // Woken when half of the ring is pending; the poll catches a missed edge
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAN_VICTRON_CAPTURE_SPILL_POLL_MS));
+        if (!s_spill_should_exit) {
+            (void)can_victron_capture_spill(false);
+        }
+    }
+
+    s_spill_exited = true;
+    vTaskDelete(NULL);
+}
+#endif
+
+esp_err_t can_victron_capture_start_spill_task(void)
+{
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL && CAN_VICTRON_CAPTURE_DEPTH > 0
+    if (s_spill_task != NULL) {
+        return ESP_OK;
+    }
+
+    s_spill_should_exit = false;
+    s_spill_exited = false;
+    TaskHandle_t handle = NULL;
+    BaseType_t rc = xTaskCreate(can_victron_capture_spill_task,
+                                "can_capture",
+                                CAN_VICTRON_CAPTURE_SPILL_STACK,
+                                NULL,
+                                CAN_VICTRON_CAPTURE_SPILL_PRIORITY,
+                                &handle);
+    if (rc != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create CAN capture spill task");
+        return ESP_ERR_NO_MEM;
+    }
+    s_spill_task = handle;
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void can_victron_capture_stop_spill_task(void)
+{
+#if CONFIG_TINYBMS_CAN_CAPTURE_SPILL && CAN_VICTRON_CAPTURE_DEPTH > 0
+    TaskHandle_t handle = s_spill_task;
+    if (handle == NULL) {
+        return;
+    }
+
+    s_spill_should_exit = true;
+    xTaskNotifyGive(handle);
+    uint32_t waited_ms = 0;
+    while (!s_spill_exited && waited_ms < CAN_VICTRON_CAPTURE_SPILL_EXIT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited_ms += 10U;
+    }
+    if (!s_spill_exited) {
+        ESP_LOGW(TAG, "CAN capture spill task did not exit, deleting it");
+        vTaskDelete(handle);
+    }
+    s_spill_task = NULL;
+#endif
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * @file can_victron_capture.h
+ * @brief Binary ring recording every CAN frame seen by the Victron driver
+ *
+ * Each TX and RX frame is stored as a fixed 16-byte record (timestamp, id,
+ * flags, dlc, payload) in a RAM ring of CONFIG_TINYBMS_CAN_CAPTURE_DEPTH
+ * entries. Recording is a bounded memcpy under a spinlock, so it stays on the
+ * hot path without the JSON event cost. The ring can be exported as a
+ * candump log (`candump -L` format) or in binary, and optionally spilled to
+ * the history filesystem.
+ *
+ * @section can_victron_capture_file Spill file format
+ * A ::can_victron_capture_file_header_t followed by raw
+ * ::can_victron_capture_record_t entries, little endian.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAN_VICTRON_CAPTURE_FLAG_RX  0x01U  /**< Frame received from the bus (TX otherwise). */
+#define CAN_VICTRON_CAPTURE_FLAG_RTR 0x02U  /**< Remote transmission request. */
+
+#define CAN_VICTRON_CAPTURE_MAGIC   "TBCANCAP"
+#define CAN_VICTRON_CAPTURE_VERSION 1U
+
+/** Longest line produced by can_victron_capture_format_candump(). */
+#define CAN_VICTRON_CAPTURE_CANDUMP_LINE_MAX 48U
+
+/**
+ * @brief One captured frame (16 bytes).
+ */
+typedef struct {
+    uint32_t timestamp_ms; /**< Milliseconds since boot (wraps after ~49 days). */
+    uint16_t can_id;       /**< 11-bit identifier. */
+    uint8_t flags;         /**< CAN_VICTRON_CAPTURE_FLAG_* bits. */
+    uint8_t dlc;           /**< Data length code (0-8). */
+    uint8_t data[8];       /**< Payload, zero padded. */
+} can_victron_capture_record_t;
+
+/**
+ * @brief Header written at the start of binary exports and spill files.
+ */
+typedef struct {
+    char magic[8];         /**< CAN_VICTRON_CAPTURE_MAGIC, not NUL terminated. */
+    uint16_t version;      /**< CAN_VICTRON_CAPTURE_VERSION. */
+    uint16_t record_size;  /**< sizeof(can_victron_capture_record_t). */
+    uint32_t reserved;
+} can_victron_capture_file_header_t;
+
+/**
+ * @brief Capture counters.
+ */
+typedef struct {
+    uint32_t depth;          /**< Ring capacity in records (0 = capture disabled). */
+    uint32_t recorded;       /**< Frames recorded since boot or the last clear. */
+    uint32_t available;      /**< Records currently held by the ring. */
+    uint32_t spilled;        /**< Records appended to the spill file. */
+    uint32_t spill_lost;     /**< Records overwritten before they could be spilled. */
+    uint32_t spill_errors;   /**< Failed spill file writes. */
+} can_victron_capture_stats_t;
+
+/**
+ * @brief Record one frame. Safe from any task; no-op when the depth is 0.
+ */
+void can_victron_capture_record(bool rx,
+                                uint32_t can_id,
+                                const uint8_t *data,
+                                uint8_t dlc,
+                                bool rtr,
+                                uint64_t timestamp_ms);
+
+/**
+ * @brief Copy the ring content, oldest record first.
+ *
+ * @param out      Destination array
+ * @param capacity Number of entries available in @p out
+ * @return Number of records written
+ */
+size_t can_victron_capture_snapshot(can_victron_capture_record_t *out, size_t capacity);
+
+/**
+ * @brief Format one record as a `candump -L` line ending in a newline.
+ *
+ * @param record      Record to format
+ * @param interface   Interface name written in the line (e.g. "can0")
+ * @param buffer      Destination, at least CAN_VICTRON_CAPTURE_CANDUMP_LINE_MAX bytes
+ * @param buffer_size Size of @p buffer
+ * @return Line length, or 0 when @p buffer is too small
+ */
+size_t can_victron_capture_format_candump(const can_victron_capture_record_t *record,
+                                          const char *interface,
+                                          char *buffer,
+                                          size_t buffer_size);
+
+/**
+ * @brief Fill the binary export/spill header.
+ */
+void can_victron_capture_fill_header(can_victron_capture_file_header_t *header);
+
+/**
+ * @brief Append pending records to the spill file on the history filesystem.
+ *
+ * Without @p force, records are only written once half of the ring is
+ * pending, so flash sees few large appends. Does nothing unless
+ * CONFIG_TINYBMS_CAN_CAPTURE_SPILL is enabled and the filesystem is mounted.
+ * Blocks on flash I/O: call it from the spill task or a low-priority context.
+ */
+esp_err_t can_victron_capture_spill(bool force);
+
+/**
+ * @brief Start the low-priority task that spills the ring to flash.
+ *
+ * The task is woken once half of the ring is pending, so the CAN task never
+ * waits on LittleFS. Returns ESP_ERR_NOT_SUPPORTED when spilling is disabled.
+ */
+esp_err_t can_victron_capture_start_spill_task(void);
+
+/**
+ * @brief Stop the spill task started by can_victron_capture_start_spill_task().
+ */
+void can_victron_capture_stop_spill_task(void);
+
+void can_victron_capture_get_stats(can_victron_capture_stats_t *out_stats);
+void can_victron_capture_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
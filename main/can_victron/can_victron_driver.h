@@ -0,0 +1,110 @@
+#pragma once
+
+/**
+ * @file can_victron_driver.h
+ * @brief Controller backend used by the Victron CAN driver
+ *
+ * can_victron.c owns the keepalive logic, locking, statistics and events; the
+ * backend only moves frames to and from a controller. Two backends exist:
+ * - TWAI: the ESP32 on-chip controller (default on hardware targets).
+ * - SocketCAN: a Linux CAN_RAW socket (CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN).
+ *   The rest of the firmware has no linux port, so the backend is built and
+ *   tested on its own by tools/vcan_harness against `vcan0`, with
+ *   tools/vcan_loadtest.sh and `candump`/`cangen` as peers.
+ *
+ * Backends are not thread safe: can_victron.c serialises transmit under its TX
+ * mutex, and only the CAN task calls wait_rx() and receive().
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "can_victron.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAN_VICTRON_DRIVER_EVENT_RX            0x01U  /**< At least one frame is waiting. */
+#define CAN_VICTRON_DRIVER_EVENT_RX_OVERRUN    0x02U  /**< Frames were dropped by the controller or socket. */
+#define CAN_VICTRON_DRIVER_EVENT_BUS_OFF       0x04U  /**< Controller entered bus-off, recovery started. */
+#define CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED 0x08U  /**< Controller is back on the bus. */
+
+/**
+ * @brief Classic CAN frame exchanged with a backend.
+ */
+typedef struct {
+    uint32_t identifier;
+    uint8_t dlc;
+    uint8_t data[8];
+    bool extended;
+    bool rtr;
+} can_victron_driver_frame_t;
+
+/**
+ * @brief Backend start parameters.
+ *
+ * The RX filter accepts standard frames for which
+ * `(identifier & rx_filter_mask) == (rx_filter_id & rx_filter_mask)`;
+ * a zero mask accepts everything.
+ */
+typedef struct {
+    int tx_gpio;                /**< TWAI only. */
+    int rx_gpio;                /**< TWAI only. */
+    const char *interface;      /**< SocketCAN only, e.g. "vcan0". */
+    uint32_t bitrate_bps;
+    uint32_t tx_queue_len;
+    uint32_t rx_queue_len;
+    uint32_t rx_filter_id;
+    uint32_t rx_filter_mask;
+} can_victron_driver_config_t;
+
+/**
+ * @brief Controller counters, zero where the backend has no equivalent.
+ */
+typedef struct {
+    twai_state_t state;
+    uint32_t tx_error_counter;
+    uint32_t rx_error_counter;
+    uint32_t tx_failed_count;
+    uint32_t rx_missed_count;
+    uint32_t arb_lost_count;
+    uint32_t bus_error_count;
+} can_victron_driver_status_t;
+
+typedef struct {
+    const char *name;
+
+    /** Install and start the controller. */
+    esp_err_t (*start)(const can_victron_driver_config_t *config);
+
+    /** Stop and release the controller. */
+    void (*stop)(void);
+
+    /** Queue one frame, blocking up to @p timeout_ms for queue space. */
+    esp_err_t (*transmit)(const can_victron_driver_frame_t *frame, uint32_t timeout_ms);
+
+    /**
+     * Block until a frame or bus event arrives, or @p timeout_ms elapses.
+     * Returns ESP_OK with CAN_VICTRON_DRIVER_EVENT_* bits, ESP_ERR_TIMEOUT, or
+     * another error when the controller is unusable.
+     */
+    esp_err_t (*wait_rx)(uint32_t timeout_ms, uint32_t *out_events);
+
+    /** Fetch one waiting frame without blocking (ESP_ERR_TIMEOUT when empty). */
+    esp_err_t (*receive)(can_victron_driver_frame_t *frame);
+
+    esp_err_t (*get_status)(can_victron_driver_status_t *status);
+} can_victron_driver_t;
+
+/**
+ * @brief Backend selected by CONFIG_TINYBMS_CAN_DRIVER_*.
+ *
+ * Defined by the selected backend; not available on plain host builds, where
+ * can_victron.c compiles without a controller.
+ */
+const can_victron_driver_t *can_victron_driver_default(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,315 @@
+#include "can_victron_driver.h"
+
+#include "can_config_defaults.h"
+
+#if CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN && defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+
+#include "esp_log.h"
+
+// Overrides CONFIG_TINYBMS_CAN_SOCKETCAN_IFACE, handy on CI runners
+#define CAN_VICTRON_SOCKETCAN_IFACE_ENV "TINYBMS_CAN_IFACE"
+
+static const char *TAG = "can_socketcan";
+
+static int s_socket = -1;
+static can_victron_driver_status_t s_status;
+static uint32_t s_pending_events = 0;   // Raised by transmit/receive, reported by wait_rx
+static uint32_t s_rxq_dropped = 0;      // Last SO_RXQ_OVFL counter seen
+
+static void can_victron_socketcan_raise(uint32_t events)
+{
+    __atomic_fetch_or(&s_pending_events, events, __ATOMIC_RELAXED);
+}
+
+static void can_victron_socketcan_set_state(twai_state_t state)
+{
+    twai_state_t previous = __atomic_exchange_n(&s_status.state, state, __ATOMIC_RELAXED);
+    if (previous == state) {
+        return;
+    }
+    if (state == TWAI_STATE_BUS_OFF) {
+        ESP_LOGW(TAG, "CAN interface bus-off or down");
+        can_victron_socketcan_raise(CAN_VICTRON_DRIVER_EVENT_BUS_OFF);
+    } else if (previous == TWAI_STATE_BUS_OFF && state == TWAI_STATE_RUNNING) {
+        ESP_LOGI(TAG, "CAN interface back on the bus");
+        can_victron_socketcan_raise(CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED);
+    }
+}
+
+static esp_err_t can_victron_socketcan_start(const can_victron_driver_config_t *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char *iface = getenv(CAN_VICTRON_SOCKETCAN_IFACE_ENV);
+    if (iface == NULL || iface[0] == '\0') {
+        iface = (config->interface != NULL) ? config->interface : CONFIG_TINYBMS_CAN_SOCKETCAN_IFACE;
+    }
+
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "socket(PF_CAN) failed: %s", strerror(errno));
+        return ESP_FAIL;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, iface, sizeof(ifr.ifr_name) - 1U);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        ESP_LOGE(TAG, "CAN interface %s not found: %s", iface, strerror(errno));
+        close(fd);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (config->rx_filter_mask != 0U) {
+        // Standard frames only; RTR frames still match
+        struct can_filter filter = {
+            .can_id = config->rx_filter_id & config->rx_filter_mask & CAN_SFF_MASK,
+            .can_mask = (config->rx_filter_mask & CAN_SFF_MASK) | CAN_EFF_FLAG,
+        };
+        (void)setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+    }
+
+    can_err_mask_t err_mask = CAN_ERR_BUSOFF | CAN_ERR_RESTARTED | CAN_ERR_LOSTARB |
+                              CAN_ERR_CRTL | CAN_ERR_PROT | CAN_ERR_BUSERROR;
+    (void)setsockopt(fd, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask));
+
+    int enable = 1;
+    (void)setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+    struct sockaddr_can addr = {
+        .can_family = AF_CAN,
+        .can_ifindex = ifr.ifr_ifindex,
+    };
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "bind(%s) failed: %s", iface, strerror(errno));
+        close(fd);
+        return ESP_FAIL;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    (void)fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    memset(&s_status, 0, sizeof(s_status));
+    s_status.state = TWAI_STATE_RUNNING;
+    s_pending_events = 0;
+    s_rxq_dropped = 0;
+    s_socket = fd;
+
+    ESP_LOGI(TAG, "SocketCAN backend bound to %s", iface);
+    return ESP_OK;
+}
+
+static void can_victron_socketcan_stop(void)
+{
+    if (s_socket >= 0) {
+        close(s_socket);
+        s_socket = -1;
+    }
+    s_status.state = TWAI_STATE_STOPPED;
+}
+
+static esp_err_t can_victron_socketcan_transmit(const can_victron_driver_frame_t *frame, uint32_t timeout_ms)
+{
+    if (s_socket < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    struct can_frame cf;
+    memset(&cf, 0, sizeof(cf));
+    cf.can_id = frame->extended ? ((frame->identifier & CAN_EFF_MASK) | CAN_EFF_FLAG)
+                                : (frame->identifier & CAN_SFF_MASK);
+    if (frame->rtr) {
+        cf.can_id |= CAN_RTR_FLAG;
+    }
+    cf.can_dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+    memcpy(cf.data, frame->data, cf.can_dlc);
+
+    for (;;) {
+        ssize_t written = write(s_socket, &cf, sizeof(cf));
+        if (written == (ssize_t)sizeof(cf)) {
+            can_victron_socketcan_set_state(TWAI_STATE_RUNNING);
+            return ESP_OK;
+        }
+
+        if (errno == ENOBUFS || errno == EAGAIN) {
+            // Interface TX queue full (txqueuelen): the bus is saturated
+            struct pollfd pfd = {.fd = s_socket, .events = POLLOUT};
+            if (timeout_ms > 0U && poll(&pfd, 1, (int)timeout_ms) > 0) {
+                timeout_ms = 0U;
+                continue;
+            }
+            __atomic_fetch_add(&s_status.tx_failed_count, 1U, __ATOMIC_RELAXED);
+            return ESP_ERR_TIMEOUT;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+
+        __atomic_fetch_add(&s_status.tx_failed_count, 1U, __ATOMIC_RELAXED);
+        if (errno == ENETDOWN || errno == ENXIO) {
+            // `ip link set vcan0 down` simulates a bus-off
+            can_victron_socketcan_set_state(TWAI_STATE_BUS_OFF);
+            return ESP_ERR_INVALID_STATE;
+        }
+        return ESP_FAIL;
+    }
+}
+
+static esp_err_t can_victron_socketcan_wait_rx(uint32_t timeout_ms, uint32_t *out_events)
+{
+    if (s_socket < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t events = __atomic_exchange_n(&s_pending_events, 0U, __ATOMIC_RELAXED);
+    if (events == 0U) {
+        struct pollfd pfd = {.fd = s_socket, .events = POLLIN};
+        int rc = poll(&pfd, 1, (int)timeout_ms);
+        if (rc <= 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if ((pfd.revents & POLLERR) != 0) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            (void)getsockopt(s_socket, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error == ENETDOWN || error == ENXIO) {
+                can_victron_socketcan_set_state(TWAI_STATE_BUS_OFF);
+            }
+        }
+        if ((pfd.revents & POLLIN) != 0) {
+            events |= CAN_VICTRON_DRIVER_EVENT_RX;
+        }
+        events |= __atomic_exchange_n(&s_pending_events, 0U, __ATOMIC_RELAXED);
+    }
+
+    if (out_events != NULL) {
+        *out_events = events;
+    }
+    return ESP_OK;
+}
+
+static void can_victron_socketcan_handle_error_frame(const struct can_frame *cf)
+{
+    if ((cf->can_id & CAN_ERR_LOSTARB) != 0U) {
+        s_status.arb_lost_count++;
+    }
+    if ((cf->can_id & (CAN_ERR_PROT | CAN_ERR_BUSERROR)) != 0U) {
+        s_status.bus_error_count++;
+    }
+    if ((cf->can_id & CAN_ERR_CRTL) != 0U &&
+        (cf->data[1] & (CAN_ERR_CRTL_RX_OVERFLOW | CAN_ERR_CRTL_TX_OVERFLOW)) != 0U) {
+        s_status.rx_missed_count++;
+        can_victron_socketcan_raise(CAN_VICTRON_DRIVER_EVENT_RX_OVERRUN);
+    }
+#ifdef CAN_ERR_CNT
+    if ((cf->can_id & CAN_ERR_CNT) != 0U) {
+        s_status.tx_error_counter = cf->data[6];
+        s_status.rx_error_counter = cf->data[7];
+    }
+#endif
+    if ((cf->can_id & CAN_ERR_BUSOFF) != 0U) {
+        can_victron_socketcan_set_state(TWAI_STATE_BUS_OFF);
+    } else if ((cf->can_id & CAN_ERR_RESTARTED) != 0U) {
+        can_victron_socketcan_set_state(TWAI_STATE_RUNNING);
+    }
+}
+
+static esp_err_t can_victron_socketcan_receive(can_victron_driver_frame_t *frame)
+{
+    if (s_socket < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    for (;;) {
+        struct can_frame cf;
+        char control[CMSG_SPACE(sizeof(uint32_t))];
+        struct iovec iov = {.iov_base = &cf, .iov_len = sizeof(cf)};
+        struct msghdr msg = {
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = control,
+            .msg_controllen = sizeof(control),
+        };
+
+        ssize_t length = recvmsg(s_socket, &msg, 0);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ENETDOWN || errno == ENXIO) {
+                can_victron_socketcan_set_state(TWAI_STATE_BUS_OFF);
+            }
+            return ESP_ERR_TIMEOUT;
+        }
+        if (length != (ssize_t)sizeof(cf)) {
+            continue;
+        }
+
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t dropped = 0;
+                memcpy(&dropped, CMSG_DATA(cmsg), sizeof(dropped));
+                if (dropped != s_rxq_dropped) {
+                    s_status.rx_missed_count += dropped - s_rxq_dropped;
+                    s_rxq_dropped = dropped;
+                    can_victron_socketcan_raise(CAN_VICTRON_DRIVER_EVENT_RX_OVERRUN);
+                }
+            }
+        }
+
+        if ((cf.can_id & CAN_ERR_FLAG) != 0U) {
+            can_victron_socketcan_handle_error_frame(&cf);
+            continue;
+        }
+
+        can_victron_socketcan_set_state(TWAI_STATE_RUNNING);
+        frame->extended = (cf.can_id & CAN_EFF_FLAG) != 0U;
+        frame->rtr = (cf.can_id & CAN_RTR_FLAG) != 0U;
+        frame->identifier = cf.can_id & (frame->extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+        frame->dlc = (cf.can_dlc > 8U) ? 8U : cf.can_dlc;
+        memcpy(frame->data, cf.data, sizeof(frame->data));
+        return ESP_OK;
+    }
+}
+
+static esp_err_t can_victron_socketcan_get_status(can_victron_driver_status_t *status)
+{
+    if (s_socket < 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *status = s_status;
+    return ESP_OK;
+}
+
+static const can_victron_driver_t s_socketcan_driver = {
+    .name = "socketcan",
+    .start = can_victron_socketcan_start,
+    .stop = can_victron_socketcan_stop,
+    .transmit = can_victron_socketcan_transmit,
+    .wait_rx = can_victron_socketcan_wait_rx,
+    .receive = can_victron_socketcan_receive,
+    .get_status = can_victron_socketcan_get_status,
+};
+
+const can_victron_driver_t *can_victron_driver_default(void)
+{
+    return &s_socketcan_driver;
+}
+
+#endif  // CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN && __linux__
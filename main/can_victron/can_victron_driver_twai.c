@@ -0,0 +1,172 @@
+#include "can_victron_driver.h"
+
+#include "can_config_defaults.h"
+
+#if defined(ESP_PLATFORM) && !CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN
+
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/twai.h"
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+
+#define CAN_VICTRON_TWAI_ALERTS (TWAI_ALERT_RX_DATA | TWAI_ALERT_RX_QUEUE_FULL | \
+                                 TWAI_ALERT_BUS_OFF | TWAI_ALERT_BUS_RECOVERED)
+
+static const char *TAG = "can_twai";
+
+static esp_err_t can_victron_twai_start(const can_victron_driver_config_t *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    twai_general_config_t g_config =
+        TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)config->tx_gpio,
+                                    (gpio_num_t)config->rx_gpio,
+                                    TWAI_MODE_NORMAL);
+    g_config.tx_queue_len = config->tx_queue_len;
+    g_config.rx_queue_len = config->rx_queue_len;
+
+    // Le task bloque sur les alertes RX au lieu de scruter la file
+    g_config.alerts_enabled = CAN_VICTRON_TWAI_ALERTS;
+
+    twai_timing_config_t t_config = TWAI_TIMING_CONFIG_500KBITS();
+    if (config->bitrate_bps != 500000U) {
+        ESP_LOGW(TAG, "Unsupported bitrate %u, using 500 kbit/s", (unsigned)config->bitrate_bps);
+    }
+
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    if (config->rx_filter_mask != 0U) {
+        // Single filter on the 11-bit identifier; acceptance_mask bits set to 1
+        // are don't care, RTR and data bytes are ignored.
+        f_config.acceptance_code = (config->rx_filter_id & 0x7FFU) << 21;
+        f_config.acceptance_mask = ((~config->rx_filter_mask & 0x7FFU) << 21) | 0x001FFFFFU;
+        f_config.single_filter = true;
+    }
+
+    esp_err_t err = twai_driver_install(&g_config, &t_config, &f_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = twai_start();
+    if (err != ESP_OK) {
+        (void)twai_driver_uninstall();
+    }
+    return err;
+}
+
+static void can_victron_twai_stop(void)
+{
+    esp_err_t err = twai_stop();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to stop TWAI: %s", esp_err_to_name(err));
+    }
+
+    err = twai_driver_uninstall();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to uninstall TWAI driver: %s", esp_err_to_name(err));
+    } else {
+        ESP_LOGI(TAG, "TWAI driver uninstalled");
+    }
+}
+
+static esp_err_t can_victron_twai_transmit(const can_victron_driver_frame_t *frame, uint32_t timeout_ms)
+{
+    twai_message_t message = {
+        .identifier = frame->identifier,
+        .flags = (frame->extended ? TWAI_MSG_FLAG_EXTD : 0U) | (frame->rtr ? TWAI_MSG_FLAG_RTR : 0U),
+        .data_length_code = frame->dlc,
+    };
+    memcpy(message.data, frame->data, sizeof(message.data));
+    return twai_transmit(&message, pdMS_TO_TICKS(timeout_ms));
+}
+
+static esp_err_t can_victron_twai_wait_rx(uint32_t timeout_ms, uint32_t *out_events)
+{
+    uint32_t alerts = 0;
+    esp_err_t err = twai_read_alerts(&alerts, pdMS_TO_TICKS(timeout_ms));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t events = 0;
+    if ((alerts & TWAI_ALERT_RX_DATA) != 0U) {
+        events |= CAN_VICTRON_DRIVER_EVENT_RX;
+    }
+    if ((alerts & TWAI_ALERT_RX_QUEUE_FULL) != 0U) {
+        events |= CAN_VICTRON_DRIVER_EVENT_RX | CAN_VICTRON_DRIVER_EVENT_RX_OVERRUN;
+    }
+    if ((alerts & TWAI_ALERT_BUS_OFF) != 0U) {
+        // The controller waits for 128 x 11 recessive bits, then raises BUS_RECOVERED
+        (void)twai_initiate_recovery();
+        events |= CAN_VICTRON_DRIVER_EVENT_BUS_OFF;
+    }
+    if ((alerts & TWAI_ALERT_BUS_RECOVERED) != 0U) {
+        // Recovery leaves the driver stopped
+        err = twai_start();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to restart TWAI after bus-off: %s", esp_err_to_name(err));
+        }
+        events |= CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED;
+    }
+
+    if (out_events != NULL) {
+        *out_events = events;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t can_victron_twai_receive(can_victron_driver_frame_t *frame)
+{
+    twai_message_t message = {0};
+    esp_err_t err = twai_receive(&message, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    frame->identifier = message.identifier;
+    frame->dlc = (message.data_length_code > 8U) ? 8U : message.data_length_code;
+    frame->extended = (message.flags & TWAI_MSG_FLAG_EXTD) != 0U;
+    frame->rtr = (message.flags & TWAI_MSG_FLAG_RTR) != 0U;
+    memcpy(frame->data, message.data, sizeof(frame->data));
+    return ESP_OK;
+}
+
+static esp_err_t can_victron_twai_get_status(can_victron_driver_status_t *status)
+{
+    twai_status_info_t info = {0};
+    esp_err_t err = twai_get_status_info(&info);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    status->state = info.state;
+    status->tx_error_counter = info.tx_error_counter;
+    status->rx_error_counter = info.rx_error_counter;
+    status->tx_failed_count = info.tx_failed_count;
+    status->rx_missed_count = info.rx_missed_count;
+    status->arb_lost_count = info.arb_lost_count;
+    status->bus_error_count = info.bus_error_count;
+    return ESP_OK;
+}
+
+static const can_victron_driver_t s_twai_driver = {
+    .name = "twai",
+    .start = can_victron_twai_start,
+    .stop = can_victron_twai_stop,
+    .transmit = can_victron_twai_transmit,
+    .wait_rx = can_victron_twai_wait_rx,
+    .receive = can_victron_twai_receive,
+    .get_status = can_victron_twai_get_status,
+};
+
+const can_victron_driver_t *can_victron_driver_default(void)
+{
+    return &s_twai_driver;
+}
+
+#endif  // ESP_PLATFORM && !CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN
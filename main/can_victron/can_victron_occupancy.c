@@ -0,0 +1,142 @@
+#include "can_victron_occupancy.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define CAN_VICTRON_OCCUPANCY_SHORT_S 10U
+
+static uint32_t can_victron_occupancy_slot(const can_victron_occupancy_wheel_t *wheel, uint32_t age)
+{
+    // age 0 is the newest completed second
+    return (wheel->head + CAN_VICTRON_OCCUPANCY_SLOTS - 1U - age) % CAN_VICTRON_OCCUPANCY_SLOTS;
+}
+
+static void can_victron_occupancy_push(can_victron_occupancy_wheel_t *wheel, uint32_t bits, uint32_t frames)
+{
+    uint32_t head = wheel->head;
+    uint32_t leaving_short = (head + CAN_VICTRON_OCCUPANCY_SLOTS - CAN_VICTRON_OCCUPANCY_SHORT_S) %
+                             CAN_VICTRON_OCCUPANCY_SLOTS;
+
+    // Slots not filled yet are zero, so subtracting them is harmless
+    wheel->sum_bits_10s -= wheel->bits[leaving_short];
+    wheel->sum_frames_10s -= wheel->frames[leaving_short];
+    wheel->sum_bits_60s -= wheel->bits[head];
+    wheel->sum_frames_60s -= wheel->frames[head];
+
+    wheel->bits[head] = bits;
+    wheel->frames[head] = frames;
+    wheel->sum_bits_10s += bits;
+    wheel->sum_frames_10s += frames;
+    wheel->sum_bits_60s += bits;
+    wheel->sum_frames_60s += frames;
+
+    wheel->head = (head + 1U) % CAN_VICTRON_OCCUPANCY_SLOTS;
+    if (wheel->completed < CAN_VICTRON_OCCUPANCY_SLOTS) {
+        wheel->completed++;
+    }
+}
+
+void can_victron_occupancy_reset(can_victron_occupancy_wheel_t *wheel)
+{
+    if (wheel != NULL) {
+        memset(wheel, 0, sizeof(*wheel));
+    }
+}
+
+void can_victron_occupancy_advance(can_victron_occupancy_wheel_t *wheel, uint64_t now_ms)
+{
+    if (wheel == NULL) {
+        return;
+    }
+
+    uint64_t second = now_ms / 1000U;
+    if (!wheel->started) {
+        wheel->started = true;
+        wheel->current_second = second;
+        return;
+    }
+    if (second <= wheel->current_second) {
+        return;
+    }
+
+    uint64_t idle = second - wheel->current_second - 1U;
+    if (idle >= CAN_VICTRON_OCCUPANCY_SLOTS) {
+        // Everything in the wheel is older than a minute
+        memset(wheel->bits, 0, sizeof(wheel->bits));
+        memset(wheel->frames, 0, sizeof(wheel->frames));
+        wheel->sum_bits_10s = 0;
+        wheel->sum_bits_60s = 0;
+        wheel->sum_frames_10s = 0;
+        wheel->sum_frames_60s = 0;
+        wheel->completed = CAN_VICTRON_OCCUPANCY_SLOTS;
+    } else {
+        can_victron_occupancy_push(wheel, wheel->current_bits, wheel->current_frames);
+        for (uint64_t i = 0; i < idle; ++i) {
+            can_victron_occupancy_push(wheel, 0U, 0U);
+        }
+    }
+
+    wheel->current_second = second;
+    wheel->current_bits = 0;
+    wheel->current_frames = 0;
+}
+
+void can_victron_occupancy_add(can_victron_occupancy_wheel_t *wheel, uint64_t timestamp_ms, uint32_t bits)
+{
+    if (wheel == NULL) {
+        return;
+    }
+
+    can_victron_occupancy_advance(wheel, timestamp_ms);
+    wheel->current_bits += bits;
+    wheel->current_frames++;
+}
+
+void can_victron_occupancy_get(const can_victron_occupancy_wheel_t *wheel,
+                               uint32_t window_s,
+                               uint32_t bitrate_bps,
+                               can_victron_occupancy_window_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (wheel == NULL || bitrate_bps == 0U) {
+        return;
+    }
+
+    if (window_s == 0U) {
+        window_s = 1U;
+    } else if (window_s > CAN_VICTRON_OCCUPANCY_SLOTS) {
+        window_s = CAN_VICTRON_OCCUPANCY_SLOTS;
+    }
+
+    uint32_t span = (window_s < wheel->completed) ? window_s : wheel->completed;
+    if (span == 0U) {
+        return;
+    }
+
+    uint64_t bits = 0;
+    uint32_t frames = 0;
+    if (window_s == CAN_VICTRON_OCCUPANCY_SLOTS) {
+        bits = wheel->sum_bits_60s;
+        frames = wheel->sum_frames_60s;
+    } else if (window_s == CAN_VICTRON_OCCUPANCY_SHORT_S) {
+        bits = wheel->sum_bits_10s;
+        frames = wheel->sum_frames_10s;
+    } else {
+        for (uint32_t age = 0; age < span; ++age) {
+            uint32_t slot = can_victron_occupancy_slot(wheel, age);
+            bits += wheel->bits[slot];
+            frames += wheel->frames[slot];
+        }
+    }
+
+    double occupancy = (double)bits / ((double)bitrate_bps * (double)span);
+    if (occupancy > 1.0) {
+        occupancy = 1.0;
+    }
+    out->window_s = span;
+    out->occupancy_pct = (float)(occupancy * 100.0);
+    out->frames_per_s = (float)frames / (float)span;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * @file can_victron_occupancy.h
+ * @brief Per-second CAN bus occupancy wheel
+ *
+ * Frames are accumulated into the current second; when the second rolls over
+ * its totals are pushed into a wheel of CAN_VICTRON_OCCUPANCY_SLOTS completed
+ * seconds. Running sums over the last 10 and 60 seconds are updated on each
+ * push, so recording a frame and reading the 1 s, 10 s or 60 s figures are
+ * O(1) and memory does not grow with bus traffic.
+ *
+ * Windows cover whole completed seconds: figures lag by less than one second
+ * but count every frame exactly. The wheel does no locking, callers serialise
+ * access.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAN_VICTRON_OCCUPANCY_SLOTS 60U
+
+/**
+ * @brief Wheel state, zero-initialised by can_victron_occupancy_reset().
+ */
+typedef struct {
+    uint32_t bits[CAN_VICTRON_OCCUPANCY_SLOTS];   /**< Bits on the wire per completed second. */
+    uint32_t frames[CAN_VICTRON_OCCUPANCY_SLOTS]; /**< Frames per completed second. */
+    uint32_t head;              /**< Slot receiving the next completed second. */
+    uint32_t completed;         /**< Completed seconds held, saturates at the slot count. */
+    uint64_t current_second;    /**< Second being accumulated (timestamp_ms / 1000). */
+    uint32_t current_bits;
+    uint32_t current_frames;
+    uint64_t sum_bits_10s;
+    uint64_t sum_bits_60s;
+    uint32_t sum_frames_10s;
+    uint32_t sum_frames_60s;
+    bool started;
+} can_victron_occupancy_wheel_t;
+
+/**
+ * @brief Occupancy and frame rate over one trailing window.
+ */
+typedef struct {
+    uint32_t window_s;          /**< Completed seconds actually covered (0 until the first rollover). */
+    float occupancy_pct;        /**< Bits on the wire / (bitrate * window), in percent. */
+    float frames_per_s;         /**< Frames (TX + RX) per second. */
+} can_victron_occupancy_window_t;
+
+void can_victron_occupancy_reset(can_victron_occupancy_wheel_t *wheel);
+
+/**
+ * @brief Move the wheel to @p now_ms, closing elapsed seconds.
+ *
+ * Idle gaps push empty seconds; a gap longer than the wheel clears it.
+ */
+void can_victron_occupancy_advance(can_victron_occupancy_wheel_t *wheel, uint64_t now_ms);
+
+/**
+ * @brief Account one frame of @p bits wire bits seen at @p timestamp_ms.
+ *
+ * Frames stamped before the current second (e.g. taken before a lock) are
+ * counted in the current second.
+ */
+void can_victron_occupancy_add(can_victron_occupancy_wheel_t *wheel, uint64_t timestamp_ms, uint32_t bits);
+
+/**
+ * @brief Read the last @p window_s completed seconds (clamped to 1..60).
+ *
+ * O(1) for 1, 10 and 60 seconds, O(window) otherwise. Call
+ * can_victron_occupancy_advance() first so idle time is accounted.
+ */
+void can_victron_occupancy_get(const can_victron_occupancy_wheel_t *wheel,
+                               uint32_t window_s,
+                               uint32_t bitrate_bps,
+                               can_victron_occupancy_window_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -42,6 +42,7 @@
 #include "esp_err.h"
 
 #include "event_bus.h"
+#include "json_writer.h"
 #include "mqtt_client.h"
 
 #define CONFIG_MANAGER_DEVICE_NAME_MAX_LENGTH 64
@@ -117,6 +118,14 @@ esp_err_t config_manager_get_config_json(char *buffer,
                                          config_manager_snapshot_flags_t flags);
 esp_err_t config_manager_set_config_json(const char *json, size_t length);
 esp_err_t config_manager_get_registers_json(char *buffer, size_t buffer_size, size_t *out_length);
+
+/**
+ * @brief Stream the register catalogue of config_manager_get_registers_json()
+ *
+ * Raw values are copied under the lock first; the lock is not held while
+ * @p writer flushes.
+ */
+esp_err_t config_manager_write_registers_json(json_writer_t *writer);
 esp_err_t config_manager_apply_register_update_json(const char *json, size_t length);
 
 const config_manager_device_settings_t *config_manager_get_device_settings(void);
@@ -149,6 +158,16 @@ const config_manager_can_settings_t *config_manager_get_can_settings(void);
 
 const char *config_manager_mask_secret(const char *value);
 
+/**
+ * @brief Return the configuration generation counter.
+ *
+ * The counter is incremented each time an APP_EVENT_ID_CONFIG_UPDATED event is
+ * emitted (snapshot or register change), whether or not an event publisher is
+ * attached. Modules caching configuration-derived data compare it against the
+ * value they last saw.
+ */
+uint32_t config_manager_get_generation(void);
+
 #define CONFIG_MANAGER_MAX_CONFIG_SIZE 2048
 #define CONFIG_MANAGER_MAX_REGISTERS_JSON 4096
 
@@ -97,6 +97,11 @@ static bool s_nvs_initialised = false;
 static SemaphoreHandle_t s_config_mutex = NULL;
 static const TickType_t CONFIG_MANAGER_MUTEX_TIMEOUT_TICKS = pdMS_TO_TICKS(1000);
 
+// Bumped alongside every CONFIG_UPDATED event so consumers can detect changes
+// by polling instead of subscribing to the event bus.
+static uint32_t s_config_generation = 0;
+static portMUX_TYPE s_config_generation_lock = portMUX_INITIALIZER_UNLOCKED;
+
 static void config_manager_make_register_key(uint16_t address, char *out_key, size_t out_size)
 {
     if (out_key == NULL || out_size == 0) {
@@ -410,8 +415,25 @@ bool config_manager_load_register_raw(uint16_t address, uint16_t *out_value)
 }
 #endif
 
+static void config_manager_bump_generation(void)
+{
+    portENTER_CRITICAL(&s_config_generation_lock);
+    ++s_config_generation;
+    portEXIT_CRITICAL(&s_config_generation_lock);
+}
+
+uint32_t config_manager_get_generation(void)
+{
+    portENTER_CRITICAL(&s_config_generation_lock);
+    uint32_t generation = s_config_generation;
+    portEXIT_CRITICAL(&s_config_generation_lock);
+    return generation;
+}
+
 void config_manager_publish_config_snapshot(void)
 {
+    config_manager_bump_generation();
+
     if (s_event_publisher == NULL || s_config_length_public == 0) {
         return;
     }
@@ -430,6 +452,8 @@ void config_manager_publish_config_snapshot(void)
 void config_manager_publish_register_change(const config_manager_register_descriptor_t *desc,
                                              uint16_t raw_value)
 {
+    config_manager_bump_generation();
+
     if (s_event_publisher == NULL || desc == NULL) {
         return;
     }
@@ -20,6 +20,7 @@
 
 #include "app_config.h"
 #include "app_events.h"
+#include "json_writer.h"
 #include "mqtt_topics.h"
 #include "uart_bms.h"
 
@@ -820,34 +821,29 @@ esp_err_t config_manager_set_config_json(const char *json, size_t length)
     return config_manager_apply_config_payload(json, length, true, true);
 }
 
-esp_err_t config_manager_get_registers_json(char *buffer, size_t buffer_size, size_t *out_length)
+esp_err_t config_manager_write_registers_json(json_writer_t *writer)
 {
-    if (buffer == NULL || buffer_size == 0) {
+    if (writer == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
     config_manager_ensure_initialised();
 
+    // Descriptors are constant: only the raw values need the lock, and they
+    // are copied so that the writer may block on the socket without it.
+    uint16_t raw_values[sizeof(s_register_descriptors) / sizeof(s_register_descriptors[0])];
     esp_err_t lock_err = config_manager_lock(portMAX_DELAY);
     if (lock_err != ESP_OK) {
         return lock_err;
     }
+    memcpy(raw_values, s_register_raw_values, sizeof(raw_values));
+    config_manager_unlock();
 
-    esp_err_t result = ESP_OK;
-    size_t offset = 0;
-
-    if (!config_manager_json_append(buffer,
-                                    buffer_size,
-                                    &offset,
-                                    "{\"total\":%zu,\"registers\":[",
-                                    s_register_count)) {
-        result = ESP_ERR_INVALID_SIZE;
-        goto cleanup;
-    }
+    json_writer_printf(writer, "{\"total\":%zu,\"registers\":[", s_register_count);
 
-    for (size_t i = 0; i < s_register_count; ++i) {
+    for (size_t i = 0; i < s_register_count && json_writer_ok(writer); ++i) {
         const config_manager_register_descriptor_t *desc = &s_register_descriptors[i];
-        uint16_t raw_value = s_register_raw_values[i];
+        uint16_t raw_value = raw_values[i];
         bool is_enum = (desc->value_class == CONFIG_MANAGER_VALUE_ENUM);
         float user_value = is_enum ? (float)raw_value : config_manager_raw_to_user(desc, raw_value);
         float min_user = (desc->has_min && !is_enum) ? config_manager_raw_to_user(desc, desc->min_raw) : 0.0f;
@@ -861,118 +857,75 @@ esp_err_t config_manager_get_registers_json(char *buffer, size_t buffer_size, si
             access_str = "wo";
         }
 
-        if (!config_manager_json_append(buffer,
-                                        buffer_size,
-                                        &offset,
-                                        "%s{\"key\":\"%s\",\"label\":\"%s\",\"unit\":\"%s\",\"group\":\"%s\","\
-                                        "\"type\":\"%s\",\"access\":\"%s\",\"address\":%u,\"scale\":%.6f,"\
-                                        "\"precision\":%u,\"value\":%.*f,\"raw\":%u,\"default\":%.*f",
-                                        (i == 0) ? "" : ",",
-                                        desc->key,
-                                        desc->label != NULL ? desc->label : "",
-                                        desc->unit != NULL ? desc->unit : "",
-                                        desc->group != NULL ? desc->group : "",
-                                        desc->type != NULL ? desc->type : "",
-                                        access_str,
-                                        (unsigned)desc->address,
-                                        desc->scale,
-                                        (unsigned)desc->precision,
-                                        is_enum ? 0 : desc->precision,
-                                        user_value,
-                                        (unsigned)raw_value,
-                                        is_enum ? 0 : desc->precision,
-                                        default_user)) {
-            result = ESP_ERR_INVALID_SIZE;
-            goto cleanup;
-        }
+        json_writer_printf(writer,
+                           "%s{\"key\":\"%s\",\"label\":\"%s\",\"unit\":\"%s\",\"group\":\"%s\","\
+                           "\"type\":\"%s\",\"access\":\"%s\",\"address\":%u,\"scale\":%.6f,"\
+                           "\"precision\":%u,\"value\":%.*f,\"raw\":%u,\"default\":%.*f",
+                           (i == 0) ? "" : ",",
+                           desc->key,
+                           desc->label != NULL ? desc->label : "",
+                           desc->unit != NULL ? desc->unit : "",
+                           desc->group != NULL ? desc->group : "",
+                           desc->type != NULL ? desc->type : "",
+                           access_str,
+                           (unsigned)desc->address,
+                           desc->scale,
+                           (unsigned)desc->precision,
+                           is_enum ? 0 : desc->precision,
+                           user_value,
+                           (unsigned)raw_value,
+                           is_enum ? 0 : desc->precision,
+                           default_user);
 
         if (!is_enum) {
-            if (desc->has_min &&
-                !config_manager_json_append(buffer,
-                                            buffer_size,
-                                            &offset,
-                                            ",\"min\":%.*f",
-                                            desc->precision,
-                                            min_user)) {
-                result = ESP_ERR_INVALID_SIZE;
-                goto cleanup;
+            if (desc->has_min) {
+                json_writer_printf(writer, ",\"min\":%.*f", desc->precision, min_user);
             }
-            if (desc->has_max &&
-                !config_manager_json_append(buffer,
-                                            buffer_size,
-                                            &offset,
-                                            ",\"max\":%.*f",
-                                            desc->precision,
-                                            max_user)) {
-                result = ESP_ERR_INVALID_SIZE;
-                goto cleanup;
+            if (desc->has_max) {
+                json_writer_printf(writer, ",\"max\":%.*f", desc->precision, max_user);
             }
-            if (desc->step_raw > 0.0f &&
-                !config_manager_json_append(buffer,
-                                            buffer_size,
-                                            &offset,
-                                            ",\"step\":%.*f",
-                                            desc->precision,
-                                            step_user)) {
-                result = ESP_ERR_INVALID_SIZE;
-                goto cleanup;
+            if (desc->step_raw > 0.0f) {
+                json_writer_printf(writer, ",\"step\":%.*f", desc->precision, step_user);
             }
         }
 
-        if (desc->comment != NULL &&
-            !config_manager_json_append(buffer,
-                                        buffer_size,
-                                        &offset,
-                                        ",\"comment\":\"%s\"",
-                                        desc->comment)) {
-            result = ESP_ERR_INVALID_SIZE;
-            goto cleanup;
+        if (desc->comment != NULL) {
+            json_writer_printf(writer, ",\"comment\":");
+            json_writer_string(writer, desc->comment);
         }
 
         if (desc->enum_count > 0U) {
-            if (!config_manager_json_append(buffer,
-                                            buffer_size,
-                                            &offset,
-                                            ",\"enum\":[")) {
-                result = ESP_ERR_INVALID_SIZE;
-                goto cleanup;
-            }
+            json_writer_printf(writer, ",\"enum\":[");
             for (size_t e = 0; e < desc->enum_count; ++e) {
                 const config_manager_enum_entry_t *entry = &desc->enum_values[e];
-                if (!config_manager_json_append(buffer,
-                                                buffer_size,
-                                                &offset,
-                                                "%s{\"value\":%u,\"label\":\"%s\"}",
-                                                (e == 0) ? "" : ",",
-                                                (unsigned)entry->value,
-                                                entry->label != NULL ? entry->label : "")) {
-                    result = ESP_ERR_INVALID_SIZE;
-                    goto cleanup;
-                }
-            }
-            if (!config_manager_json_append(buffer, buffer_size, &offset, "]")) {
-                result = ESP_ERR_INVALID_SIZE;
-                goto cleanup;
+                json_writer_printf(writer,
+                                   "%s{\"value\":%u,\"label\":\"%s\"}",
+                                   (e == 0) ? "" : ",",
+                                   (unsigned)entry->value,
+                                   entry->label != NULL ? entry->label : "");
             }
+            json_writer_printf(writer, "]");
         }
 
-        if (!config_manager_json_append(buffer, buffer_size, &offset, "}")) {
-            result = ESP_ERR_INVALID_SIZE;
-            goto cleanup;
-        }
+        json_writer_printf(writer, "}");
     }
 
-    if (!config_manager_json_append(buffer, buffer_size, &offset, "]}")) {
-        result = ESP_ERR_INVALID_SIZE;
-        goto cleanup;
-    }
+    json_writer_printf(writer, "]}");
+    return writer->error;
+}
 
-    if (out_length != NULL) {
-        *out_length = offset;
+esp_err_t config_manager_get_registers_json(char *buffer, size_t buffer_size, size_t *out_length)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-cleanup:
-    config_manager_unlock();
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, buffer_size, NULL, NULL);
+    esp_err_t result = config_manager_write_registers_json(&writer);
+    if (result == ESP_OK) {
+        result = json_writer_finish(&writer, out_length);
+    }
     if (result != ESP_OK && out_length != NULL) {
         *out_length = 0;
     }
@@ -248,14 +248,23 @@ void event_bus_unsubscribe(event_bus_subscription_handle_t handle)
     vPortFree(to_free);
 }
 
+// The payload is owned by the bus from the publish call on, delivered or not
+static bool event_bus_discard(const event_bus_event_t *event)
+{
+    if (event->dispose != NULL) {
+        event->dispose(event->dispose_context);
+    }
+    return false;
+}
+
 bool event_bus_publish(const event_bus_event_t *event, TickType_t timeout)
 {
-    if (event == NULL || s_bus_lock == NULL) {
+    if (event == NULL) {
         return false;
     }
 
-    if (!event_bus_take_lock()) {
-        return false;
+    if (s_bus_lock == NULL || !event_bus_take_lock()) {
+        return event_bus_discard(event);
     }
 
     event_bus_event_lifetime_t *shared_lifetime = NULL;
@@ -263,7 +272,7 @@ bool event_bus_publish(const event_bus_event_t *event, TickType_t timeout)
         shared_lifetime = pvPortMalloc(sizeof(event_bus_event_lifetime_t));
         if (shared_lifetime == NULL) {
             event_bus_give_lock();
-            return false;
+            return event_bus_discard(event);
         }
         shared_lifetime->dispose = event->dispose;
         shared_lifetime->context = event->dispose_context;
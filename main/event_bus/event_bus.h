@@ -121,6 +121,11 @@ void event_bus_unsubscribe(event_bus_subscription_handle_t handle);
  *                  - portMAX_DELAY: Wait indefinitely
  *                  - Other value: Maximum ticks to wait for queue space
  *
+ * When @p event carries a dispose callback, the bus owns the payload from
+ * this call on: dispose runs exactly once, after the last subscriber released
+ * the event, or before returning when nobody received it. The publisher must
+ * never release the payload itself, whatever the return value.
+ *
  * @return true when all subscribers accepted the event, false otherwise. When
  *         false is returned, at least one subscriber queue was full and the
  *         event was discarded for that subscriber after the timeout expired.
@@ -32,8 +32,10 @@ typedef enum {
     APP_EVENT_ID_CAN_FRAME_RAW = 0x1200,
     /** Human readable representation of a CAN frame. */
     APP_EVENT_ID_CAN_FRAME_DECODED = 0x1201,
-    /** Binary CAN frame prepared by the CAN publisher. */
+    /** Binary CAN frame(s) sent by the CAN publisher: one, or an array for a batched cycle. */
     APP_EVENT_ID_CAN_FRAME_READY = 0x1202,
+    /** JSON array of the CAN frames transmitted in one publisher cycle. */
+    APP_EVENT_ID_CAN_FRAME_BATCH = 0x1203,
     /** Wi-Fi station interface has started. */
     APP_EVENT_ID_WIFI_STA_START = 0x1300,
     /** Wi-Fi station connected to the configured access point. */
@@ -47,6 +47,63 @@ extern "C" {
 #define CONFIG_TINYBMS_CAN_PUBLISHER_PERIOD_MS 0
 #endif
 
+// Controller backend: TWAI unless the linux target selects SocketCAN
+#ifndef CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN
+#define CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN 0
+#endif
+
+#ifndef CONFIG_TINYBMS_CAN_SOCKETCAN_IFACE
+#define CONFIG_TINYBMS_CAN_SOCKETCAN_IFACE "vcan0"
+#endif
+
+// Receive every frame instead of filtering on 0x305/0x307 in hardware
+#ifndef CONFIG_TINYBMS_CAN_RX_ACCEPT_ALL
+#define CONFIG_TINYBMS_CAN_RX_ACCEPT_ALL 0
+#endif
+
+// =============================================================================
+// CAN TX Shaping Configuration
+// =============================================================================
+
+// Bus occupancy (percent, measured over the last second) above which
+// low-priority channels are stretched, and below which they are restored.
+#ifndef CONFIG_TINYBMS_CAN_SHAPING_THRESHOLD_PCT
+#define CONFIG_TINYBMS_CAN_SHAPING_THRESHOLD_PCT 50
+#endif
+
+#ifndef CONFIG_TINYBMS_CAN_SHAPING_RELEASE_PCT
+#define CONFIG_TINYBMS_CAN_SHAPING_RELEASE_PCT 35
+#endif
+
+// Period multiplier applied to low-priority channels while shaping is active
+#ifndef CONFIG_TINYBMS_CAN_SHAPING_STRETCH_FACTOR
+#define CONFIG_TINYBMS_CAN_SHAPING_STRETCH_FACTOR 4
+#endif
+
+// Minimum spacing between an out-of-band (on-change) frame and the previous
+// transmission of the same critical channel, in periodic mode
+#ifndef CONFIG_TINYBMS_CAN_ON_CHANGE_GUARD_MS
+#define CONFIG_TINYBMS_CAN_ON_CHANGE_GUARD_MS 100
+#endif
+
+// =============================================================================
+// CAN Capture Configuration
+// =============================================================================
+
+// Frames kept in the binary capture ring (16 bytes each, 0 disables capture)
+#ifndef CONFIG_TINYBMS_CAN_CAPTURE_DEPTH
+#define CONFIG_TINYBMS_CAN_CAPTURE_DEPTH 512
+#endif
+
+// Append the capture ring to the history filesystem
+#ifndef CONFIG_TINYBMS_CAN_CAPTURE_SPILL
+#define CONFIG_TINYBMS_CAN_CAPTURE_SPILL 0
+#endif
+
+#ifndef CONFIG_TINYBMS_CAN_CAPTURE_SPILL_MAX_BYTES
+#define CONFIG_TINYBMS_CAN_CAPTURE_SPILL_MAX_BYTES 262144
+#endif
+
 // =============================================================================
 // CAN Protocol Configuration
 // =============================================================================
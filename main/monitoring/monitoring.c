@@ -1,9 +1,11 @@
 #include "monitoring.h"
 
+#include <assert.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_err.h"
@@ -18,6 +20,8 @@
 #include "can_publisher/conversion_table.h"
 #include "uart_bms.h"
 #include "history_logger.h"
+#include "json_writer.h"
+#include "telemetry_binary.h"
 
 static const char *TAG = "monitoring";
 
@@ -31,6 +35,7 @@ typedef struct {
 } monitoring_history_entry_t;
 
 #define MONITORING_HISTORY_CAPACITY 512
+#define MONITORING_HISTORY_BATCH    8U   // Entries copied per mutex hold when streaming
 
 static event_bus_publish_fn_t s_event_publisher = NULL;
 static uart_bms_live_data_t s_latest_bms = {0};
@@ -38,12 +43,24 @@ static bool s_has_latest_bms = false;
 static monitoring_history_entry_t s_history[MONITORING_HISTORY_CAPACITY];
 static size_t s_history_head = 0;
 static size_t s_history_count = 0;
-static char s_last_snapshot[MONITORING_SNAPSHOT_MAX_SIZE] = {0};
-static size_t s_last_snapshot_len = 0;
+static uint64_t s_history_written = 0;  // Pushes since init, to address entries by sequence
+
+// Telemetry sample published on the event bus: rendered once in its wrapped
+// {"battery":...} form, the event payload being the snapshot inside it and
+// the event dispose_context this buffer
+struct monitoring_snapshot {
+    uint32_t refs;
+    size_t length;  // Wrapped length, without the NUL
+    char data[];
+};
 
 // Mutex to protect access to shared monitoring state
 static SemaphoreHandle_t s_monitoring_mutex = NULL;
 
+// Bumped with each TinyBMS sample, read by response caches
+static uint32_t s_sample_generation = 0;
+static portMUX_TYPE s_sample_generation_lock = portMUX_INITIALIZER_UNLOCKED;
+
 #define MONITORING_DIAGNOSTICS_INTERVAL_MS    5000U
 #define MONITORING_MAX_EVENT_BUS_CONSUMERS    16U
 
@@ -54,6 +71,11 @@ typedef struct {
     uint64_t snapshot_latency_total_us;
     uint32_t snapshot_latency_samples;
     uint32_t snapshot_latency_max_us;
+    uint32_t snapshot_bytes_last;
+    uint64_t binary_latency_total_us;
+    uint32_t binary_latency_samples;
+    uint32_t binary_latency_max_us;
+    uint32_t binary_bytes_last;
 } monitoring_diagnostics_state_t;
 
 static monitoring_diagnostics_state_t s_diagnostics_state = {0};
@@ -84,7 +106,7 @@ static uint32_t monitoring_diagnostics_record_publish_failure(void)
     return value;
 }
 
-static void monitoring_diagnostics_record_snapshot_latency(uint32_t duration_us)
+static void monitoring_diagnostics_record_snapshot_latency(uint32_t duration_us, size_t length)
 {
     portENTER_CRITICAL(&s_diagnostics_lock);
     s_diagnostics_state.snapshot_latency_total_us += (uint64_t)duration_us;
@@ -92,6 +114,19 @@ static void monitoring_diagnostics_record_snapshot_latency(uint32_t duration_us)
     if (duration_us > s_diagnostics_state.snapshot_latency_max_us) {
         s_diagnostics_state.snapshot_latency_max_us = duration_us;
     }
+    s_diagnostics_state.snapshot_bytes_last = (uint32_t)length;
+    portEXIT_CRITICAL(&s_diagnostics_lock);
+}
+
+static void monitoring_diagnostics_record_binary_latency(uint32_t duration_us, size_t length)
+{
+    portENTER_CRITICAL(&s_diagnostics_lock);
+    s_diagnostics_state.binary_latency_total_us += (uint64_t)duration_us;
+    s_diagnostics_state.binary_latency_samples++;
+    if (duration_us > s_diagnostics_state.binary_latency_max_us) {
+        s_diagnostics_state.binary_latency_max_us = duration_us;
+    }
+    s_diagnostics_state.binary_bytes_last = (uint32_t)length;
     portEXIT_CRITICAL(&s_diagnostics_lock);
 }
 
@@ -171,6 +206,7 @@ static void monitoring_history_push(const uart_bms_live_data_t *data)
     if (s_history_count < MONITORING_HISTORY_CAPACITY) {
         ++s_history_count;
     }
+    ++s_history_written;
 
     xSemaphoreGive(s_monitoring_mutex);
 }
@@ -199,6 +235,32 @@ static bool monitoring_json_append(char *buffer, size_t buffer_size, size_t *off
     return true;
 }
 
+// Values of the snapshot that do not come straight from the BMS, shared by
+// the JSON and binary encodings.
+static void monitoring_compute_extras(const uart_bms_live_data_t *snapshot, telemetry_binary_extras_t *out)
+{
+    double energy_charged_wh = 0.0;
+    double energy_discharged_wh = 0.0;
+    can_publisher_conversion_get_energy_state(&energy_charged_wh, &energy_discharged_wh);
+
+    if (!isfinite(energy_charged_wh) || energy_charged_wh < 0.0) {
+        energy_charged_wh = 0.0;
+    }
+    if (!isfinite(energy_discharged_wh) || energy_discharged_wh < 0.0) {
+        energy_discharged_wh = 0.0;
+    }
+
+    float pack_voltage_v = isfinite((double)snapshot->pack_voltage_v) ? snapshot->pack_voltage_v : 0.0f;
+    float pack_current_a = isfinite((double)snapshot->pack_current_a) ? snapshot->pack_current_a : 0.0f;
+    float power_w = pack_voltage_v * pack_current_a;
+
+    out->power_w = isfinite((double)power_w) ? power_w : 0.0f;
+    out->is_charging = (pack_current_a > 0.05f) ? 1U : 0U;
+    out->energy_charged_wh = (energy_charged_wh > 0.0) ? (uint32_t)(energy_charged_wh + 0.5) : 0U;
+    out->energy_discharged_wh = (energy_discharged_wh > 0.0) ? (uint32_t)(energy_discharged_wh + 0.5) : 0U;
+    out->history_available = monitoring_history_empty() ? 0U : 1U;
+}
+
 static esp_err_t monitoring_build_snapshot_json(const uart_bms_live_data_t *data,
                                                 char *buffer,
                                                 size_t buffer_size,
@@ -211,16 +273,8 @@ static esp_err_t monitoring_build_snapshot_json(const uart_bms_live_data_t *data
     uart_bms_live_data_t empty = {0};
     const uart_bms_live_data_t *snapshot = data != NULL ? data : &empty;
 
-    double energy_charged_wh = 0.0;
-    double energy_discharged_wh = 0.0;
-    can_publisher_conversion_get_energy_state(&energy_charged_wh, &energy_discharged_wh);
-
-    if (!isfinite(energy_charged_wh) || energy_charged_wh < 0.0) {
-        energy_charged_wh = 0.0;
-    }
-    if (!isfinite(energy_discharged_wh) || energy_discharged_wh < 0.0) {
-        energy_discharged_wh = 0.0;
-    }
+    telemetry_binary_extras_t extras = {0};
+    monitoring_compute_extras(snapshot, &extras);
 
     float pack_voltage_v = snapshot->pack_voltage_v;
     if (!isfinite((double)pack_voltage_v)) {
@@ -232,16 +286,6 @@ static esp_err_t monitoring_build_snapshot_json(const uart_bms_live_data_t *data
         pack_current_a = 0.0f;
     }
 
-    float power_w = pack_voltage_v * pack_current_a;
-    if (!isfinite((double)power_w)) {
-        power_w = 0.0f;
-    }
-
-    bool is_charging = (pack_current_a > 0.05f);
-
-    uint32_t energy_in_wh = (energy_charged_wh > 0.0) ? (uint32_t)(energy_charged_wh + 0.5) : 0U;
-    uint32_t energy_out_wh = (energy_discharged_wh > 0.0) ? (uint32_t)(energy_discharged_wh + 0.5) : 0U;
-
     size_t offset = 0;
     if (!monitoring_json_append(buffer,
                                 buffer_size,
@@ -265,8 +309,8 @@ static esp_err_t monitoring_build_snapshot_json(const uart_bms_live_data_t *data
                                 snapshot->timestamp_ms,
                                 pack_voltage_v,
                                 pack_current_a,
-                                power_w,
-                                is_charging ? "true" : "false",
+                                extras.power_w,
+                                extras.is_charging ? "true" : "false",
                                 snapshot->state_of_charge_pct,
                                 snapshot->state_of_health_pct,
                                 snapshot->average_temperature_c,
@@ -298,8 +342,8 @@ static esp_err_t monitoring_build_snapshot_json(const uart_bms_live_data_t *data
                                 (unsigned)snapshot->firmware_version,
                                 (unsigned)snapshot->firmware_flags,
                                 (unsigned)snapshot->internal_firmware_version,
-                                (unsigned)energy_in_wh,
-                                (unsigned)energy_out_wh)) {
+                                (unsigned)extras.energy_charged_wh,
+                                (unsigned)extras.energy_discharged_wh)) {
         return ESP_ERR_INVALID_SIZE;
     }
 
@@ -356,7 +400,7 @@ static esp_err_t monitoring_build_snapshot_json(const uart_bms_live_data_t *data
                                 buffer_size,
                                 &offset,
                                 "],\"history_available\":%s}",
-                                monitoring_history_empty() ? "false" : "true")) {
+                                extras.history_available ? "true" : "false")) {
         return ESP_ERR_INVALID_SIZE;
     }
 
@@ -423,13 +467,32 @@ static esp_err_t monitoring_build_diagnostics_json(char *buffer, size_t buffer_s
     if (!monitoring_json_append(buffer,
                                 buffer_size,
                                 &offset,
-                                "\"snapshot_latency\":{\"avg_us\":%" PRIu32 ",\"max_us\":%" PRIu32 ",\"samples\":%" PRIu32 "}}",
+                                "\"snapshot_latency\":{\"avg_us\":%" PRIu32 ",\"max_us\":%" PRIu32 ",\"samples\":%" PRIu32 "},",
                                 avg_latency_us,
                                 diagnostics.snapshot_latency_max_us,
                                 diagnostics.snapshot_latency_samples)) {
         return ESP_ERR_INVALID_SIZE;
     }
 
+    // Cost per push of each /ws/telemetry encoding, side by side
+    uint32_t avg_binary_us = 0;
+    if (diagnostics.binary_latency_samples > 0U) {
+        avg_binary_us = (uint32_t)(diagnostics.binary_latency_total_us / diagnostics.binary_latency_samples);
+    }
+    if (!monitoring_json_append(buffer,
+                                buffer_size,
+                                &offset,
+                                "\"snapshot_cost\":{\"json\":{\"bytes\":%" PRIu32 ",\"avg_us\":%" PRIu32 "},"
+                                "\"binary\":{\"bytes\":%" PRIu32 ",\"avg_us\":%" PRIu32 ",\"max_us\":%" PRIu32 ",\"samples\":%" PRIu32 "}}}",
+                                diagnostics.snapshot_bytes_last,
+                                avg_latency_us,
+                                diagnostics.binary_bytes_last,
+                                avg_binary_us,
+                                diagnostics.binary_latency_max_us,
+                                diagnostics.binary_latency_samples)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
     if (out_length != NULL) {
         *out_length = offset;
     }
@@ -437,7 +500,7 @@ static esp_err_t monitoring_build_diagnostics_json(char *buffer, size_t buffer_s
     return ESP_OK;
 }
 
-static esp_err_t monitoring_prepare_snapshot(void)
+static esp_err_t monitoring_prepare_snapshot(char *buffer, size_t buffer_size, size_t *out_length)
 {
     if (s_monitoring_mutex == NULL) {
         return ESP_ERR_INVALID_STATE;
@@ -463,14 +526,13 @@ static esp_err_t monitoring_prepare_snapshot(void)
 
     const uart_bms_live_data_t *snapshot = has_data ? &bms_copy : NULL;
     uint64_t start_us = esp_timer_get_time();
-    esp_err_t build_err =
-        monitoring_build_snapshot_json(snapshot, s_last_snapshot, sizeof(s_last_snapshot), &s_last_snapshot_len);
+    esp_err_t build_err = monitoring_build_snapshot_json(snapshot, buffer, buffer_size, out_length);
     if (build_err == ESP_OK) {
         uint64_t duration_us = esp_timer_get_time() - start_us;
         if (duration_us > UINT32_MAX) {
             duration_us = UINT32_MAX;
         }
-        monitoring_diagnostics_record_snapshot_latency((uint32_t)duration_us);
+        monitoring_diagnostics_record_snapshot_latency((uint32_t)duration_us, *out_length);
     }
 
     return build_err;
@@ -488,6 +550,10 @@ static void monitoring_on_bms_update(const uart_bms_live_data_t *data, void *con
         s_latest_bms = *data;
         s_has_latest_bms = true;
         xSemaphoreGive(s_monitoring_mutex);
+
+        portENTER_CRITICAL(&s_sample_generation_lock);
+        ++s_sample_generation;
+        portEXIT_CRITICAL(&s_sample_generation_lock);
     } else {
         uint32_t count = monitoring_diagnostics_record_mutex_timeout();
         ESP_LOGW(TAG,
@@ -504,6 +570,14 @@ static void monitoring_on_bms_update(const uart_bms_live_data_t *data, void *con
     }
 }
 
+uint32_t monitoring_get_generation(void)
+{
+    portENTER_CRITICAL(&s_sample_generation_lock);
+    uint32_t generation = s_sample_generation;
+    portEXIT_CRITICAL(&s_sample_generation_lock);
+    return generation;
+}
+
 void monitoring_set_event_publisher(event_bus_publish_fn_t publisher)
 {
     s_event_publisher = publisher;
@@ -523,11 +597,6 @@ void monitoring_init(void)
         ESP_LOGW(TAG, "Unable to register TinyBMS listener: %s", esp_err_to_name(reg_err));
     }
 
-    esp_err_t snapshot_err = monitoring_prepare_snapshot();
-    if (snapshot_err != ESP_OK) {
-        ESP_LOGW(TAG, "Initial telemetry snapshot build failed: %s", esp_err_to_name(snapshot_err));
-    }
-
     esp_err_t publish_err = monitoring_publish_telemetry_snapshot();
     if (publish_err != ESP_OK) {
         ESP_LOGW(TAG, "Initial telemetry publish failed: %s", esp_err_to_name(publish_err));
@@ -591,21 +660,90 @@ esp_err_t monitoring_get_status_json(char *buffer, size_t buffer_size, size_t *o
     return monitoring_build_snapshot_json(snapshot, buffer, buffer_size, out_length);
 }
 
+esp_err_t monitoring_get_status_binary(uint8_t *buffer, size_t buffer_size, size_t *out_length)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_monitoring_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uart_bms_live_data_t local_data;
+    bool has_data = false;
+
+    if (xSemaphoreTake(s_monitoring_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        uint32_t count = monitoring_diagnostics_record_mutex_timeout();
+        ESP_LOGW(TAG,
+                 "Mutex timeout reading binary status (timeout #%u)",
+                 (unsigned)count);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    has_data = s_has_latest_bms;
+    if (has_data) {
+        local_data = s_latest_bms;
+    }
+
+    xSemaphoreGive(s_monitoring_mutex);
+
+    uart_bms_live_data_t empty = {0};
+    const uart_bms_live_data_t *snapshot = has_data ? &local_data : &empty;
+
+    uint64_t start_us = esp_timer_get_time();
+    telemetry_binary_extras_t extras = {0};
+    monitoring_compute_extras(snapshot, &extras);
+
+    size_t length = 0;
+    if (!telemetry_binary_write_snapshot(snapshot, &extras, buffer, buffer_size, &length)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint64_t duration_us = esp_timer_get_time() - start_us;
+    monitoring_diagnostics_record_binary_latency((duration_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration_us,
+                                                 length);
+
+    if (out_length != NULL) {
+        *out_length = length;
+    }
+    return ESP_OK;
+}
+
 esp_err_t monitoring_publish_telemetry_snapshot(void)
 {
     if (s_event_publisher == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    esp_err_t err = monitoring_prepare_snapshot();
+    // Room for the prefix, the snapshot with its NUL, and the closing brace
+    monitoring_snapshot_t *buffer =
+        malloc(sizeof(monitoring_snapshot_t) + MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH +
+               MONITORING_SNAPSHOT_MAX_SIZE + 1U);
+    if (buffer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    char *body = buffer->data + MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH;
+    size_t body_length = 0;
+    esp_err_t err = monitoring_prepare_snapshot(body, MONITORING_SNAPSHOT_MAX_SIZE, &body_length);
     if (err != ESP_OK) {
+        free(buffer);
         return err;
     }
 
+    memcpy(buffer->data, MONITORING_SNAPSHOT_WRAP_PREFIX, MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH);
+    body[body_length] = '}';
+    body[body_length + 1U] = '\0';
+    buffer->length = MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH + body_length + 1U;
+    buffer->refs = 1U;
+
     event_bus_event_t event = {
         .id = APP_EVENT_ID_TELEMETRY_SAMPLE,
-        .payload = s_last_snapshot,
-        .payload_size = s_last_snapshot_len + 1,
+        .payload = body,
+        .payload_size = body_length,
+        .dispose = monitoring_snapshot_release,
+        .dispose_context = buffer,
     };
 
     if (!s_event_publisher(&event, pdMS_TO_TICKS(50))) {
@@ -613,12 +751,53 @@ esp_err_t monitoring_publish_telemetry_snapshot(void)
         ESP_LOGW(TAG,
                  "Unable to publish telemetry snapshot (queue saturation #%u)",
                  (unsigned)count);
+        // The bus disposes of the buffer on every path
         return ESP_FAIL;
     }
 
     return ESP_OK;
 }
 
+monitoring_snapshot_t *monitoring_snapshot_from_event(const event_bus_event_t *event)
+{
+    // Only monitoring publishes this pairing, so the context is our buffer
+    if (event == NULL || event->id != APP_EVENT_ID_TELEMETRY_SAMPLE ||
+        event->dispose != monitoring_snapshot_release) {
+        return NULL;
+    }
+    return (monitoring_snapshot_t *)event->dispose_context;
+}
+
+const char *monitoring_snapshot_wrapped(const monitoring_snapshot_t *snapshot, size_t *out_length)
+{
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    if (out_length != NULL) {
+        *out_length = snapshot->length;
+    }
+    return snapshot->data;
+}
+
+bool monitoring_snapshot_retain(monitoring_snapshot_t *snapshot)
+{
+    if (snapshot == NULL) {
+        return false;
+    }
+
+    __atomic_add_fetch(&snapshot->refs, 1U, __ATOMIC_RELAXED);
+    return true;
+}
+
+void monitoring_snapshot_release(void *snapshot)
+{
+    monitoring_snapshot_t *buffer = (monitoring_snapshot_t *)snapshot;
+    if (buffer != NULL && __atomic_sub_fetch(&buffer->refs, 1U, __ATOMIC_ACQ_REL) == 0U) {
+        free(buffer);
+    }
+}
+
 esp_err_t monitoring_publish_diagnostics_snapshot(void)
 {
     if (s_event_publisher == NULL) {
@@ -648,9 +827,21 @@ esp_err_t monitoring_publish_diagnostics_snapshot(void)
     return ESP_OK;
 }
 
-esp_err_t monitoring_get_history_json(size_t limit, char *buffer, size_t buffer_size, size_t *out_length)
+static bool monitoring_lock_history(void)
 {
-    if (buffer == NULL || buffer_size == 0) {
+    if (xSemaphoreTake(s_monitoring_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        uint32_t count = monitoring_diagnostics_record_mutex_timeout();
+        ESP_LOGW(TAG,
+                 "Failed to acquire mutex for history read (timeout #%u)",
+                 (unsigned)count);
+        return false;
+    }
+    return true;
+}
+
+esp_err_t monitoring_write_history_json(size_t limit, json_writer_t *writer)
+{
+    if (writer == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -658,68 +849,77 @@ esp_err_t monitoring_get_history_json(size_t limit, char *buffer, size_t buffer_
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Acquire mutex for reading history data
-    if (xSemaphoreTake(s_monitoring_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        uint32_t count = monitoring_diagnostics_record_mutex_timeout();
-        ESP_LOGW(TAG,
-                 "Failed to acquire mutex for history read (timeout #%u)",
-                 (unsigned)count);
+    if (!monitoring_lock_history()) {
         return ESP_ERR_TIMEOUT;
     }
-
     size_t available = s_history_count;
-    if (available == 0) {
-        xSemaphoreGive(s_monitoring_mutex);
-        int written = snprintf(buffer, buffer_size, "{\"total\":0,\"samples\":[]}");
-        if (written < 0 || (size_t)written >= buffer_size) {
-            return ESP_ERR_INVALID_SIZE;
-        }
-        if (out_length != NULL) {
-            *out_length = (size_t)written;
-        }
-        return ESP_OK;
-    }
+    uint64_t written_at_start = s_history_written;
+    xSemaphoreGive(s_monitoring_mutex);
 
     size_t max_samples = (limit == 0 || limit > available) ? available : limit;
-    size_t offset = 0;
-    if (!monitoring_json_append(buffer, buffer_size, &offset, "{\"total\":%zu,\"samples\":[", available)) {
+    json_writer_printf(writer, "{\"total\":%zu,\"samples\":[", available);
+
+    // Entries are copied a batch at a time and formatted without the mutex,
+    // since formatting may block on the HTTP socket. They are addressed by
+    // push sequence, so pushes in between do not shift the window; entries
+    // overwritten meanwhile are skipped.
+    monitoring_history_entry_t batch[MONITORING_HISTORY_BATCH];
+    uint64_t next_seq = written_at_start - max_samples;
+    bool first = true;
+    while (next_seq < written_at_start && json_writer_ok(writer)) {
+        if (!monitoring_lock_history()) {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (s_history_written < written_at_start) {
+            xSemaphoreGive(s_monitoring_mutex);  // History was reset
+            break;
+        }
+        uint64_t oldest_seq = s_history_written - s_history_count;
+        if (next_seq < oldest_seq) {
+            next_seq = oldest_seq;
+        }
+        size_t copied = 0;
+        while (copied < MONITORING_HISTORY_BATCH && next_seq < written_at_start) {
+            size_t age = (size_t)(s_history_written - next_seq);
+            size_t idx = (s_history_head + MONITORING_HISTORY_CAPACITY - age) % MONITORING_HISTORY_CAPACITY;
+            batch[copied++] = s_history[idx];
+            ++next_seq;
+        }
         xSemaphoreGive(s_monitoring_mutex);
-        return ESP_ERR_INVALID_SIZE;
-    }
 
-    size_t start_index = (s_history_head + MONITORING_HISTORY_CAPACITY - max_samples) % MONITORING_HISTORY_CAPACITY;
-    for (size_t i = 0; i < max_samples; ++i) {
-        size_t idx = (start_index + i) % MONITORING_HISTORY_CAPACITY;
-        const monitoring_history_entry_t *entry = &s_history[idx];
-        if (!monitoring_json_append(buffer,
-                                    buffer_size,
-                                    &offset,
-                                    "%s{\"timestamp\":%" PRIu64 ",\"pack_voltage\":%.3f,\"pack_current\":%.3f,"
-                                    "\"state_of_charge\":%.2f,\"state_of_health\":%.2f,\"average_temperature\":%.2f}",
-                                    (i == 0) ? "" : ",",
-                                    entry->timestamp_ms,
-                                    entry->pack_voltage_v,
-                                    entry->pack_current_a,
-                                    entry->state_of_charge_pct,
-                                    entry->state_of_health_pct,
-                                    entry->average_temperature_c)) {
-            xSemaphoreGive(s_monitoring_mutex);
-            return ESP_ERR_INVALID_SIZE;
+        for (size_t i = 0; i < copied; ++i) {
+            const monitoring_history_entry_t *entry = &batch[i];
+            json_writer_printf(writer,
+                               "%s{\"timestamp\":%" PRIu64 ",\"pack_voltage\":%.3f,\"pack_current\":%.3f,"
+                               "\"state_of_charge\":%.2f,\"state_of_health\":%.2f,\"average_temperature\":%.2f}",
+                               first ? "" : ",",
+                               entry->timestamp_ms,
+                               entry->pack_voltage_v,
+                               entry->pack_current_a,
+                               entry->state_of_charge_pct,
+                               entry->state_of_health_pct,
+                               entry->average_temperature_c);
+            first = false;
         }
     }
 
-    if (!monitoring_json_append(buffer, buffer_size, &offset, "]}")) {
-        xSemaphoreGive(s_monitoring_mutex);
-        return ESP_ERR_INVALID_SIZE;
-    }
-
-    xSemaphoreGive(s_monitoring_mutex);
+    json_writer_printf(writer, "]}");
+    return writer->error;
+}
 
-    if (out_length != NULL) {
-        *out_length = offset;
+esp_err_t monitoring_get_history_json(size_t limit, char *buffer, size_t buffer_size, size_t *out_length)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    return ESP_OK;
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, buffer_size, NULL, NULL);
+    esp_err_t err = monitoring_write_history_json(limit, &writer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return json_writer_finish(&writer, out_length);
 }
 
 void monitoring_deinit(void)
@@ -743,14 +943,16 @@ void monitoring_deinit(void)
 
     // Reset state
     s_has_latest_bms = false;
+    portENTER_CRITICAL(&s_sample_generation_lock);
+    ++s_sample_generation;  // Cached status no longer matches
+    portEXIT_CRITICAL(&s_sample_generation_lock);
     s_event_publisher = NULL;
     s_history_head = 0;
     s_history_count = 0;
-    s_last_snapshot_len = 0;
+    s_history_written = 0;
     s_last_diagnostics_len = 0;
     memset(&s_latest_bms, 0, sizeof(s_latest_bms));
     memset(s_history, 0, sizeof(s_history));
-    memset(s_last_snapshot, 0, sizeof(s_last_snapshot));
     memset(s_last_diagnostics, 0, sizeof(s_last_diagnostics));
     monitoring_diagnostics_reset();
 
@@ -50,21 +50,98 @@
  * @endcode
  */
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "esp_err.h"
 
 #include "event_bus.h"
+#include "json_writer.h"
 
 #define MONITORING_SNAPSHOT_MAX_SIZE     2048U
-#define MONITORING_DIAGNOSTICS_MAX_SIZE  512U
+#define MONITORING_DIAGNOSTICS_MAX_SIZE  768U
+
+// Wrapper of the snapshot in the WebSocket telemetry frames
+#define MONITORING_SNAPSHOT_WRAP_PREFIX         "{\"battery\":"
+#define MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH  (sizeof(MONITORING_SNAPSHOT_WRAP_PREFIX) - 1U)
 
 void monitoring_init(void);
 void monitoring_deinit(void);
 void monitoring_set_event_publisher(event_bus_publish_fn_t publisher);
 
 esp_err_t monitoring_get_status_json(char *buffer, size_t buffer_size, size_t *out_length);
+
+/**
+ * @brief Sample generation counter
+ *
+ * Incremented each time a TinyBMS sample replaces the latest snapshot, so
+ * callers caching monitoring_get_status_json() output know when to re-render.
+ */
+uint32_t monitoring_get_generation(void);
+
+/**
+ * @brief Latest snapshot in the packed binary encoding (telemetry_binary.h)
+ *
+ * Same content as monitoring_get_status_json(); the encode time and size
+ * are reported next to the JSON ones in the diagnostics "snapshot_cost".
+ */
+esp_err_t monitoring_get_status_binary(uint8_t *buffer, size_t buffer_size, size_t *out_length);
+
+/**
+ * @brief Publish the latest snapshot as APP_EVENT_ID_TELEMETRY_SAMPLE
+ *
+ * The snapshot is rendered once into a reference-counted buffer already
+ * wrapped as {"battery":<snapshot>}. The event payload is the snapshot
+ * inside it: payload_size bytes, followed by the closing brace rather than
+ * a NUL. The buffer handle is the event dispose_context, released by the
+ * bus through monitoring_snapshot_release().
+ */
 esp_err_t monitoring_publish_telemetry_snapshot(void);
+
+/**
+ * @brief Reference-counted buffer behind a telemetry sample event
+ */
+typedef struct monitoring_snapshot monitoring_snapshot_t;
+
+/**
+ * @brief Buffer handle carried by a telemetry sample event
+ *
+ * @return The event dispose_context when @p event is an
+ *         APP_EVENT_ID_TELEMETRY_SAMPLE published by monitoring, NULL for
+ *         any other event
+ */
+monitoring_snapshot_t *monitoring_snapshot_from_event(const event_bus_event_t *event);
+
+/**
+ * @brief Wrapped {"battery":...} form of a telemetry sample
+ *
+ * @param out_length Length of the wrapped form, without its NUL
+ * @return NUL-terminated text, valid while the event or a reference taken
+ *         with monitoring_snapshot_retain() is held; NULL for a NULL handle
+ */
+const char *monitoring_snapshot_wrapped(const monitoring_snapshot_t *snapshot, size_t *out_length);
+
+/**
+ * @brief Keep a telemetry sample alive after its event is released
+ *
+ * @return false for a NULL handle (no reference taken)
+ */
+bool monitoring_snapshot_retain(monitoring_snapshot_t *snapshot);
+
+/**
+ * @brief Drop a reference to a telemetry sample buffer
+ *
+ * Takes the handle as void *, so it is also the event dispose callback.
+ */
+void monitoring_snapshot_release(void *snapshot);
 esp_err_t monitoring_publish_diagnostics_snapshot(void);
 esp_err_t monitoring_get_history_json(size_t limit, char *buffer, size_t buffer_size, size_t *out_length);
+
+/**
+ * @brief Stream the @p limit most recent history samples (0 = all) to @p writer
+ *
+ * Same document as monitoring_get_history_json(). The ring is copied in
+ * small batches, so the mutex is never held while the writer flushes.
+ */
+esp_err_t monitoring_write_history_json(size_t limit, json_writer_t *writer);
@@ -286,9 +286,9 @@ void tiny_mqtt_publisher_on_bms_update(const uart_bms_live_data_t *data, void *c
         .dispose_context = event_buffer,
     };
 
+    // The bus disposes of event_buffer on every path
     if (!s_event_publisher(&event, pdMS_TO_TICKS(50))) {
         ESP_LOGW(TAG, "Unable to publish TinyBMS MQTT metrics event");
-        tiny_mqtt_publisher_release_event_buffer(event_buffer);
     }
 }
 
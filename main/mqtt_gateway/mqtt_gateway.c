@@ -571,15 +571,21 @@ static void mqtt_gateway_handle_event(const event_bus_event_t *event)
             mqtt_gateway_reload_config(true);
             break;
         case APP_EVENT_ID_CAN_FRAME_RAW:
+        case APP_EVENT_ID_CAN_FRAME_BATCH:
             mqtt_gateway_publish_can_string(event, s_gateway.can_raw_topic);
             break;
         case APP_EVENT_ID_CAN_FRAME_DECODED:
             mqtt_gateway_publish_can_string(event, s_gateway.can_decoded_topic);
             break;
         case APP_EVENT_ID_CAN_FRAME_READY:
-            if (event->payload != NULL && event->payload_size == sizeof(can_publisher_frame_t)) {
-                const can_publisher_frame_t *frame = (const can_publisher_frame_t *)event->payload;
-                mqtt_gateway_publish_can_ready(frame);
+            // One frame, or every frame of a batched publisher cycle
+            if (event->payload != NULL && event->payload_size != 0U &&
+                (event->payload_size % sizeof(can_publisher_frame_t)) == 0U) {
+                const can_publisher_frame_t *frames = (const can_publisher_frame_t *)event->payload;
+                size_t count = event->payload_size / sizeof(can_publisher_frame_t);
+                for (size_t i = 0; i < count; ++i) {
+                    mqtt_gateway_publish_can_ready(&frames[i]);
+                }
             }
             break;
         case APP_EVENT_ID_WIFI_STA_GOT_IP:
@@ -0,0 +1,175 @@
+/**
+ * @file json_writer.c
+ * @brief Streaming JSON writer with a fixed-size window
+ */
+
+#include "json_writer.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static bool json_writer_fail(json_writer_t *writer, esp_err_t error)
+{
+    if (writer->error == ESP_OK) {
+        writer->error = error;
+    }
+    return false;
+}
+
+static bool json_writer_flush_window(json_writer_t *writer)
+{
+    if (writer->flush == NULL) {
+        return json_writer_fail(writer, ESP_ERR_INVALID_SIZE);
+    }
+    if (writer->length == 0U) {
+        return true;
+    }
+
+    esp_err_t err = writer->flush(writer->context, writer->window, writer->length);
+    if (err != ESP_OK) {
+        return json_writer_fail(writer, err);
+    }
+    writer->flushed += writer->length;
+    writer->length = 0U;
+    return true;
+}
+
+void json_writer_init(json_writer_t *writer,
+                      char *window,
+                      size_t capacity,
+                      json_writer_flush_fn_t flush,
+                      void *context)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    memset(writer, 0, sizeof(*writer));
+    writer->window = window;
+    writer->capacity = capacity;
+    writer->flush = flush;
+    writer->context = context;
+    // One byte is kept for vsnprintf's terminator
+    writer->error = (window == NULL || capacity < 2U) ? ESP_ERR_INVALID_ARG : ESP_OK;
+    if (window != NULL && capacity > 0U) {
+        window[0] = '\0';
+    }
+}
+
+bool json_writer_printf(json_writer_t *writer, const char *format, ...)
+{
+    if (writer == NULL || format == NULL || writer->error != ESP_OK) {
+        return false;
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        size_t room = writer->capacity - writer->length;
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(writer->window + writer->length, room, format, args);
+        va_end(args);
+
+        if (written < 0) {
+            return json_writer_fail(writer, ESP_FAIL);
+        }
+        if ((size_t)written < room) {
+            writer->length += (size_t)written;
+            return true;
+        }
+
+        // Truncated output is dropped: flush what came before and retry once
+        // in an empty window.
+        if (writer->length == 0U || !json_writer_flush_window(writer)) {
+            break;
+        }
+    }
+
+    return json_writer_fail(writer, ESP_ERR_INVALID_SIZE);
+}
+
+bool json_writer_write(json_writer_t *writer, const char *data, size_t length)
+{
+    if (writer == NULL || (data == NULL && length > 0U) || writer->error != ESP_OK) {
+        return false;
+    }
+
+    while (length > 0U) {
+        size_t room = writer->capacity - 1U - writer->length;
+        if (room == 0U) {
+            if (!json_writer_flush_window(writer)) {
+                return false;
+            }
+            continue;
+        }
+        size_t chunk = (length < room) ? length : room;
+        memcpy(writer->window + writer->length, data, chunk);
+        writer->length += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+bool json_writer_string(json_writer_t *writer, const char *value)
+{
+    if (value == NULL) {
+        return json_writer_write(writer, "null", 4U);
+    }
+
+    if (!json_writer_write(writer, "\"", 1U)) {
+        return false;
+    }
+
+    // Copy runs of plain characters in one go, escape the rest
+    const char *run = value;
+    for (const char *p = value; *p != '\0'; ++p) {
+        unsigned char c = (unsigned char)*p;
+        const char *escape = NULL;
+        char control[7];
+        switch (c) {
+            case '"':  escape = "\\\""; break;
+            case '\\': escape = "\\\\"; break;
+            case '\n': escape = "\\n"; break;
+            case '\r': escape = "\\r"; break;
+            case '\t': escape = "\\t"; break;
+            case '\b': escape = "\\b"; break;
+            case '\f': escape = "\\f"; break;
+            default:
+                if (c < 0x20U) {
+                    snprintf(control, sizeof(control), "\\u%04x", (unsigned)c);
+                    escape = control;
+                }
+                break;
+        }
+        if (escape == NULL) {
+            continue;
+        }
+        if (!json_writer_write(writer, run, (size_t)(p - run)) ||
+            !json_writer_write(writer, escape, strlen(escape))) {
+            return false;
+        }
+        run = p + 1;
+    }
+
+    return json_writer_write(writer, run, strlen(run)) && json_writer_write(writer, "\"", 1U);
+}
+
+esp_err_t json_writer_finish(json_writer_t *writer, size_t *out_length)
+{
+    if (writer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (writer->error == ESP_OK && writer->flush != NULL) {
+        (void)json_writer_flush_window(writer);
+    }
+    if (writer->error == ESP_OK && writer->window != NULL) {
+        writer->window[writer->length] = '\0';
+    }
+
+    if (out_length != NULL) {
+        *out_length = writer->flushed + writer->length;
+    }
+    return writer->error;
+}
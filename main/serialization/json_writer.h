@@ -0,0 +1,90 @@
+#pragma once
+
+/**
+ * @file json_writer.h
+ * @brief Streaming JSON writer with a fixed-size window
+ *
+ * Producers append fragments to a small window; when a fragment does not fit,
+ * the window is handed to a flush callback (httpd_resp_send_chunk() for REST
+ * handlers) and reused. Peak RAM is the window whatever the document size.
+ *
+ * Without a flush callback the window is the whole output buffer: legacy
+ * APIs that fill a caller buffer wrap the same producer and fail with
+ * ESP_ERR_INVALID_SIZE when the document outgrows it.
+ *
+ * Errors are sticky: after the first failure every call is a no-op and
+ * json_writer_finish() reports it, so producers only check at the end or
+ * before taking a lock.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_WRITER_WINDOW_SIZE 1024U
+
+typedef esp_err_t (*json_writer_flush_fn_t)(void *context, const char *data, size_t length);
+
+typedef struct {
+    char *window;
+    size_t capacity;
+    size_t length;                  /**< Bytes waiting in the window. */
+    size_t flushed;                 /**< Bytes already handed to @ref flush. */
+    json_writer_flush_fn_t flush;   /**< NULL: @ref window is the whole output. */
+    void *context;
+    esp_err_t error;                /**< First error, ESP_OK while writing. */
+} json_writer_t;
+
+/**
+ * @brief Start a document in @p window
+ *
+ * @param flush Called with each full window, NULL to write into @p window only
+ */
+void json_writer_init(json_writer_t *writer,
+                      char *window,
+                      size_t capacity,
+                      json_writer_flush_fn_t flush,
+                      void *context);
+
+/**
+ * @brief Append a printf-formatted fragment (at most one window long)
+ */
+bool json_writer_printf(json_writer_t *writer, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Append raw bytes of any length
+ */
+bool json_writer_write(json_writer_t *writer, const char *data, size_t length);
+
+/**
+ * @brief Append @p value as a quoted, escaped JSON string ("null" when NULL)
+ */
+bool json_writer_string(json_writer_t *writer, const char *value);
+
+/**
+ * @brief Whether every call so far succeeded
+ */
+static inline bool json_writer_ok(const json_writer_t *writer)
+{
+    return writer != NULL && writer->error == ESP_OK;
+}
+
+/**
+ * @brief Flush what is left and terminate the document
+ *
+ * In buffer mode the window is NUL-terminated.
+ *
+ * @param out_length Total document length (optional)
+ * @return The first error met while writing, or ESP_OK
+ */
+esp_err_t json_writer_finish(json_writer_t *writer, size_t *out_length);
+
+#ifdef __cplusplus
+}
+#endif
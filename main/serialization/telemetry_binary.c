@@ -0,0 +1,521 @@
+#include "telemetry_binary.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+    TELEMETRY_BINARY_U8 = 0,
+    TELEMETRY_BINARY_U16,
+    TELEMETRY_BINARY_U32,
+    TELEMETRY_BINARY_U64,
+    TELEMETRY_BINARY_I16,
+    TELEMETRY_BINARY_I32,
+} telemetry_binary_wire_t;
+
+typedef enum {
+    TELEMETRY_BINARY_SRC_FLOAT = 0,
+    TELEMETRY_BINARY_SRC_U8,
+    TELEMETRY_BINARY_SRC_U16,
+    TELEMETRY_BINARY_SRC_U32,
+    TELEMETRY_BINARY_SRC_U64,
+} telemetry_binary_source_t;
+
+typedef struct {
+    const char *name;
+    telemetry_binary_wire_t wire;
+    uint16_t scale;          // Wire value = source value x scale (floats only)
+    bool extra;              // Read from telemetry_binary_extras_t instead of the BMS data
+    telemetry_binary_source_t source;
+    uint16_t offset;
+    uint32_t deadband;       // Delta mode: change in wire units needed to resend the field
+} telemetry_binary_field_t;
+
+// Never triggers a delta on its own, rides along with any other change
+#define FOLLOWS UINT32_MAX
+
+#define BMS_FLOAT(name, member, wire, scale, deadband) \
+    {name, wire, scale, false, TELEMETRY_BINARY_SRC_FLOAT, offsetof(uart_bms_live_data_t, member), deadband}
+#define BMS_INT(name, member, wire, source, deadband) \
+    {name, wire, 1U, false, source, offsetof(uart_bms_live_data_t, member), deadband}
+#define EXTRA_FLOAT(name, member, wire, scale, deadband) \
+    {name, wire, scale, true, TELEMETRY_BINARY_SRC_FLOAT, offsetof(telemetry_binary_extras_t, member), deadband}
+#define EXTRA_INT(name, member, wire, source, deadband) \
+    {name, wire, 1U, true, source, offsetof(telemetry_binary_extras_t, member), deadband}
+
+// Names match the JSON snapshot keys; scales keep the JSON precision.
+// Deadbands filter sensor jitter in delta mode: the comparison is made
+// against the value the client last received, so slow drifts still go out.
+// Append only: the schema version must change if a field moves or is removed.
+static const telemetry_binary_field_t s_fields[] = {
+    BMS_INT("timestamp_ms", timestamp_ms, TELEMETRY_BINARY_U64, TELEMETRY_BINARY_SRC_U64, FOLLOWS),
+    BMS_FLOAT("pack_voltage_v", pack_voltage_v, TELEMETRY_BINARY_U32, 1000U, 20U),
+    BMS_FLOAT("pack_current_a", pack_current_a, TELEMETRY_BINARY_I32, 1000U, 100U),
+    EXTRA_FLOAT("power_w", power_w, TELEMETRY_BINARY_I32, 10U, 20U),
+    EXTRA_INT("is_charging", is_charging, TELEMETRY_BINARY_U8, TELEMETRY_BINARY_SRC_U8, 0U),
+    BMS_FLOAT("state_of_charge_pct", state_of_charge_pct, TELEMETRY_BINARY_U16, 100U, 10U),
+    BMS_FLOAT("state_of_health_pct", state_of_health_pct, TELEMETRY_BINARY_U16, 100U, 10U),
+    BMS_FLOAT("average_temperature_c", average_temperature_c, TELEMETRY_BINARY_I16, 100U, 20U),
+    BMS_FLOAT("mos_temperature_c", mosfet_temperature_c, TELEMETRY_BINARY_I16, 100U, 20U),
+    BMS_FLOAT("auxiliary_temperature_c", auxiliary_temperature_c, TELEMETRY_BINARY_I16, 100U, 20U),
+    BMS_FLOAT("pack_temperature_min_c", pack_temperature_min_c, TELEMETRY_BINARY_I16, 100U, 20U),
+    BMS_FLOAT("pack_temperature_max_c", pack_temperature_max_c, TELEMETRY_BINARY_I16, 100U, 20U),
+    BMS_INT("min_cell_mv", min_cell_mv, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 2U),
+    BMS_INT("max_cell_mv", max_cell_mv, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 2U),
+    BMS_INT("balancing_bits", balancing_bits, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    BMS_INT("alarm_bits", alarm_bits, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    BMS_INT("warning_bits", warning_bits, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    BMS_INT("uptime_seconds", uptime_seconds, TELEMETRY_BINARY_U32, TELEMETRY_BINARY_SRC_U32, FOLLOWS),
+    BMS_INT("estimated_time_left_seconds", estimated_time_left_seconds, TELEMETRY_BINARY_U32, TELEMETRY_BINARY_SRC_U32, 60U),
+    BMS_INT("cycle_count", cycle_count, TELEMETRY_BINARY_U32, TELEMETRY_BINARY_SRC_U32, 0U),
+    BMS_FLOAT("battery_capacity_ah", battery_capacity_ah, TELEMETRY_BINARY_U32, 100U, 0U),
+    BMS_INT("series_cell_count", series_cell_count, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    BMS_INT("overvoltage_cutoff_mv", overvoltage_cutoff_mv, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    BMS_INT("undervoltage_cutoff_mv", undervoltage_cutoff_mv, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    BMS_FLOAT("discharge_overcurrent_limit_a", discharge_overcurrent_limit_a, TELEMETRY_BINARY_I32, 1000U, 0U),
+    BMS_FLOAT("charge_overcurrent_limit_a", charge_overcurrent_limit_a, TELEMETRY_BINARY_I32, 1000U, 0U),
+    BMS_FLOAT("max_discharge_current_limit_a", max_discharge_current_limit_a, TELEMETRY_BINARY_I32, 1000U, 0U),
+    BMS_FLOAT("max_charge_current_limit_a", max_charge_current_limit_a, TELEMETRY_BINARY_I32, 1000U, 0U),
+    BMS_FLOAT("peak_discharge_current_limit_a", peak_discharge_current_limit_a, TELEMETRY_BINARY_I32, 1000U, 0U),
+    BMS_FLOAT("overheat_cutoff_c", overheat_cutoff_c, TELEMETRY_BINARY_I16, 100U, 0U),
+    BMS_FLOAT("low_temp_charge_cutoff_c", low_temp_charge_cutoff_c, TELEMETRY_BINARY_I16, 100U, 0U),
+    BMS_INT("hardware_version", hardware_version, TELEMETRY_BINARY_U8, TELEMETRY_BINARY_SRC_U8, 0U),
+    BMS_INT("hardware_changes_version", hardware_changes_version, TELEMETRY_BINARY_U8, TELEMETRY_BINARY_SRC_U8, 0U),
+    BMS_INT("firmware_version", firmware_version, TELEMETRY_BINARY_U8, TELEMETRY_BINARY_SRC_U8, 0U),
+    BMS_INT("firmware_flags", firmware_flags, TELEMETRY_BINARY_U8, TELEMETRY_BINARY_SRC_U8, 0U),
+    BMS_INT("internal_firmware_version", internal_firmware_version, TELEMETRY_BINARY_U16, TELEMETRY_BINARY_SRC_U16, 0U),
+    EXTRA_INT("energy_charged_wh", energy_charged_wh, TELEMETRY_BINARY_U32, TELEMETRY_BINARY_SRC_U32, 0U),
+    EXTRA_INT("energy_discharged_wh", energy_discharged_wh, TELEMETRY_BINARY_U32, TELEMETRY_BINARY_SRC_U32, 0U),
+    EXTRA_INT("history_available", history_available, TELEMETRY_BINARY_U8, TELEMETRY_BINARY_SRC_U8, 0U),
+};
+
+#define TELEMETRY_BINARY_FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+static const char *const s_wire_names[] = {"u8", "u16", "u32", "u64", "i16", "i32"};
+static const uint8_t s_wire_sizes[] = {1U, 2U, 4U, 8U, 2U, 4U};
+
+typedef struct {
+    uint8_t *buffer;
+    size_t size;
+    size_t offset;
+} telemetry_binary_writer_t;
+
+static bool telemetry_binary_put(telemetry_binary_writer_t *writer, uint64_t value, size_t width)
+{
+    if (writer->offset + width > writer->size) {
+        return false;
+    }
+    for (size_t i = 0; i < width; ++i) {
+        writer->buffer[writer->offset++] = (uint8_t)(value >> (8U * i));
+    }
+    return true;
+}
+
+static int64_t telemetry_binary_scale(float value, uint16_t scale, telemetry_binary_wire_t wire)
+{
+    if (!isfinite(value)) {
+        return 0;
+    }
+
+    double scaled = round((double)value * (double)scale);
+    double min = 0.0;
+    double max = 0.0;
+    switch (wire) {
+        case TELEMETRY_BINARY_U8:  max = UINT8_MAX; break;
+        case TELEMETRY_BINARY_U16: max = UINT16_MAX; break;
+        case TELEMETRY_BINARY_U32: max = UINT32_MAX; break;
+        case TELEMETRY_BINARY_I16: min = INT16_MIN; max = INT16_MAX; break;
+        case TELEMETRY_BINARY_I32: min = INT32_MIN; max = INT32_MAX; break;
+        default: return (int64_t)scaled;
+    }
+    if (scaled < min) {
+        scaled = min;
+    }
+    if (scaled > max) {
+        scaled = max;
+    }
+    return (int64_t)scaled;
+}
+
+static uint64_t telemetry_binary_read(const telemetry_binary_field_t *field, const uint8_t *base)
+{
+    const uint8_t *source = base + field->offset;
+    switch (field->source) {
+        case TELEMETRY_BINARY_SRC_FLOAT: {
+            float value = 0.0f;
+            memcpy(&value, source, sizeof(value));
+            return (uint64_t)telemetry_binary_scale(value, field->scale, field->wire);
+        }
+        case TELEMETRY_BINARY_SRC_U8:
+            return *source;
+        case TELEMETRY_BINARY_SRC_U16: {
+            uint16_t value = 0;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        case TELEMETRY_BINARY_SRC_U32: {
+            uint32_t value = 0;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        case TELEMETRY_BINARY_SRC_U64: {
+            uint64_t value = 0;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        default:
+            return 0U;
+    }
+}
+
+bool telemetry_binary_write_snapshot(const uart_bms_live_data_t *data,
+                                     const telemetry_binary_extras_t *extras,
+                                     uint8_t *buffer,
+                                     size_t buffer_size,
+                                     size_t *out_length)
+{
+    if (buffer == NULL || buffer_size == 0U) {
+        return false;
+    }
+
+    static const uart_bms_live_data_t k_empty_data = {0};
+    static const telemetry_binary_extras_t k_empty_extras = {0};
+    const uart_bms_live_data_t *snapshot = (data != NULL) ? data : &k_empty_data;
+    const telemetry_binary_extras_t *derived = (extras != NULL) ? extras : &k_empty_extras;
+
+    telemetry_binary_writer_t writer = {
+        .buffer = buffer,
+        .size = buffer_size,
+        .offset = 0U,
+    };
+
+    if (!telemetry_binary_put(&writer, TELEMETRY_BINARY_FRAME_SNAPSHOT, 1U) ||
+        !telemetry_binary_put(&writer, TELEMETRY_BINARY_VERSION, 1U) ||
+        !telemetry_binary_put(&writer, TELEMETRY_BINARY_FIELD_COUNT, 2U)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < TELEMETRY_BINARY_FIELD_COUNT; ++i) {
+        const telemetry_binary_field_t *field = &s_fields[i];
+        const uint8_t *base = field->extra ? (const uint8_t *)derived : (const uint8_t *)snapshot;
+        if (!telemetry_binary_put(&writer, telemetry_binary_read(field, base), s_wire_sizes[field->wire])) {
+            return false;
+        }
+    }
+
+    if (!telemetry_binary_put(&writer, UART_BMS_CELL_COUNT, 1U)) {
+        return false;
+    }
+    for (size_t i = 0; i < UART_BMS_CELL_COUNT; ++i) {
+        if (!telemetry_binary_put(&writer, snapshot->cell_voltage_mv[i], 2U)) {
+            return false;
+        }
+    }
+    for (size_t byte = 0; byte < (UART_BMS_CELL_COUNT + 7U) / 8U; ++byte) {
+        uint8_t bits = 0U;
+        for (size_t bit = 0; bit < 8U && byte * 8U + bit < UART_BMS_CELL_COUNT; ++bit) {
+            if (snapshot->cell_balancing[byte * 8U + bit] != 0U) {
+                bits |= (uint8_t)(1U << bit);
+            }
+        }
+        if (!telemetry_binary_put(&writer, bits, 1U)) {
+            return false;
+        }
+    }
+
+    size_t register_count = (snapshot->register_count < UART_BMS_MAX_REGISTERS) ? snapshot->register_count
+                                                                                : UART_BMS_MAX_REGISTERS;
+    if (!telemetry_binary_put(&writer, register_count, 2U)) {
+        return false;
+    }
+    for (size_t i = 0; i < register_count; ++i) {
+        if (!telemetry_binary_put(&writer, snapshot->registers[i].address, 2U) ||
+            !telemetry_binary_put(&writer, snapshot->registers[i].raw_value, 2U)) {
+            return false;
+        }
+    }
+
+    if (out_length != NULL) {
+        *out_length = writer.offset;
+    }
+    return true;
+}
+
+// Delta slots, in order: scalar fields, cells, the balancing bitmap, then
+// register values (their addresses are part of the layout, not of a slot).
+typedef struct {
+    size_t index;
+    size_t offset;           // Offset of the next slot in a snapshot frame
+    size_t cell_count;
+    size_t register_count;
+} telemetry_binary_slot_iter_t;
+
+typedef struct {
+    size_t offset;
+    uint8_t width;
+    bool is_signed;
+    uint32_t deadband;
+} telemetry_binary_slot_t;
+
+static size_t telemetry_binary_slot_count(const telemetry_binary_slot_iter_t *iter)
+{
+    return TELEMETRY_BINARY_FIELD_COUNT + iter->cell_count + 1U + iter->register_count;
+}
+
+static bool telemetry_binary_next_slot(telemetry_binary_slot_iter_t *iter, telemetry_binary_slot_t *slot)
+{
+    size_t index = iter->index;
+    if (index >= telemetry_binary_slot_count(iter)) {
+        return false;
+    }
+
+    if (index < TELEMETRY_BINARY_FIELD_COUNT) {
+        const telemetry_binary_field_t *field = &s_fields[index];
+        slot->width = s_wire_sizes[field->wire];
+        slot->is_signed = (field->wire == TELEMETRY_BINARY_I16 || field->wire == TELEMETRY_BINARY_I32);
+        slot->deadband = field->deadband;
+    } else if (index < TELEMETRY_BINARY_FIELD_COUNT + iter->cell_count) {
+        if (index == TELEMETRY_BINARY_FIELD_COUNT) {
+            iter->offset += 1U;  // Cell count
+        }
+        slot->width = 2U;
+        slot->is_signed = false;
+        slot->deadband = TELEMETRY_BINARY_CELL_DEADBAND_MV;
+    } else if (index == TELEMETRY_BINARY_FIELD_COUNT + iter->cell_count) {
+        slot->width = (uint8_t)((iter->cell_count + 7U) / 8U);
+        slot->is_signed = false;
+        slot->deadband = 0U;
+    } else {
+        if (index == TELEMETRY_BINARY_FIELD_COUNT + iter->cell_count + 1U) {
+            iter->offset += 2U;  // Register count
+        }
+        iter->offset += 2U;      // Register address
+        slot->width = 2U;
+        slot->is_signed = false;
+        slot->deadband = 0U;
+    }
+
+    slot->offset = iter->offset;
+    iter->offset += slot->width;
+    iter->index++;
+    return true;
+}
+
+static int64_t telemetry_binary_slot_value(const uint8_t *frame, const telemetry_binary_slot_t *slot)
+{
+    uint64_t raw = 0U;
+    for (size_t i = 0; i < slot->width; ++i) {
+        raw |= (uint64_t)frame[slot->offset + i] << (8U * i);
+    }
+    if (slot->is_signed && slot->width < 8U && (raw & (1ULL << (8U * slot->width - 1U))) != 0U) {
+        raw |= ~0ULL << (8U * slot->width);
+    }
+    return (int64_t)raw;
+}
+
+// Parses the array counts of a snapshot frame; false when it is malformed
+static bool telemetry_binary_slot_begin(const uint8_t *frame, size_t length, telemetry_binary_slot_iter_t *iter)
+{
+    size_t offset = 4U;
+    for (size_t i = 0; i < TELEMETRY_BINARY_FIELD_COUNT; ++i) {
+        offset += s_wire_sizes[s_fields[i].wire];
+    }
+    if (length < 4U || frame[0] != TELEMETRY_BINARY_FRAME_SNAPSHOT || offset + 1U > length) {
+        return false;
+    }
+
+    iter->index = 0U;
+    iter->offset = 4U;
+    iter->cell_count = frame[offset];
+    offset += 1U + iter->cell_count * 2U + (iter->cell_count + 7U) / 8U;
+    if (offset + 2U > length) {
+        return false;
+    }
+    iter->register_count = (size_t)frame[offset] | ((size_t)frame[offset + 1U] << 8U);
+    return offset + 2U + iter->register_count * 4U == length;
+}
+
+telemetry_binary_delta_t telemetry_binary_write_delta(uint8_t *state,
+                                                      size_t state_length,
+                                                      const uint8_t *current,
+                                                      size_t current_length,
+                                                      uint8_t *buffer,
+                                                      size_t buffer_size,
+                                                      size_t *out_length)
+{
+    telemetry_binary_slot_iter_t iter;
+    if (state == NULL || current == NULL || buffer == NULL || state_length != current_length ||
+        memcmp(state, current, 4U) != 0 || !telemetry_binary_slot_begin(current, current_length, &iter)) {
+        return TELEMETRY_BINARY_DELTA_KEYFRAME;
+    }
+
+    // Same length and counts: the layouts match once register addresses agree
+    size_t addresses = current_length - iter.register_count * 4U;
+    for (size_t i = 0; i < iter.register_count; ++i) {
+        if (memcmp(&state[addresses + i * 4U], &current[addresses + i * 4U], 2U) != 0) {
+            return TELEMETRY_BINARY_DELTA_KEYFRAME;
+        }
+    }
+
+    size_t slot_count = telemetry_binary_slot_count(&iter);
+    size_t bitmap_size = (slot_count + 7U) / 8U;
+    if (buffer_size < 4U + bitmap_size) {
+        return TELEMETRY_BINARY_DELTA_KEYFRAME;
+    }
+    buffer[0] = TELEMETRY_BINARY_FRAME_DELTA;
+    buffer[1] = TELEMETRY_BINARY_VERSION;
+    buffer[2] = (uint8_t)slot_count;
+    buffer[3] = (uint8_t)(slot_count >> 8U);
+    uint8_t *bitmap = &buffer[4];
+    memset(bitmap, 0, bitmap_size);
+
+    // First pass: which slots moved beyond their deadband
+    telemetry_binary_slot_iter_t first = iter;
+    telemetry_binary_slot_t slot;
+    bool changed = false;
+    for (size_t i = 0; telemetry_binary_next_slot(&first, &slot); ++i) {
+        if (slot.deadband == FOLLOWS) {
+            continue;
+        }
+        int64_t previous = telemetry_binary_slot_value(state, &slot);
+        int64_t value = telemetry_binary_slot_value(current, &slot);
+        uint64_t distance = (value > previous) ? (uint64_t)value - (uint64_t)previous
+                                               : (uint64_t)previous - (uint64_t)value;
+        if (distance > slot.deadband) {
+            bitmap[i / 8U] |= (uint8_t)(1U << (i % 8U));
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return TELEMETRY_BINARY_DELTA_UNCHANGED;
+    }
+
+    // Second pass: emit the values and record them as what the client holds
+    size_t offset = 4U + bitmap_size;
+    for (size_t i = 0; telemetry_binary_next_slot(&iter, &slot); ++i) {
+        bool follows = (slot.deadband == FOLLOWS) && memcmp(&state[slot.offset], &current[slot.offset], slot.width) != 0;
+        if (follows) {
+            bitmap[i / 8U] |= (uint8_t)(1U << (i % 8U));
+        }
+        if ((bitmap[i / 8U] & (1U << (i % 8U))) == 0U) {
+            continue;
+        }
+        if (offset + slot.width > buffer_size) {
+            return TELEMETRY_BINARY_DELTA_KEYFRAME;
+        }
+        memcpy(&buffer[offset], &current[slot.offset], slot.width);
+        offset += slot.width;
+    }
+
+    // Only committed once the whole frame fits
+    (void)telemetry_binary_slot_begin(current, current_length, &iter);
+    for (size_t i = 0; telemetry_binary_next_slot(&iter, &slot); ++i) {
+        if ((bitmap[i / 8U] & (1U << (i % 8U))) != 0U) {
+            memcpy(&state[slot.offset], &current[slot.offset], slot.width);
+        }
+    }
+
+    if (out_length != NULL) {
+        *out_length = offset;
+    }
+    return TELEMETRY_BINARY_DELTA_WRITTEN;
+}
+
+static bool telemetry_binary_append(char *buffer, size_t buffer_size, size_t *offset, const char *text)
+{
+    size_t length = strlen(text);
+    if (*offset + length >= buffer_size) {
+        return false;
+    }
+    memcpy(buffer + *offset, text, length + 1U);
+    *offset += length;
+    return true;
+}
+
+bool telemetry_binary_write_schema(char *buffer, size_t buffer_size, size_t *out_length)
+{
+    if (buffer == NULL || buffer_size == 0U) {
+        return false;
+    }
+
+    char line[192];
+    size_t offset = 0U;
+    snprintf(line,
+             sizeof(line),
+             "{\"type\":\"schema\",\"subprotocol\":\"%s\",\"version\":%u,\"frame_type\":%u,"
+             "\"delta_frame_type\":%u,\"cell_deadband\":%u,\"endianness\":\"little\",\"fields\":[",
+             TELEMETRY_BINARY_SUBPROTOCOL,
+             (unsigned)TELEMETRY_BINARY_VERSION,
+             (unsigned)TELEMETRY_BINARY_FRAME_SNAPSHOT,
+             (unsigned)TELEMETRY_BINARY_FRAME_DELTA,
+             (unsigned)TELEMETRY_BINARY_CELL_DEADBAND_MV);
+    if (!telemetry_binary_append(buffer, buffer_size, &offset, line)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < TELEMETRY_BINARY_FIELD_COUNT; ++i) {
+        snprintf(line,
+                 sizeof(line),
+                 "%s{\"name\":\"%s\",\"type\":\"%s\",\"scale\":%u,\"deadband\":%ld}",
+                 (i == 0U) ? "" : ",",
+                 s_fields[i].name,
+                 s_wire_names[s_fields[i].wire],
+                 (unsigned)s_fields[i].scale,
+                 (s_fields[i].deadband == FOLLOWS) ? -1L : (long)s_fields[i].deadband);
+        if (!telemetry_binary_append(buffer, buffer_size, &offset, line)) {
+            return false;
+        }
+    }
+
+    if (!telemetry_binary_append(buffer,
+                                 buffer_size,
+                                 &offset,
+                                 "],\"arrays\":["
+                                 "{\"name\":\"cell_voltage_mv\",\"count\":\"u8\",\"type\":\"u16\"},"
+                                 "{\"name\":\"cell_balancing\",\"count\":\"cell_voltage_mv\",\"type\":\"bitmap\"},"
+                                 "{\"name\":\"registers\",\"count\":\"u16\",\"type\":\"struct\","
+                                 "\"fields\":[{\"name\":\"address\",\"type\":\"u16\"},"
+                                 "{\"name\":\"value\",\"type\":\"u16\"}]}]}")) {
+        return false;
+    }
+
+    if (out_length != NULL) {
+        *out_length = offset;
+    }
+    return true;
+}
+
+bool telemetry_binary_read_field(const uint8_t *frame, size_t length, const char *name, double *out_value)
+{
+    if (frame == NULL || name == NULL || out_value == NULL || length < 4U ||
+        frame[0] != TELEMETRY_BINARY_FRAME_SNAPSHOT) {
+        return false;
+    }
+
+    size_t offset = 4U;
+    for (size_t i = 0; i < TELEMETRY_BINARY_FIELD_COUNT; ++i) {
+        const telemetry_binary_field_t *field = &s_fields[i];
+        telemetry_binary_slot_t slot = {
+            .offset = offset,
+            .width = s_wire_sizes[field->wire],
+            .is_signed = (field->wire == TELEMETRY_BINARY_I16 || field->wire == TELEMETRY_BINARY_I32),
+        };
+        if (offset + slot.width > length) {
+            return false;
+        }
+        if (strcmp(field->name, name) == 0) {
+            int64_t raw = telemetry_binary_slot_value(frame, &slot);
+            *out_value = (field->wire == TELEMETRY_BINARY_U64) ? (double)(uint64_t)raw : (double)raw;
+            *out_value /= (double)field->scale;
+            return true;
+        }
+        offset += slot.width;
+    }
+    return false;
+}
+
+size_t telemetry_binary_field_count(void)
+{
+    return TELEMETRY_BINARY_FIELD_COUNT;
+}
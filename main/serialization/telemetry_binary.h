@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * @file telemetry_binary.h
+ * @brief Packed binary encoding of the battery snapshot (/ws/telemetry)
+ *
+ * Clients that negotiate the TELEMETRY_BINARY_SUBPROTOCOL WebSocket
+ * subprotocol receive the snapshot built by monitoring as a little-endian
+ * binary frame instead of JSON:
+ *
+ *   u8 frame type (TELEMETRY_BINARY_FRAME_SNAPSHOT) | u8 schema version |
+ *   u16 field count | scalar fields in schema order |
+ *   u8 cell count | u16 cell mV[count] | balancing bitmap[(count + 7) / 8] |
+ *   u16 register count | { u16 address, u16 raw value }[count]
+ *
+ * Floats are sent as integers multiplied by the field's scale. The schema is
+ * described once per connection by a JSON text frame from
+ * telemetry_binary_write_schema(), so a client decodes fields by name rather
+ * than by a hard-coded layout.
+ *
+ * Delta mode (opt-in, see web_server_websocket.c) sends a snapshot frame as
+ * keyframe, then only the values that moved beyond their deadband since the
+ * client last received them:
+ *
+ *   u8 frame type (TELEMETRY_BINARY_FRAME_DELTA) | u8 schema version |
+ *   u16 slot count | changed-slot bitmap[(slots + 7) / 8] |
+ *   values of the changed slots, in slot order, with their snapshot widths
+ *
+ * Slots are the scalar fields, then each cell voltage, then the whole
+ * balancing bitmap, then each register value. Fields with a negative
+ * deadband in the schema (timestamp, uptime) never trigger a delta and are
+ * only sent along with another change.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "uart_bms.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_BINARY_SUBPROTOCOL      "tinybms.telemetry.v1"
+#define TELEMETRY_BINARY_VERSION          1U
+#define TELEMETRY_BINARY_FRAME_SNAPSHOT   0x01U
+#define TELEMETRY_BINARY_FRAME_DELTA      0x02U
+#define TELEMETRY_BINARY_SCHEMA_MAX_SIZE  4096U
+#define TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE 512U
+#define TELEMETRY_BINARY_CELL_DEADBAND_MV  2U
+
+/**
+ * @brief Snapshot values derived by monitoring rather than read from the BMS
+ */
+typedef struct {
+    float power_w;
+    uint32_t energy_charged_wh;
+    uint32_t energy_discharged_wh;
+    uint8_t is_charging;
+    uint8_t history_available;
+} telemetry_binary_extras_t;
+
+/**
+ * @brief Encode one snapshot frame
+ *
+ * @return false when @p buffer is too small
+ */
+bool telemetry_binary_write_snapshot(const uart_bms_live_data_t *data,
+                                     const telemetry_binary_extras_t *extras,
+                                     uint8_t *buffer,
+                                     size_t buffer_size,
+                                     size_t *out_length);
+
+typedef enum {
+    TELEMETRY_BINARY_DELTA_UNCHANGED = 0,  /**< Nothing moved beyond its deadband, send nothing. */
+    TELEMETRY_BINARY_DELTA_WRITTEN,        /**< A delta frame was written to the buffer. */
+    TELEMETRY_BINARY_DELTA_KEYFRAME,       /**< Layout changed (or no room): send the snapshot instead. */
+} telemetry_binary_delta_t;
+
+/**
+ * @brief Encode the changes from @p state to @p current as a delta frame
+ *
+ * @param state   Snapshot frame image the client currently holds; the slots
+ *                written to the delta are copied into it
+ * @param current Snapshot frame just encoded by telemetry_binary_write_snapshot()
+ *
+ * On TELEMETRY_BINARY_DELTA_KEYFRAME @p state is left untouched; the caller
+ * sends @p current and makes it the new state.
+ */
+telemetry_binary_delta_t telemetry_binary_write_delta(uint8_t *state,
+                                                      size_t state_length,
+                                                      const uint8_t *current,
+                                                      size_t current_length,
+                                                      uint8_t *buffer,
+                                                      size_t buffer_size,
+                                                      size_t *out_length);
+
+/**
+ * @brief Write the JSON schema descriptor sent once on connect
+ */
+bool telemetry_binary_write_schema(char *buffer, size_t buffer_size, size_t *out_length);
+
+/**
+ * @brief Decode scalar field @p name from a snapshot frame, scale applied
+ */
+bool telemetry_binary_read_field(const uint8_t *frame, size_t length, const char *name, double *out_value);
+
+/**
+ * @brief Number of scalar fields in the schema
+ */
+size_t telemetry_binary_field_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -218,6 +218,7 @@ static void status_led_handle_event(const event_bus_event_t *event)
     case APP_EVENT_ID_CAN_FRAME_RAW:
     case APP_EVENT_ID_CAN_FRAME_DECODED:
     case APP_EVENT_ID_CAN_FRAME_READY:
+    case APP_EVENT_ID_CAN_FRAME_BATCH:
     case APP_EVENT_ID_UART_FRAME_RAW:
     case APP_EVENT_ID_UART_FRAME_DECODED:
     case APP_EVENT_ID_BMS_LIVE_DATA:
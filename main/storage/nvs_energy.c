@@ -1,34 +1,219 @@
 #include "nvs_energy.h"
 
 #include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 #ifdef ESP_PLATFORM
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "nvs.h"
 #include "nvs_flash.h"
+#endif
 
-#define NVS_ENERGY_NAMESPACE "energy"
-#define NVS_ENERGY_KEY       "accum"
+#define NVS_ENERGY_NAMESPACE   "energy"
+#define NVS_ENERGY_RECORD_KEY  "state"
+#define NVS_ENERGY_LEGACY_KEY  "accum"
+#define NVS_ENERGY_LOCK_TIMEOUT_MS 1000U
 
-static const char *TAG = "nvs_energy";
+// Single CRC-protected blob. NVS already spreads rewrites of one key across
+// its pages, so the wear comes from how often the blob is written: callers
+// rate-limit stores and identical states are never written twice.
+typedef struct {
+    uint64_t charged_mwh;
+    uint64_t discharged_mwh;
+    uint32_t charged_remainder_nj;
+    uint32_t discharged_remainder_nj;
+    uint32_t crc32;
+} nvs_energy_record_t;
 
-static bool s_nvs_ready = false;
+// Last record known to be on flash, protected by the backend lock.
+static nvs_energy_record_t s_persisted;
+static bool s_persisted_valid = false;
+static uint32_t s_write_count = 0;
+
+static esp_err_t energy_backend_lock(void);
+static void energy_backend_unlock(void);
+static esp_err_t energy_backend_begin(bool writable);
+static esp_err_t energy_backend_end(bool commit);
+static esp_err_t energy_backend_read(const char *key, nvs_energy_record_t *record);
+static esp_err_t energy_backend_write(const char *key, const nvs_energy_record_t *record);
+static esp_err_t energy_backend_erase(const char *key);
+static esp_err_t energy_backend_read_legacy(nvs_energy_state_t *state);
+
+static uint32_t energy_crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1U) ^ (0xEDB88320U & (uint32_t)(-(int32_t)(crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t energy_record_crc(const nvs_energy_record_t *record)
+{
+    return energy_crc32((const uint8_t *)record, offsetof(nvs_energy_record_t, crc32));
+}
+
+static void energy_record_from_state(const nvs_energy_state_t *state, nvs_energy_record_t *record)
+{
+    memset(record, 0, sizeof(*record));
+    record->charged_mwh = state->charged_mwh;
+    record->discharged_mwh = state->discharged_mwh;
+    record->charged_remainder_nj = state->charged_remainder_nj;
+    record->discharged_remainder_nj = state->discharged_remainder_nj;
+    record->crc32 = energy_record_crc(record);
+}
+
+static bool energy_record_valid(const nvs_energy_record_t *record)
+{
+    return record->crc32 == energy_record_crc(record) &&
+           record->charged_remainder_nj < NVS_ENERGY_NJ_PER_MWH &&
+           record->discharged_remainder_nj < NVS_ENERGY_NJ_PER_MWH;
+}
+
+static void energy_state_from_record(const nvs_energy_record_t *record, nvs_energy_state_t *state)
+{
+    state->charged_mwh = record->charged_mwh;
+    state->discharged_mwh = record->discharged_mwh;
+    state->charged_remainder_nj = record->charged_remainder_nj;
+    state->discharged_remainder_nj = record->discharged_remainder_nj;
+}
+
+static bool energy_state_sane(const nvs_energy_state_t *state)
+{
+    return state->charged_remainder_nj < NVS_ENERGY_NJ_PER_MWH &&
+           state->discharged_remainder_nj < NVS_ENERGY_NJ_PER_MWH;
+}
+
+esp_err_t nvs_energy_load(nvs_energy_state_t *state)
+{
+    if (state == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = energy_backend_lock();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = energy_backend_begin(false);
+    if (err == ESP_OK) {
+        nvs_energy_record_t record;
+        nvs_energy_state_t loaded = {0};
+        esp_err_t read_err = energy_backend_read(NVS_ENERGY_RECORD_KEY, &record);
+        if (read_err == ESP_OK && energy_record_valid(&record)) {
+            energy_state_from_record(&record, &loaded);
+            s_persisted = record;
+            s_persisted_valid = true;
+        } else if (energy_backend_read_legacy(&loaded) != ESP_OK) {
+            err = ESP_ERR_NOT_FOUND;
+        }
+        (void)energy_backend_end(false);
+        if (err == ESP_OK) {
+            *state = loaded;
+        }
+    }
+
+    energy_backend_unlock();
+    return err;
+}
 
-static double sanitize_energy_value(double value)
+esp_err_t nvs_energy_store(const nvs_energy_state_t *state)
 {
-    if (!(value > 0.0) || !isfinite(value)) {
-        return 0.0;
+    if (state == NULL || !energy_state_sane(state)) {
+        return ESP_ERR_INVALID_ARG;
     }
-    return value;
+
+    nvs_energy_record_t record;
+    energy_record_from_state(state, &record);
+
+    esp_err_t err = energy_backend_lock();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Coalesce: a state already on flash costs no write
+    if (s_persisted_valid && memcmp(&s_persisted, &record, sizeof(record)) == 0) {
+        energy_backend_unlock();
+        return ESP_OK;
+    }
+
+    err = energy_backend_begin(true);
+    if (err == ESP_OK) {
+        err = energy_backend_write(NVS_ENERGY_RECORD_KEY, &record);
+        if (err == ESP_OK && !s_persisted_valid) {
+            // First write since boot: the legacy blob has been migrated
+            (void)energy_backend_erase(NVS_ENERGY_LEGACY_KEY);
+        }
+        esp_err_t end_err = energy_backend_end(err == ESP_OK);
+        if (err == ESP_OK) {
+            err = end_err;
+        }
+    }
+    if (err == ESP_OK) {
+        s_persisted = record;
+        s_persisted_valid = true;
+        ++s_write_count;
+    } else {
+        s_persisted_valid = false;
+    }
+
+    energy_backend_unlock();
+    return err;
 }
 
+esp_err_t nvs_energy_clear(void)
+{
+    esp_err_t err = energy_backend_lock();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = energy_backend_begin(true);
+    if (err == ESP_OK) {
+        (void)energy_backend_erase(NVS_ENERGY_RECORD_KEY);
+        (void)energy_backend_erase(NVS_ENERGY_LEGACY_KEY);
+        err = energy_backend_end(true);
+    }
+    s_persisted_valid = false;
+
+    energy_backend_unlock();
+    return err;
+}
+
+uint32_t nvs_energy_write_count(void)
+{
+    return __atomic_load_n(&s_write_count, __ATOMIC_RELAXED);
+}
+
+#ifdef ESP_PLATFORM
+
+static const char *TAG = "nvs_energy";
+
+static bool s_nvs_ready = false;
+static SemaphoreHandle_t s_lock = NULL;  // Serialises s_handle and the cached record
+static nvs_handle_t s_handle = 0;
+
 esp_err_t nvs_energy_init(void)
 {
     if (s_nvs_ready) {
         return ESP_OK;
     }
 
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL) {
+            ESP_LOGE(TAG, "Unable to create energy storage lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW(TAG, "NVS init failed (%s), erasing", esp_err_to_name(err));
@@ -48,137 +233,194 @@ esp_err_t nvs_energy_init(void)
     return ESP_OK;
 }
 
-esp_err_t nvs_energy_load(nvs_energy_state_t *state)
+static esp_err_t energy_backend_lock(void)
 {
-    if (state == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    // Created by nvs_energy_init(), which runs before any concurrent user
+    if (!s_nvs_ready || s_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
-    if (nvs_energy_init() != ESP_OK) {
-        return ESP_FAIL;
+    if (xSemaphoreTake(s_lock, pdMS_TO_TICKS(NVS_ENERGY_LOCK_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Timed out waiting for energy storage lock");
+        return ESP_ERR_TIMEOUT;
     }
+    return ESP_OK;
+}
 
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_ENERGY_NAMESPACE, NVS_READONLY, &handle);
-    if (err != ESP_OK) {
-        return err;
-    }
+static void energy_backend_unlock(void)
+{
+    xSemaphoreGive(s_lock);
+}
 
-    nvs_energy_state_t stored = {0};
-    size_t required = sizeof(stored);
-    err = nvs_get_blob(handle, NVS_ENERGY_KEY, &stored, &required);
-    nvs_close(handle);
-    if (err != ESP_OK) {
-        return err;
-    }
-    if (required != sizeof(stored)) {
-        return ESP_ERR_INVALID_SIZE;
-    }
+static esp_err_t energy_backend_begin(bool writable)
+{
+    return nvs_open(NVS_ENERGY_NAMESPACE, writable ? NVS_READWRITE : NVS_READONLY, &s_handle);
+}
 
-    state->charged_wh = sanitize_energy_value(stored.charged_wh);
-    state->discharged_wh = sanitize_energy_value(stored.discharged_wh);
-    return ESP_OK;
+static esp_err_t energy_backend_end(bool commit)
+{
+    esp_err_t err = commit ? nvs_commit(s_handle) : ESP_OK;
+    nvs_close(s_handle);
+    s_handle = 0;
+    return err;
 }
 
-esp_err_t nvs_energy_store(const nvs_energy_state_t *state)
+static esp_err_t energy_backend_read(const char *key, nvs_energy_record_t *record)
 {
-    if (state == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (nvs_energy_init() != ESP_OK) {
-        return ESP_FAIL;
+    size_t required = sizeof(*record);
+    esp_err_t err = nvs_get_blob(s_handle, key, record, &required);
+    if (err == ESP_OK && required != sizeof(*record)) {
+        return ESP_ERR_INVALID_SIZE;
     }
+    return err;
+}
 
-    nvs_energy_state_t sanitized = {
-        .charged_wh = sanitize_energy_value(state->charged_wh),
-        .discharged_wh = sanitize_energy_value(state->discharged_wh),
-    };
-
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_ENERGY_NAMESPACE, NVS_READWRITE, &handle);
+static esp_err_t energy_backend_write(const char *key, const nvs_energy_record_t *record)
+{
+    esp_err_t err = nvs_set_blob(s_handle, key, record, sizeof(*record));
     if (err != ESP_OK) {
-        return err;
+        ESP_LOGW(TAG, "Failed to write energy record %s: %s", key, esp_err_to_name(err));
     }
-
-    err = nvs_set_blob(handle, NVS_ENERGY_KEY, &sanitized, sizeof(sanitized));
-    if (err == ESP_OK) {
-        err = nvs_commit(handle);
-    }
-    nvs_close(handle);
     return err;
 }
 
-esp_err_t nvs_energy_clear(void)
+static esp_err_t energy_backend_erase(const char *key)
 {
-    if (nvs_energy_init() != ESP_OK) {
-        return ESP_FAIL;
-    }
+    esp_err_t err = nvs_erase_key(s_handle, key);
+    return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+}
 
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open(NVS_ENERGY_NAMESPACE, NVS_READWRITE, &handle);
+// Blob written by firmware versions that stored two doubles in Wh.
+static esp_err_t energy_backend_read_legacy(nvs_energy_state_t *state)
+{
+    struct {
+        double charged_wh;
+        double discharged_wh;
+    } legacy = {0};
+    size_t required = sizeof(legacy);
+    esp_err_t err = nvs_get_blob(s_handle, NVS_ENERGY_LEGACY_KEY, &legacy, &required);
     if (err != ESP_OK) {
         return err;
     }
-
-    err = nvs_erase_key(handle, NVS_ENERGY_KEY);
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        err = ESP_OK;
+    if (required != sizeof(legacy)) {
+        return ESP_ERR_INVALID_SIZE;
     }
-    if (err == ESP_OK) {
-        err = nvs_commit(handle);
+
+    double values[2] = {legacy.charged_wh, legacy.discharged_wh};
+    uint64_t mwh[2] = {0};
+    uint32_t remainder[2] = {0};
+    for (size_t i = 0; i < 2U; ++i) {
+        if (!(values[i] > 0.0) || !isfinite(values[i])) {
+            continue;
+        }
+        double total_mwh = values[i] * 1000.0;
+        double whole = floor(total_mwh);
+        mwh[i] = (uint64_t)whole;
+        remainder[i] = (uint32_t)((total_mwh - whole) * (double)NVS_ENERGY_NJ_PER_MWH);
+        if (remainder[i] >= NVS_ENERGY_NJ_PER_MWH) {
+            remainder[i] = (uint32_t)(NVS_ENERGY_NJ_PER_MWH - 1U);
+        }
     }
-    nvs_close(handle);
-    return err;
+
+    state->charged_mwh = mwh[0];
+    state->discharged_mwh = mwh[1];
+    state->charged_remainder_nj = remainder[0];
+    state->discharged_remainder_nj = remainder[1];
+    ESP_LOGI(TAG, "Migrating legacy energy blob");
+    return ESP_OK;
 }
 
 #else  // !ESP_PLATFORM
 
-static bool s_mock_initialised = false;
-static bool s_mock_has_state = false;
-static nvs_energy_state_t s_mock_state = {0};
+#define NVS_ENERGY_MOCK_KEYS 2U
+#define NVS_ENERGY_KEY_MAX_LEN 8U
+
+typedef struct {
+    char key[NVS_ENERGY_KEY_MAX_LEN];
+    nvs_energy_record_t record;
+    bool used;
+} nvs_energy_mock_entry_t;
+
+static nvs_energy_mock_entry_t s_mock_entries[NVS_ENERGY_MOCK_KEYS];
 
 esp_err_t nvs_energy_init(void)
 {
-    s_mock_initialised = true;
     return ESP_OK;
 }
 
-esp_err_t nvs_energy_load(nvs_energy_state_t *state)
+static nvs_energy_mock_entry_t *energy_mock_find(const char *key, bool create)
 {
-    if (state == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    nvs_energy_mock_entry_t *free_entry = NULL;
+    for (size_t i = 0; i < NVS_ENERGY_MOCK_KEYS; ++i) {
+        if (s_mock_entries[i].used && strcmp(s_mock_entries[i].key, key) == 0) {
+            return &s_mock_entries[i];
+        }
+        if (!s_mock_entries[i].used && free_entry == NULL) {
+            free_entry = &s_mock_entries[i];
+        }
     }
-    if (!s_mock_initialised) {
-        nvs_energy_init();
+    if (create && free_entry != NULL) {
+        memset(free_entry, 0, sizeof(*free_entry));
+        (void)snprintf(free_entry->key, sizeof(free_entry->key), "%s", key);
+        free_entry->used = true;
+        return free_entry;
     }
-    if (!s_mock_has_state) {
+    return NULL;
+}
+
+static esp_err_t energy_backend_lock(void)
+{
+    return ESP_OK;
+}
+
+static void energy_backend_unlock(void)
+{
+}
+
+static esp_err_t energy_backend_begin(bool writable)
+{
+    (void)writable;
+    return ESP_OK;
+}
+
+static esp_err_t energy_backend_end(bool commit)
+{
+    (void)commit;
+    return ESP_OK;
+}
+
+static esp_err_t energy_backend_read(const char *key, nvs_energy_record_t *record)
+{
+    nvs_energy_mock_entry_t *entry = energy_mock_find(key, false);
+    if (entry == NULL) {
         return ESP_ERR_NOT_FOUND;
     }
-    *state = s_mock_state;
+    *record = entry->record;
     return ESP_OK;
 }
 
-esp_err_t nvs_energy_store(const nvs_energy_state_t *state)
+static esp_err_t energy_backend_write(const char *key, const nvs_energy_record_t *record)
 {
-    if (state == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    if (!s_mock_initialised) {
-        nvs_energy_init();
+    nvs_energy_mock_entry_t *entry = energy_mock_find(key, true);
+    if (entry == NULL) {
+        return ESP_ERR_NO_MEM;
     }
-    s_mock_state = *state;
-    s_mock_has_state = true;
+    entry->record = *record;
     return ESP_OK;
 }
 
-esp_err_t nvs_energy_clear(void)
+static esp_err_t energy_backend_erase(const char *key)
 {
-    if (!s_mock_initialised) {
-        nvs_energy_init();
+    nvs_energy_mock_entry_t *entry = energy_mock_find(key, false);
+    if (entry != NULL) {
+        entry->used = false;
     }
-    memset(&s_mock_state, 0, sizeof(s_mock_state));
-    s_mock_has_state = false;
     return ESP_OK;
 }
 
-#endif  // ESP_PLATFORM
+static esp_err_t energy_backend_read_legacy(nvs_energy_state_t *state)
+{
+    (void)state;
+    return ESP_ERR_NOT_FOUND;
+}
 
+#endif  // ESP_PLATFORM
@@ -1,14 +1,38 @@
 #pragma once
 
+/**
+ * @file nvs_energy.h
+ * @brief Persistence of the cumulative energy counters
+ *
+ * The counters live in one CRC-protected NVS blob. A store whose state matches
+ * the record already on flash is skipped, so only real changes cost a write.
+ * nvs_energy_init() must run before the module is used from several tasks; it
+ * creates the lock serialising every access.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
 #include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Nanojoules in one milliwatt-hour (remainder unit of the accumulators). */
+#define NVS_ENERGY_NJ_PER_MWH 3600000000ULL
+
+/**
+ * @brief Fixed-point energy accumulators.
+ *
+ * Energy is kept as whole milliwatt-hours plus a sub-mWh remainder in
+ * nanojoules, so restoring a persisted state is exact.
+ */
 typedef struct {
-    double charged_wh;
-    double discharged_wh;
+    uint64_t charged_mwh;
+    uint64_t discharged_mwh;
+    uint32_t charged_remainder_nj;    /**< Always below ::NVS_ENERGY_NJ_PER_MWH. */
+    uint32_t discharged_remainder_nj; /**< Always below ::NVS_ENERGY_NJ_PER_MWH. */
 } nvs_energy_state_t;
 
 esp_err_t nvs_energy_init(void);
@@ -16,7 +40,11 @@ esp_err_t nvs_energy_load(nvs_energy_state_t *state);
 esp_err_t nvs_energy_store(const nvs_energy_state_t *state);
 esp_err_t nvs_energy_clear(void);
 
+/**
+ * @brief Number of flash writes issued by nvs_energy_store() since boot.
+ */
+uint32_t nvs_energy_write_count(void);
+
 #ifdef __cplusplus
 }
 #endif
-
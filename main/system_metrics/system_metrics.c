@@ -488,41 +488,47 @@ static const char *system_metrics_task_state_to_string(uint32_t state)
     }
 }
 
+esp_err_t system_metrics_write_tasks_json(const system_metrics_task_snapshot_t *tasks,
+                                          json_writer_t *writer)
+{
+    if (tasks == NULL || writer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    json_writer_printf(writer, "[");
+    for (size_t i = 0; i < tasks->task_count && json_writer_ok(writer); ++i) {
+        const system_metrics_task_info_t *task = &tasks->tasks[i];
+        json_writer_printf(writer, "%s{\"name\":", (i == 0) ? "" : ",");
+        json_writer_string(writer, task->name);
+        json_writer_printf(writer,
+                           ",\"state\":\"%s\",\"cpu_percent\":%.2f,\"runtime_ticks\":%" PRIu32
+                           ",\"stack_high_water_mark\":%" PRIu32 ",\"core\":%" PRId32 "}",
+                           system_metrics_task_state_to_string(task->state),
+                           (double)task->cpu_percent,
+                           task->runtime_ticks,
+                           task->stack_high_water_mark,
+                           task->core_id);
+    }
+    json_writer_printf(writer, "]");
+    return writer->error;
+}
+
 esp_err_t system_metrics_tasks_to_json(const system_metrics_task_snapshot_t *tasks,
                                        char *buffer,
                                        size_t buffer_size,
                                        size_t *out_length)
 {
-    if (tasks == NULL) {
+    if (tasks == NULL || buffer == NULL || buffer_size == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    cJSON *array = cJSON_CreateArray();
-    if (array == NULL) {
-        return ESP_ERR_NO_MEM;
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, buffer_size, NULL, NULL);
+    esp_err_t err = system_metrics_write_tasks_json(tasks, &writer);
+    if (err != ESP_OK) {
+        return err;
     }
-
-    for (size_t i = 0; i < tasks->task_count; ++i) {
-        const system_metrics_task_info_t *task = &tasks->tasks[i];
-        cJSON *entry = cJSON_CreateObject();
-        if (entry == NULL) {
-            cJSON_Delete(array);
-            return ESP_ERR_NO_MEM;
-        }
-
-        cJSON_AddStringToObject(entry, "name", task->name);
-        cJSON_AddStringToObject(entry, "state", system_metrics_task_state_to_string(task->state));
-        cJSON_AddNumberToObject(entry, "cpu_percent", task->cpu_percent);
-        cJSON_AddNumberToObject(entry, "runtime_ticks", (double)task->runtime_ticks);
-        cJSON_AddNumberToObject(entry, "stack_high_water_mark", (double)task->stack_high_water_mark);
-        cJSON_AddNumberToObject(entry, "core", (double)task->core_id);
-
-        cJSON_AddItemToArray(array, entry);
-    }
-
-    esp_err_t err = system_metrics_send_json(array, buffer, buffer_size, out_length);
-    cJSON_Delete(array);
-    return err;
+    return json_writer_finish(&writer, out_length);
 }
 
 esp_err_t system_metrics_modules_to_json(const system_metrics_module_snapshot_t *modules,
@@ -6,6 +6,8 @@
 #include "esp_err.h"
 #include "esp_system.h"
 
+#include "json_writer.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -108,6 +110,12 @@ esp_err_t system_metrics_tasks_to_json(const system_metrics_task_snapshot_t *tas
                                        size_t buffer_size,
                                        size_t *out_length);
 
+/**
+ * @brief Stream the task list of system_metrics_tasks_to_json() to @p writer
+ */
+esp_err_t system_metrics_write_tasks_json(const system_metrics_task_snapshot_t *tasks,
+                                          json_writer_t *writer);
+
 esp_err_t system_metrics_modules_to_json(const system_metrics_module_snapshot_t *modules,
                                          char *buffer,
                                          size_t buffer_size,
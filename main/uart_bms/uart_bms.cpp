@@ -831,12 +831,32 @@ uint32_t uart_bms_get_poll_interval_ms(void)
     return interval;
 }
 
+esp_err_t uart_bms_listeners_init(void)
+{
+    if (s_listeners_mutex != nullptr) {
+        return ESP_OK;
+    }
+
+    s_listeners_mutex = xSemaphoreCreateMutex();
+    if (s_listeners_mutex == nullptr) {
+        ESP_LOGE(kTag, "Unable to allocate TinyBMS listeners mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
 void uart_bms_init(void)
 {
     if (s_uart_initialised) {
         return;
     }
 
+    // Le registre des listeners ne dépend pas du driver UART : il est créé
+    // en premier pour que les modules puissent s'abonner même si l'UART échoue
+    if (uart_bms_listeners_init() != ESP_OK) {
+        return;
+    }
+
     uart_config_t config = {
         .baud_rate = UART_BMS_BAUD_RATE,
         .data_bits = UART_DATA_8_BITS,
@@ -924,15 +944,6 @@ void uart_bms_init(void)
         }
     }
 
-    if (s_listeners_mutex == nullptr) {
-        s_listeners_mutex = xSemaphoreCreateMutex();
-        if (s_listeners_mutex == nullptr) {
-            ESP_LOGE(kTag, "Unable to allocate TinyBMS listeners mutex");
-            uart_driver_delete(UART_BMS_UART_PORT);
-            return;
-        }
-    }
-
     if (s_shared_listeners_mutex == nullptr) {
         s_shared_listeners_mutex = xSemaphoreCreateMutex();
         if (s_shared_listeners_mutex == nullptr) {
@@ -982,10 +993,6 @@ void uart_bms_init(void)
             vSemaphoreDelete(s_snapshot_mutex);
             s_snapshot_mutex = nullptr;
         }
-        if (s_listeners_mutex != nullptr) {
-            vSemaphoreDelete(s_listeners_mutex);
-            s_listeners_mutex = nullptr;
-        }
         if (s_shared_listeners_mutex != nullptr) {
             vSemaphoreDelete(s_shared_listeners_mutex);
             s_shared_listeners_mutex = nullptr;
@@ -1003,7 +1010,11 @@ esp_err_t uart_bms_register_listener(uart_bms_data_callback_t callback, void *co
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (s_listeners_mutex == nullptr || xSemaphoreTake(s_listeners_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+    if (s_listeners_mutex == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xSemaphoreTake(s_listeners_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
         return ESP_ERR_TIMEOUT;
     }
 
@@ -81,6 +81,14 @@ typedef struct {
 
 typedef void (*uart_bms_data_callback_t)(const uart_bms_live_data_t *data, void *context);
 
+/**
+ * @brief Create the listener registry used by uart_bms_register_listener().
+ *
+ * Called by uart_bms_init(). Call it directly, from the init context, when
+ * frames are fed through uart_bms_process_frame() without the UART driver.
+ */
+esp_err_t uart_bms_listeners_init(void);
+
 void uart_bms_init(void);
 void uart_bms_deinit(void);
 void uart_bms_set_event_publisher(event_bus_publish_fn_t publisher);
@@ -547,16 +547,49 @@ const uart_bms_register_metadata_t g_uart_bms_registers[UART_BMS_REGISTER_COUNT]
 
 const size_t g_uart_bms_register_count = UART_BMS_REGISTER_COUNT;
 
+/*
+ * Poll list in request order. Each entry carries its word index so the
+ * address table and the direct-mapped slot lookup below stay in sync.
+ */
+#define UART_BMS_POLL_ADDRESS_LIST(X) \
+    X( 0, 0x0000) X( 1, 0x0001) X( 2, 0x0002) X( 3, 0x0003) X( 4, 0x0004) \
+    X( 5, 0x0005) X( 6, 0x0006) X( 7, 0x0007) X( 8, 0x0008) X( 9, 0x0009) \
+    X(10, 0x000A) X(11, 0x000B) X(12, 0x000C) X(13, 0x000D) X(14, 0x000E) \
+    X(15, 0x000F) X(16, 0x0020) X(17, 0x0021) X(18, 0x0022) X(19, 0x0023) \
+    X(20, 0x0024) X(21, 0x0025) X(22, 0x0026) X(23, 0x0027) X(24, 0x0028) \
+    X(25, 0x0029) X(26, 0x002A) X(27, 0x002B) X(28, 0x002D) X(29, 0x002E) \
+    X(30, 0x002F) X(31, 0x0030) X(32, 0x0032) X(33, 0x0033) X(34, 0x0034) \
+    X(35, 0x0066) X(36, 0x0067) X(37, 0x0071) X(38, 0x0131) X(39, 0x0132) \
+    X(40, 0x0133) X(41, 0x013B) X(42, 0x013C) X(43, 0x013D) X(44, 0x013E) \
+    X(45, 0x013F) X(46, 0x0140) X(47, 0x01F4) X(48, 0x01F5) X(49, 0x01F6) \
+    X(50, 0x01F7) X(51, 0x01F8) X(52, 0x01F9) X(53, 0x01FA) X(54, 0x01FB) \
+    X(55, 0x01FC) X(56, 0x01FD) X(57, 0x01FE) X(58, 0x01FF)
+
+#define UART_BMS_POLL_ADDRESS_ENTRY(index, address) (address),
+#define UART_BMS_POLL_SLOT_ENTRY(index, address) [(address)] = (uint8_t)((index) + 1),
+
 const uint16_t g_uart_bms_poll_addresses[UART_BMS_REGISTER_WORD_COUNT] = {
-    0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008,
-    0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F, 0x0020, 0x0021,
-    0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A,
-    0x002B, 0x002D, 0x002E, 0x002F, 0x0030, 0x0032, 0x0033, 0x0034, 0x0066,
-    0x0067, 0x0071, 0x0131, 0x0132, 0x0133, 0x013B, 0x013C, 0x013D, 0x013E,
-    0x013F, 0x0140, 0x01F4, 0x01F5, 0x01F6, 0x01F7, 0x01F8, 0x01F9, 0x01FA,
-    0x01FB, 0x01FC, 0x01FD, 0x01FE, 0x01FF,
+    UART_BMS_POLL_ADDRESS_LIST(UART_BMS_POLL_ADDRESS_ENTRY)
+};
+
+// Direct-mapped address -> (word index + 1); zero marks addresses outside the poll list.
+static const uint8_t s_poll_slot_by_address[UART_BMS_POLL_ADDRESS_SPAN] = {
+    UART_BMS_POLL_ADDRESS_LIST(UART_BMS_POLL_SLOT_ENTRY)
 };
 
+size_t uart_bms_protocol_poll_index(uint16_t address)
+{
+    if (address >= UART_BMS_POLL_ADDRESS_SPAN) {
+        return UART_BMS_POLL_INDEX_NONE;
+    }
+
+    uint8_t slot = s_poll_slot_by_address[address];
+    if (slot == 0U) {
+        return UART_BMS_POLL_INDEX_NONE;
+    }
+    return (size_t)(slot - 1U);
+}
+
 const uart_bms_register_metadata_t *uart_bms_protocol_find_by_address(uint16_t address)
 {
     for (size_t i = 0; i < UART_BMS_REGISTER_COUNT; ++i) {
@@ -573,4 +606,5 @@ const uart_bms_register_metadata_t *uart_bms_protocol_find_by_address(uint16_t a
 static_assert((sizeof(g_uart_bms_poll_addresses) / sizeof(g_uart_bms_poll_addresses[0])) ==
                   UART_BMS_REGISTER_WORD_COUNT,
               "Poll address table size must match register word count");
-
+static_assert(UART_BMS_REGISTER_WORD_COUNT < 0xFF,
+              "Poll slot table stores word indexes in uint8_t");
@@ -18,6 +18,16 @@ extern "C" {
  */
 #define UART_BMS_REGISTER_WORD_COUNT 59
 
+/**
+ * @brief Exclusive upper bound of the register addresses covered by the poll list.
+ */
+#define UART_BMS_POLL_ADDRESS_SPAN 0x0200U
+
+/**
+ * @brief Sentinel returned by uart_bms_protocol_poll_index() for unpolled addresses.
+ */
+#define UART_BMS_POLL_INDEX_NONE UART_BMS_REGISTER_WORD_COUNT
+
 /**
  * @brief Enumerates the logical TinyBMS registers that are polled over UART.
  */
@@ -142,6 +152,18 @@ extern const uint16_t g_uart_bms_poll_addresses[UART_BMS_REGISTER_WORD_COUNT];
 
 const uart_bms_register_metadata_t *uart_bms_protocol_find_by_address(uint16_t address);
 
+/**
+ * @brief Resolve the word index of a register address within the poll list.
+ *
+ * Decoded samples store register words in poll order, so the returned index
+ * is also the slot of the address in uart_bms_live_data_t::registers. The
+ * lookup is a single direct-mapped table access.
+ *
+ * @param address TinyBMS register address.
+ * @return Index into ::g_uart_bms_poll_addresses, or ::UART_BMS_POLL_INDEX_NONE.
+ */
+size_t uart_bms_protocol_poll_index(uint16_t address);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,12 +55,8 @@ uint8_t sanitize_ascii(uint8_t value)
 
 size_t find_poll_index(uint16_t address, size_t register_count)
 {
-    for (size_t i = 0; i < register_count; ++i) {
-        if (g_uart_bms_poll_addresses[i] == address) {
-            return i;
-        }
-    }
-    return register_count;
+    size_t index = uart_bms_protocol_poll_index(address);
+    return (index < register_count) ? index : register_count;
 }
 
 size_t decode_ascii_field(uint16_t base_address,
@@ -53,6 +53,7 @@
 #include "system_metrics.h"
 #include "ota_update.h"
 #include "system_control.h"
+#include "telemetry_binary.h"
 #include "web_server_ota_errors.h"
 
 #include "cJSON.h"
@@ -101,12 +102,10 @@
 #define WEB_SERVER_MULTIPART_BOUNDARY_MAX 72
 #define WEB_SERVER_MULTIPART_HEADER_MAX 256
 #define WEB_SERVER_RESTART_DEFAULT_DELAY_MS 750U
-#define WEB_SERVER_HISTORY_JSON_SIZE      4096
 #define WEB_SERVER_MQTT_JSON_SIZE         768
 #define WEB_SERVER_CAN_JSON_SIZE          512
 #define WEB_SERVER_RUNTIME_JSON_SIZE      1536
 #define WEB_SERVER_EVENT_BUS_JSON_SIZE    1536
-#define WEB_SERVER_TASKS_JSON_SIZE        8192
 #define WEB_SERVER_MODULES_JSON_SIZE      2048
 #define WEB_SERVER_JSON_CHUNK_SIZE        1024
 
@@ -348,6 +347,22 @@ void web_server_init(void)
     };
     httpd_register_uri_handler(s_httpd, &api_system_modules);
 
+    const httpd_uri_t api_metrics_websocket = {
+        .uri = "/api/metrics/websocket",
+        .method = HTTP_GET,
+        .handler = web_server_api_websocket_metrics_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(s_httpd, &api_metrics_websocket);
+
+    const httpd_uri_t api_metrics_cache = {
+        .uri = "/api/metrics/cache",
+        .method = HTTP_GET,
+        .handler = web_server_api_cache_metrics_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(s_httpd, &api_metrics_cache);
+
     const httpd_uri_t api_system_restart = {
         .uri = "/api/system/restart",
         .method = HTTP_POST,
@@ -430,6 +445,14 @@ void web_server_init(void)
     };
     httpd_register_uri_handler(s_httpd, &api_can_status);
 
+    const httpd_uri_t api_can_capture = {
+        .uri = "/api/can/capture",
+        .method = HTTP_GET,
+        .handler = web_server_api_can_capture_handler,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(s_httpd, &api_can_capture);
+
     const httpd_uri_t api_history = {
         .uri = "/api/history",
         .method = HTTP_GET,
@@ -557,6 +580,7 @@ void web_server_init(void)
         .handler = web_server_telemetry_ws_handler,
         .user_ctx = NULL,
         .is_websocket = true,
+        .supported_subprotocol = TELEMETRY_BINARY_SUBPROTOCOL,
     };
     httpd_register_uri_handler(s_httpd, &telemetry_ws);
 
@@ -773,7 +797,7 @@ static void web_server_event_task(void *context)
         }
 
         // Delegate to WebSocket module for broadcasting
-        web_server_websocket_broadcast_event(event.id, payload, length);
+        web_server_websocket_broadcast_event(event.id, payload, length, monitoring_snapshot_from_event(&event));
         event_bus_release(&event);
     }
 
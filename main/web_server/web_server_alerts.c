@@ -135,6 +135,11 @@ esp_err_t web_server_api_alerts_active_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static esp_err_t web_server_write_alert_history_json(json_writer_t *writer, void *context)
+{
+    return alert_manager_write_history_json(writer, *(const size_t *)context);
+}
+
 /**
  * @brief GET /api/alerts/history?limit=N - Get alert history
  */
@@ -150,27 +155,7 @@ esp_err_t web_server_api_alerts_history_handler(httpd_req_t *req)
         }
     }
 
-    char *buffer = malloc(ALERT_JSON_BUFFER_SIZE);
-    if (buffer == NULL) {
-        httpd_resp_send_500(req);
-        return ESP_ERR_NO_MEM;
-    }
-
-    size_t length = 0;
-    esp_err_t err = alert_manager_get_history_json(buffer, ALERT_JSON_BUFFER_SIZE, &length, limit);
-
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get alert history JSON: %s", esp_err_to_name(err));
-        free(buffer);
-        httpd_resp_send_500(req);
-        return err;
-    }
-
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, buffer, length);
-    free(buffer);
-
-    return ESP_OK;
+    return web_server_stream_json(req, web_server_write_alert_history_json, &limit);
 }
 
 /**
@@ -34,6 +34,7 @@
 #include "esp_spiffs.h"
 #include "esp_timer.h"
 #include "esp_system.h"
+#include "esp_random.h"
 #include "nvs.h"
 
 #include "freertos/FreeRTOS.h"
@@ -50,7 +51,12 @@
 #include "history_fs.h"
 #include "alert_manager.h"
 #include "web_server_alerts.h"
+#include "ws_client_queue.h"
+#include "json_writer.h"
+#include "web_server_cache.h"
 #include "can_victron.h"
+#include "can_victron_capture.h"
+#include "can_publisher.h"
 #include "system_metrics.h"
 #include "ota_update.h"
 #include "system_control.h"
@@ -94,14 +100,15 @@
 #define WEB_SERVER_MULTIPART_BOUNDARY_MAX 72
 #define WEB_SERVER_MULTIPART_HEADER_MAX 256
 #define WEB_SERVER_RESTART_DEFAULT_DELAY_MS 750U
-#define WEB_SERVER_HISTORY_JSON_SIZE      4096
 #define WEB_SERVER_MQTT_JSON_SIZE         768
 #define WEB_SERVER_CAN_JSON_SIZE          512
 #define WEB_SERVER_RUNTIME_JSON_SIZE      1536
 #define WEB_SERVER_EVENT_BUS_JSON_SIZE    1536
-#define WEB_SERVER_TASKS_JSON_SIZE        8192
 #define WEB_SERVER_MODULES_JSON_SIZE      2048
 #define WEB_SERVER_JSON_CHUNK_SIZE        1024
+#define WEB_SERVER_STATUS_RESPONSE_SIZE   (MONITORING_SNAPSHOT_MAX_SIZE + 32U)
+#define WEB_SERVER_CACHE_COND_HDR_MAX     128
+#define WEB_SERVER_STATUS_CACHE_MAX_AGE_MS 1000U
 
 static const char *TAG = "web_server_api";
 
@@ -124,6 +131,14 @@ static app_event_metadata_t s_restart_event_metadata = {
     .timestamp_ms = 0U,
 };
 
+// Rendered /api/status and /api/config bodies (see web_server_cache.h)
+static char s_status_cache_body[WEB_SERVER_STATUS_RESPONSE_SIZE];
+static char s_config_cache_body[CONFIG_MANAGER_MAX_CONFIG_SIZE];
+static web_server_cache_entry_t s_status_cache;
+static web_server_cache_entry_t s_config_cache;
+static const char *s_config_cache_visibility = NULL;
+static uint32_t s_cache_epoch = 0;
+
 static esp_err_t web_server_send_json(httpd_req_t *req, const char *buffer, size_t length)
 {
     if (req == NULL || buffer == NULL) {
@@ -150,6 +165,100 @@ static esp_err_t web_server_send_json(httpd_req_t *req, const char *buffer, size
     return httpd_resp_send_chunk(req, NULL, 0);
 }
 
+static esp_err_t web_server_json_chunk_flush(void *context, const char *data, size_t length)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)context, data, length);
+}
+
+esp_err_t web_server_stream_json(httpd_req_t *req, web_server_json_producer_t produce, void *context)
+{
+    if (req == NULL || produce == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char *window = malloc(JSON_WRITER_WINDOW_SIZE);
+    if (window == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    web_server_set_security_headers(req);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    json_writer_t writer;
+    json_writer_init(&writer, window, JSON_WRITER_WINDOW_SIZE, web_server_json_chunk_flush, req);
+    esp_err_t err = produce(&writer, context);
+    bool producer_failed = (err != ESP_OK);
+    if (!producer_failed) {
+        err = json_writer_finish(&writer, NULL);
+    }
+    size_t flushed = writer.flushed;
+    free(window);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to stream JSON after %zu bytes: %s", flushed, esp_err_to_name(err));
+        // Once a chunk is out the status line is gone too: returning the
+        // error closes the socket, so the client sees a truncated body.
+        if (producer_failed && flushed == 0U) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON serialization error");
+        }
+        return err;
+    }
+
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static void web_server_api_cache_setup(void)
+{
+    if (s_status_cache.body != NULL) {
+        return;
+    }
+
+    s_cache_epoch = esp_random();
+    web_server_cache_init(&s_status_cache, "status", s_status_cache_body, sizeof(s_status_cache_body));
+    // The status body also embeds the uptime, monitoring diagnostics and
+    // event bus metrics, which move without a new sample
+    web_server_cache_set_max_age(&s_status_cache, WEB_SERVER_STATUS_CACHE_MAX_AGE_MS);
+    web_server_cache_init(&s_config_cache, "config", s_config_cache_body, sizeof(s_config_cache_body));
+}
+
+// Sends a refreshed cache entry, or 304 when If-None-Match holds its ETag.
+// Only public bodies are revalidated: no-cache (not no-store) lets browsers
+// keep them. A body holding secrets (Wi-Fi/MQTT passwords) stays no-store
+// and goes out without an ETag, so no client or proxy writes it to disk.
+static esp_err_t web_server_send_cache_entry(httpd_req_t *req, web_server_cache_entry_t *entry, bool public_body)
+{
+    if (!public_body) {
+        httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_send(req, entry->body, entry->length);
+    }
+
+    char etag[WEB_SERVER_CACHE_ETAG_MAX];
+    if (!web_server_cache_format_etag(entry, s_cache_epoch, etag, sizeof(etag))) {
+        etag[0] = '\0';
+    }
+
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (etag[0] != '\0') {
+        httpd_resp_set_hdr(req, "ETag", etag);
+
+        char if_none_match[WEB_SERVER_CACHE_COND_HDR_MAX];
+        size_t header_len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+        if (header_len > 0U && header_len < sizeof(if_none_match) &&
+            httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+            web_server_static_etag_matches(if_none_match, etag)) {
+            entry->not_modified++;
+            httpd_resp_set_status(req, "304 Not Modified");
+            return httpd_resp_send(req, NULL, 0);
+        }
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, entry->body, entry->length);
+}
+
 static void web_server_set_http_status_code(httpd_req_t *req, int status_code)
 {
     if (req == NULL) {
@@ -636,6 +745,11 @@ static esp_err_t web_server_api_event_bus_metrics_handler(httpd_req_t *req)
     return send_err;
 }
 
+static esp_err_t web_server_write_tasks_json(json_writer_t *writer, void *context)
+{
+    return system_metrics_write_tasks_json((const system_metrics_task_snapshot_t *)context, writer);
+}
+
 static esp_err_t web_server_api_system_tasks_handler(httpd_req_t *req)
 {
     system_metrics_task_snapshot_t tasks;
@@ -646,24 +760,49 @@ static esp_err_t web_server_api_system_tasks_handler(httpd_req_t *req)
         return err;
     }
 
-    char *buffer = malloc(WEB_SERVER_TASKS_JSON_SIZE);
-    if (buffer == NULL) {
-        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
-        return ESP_ERR_NO_MEM;
-    }
+    return web_server_stream_json(req, web_server_write_tasks_json, &tasks);
+}
 
-    size_t length = 0;
-    err = system_metrics_tasks_to_json(&tasks, buffer, WEB_SERVER_TASKS_JSON_SIZE, &length);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to serialize task metrics: %s", esp_err_to_name(err));
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Task metrics serialization error");
-        free(buffer);
-        return err;
+static esp_err_t web_server_write_history_json(json_writer_t *writer, void *context)
+{
+    return monitoring_write_history_json(*(const size_t *)context, writer);
+}
+
+/**
+ * @brief GET /api/history?limit=N - Recent samples kept by monitoring
+ */
+esp_err_t web_server_api_history_handler(httpd_req_t *req)
+{
+    size_t limit = 0;
+    char query[32];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "limit", value, sizeof(value)) == ESP_OK) {
+            char *end = NULL;
+            unsigned long parsed = strtoul(value, &end, 10);
+            if (end == value || *end != '\0') {
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid limit");
+                return ESP_ERR_INVALID_ARG;
+            }
+            limit = (size_t)parsed;
+        }
     }
 
-    esp_err_t send_err = web_server_send_json(req, buffer, length);
-    free(buffer);
-    return send_err;
+    return web_server_stream_json(req, web_server_write_history_json, &limit);
+}
+
+static esp_err_t web_server_write_registers_json(json_writer_t *writer, void *context)
+{
+    (void)context;
+    return config_manager_write_registers_json(writer);
+}
+
+/**
+ * @brief GET /api/registers - TinyBMS register catalogue with current values
+ */
+esp_err_t web_server_api_registers_get_handler(httpd_req_t *req)
+{
+    return web_server_stream_json(req, web_server_write_registers_json, NULL);
 }
 
 static esp_err_t web_server_api_system_modules_handler(httpd_req_t *req)
@@ -704,6 +843,395 @@ static esp_err_t web_server_api_system_modules_handler(httpd_req_t *req)
     return send_err;
 }
 
+#define WEB_SERVER_WS_STATS_MAX_CLIENTS 32U
+
+esp_err_t web_server_api_websocket_metrics_handler(httpd_req_t *req)
+{
+    web_server_ws_client_stats_t *clients = calloc(WEB_SERVER_WS_STATS_MAX_CLIENTS, sizeof(*clients));
+    if (clients == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t evictions = 0;
+    size_t total = web_server_websocket_get_client_stats(clients, WEB_SERVER_WS_STATS_MAX_CLIENTS, &evictions);
+    size_t listed = (total < WEB_SERVER_WS_STATS_MAX_CLIENTS) ? total : WEB_SERVER_WS_STATS_MAX_CLIENTS;
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        free(clients);
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddNumberToObject(root, "queue_depth", CONFIG_TINYBMS_WEB_WS_QUEUE_DEPTH);
+    cJSON_AddNumberToObject(root, "lag_budget_ms", CONFIG_TINYBMS_WEB_WS_LAG_BUDGET_MS);
+    cJSON_AddNumberToObject(root, "keyframe_interval_ms", CONFIG_TINYBMS_WEB_WS_KEYFRAME_INTERVAL_MS);
+    cJSON_AddNumberToObject(root, "client_count", (double)total);
+    cJSON_AddNumberToObject(root, "evictions", evictions);
+
+    cJSON *array = cJSON_AddArrayToObject(root, "clients");
+    for (size_t i = 0; array != NULL && i < listed; ++i) {
+        cJSON *entry = cJSON_CreateObject();
+        if (entry == NULL) {
+            break;
+        }
+        cJSON_AddNumberToObject(entry, "fd", clients[i].fd);
+        cJSON_AddStringToObject(entry, "channel", clients[i].channel);
+        cJSON_AddStringToObject(entry, "format", clients[i].format);
+        cJSON_AddNumberToObject(entry, "queued", clients[i].queued);
+        cJSON_AddNumberToObject(entry, "sent", clients[i].sent);
+        cJSON_AddNumberToObject(entry, "bytes_sent", clients[i].bytes_sent);
+        cJSON_AddNumberToObject(entry, "keyframes", clients[i].keyframes);
+        cJSON_AddNumberToObject(entry, "interval_ms", clients[i].interval_ms);
+        cJSON_AddNumberToObject(entry, "skipped", clients[i].skipped);
+        cJSON_AddNumberToObject(entry, "dropped", clients[i].dropped);
+        cJSON_AddNumberToObject(entry, "lag_ms", clients[i].lag_ms);
+        cJSON_AddNumberToObject(entry, "max_lag_ms", clients[i].max_lag_ms);
+        cJSON_AddItemToArray(array, entry);
+    }
+    free(clients);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (json == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t send_err = web_server_send_json(req, json, strlen(json));
+    cJSON_free(json);
+    return send_err;
+}
+
+static void web_server_add_cache_metrics(cJSON *root, const web_server_cache_entry_t *entry)
+{
+    cJSON *object = cJSON_AddObjectToObject(root, entry->name);
+    if (object == NULL) {
+        return;
+    }
+    cJSON_AddNumberToObject(object, "generation", entry->generation);
+    cJSON_AddNumberToObject(object, "hits", entry->hits);
+    cJSON_AddNumberToObject(object, "misses", entry->misses);
+    cJSON_AddNumberToObject(object, "not_modified", entry->not_modified);
+    cJSON_AddNumberToObject(object, "hit_rate_pct", web_server_cache_hit_rate(entry));
+    cJSON_AddNumberToObject(object, "bytes", (double)entry->length);
+}
+
+esp_err_t web_server_api_cache_metrics_handler(httpd_req_t *req)
+{
+    web_server_api_cache_setup();
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    web_server_add_cache_metrics(root, &s_status_cache);
+    web_server_add_cache_metrics(root, &s_config_cache);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (json == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t send_err = web_server_send_json(req, json, strlen(json));
+    cJSON_free(json);
+    return send_err;
+}
+
+static const char *web_server_can_bus_state_label(twai_state_t state)
+{
+    switch (state) {
+        case TWAI_STATE_STOPPED:
+            return "stopped";
+        case TWAI_STATE_RUNNING:
+            return "running";
+        case TWAI_STATE_BUS_OFF:
+            return "bus_off";
+        case TWAI_STATE_RECOVERING:
+            return "recovering";
+        default:
+            return "unknown";
+    }
+}
+
+static cJSON *web_server_can_publisher_to_json(void)
+{
+    cJSON *publisher = cJSON_CreateObject();
+    if (publisher == NULL) {
+        return NULL;
+    }
+
+    can_publisher_shaping_status_t shaping = {0};
+    can_publisher_get_shaping_status(&shaping);
+    cJSON_AddBoolToObject(publisher, "shaping_active", shaping.active);
+    cJSON_AddNumberToObject(publisher, "shaping_occupancy_pct", shaping.bus_occupancy_pct);
+
+    can_publisher_buffer_diagnostics_t diagnostics = {0};
+    can_publisher_get_buffer_diagnostics(&diagnostics);
+    cJSON_AddNumberToObject(publisher, "torn_reads", diagnostics.torn_reads);
+    cJSON_AddNumberToObject(publisher, "skipped_reads", diagnostics.skipped_reads);
+
+    can_publisher_dispatch_stats_t dispatch = {0};
+    can_publisher_get_dispatch_stats(&dispatch);
+    cJSON_AddNumberToObject(publisher, "dispatch_passes", dispatch.passes);
+    cJSON_AddNumberToObject(publisher, "dispatch_frames", dispatch.frames);
+    cJSON_AddNumberToObject(publisher, "dispatch_publisher_calls", dispatch.publisher_calls);
+    cJSON_AddNumberToObject(publisher, "dispatch_last_us", dispatch.last_dispatch_us);
+    cJSON_AddNumberToObject(publisher, "dispatch_max_us", dispatch.max_dispatch_us);
+    cJSON_AddNumberToObject(publisher, "dispatch_total_us", (double)dispatch.total_dispatch_us);
+
+    can_publisher_channel_stats_t stats[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    size_t count = can_publisher_get_channel_stats(stats, CAN_PUBLISHER_MAX_BUFFER_SLOTS);
+
+    cJSON *channels = cJSON_AddArrayToObject(publisher, "channels");
+    if (channels == NULL) {
+        cJSON_Delete(publisher);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        cJSON *channel = cJSON_CreateObject();
+        if (channel == NULL) {
+            cJSON_Delete(publisher);
+            return NULL;
+        }
+        double rate_hz = (stats[i].avg_interval_us > 0U) ? (1000000.0 / (double)stats[i].avg_interval_us) : 0.0;
+        cJSON_AddNumberToObject(channel, "can_id", stats[i].can_id);
+        cJSON_AddNumberToObject(channel, "period_ms", stats[i].period_ms);
+        cJSON_AddNumberToObject(channel, "effective_period_ms", stats[i].effective_period_ms);
+        cJSON_AddNumberToObject(channel, "rate_hz", rate_hz);
+        cJSON_AddNumberToObject(channel, "frames_sent", stats[i].frames_sent);
+        cJSON_AddNumberToObject(channel, "jitter_last_us", stats[i].last_jitter_us);
+        cJSON_AddNumberToObject(channel, "jitter_max_us", stats[i].max_jitter_us);
+        cJSON_AddNumberToObject(channel, "jitter_avg_us", stats[i].avg_jitter_us);
+        cJSON_AddNumberToObject(channel, "on_change_frames", stats[i].on_change_frames);
+        cJSON_AddNumberToObject(channel, "change_count", stats[i].change_latency_count);
+        cJSON_AddNumberToObject(channel, "change_latency_last_us", stats[i].change_latency_last_us);
+        cJSON_AddNumberToObject(channel, "change_latency_max_us", stats[i].change_latency_max_us);
+        cJSON_AddNumberToObject(channel, "change_latency_avg_us", stats[i].change_latency_avg_us);
+        cJSON_AddItemToArray(channels, channel);
+    }
+
+    return publisher;
+}
+
+esp_err_t web_server_api_can_status_handler(httpd_req_t *req)
+{
+    can_victron_status_t status;
+    esp_err_t err = can_victron_get_status(&status);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to collect CAN status: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "CAN status unavailable");
+        return err;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddNumberToObject(root, "timestamp_ms", (double)status.timestamp_ms);
+    cJSON_AddBoolToObject(root, "driver_started", status.driver_started);
+
+    cJSON *keepalive = cJSON_AddObjectToObject(root, "keepalive");
+    if (keepalive != NULL) {
+        cJSON_AddBoolToObject(keepalive, "ok", status.keepalive_ok);
+        cJSON_AddNumberToObject(keepalive, "interval_ms", status.keepalive_interval_ms);
+        cJSON_AddNumberToObject(keepalive, "timeout_ms", status.keepalive_timeout_ms);
+        cJSON_AddNumberToObject(keepalive, "retry_ms", status.keepalive_retry_ms);
+        cJSON_AddNumberToObject(keepalive, "last_tx_ms", (double)status.last_keepalive_tx_ms);
+        cJSON_AddNumberToObject(keepalive, "last_rx_ms", (double)status.last_keepalive_rx_ms);
+        cJSON_AddNumberToObject(keepalive, "responses", status.keepalive_response_count);
+        cJSON_AddNumberToObject(keepalive, "response_last_us", status.keepalive_response_last_us);
+        cJSON_AddNumberToObject(keepalive, "response_avg_us", status.keepalive_response_avg_us);
+        cJSON_AddNumberToObject(keepalive, "response_max_us", status.keepalive_response_max_us);
+    }
+
+    cJSON *frames = cJSON_AddObjectToObject(root, "frames");
+    if (frames != NULL) {
+        cJSON_AddNumberToObject(frames, "tx_count", (double)status.tx_frame_count);
+        cJSON_AddNumberToObject(frames, "rx_count", (double)status.rx_frame_count);
+        cJSON_AddNumberToObject(frames, "tx_bytes", (double)status.tx_byte_count);
+        cJSON_AddNumberToObject(frames, "rx_bytes", (double)status.rx_byte_count);
+        cJSON_AddNumberToObject(frames, "tx_batches", status.tx_batch_count);
+        cJSON_AddNumberToObject(frames, "tx_lock_hold_last_us", status.tx_lock_hold_last_us);
+        cJSON_AddNumberToObject(frames, "tx_lock_hold_max_us", status.tx_lock_hold_max_us);
+        cJSON_AddNumberToObject(frames, "tx_lock_hold_total_us", (double)status.tx_lock_hold_total_us);
+        cJSON_AddNumberToObject(frames, "tx_lock_acquisitions", status.tx_lock_acquisitions);
+        cJSON_AddBoolToObject(frames, "rx_filter", status.rx_filter_enabled);
+        cJSON_AddNumberToObject(frames, "rx_task_wakeups", status.rx_task_wakeups);
+    }
+
+    cJSON *errors = cJSON_AddObjectToObject(root, "errors");
+    if (errors != NULL) {
+        cJSON_AddNumberToObject(errors, "tx_error_counter", status.tx_error_counter);
+        cJSON_AddNumberToObject(errors, "rx_error_counter", status.rx_error_counter);
+        cJSON_AddNumberToObject(errors, "tx_failed_count", status.tx_failed_count);
+        cJSON_AddNumberToObject(errors, "rx_missed_count", status.rx_missed_count);
+        cJSON_AddNumberToObject(errors, "arbitration_lost_count", status.arbitration_lost_count);
+        cJSON_AddNumberToObject(errors, "bus_error_count", status.bus_error_count);
+        cJSON_AddNumberToObject(errors, "bus_off_count", status.bus_off_count);
+        cJSON_AddNumberToObject(errors, "bus_recovery_count", status.bus_recovery_count);
+    }
+
+    cJSON *bus = cJSON_AddObjectToObject(root, "bus");
+    if (bus != NULL) {
+        cJSON_AddNumberToObject(bus, "state", (double)status.bus_state);
+        cJSON_AddStringToObject(bus, "state_label", web_server_can_bus_state_label(status.bus_state));
+        cJSON_AddNumberToObject(bus, "occupancy_pct", status.bus_occupancy_pct);
+        cJSON_AddNumberToObject(bus, "window_ms", status.occupancy_window_ms);
+
+        cJSON *windows = cJSON_AddArrayToObject(bus, "windows");
+        for (size_t i = 0; windows != NULL && i < CAN_VICTRON_OCCUPANCY_WINDOW_COUNT; ++i) {
+            cJSON *entry = cJSON_CreateObject();
+            if (entry == NULL) {
+                break;
+            }
+            cJSON_AddNumberToObject(entry, "window_s", status.occupancy[i].window_s);
+            cJSON_AddNumberToObject(entry, "covered_s", status.occupancy[i].covered_s);
+            cJSON_AddNumberToObject(entry, "occupancy_pct", status.occupancy[i].occupancy_pct);
+            cJSON_AddNumberToObject(entry, "frames_per_s", status.occupancy[i].frames_per_s);
+            cJSON_AddItemToArray(windows, entry);
+        }
+    }
+
+    cJSON *publisher = web_server_can_publisher_to_json();
+    if (publisher != NULL) {
+        cJSON_AddItemToObject(root, "publisher", publisher);
+    }
+
+    can_victron_capture_stats_t capture_stats;
+    can_victron_capture_get_stats(&capture_stats);
+    cJSON *capture = cJSON_AddObjectToObject(root, "capture");
+    if (capture != NULL) {
+        cJSON_AddNumberToObject(capture, "depth", capture_stats.depth);
+        cJSON_AddNumberToObject(capture, "recorded", capture_stats.recorded);
+        cJSON_AddNumberToObject(capture, "available", capture_stats.available);
+        cJSON_AddNumberToObject(capture, "spilled", capture_stats.spilled);
+        cJSON_AddNumberToObject(capture, "spill_lost", capture_stats.spill_lost);
+        cJSON_AddNumberToObject(capture, "spill_errors", capture_stats.spill_errors);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (json == NULL) {
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t send_err = web_server_send_json(req, json, strlen(json));
+    cJSON_free(json);
+    return send_err;
+}
+
+#define WEB_SERVER_CAN_CAPTURE_CHUNK 1024U
+
+// GET /api/can/capture?format=candump|bin&dir=all|tx|rx&iface=can0
+esp_err_t web_server_api_can_capture_handler(httpd_req_t *req)
+{
+    bool binary = false;
+    int direction_filter = -1;  // -1 = all, 0 = tx, 1 = rx
+    char iface[16] = "can0";
+
+    char query[96];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            binary = (strcmp(value, "bin") == 0);
+        }
+        if (httpd_query_key_value(query, "dir", value, sizeof(value)) == ESP_OK) {
+            if (strcmp(value, "tx") == 0) {
+                direction_filter = 0;
+            } else if (strcmp(value, "rx") == 0) {
+                direction_filter = 1;
+            }
+        }
+        if (httpd_query_key_value(query, "iface", value, sizeof(value)) == ESP_OK && value[0] != '\0') {
+            bool valid = true;
+            for (const char *p = value; *p != '\0'; ++p) {
+                if (!isalnum((unsigned char)*p) && *p != '_' && *p != '-') {
+                    valid = false;
+                    break;
+                }
+            }
+            if (valid) {
+                snprintf(iface, sizeof(iface), "%s", value);
+            }
+        }
+    }
+
+    can_victron_capture_stats_t stats;
+    can_victron_capture_get_stats(&stats);
+    if (stats.depth == 0U) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "CAN capture disabled");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    can_victron_capture_record_t *records = malloc((size_t)stats.depth * sizeof(*records));
+    char *chunk = malloc(WEB_SERVER_CAN_CAPTURE_CHUNK);
+    if (records == NULL || chunk == NULL) {
+        free(records);
+        free(chunk);
+        httpd_resp_send_err(req, HTTPD_503_SERVICE_UNAVAILABLE, "Memory allocation failure");
+        return ESP_ERR_NO_MEM;
+    }
+    size_t count = can_victron_capture_snapshot(records, stats.depth);
+
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    if (binary) {
+        httpd_resp_set_type(req, "application/octet-stream");
+        httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"can_capture.bin\"");
+    } else {
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"can_capture.log\"");
+    }
+
+    size_t used = 0;
+    esp_err_t err = ESP_OK;
+    if (binary) {
+        can_victron_capture_file_header_t header;
+        can_victron_capture_fill_header(&header);
+        memcpy(chunk, &header, sizeof(header));
+        used = sizeof(header);
+    }
+
+    for (size_t i = 0; i < count && err == ESP_OK; ++i) {
+        const can_victron_capture_record_t *record = &records[i];
+        int is_rx = ((record->flags & CAN_VICTRON_CAPTURE_FLAG_RX) != 0U) ? 1 : 0;
+        if (direction_filter >= 0 && direction_filter != is_rx) {
+            continue;
+        }
+
+        size_t needed = binary ? sizeof(*record) : CAN_VICTRON_CAPTURE_CANDUMP_LINE_MAX;
+        if (used + needed > WEB_SERVER_CAN_CAPTURE_CHUNK) {
+            err = httpd_resp_send_chunk(req, chunk, used);
+            used = 0;
+        }
+        if (binary) {
+            memcpy(chunk + used, record, sizeof(*record));
+            used += sizeof(*record);
+        } else {
+            used += can_victron_capture_format_candump(record, iface, chunk + used, WEB_SERVER_CAN_CAPTURE_CHUNK - used);
+        }
+    }
+
+    if (err == ESP_OK && used > 0) {
+        err = httpd_resp_send_chunk(req, chunk, used);
+    }
+    free(records);
+    free(chunk);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
 static void web_server_parse_mqtt_uri(const char *uri,
                                       char *scheme,
                                       size_t scheme_size,
@@ -874,35 +1402,45 @@ static const char *web_server_mqtt_event_to_string(mqtt_client_event_id_t id)
     }
 }
 
-static esp_err_t web_server_api_status_handler(httpd_req_t *req)
+static esp_err_t web_server_render_status(char *buffer, size_t buffer_size, size_t *out_length)
 {
-    char snapshot[MONITORING_SNAPSHOT_MAX_SIZE];
+    static const char prefix[] = "{\"battery\":";
+    const size_t prefix_len = sizeof(prefix) - 1U;
+    if (buffer_size < prefix_len + 2U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Render the snapshot in place, between the wrapper's braces
+    memcpy(buffer, prefix, prefix_len);
     size_t length = 0;
-    esp_err_t err = monitoring_get_status_json(snapshot, sizeof(snapshot), &length);
+    esp_err_t err = monitoring_get_status_json(buffer + prefix_len, buffer_size - prefix_len - 1U, &length);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to build status JSON: %s", esp_err_to_name(err));
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Status unavailable");
         return err;
     }
 
-    if (length >= sizeof(snapshot)) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Status too large");
-        return ESP_ERR_INVALID_SIZE;
-    }
+    length += prefix_len;
+    buffer[length++] = '}';
+    buffer[length] = '\0';
+    *out_length = length;
+    return ESP_OK;
+}
 
-    snapshot[length] = '\0';
+static esp_err_t web_server_api_status_handler(httpd_req_t *req)
+{
+    web_server_api_cache_setup();
 
-    char response[MONITORING_SNAPSHOT_MAX_SIZE + 32U];
-    int written = snprintf(response, sizeof(response), "{\"battery\":%s}", snapshot);
-    if (written <= 0 || (size_t)written >= sizeof(response)) {
-        ESP_LOGE(TAG, "Failed to wrap status response");
+    esp_err_t err = web_server_cache_refresh(&s_status_cache,
+                                             monitoring_get_generation(),
+                                             (uint64_t)(esp_timer_get_time() / 1000LL),
+                                             web_server_render_status,
+                                             NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to build status JSON: %s", esp_err_to_name(err));
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Status unavailable");
-        return ESP_ERR_INVALID_SIZE;
+        return err;
     }
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
-    return httpd_resp_send(req, response, written);
+    return web_server_send_cache_entry(req, &s_status_cache, true);
 }
 
 static bool web_server_request_authorized_for_secrets(httpd_req_t *req)
@@ -934,34 +1472,43 @@ esp_err_t web_server_prepare_config_snapshot(const char *uri,
     return err;
 }
 
+static esp_err_t web_server_render_config(char *buffer, size_t buffer_size, size_t *out_length)
+{
+    return web_server_prepare_config_snapshot(NULL,
+                                              true,
+                                              buffer,
+                                              buffer_size,
+                                              out_length,
+                                              &s_config_cache_visibility);
+}
+
 static esp_err_t web_server_api_config_get_handler(httpd_req_t *req)
 {
     if (!web_server_require_authorization(req, false, NULL, 0)) {
         return ESP_FAIL;
     }
 
-    char buffer[CONFIG_MANAGER_MAX_CONFIG_SIZE];
-    size_t length = 0;
-    const char *visibility = NULL;
-    bool authorized = web_server_request_authorized_for_secrets(req);
-    esp_err_t err = web_server_prepare_config_snapshot(req->uri,
-                                                       authorized,
-                                                       buffer,
-                                                       sizeof(buffer),
-                                                       &length,
-                                                       &visibility);
+    // A single entry is cached: every authorized caller gets the full
+    // snapshot today. Key the cache on visibility too if that changes.
+    (void)web_server_request_authorized_for_secrets(req);
+    web_server_api_cache_setup();
+
+    esp_err_t err = web_server_cache_refresh(&s_config_cache,
+                                             config_manager_get_generation(),
+                                             (uint64_t)(esp_timer_get_time() / 1000LL),
+                                             web_server_render_config,
+                                             NULL);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to load configuration JSON: %s", esp_err_to_name(err));
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Config unavailable");
         return err;
     }
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
-    if (visibility != NULL) {
-        httpd_resp_set_hdr(req, "X-Config-Snapshot", visibility);
+    if (s_config_cache_visibility != NULL) {
+        httpd_resp_set_hdr(req, "X-Config-Snapshot", s_config_cache_visibility);
     }
-    return httpd_resp_send(req, buffer, length);
+    // The snapshot includes secrets: the cache only saves the render here
+    return web_server_send_cache_entry(req, &s_config_cache, false);
 }
 
 static esp_err_t web_server_api_config_post_handler(httpd_req_t *req)
@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * @file web_server_assets.h
+ * @brief Web UI assets compiled into the firmware (CONFIG_TINYBMS_WEB_EMBED_ASSETS)
+ *
+ * The table is generated at build time by tools/build_web_assets.py from
+ * `web/`. Entries are sorted by path in byte order so lookups can use
+ * bsearch() with strcmp(); bodies live in rodata and are sent from flash
+ * without an intermediate buffer.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *path;     /**< URI path, e.g. "/dashboard.js". */
+    const uint8_t *data;  /**< Body as sent on the wire. */
+    uint32_t size;        /**< Body length in bytes. */
+    const char *etag;     /**< First 64 bits of the SHA-256 of the uncompressed file, hex. */
+    bool gzip;            /**< Body is gzip encoded (Content-Encoding: gzip). */
+} web_server_embedded_asset_t;
+
+extern const web_server_embedded_asset_t g_web_server_embedded_assets[];
+extern const size_t g_web_server_embedded_asset_count;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file web_server_cache.c
+ * @brief Rendered-response cache for polled REST endpoints
+ */
+
+#include "web_server_cache.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+void web_server_cache_init(web_server_cache_entry_t *entry, const char *name, char *storage, size_t capacity)
+{
+    if (entry == NULL) {
+        return;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->name = name;
+    entry->body = storage;
+    entry->capacity = capacity;
+}
+
+void web_server_cache_set_max_age(web_server_cache_entry_t *entry, uint32_t max_age_ms)
+{
+    if (entry != NULL) {
+        entry->max_age_ms = max_age_ms;
+    }
+}
+
+static bool web_server_cache_expired(const web_server_cache_entry_t *entry, uint64_t now_ms)
+{
+    if (entry->max_age_ms == 0U) {
+        return false;
+    }
+    // A clock going backwards counts as expired too
+    return now_ms < entry->rendered_ms || (now_ms - entry->rendered_ms) >= entry->max_age_ms;
+}
+
+esp_err_t web_server_cache_refresh(web_server_cache_entry_t *entry,
+                                   uint32_t generation,
+                                   uint64_t now_ms,
+                                   web_server_cache_render_fn_t render,
+                                   bool *out_hit)
+{
+    if (out_hit != NULL) {
+        *out_hit = false;
+    }
+    if (entry == NULL || entry->body == NULL || entry->capacity == 0U || render == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (entry->valid && entry->generation == generation && !web_server_cache_expired(entry, now_ms)) {
+        entry->hits++;
+        if (out_hit != NULL) {
+            *out_hit = true;
+        }
+        return ESP_OK;
+    }
+
+    entry->misses++;
+    entry->valid = false;
+    size_t length = 0;
+    esp_err_t err = render(entry->body, entry->capacity, &length);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (length >= entry->capacity) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    entry->length = length;
+    entry->generation = generation;
+    entry->rendered_ms = now_ms;
+    entry->renders++;
+    entry->valid = true;
+    return ESP_OK;
+}
+
+void web_server_cache_invalidate(web_server_cache_entry_t *entry)
+{
+    if (entry != NULL) {
+        entry->valid = false;
+    }
+}
+
+bool web_server_cache_format_etag(const web_server_cache_entry_t *entry,
+                                  uint32_t epoch,
+                                  char *buffer,
+                                  size_t buffer_size)
+{
+    if (entry == NULL || !entry->valid || buffer == NULL || buffer_size == 0U) {
+        return false;
+    }
+
+    int written = snprintf(buffer,
+                           buffer_size,
+                           "\"%s-%08" PRIx32 "-%" PRIu32 "-%" PRIu32 "\"",
+                           (entry->name != NULL) ? entry->name : "",
+                           epoch,
+                           entry->generation,
+                           entry->renders);
+    return written > 0 && (size_t)written < buffer_size;
+}
+
+float web_server_cache_hit_rate(const web_server_cache_entry_t *entry)
+{
+    if (entry == NULL) {
+        return 0.0f;
+    }
+
+    uint32_t total = entry->hits + entry->misses;
+    if (total == 0U) {
+        return 0.0f;
+    }
+    return 100.0f * (float)entry->hits / (float)total;
+}
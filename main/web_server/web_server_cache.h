@@ -0,0 +1,112 @@
+/**
+ * @file web_server_cache.h
+ * @brief Rendered-response cache for polled REST endpoints
+ *
+ * /api/status and /api/config are polled by every open web UI tab while
+ * their content only changes with a new TinyBMS sample or a configuration
+ * update. Each cached response is tagged with the generation counter of its
+ * source (monitoring_get_generation(), config_manager_get_generation()); a
+ * request re-renders only when the generation moved, and the generation also
+ * forms the ETag so an up-to-date client gets a 304 without a body. An entry
+ * can also carry a max age, for bodies that embed values moving without their
+ * source generation (uptime, diagnostics, bus metrics). Bodies
+ * that carry secrets (/api/config) only use the render cache: they are sent
+ * with no-store and without an ETag.
+ *
+ * Entries are not thread safe: all HTTP handlers run on the single
+ * esp_http_server task.
+ */
+
+#ifndef WEB_SERVER_CACHE_H
+#define WEB_SERVER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WEB_SERVER_CACHE_ETAG_MAX 48U
+
+/**
+ * @brief Render the response body into @p buffer (see web_server_cache_refresh())
+ */
+typedef esp_err_t (*web_server_cache_render_fn_t)(char *buffer, size_t buffer_size, size_t *out_length);
+
+typedef struct {
+    const char *name;       /**< Endpoint label, part of the ETag. */
+    char *body;             /**< Caller-provided storage. */
+    size_t capacity;
+    size_t length;
+    uint32_t generation;    /**< Source generation @ref body was rendered for. */
+    uint32_t max_age_ms;    /**< Re-render after this age even on the same generation (0: never). */
+    uint64_t rendered_ms;   /**< Time @ref body was rendered. */
+    uint32_t renders;       /**< Render count, part of the ETag. */
+    bool valid;
+    uint32_t hits;          /**< Requests served from @ref body. */
+    uint32_t misses;        /**< Requests that rendered @ref body. */
+    uint32_t not_modified;  /**< Hits answered with 304 Not Modified. */
+} web_server_cache_entry_t;
+
+/**
+ * @brief Bind @p entry to @p storage and clear it
+ */
+void web_server_cache_init(web_server_cache_entry_t *entry, const char *name, char *storage, size_t capacity);
+
+/**
+ * @brief Re-render @p entry once its body is older than @p max_age_ms
+ *
+ * @param max_age_ms 0 (the default) keys the entry on its generation only
+ */
+void web_server_cache_set_max_age(web_server_cache_entry_t *entry, uint32_t max_age_ms);
+
+/**
+ * @brief Make @p entry hold the body for @p generation
+ *
+ * Read the source generation before calling: a sample landing during the
+ * render then tags newer data with an older generation, which only costs
+ * one extra render, never a stale hit.
+ *
+ * @param now_ms  Current time, checked against the entry's max age
+ * @param out_hit Set when @p entry already held @p generation (optional)
+ * @return ESP_OK, or the render error (the entry is then invalid)
+ */
+esp_err_t web_server_cache_refresh(web_server_cache_entry_t *entry,
+                                   uint32_t generation,
+                                   uint64_t now_ms,
+                                   web_server_cache_render_fn_t render,
+                                   bool *out_hit);
+
+/**
+ * @brief Drop the cached body so the next request renders
+ */
+void web_server_cache_invalidate(web_server_cache_entry_t *entry);
+
+/**
+ * @brief Quoted ETag for the cached body, e.g. "status-1a2b3c4d-42-3"
+ *
+ * The tag holds the generation and the render count, so a body re-rendered
+ * on age for the same generation gets a new tag.
+ *
+ * @param epoch Random per-boot value, so generations restarting at 0 after
+ *              a reboot never match a tag a client kept
+ */
+bool web_server_cache_format_etag(const web_server_cache_entry_t *entry,
+                                  uint32_t epoch,
+                                  char *buffer,
+                                  size_t buffer_size);
+
+/**
+ * @brief Share of requests served without rendering, in percent (0 when idle)
+ */
+float web_server_cache_hit_rate(const web_server_cache_entry_t *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WEB_SERVER_CACHE_H
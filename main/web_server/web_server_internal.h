@@ -18,6 +18,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "event_bus.h"
+#include "json_writer.h"
+#include "monitoring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +33,11 @@ extern "C" {
 #define WEB_SERVER_MAX_URI_LEN 128
 #define WEB_SERVER_MAX_CONTENT_LEN 8192
 
+// Full snapshot interval for /ws/telemetry?mode=delta clients
+#ifndef CONFIG_TINYBMS_WEB_WS_KEYFRAME_INTERVAL_MS
+#define CONFIG_TINYBMS_WEB_WS_KEYFRAME_INTERVAL_MS 10000
+#endif
+
 #if CONFIG_TINYBMS_WEB_AUTH_BASIC_ENABLE
 #define WEB_SERVER_AUTH_HEADER_MAX 512
 #define WEB_SERVER_AUTH_DECODED_MAX 256
@@ -76,6 +83,20 @@ bool web_server_format_iso8601(time_t timestamp, char *buffer, size_t size);
  */
 esp_err_t web_server_send_json(httpd_req_t *req, const char *buffer, size_t length);
 
+/**
+ * @brief Writes one JSON document into @p writer (see web_server_stream_json())
+ */
+typedef esp_err_t (*web_server_json_producer_t)(json_writer_t *writer, void *context);
+
+/**
+ * @brief Stream the JSON document of @p produce as a chunked response
+ *
+ * The document goes out through a JSON_WRITER_WINDOW_SIZE window, so the
+ * request needs the same RAM whatever the response size. A producer error
+ * before the first chunk becomes a 500; after it, the connection is closed.
+ */
+esp_err_t web_server_stream_json(httpd_req_t *req, web_server_json_producer_t produce, void *context);
+
 /**
  * @brief Take server mutex with timeout
  */
@@ -147,6 +168,7 @@ esp_err_t web_server_api_mqtt_config_post_handler(httpd_req_t *req);
 esp_err_t web_server_api_mqtt_status_handler(httpd_req_t *req);
 esp_err_t web_server_api_mqtt_test_handler(httpd_req_t *req);
 esp_err_t web_server_api_can_status_handler(httpd_req_t *req);
+esp_err_t web_server_api_can_capture_handler(httpd_req_t *req);
 esp_err_t web_server_api_history_handler(httpd_req_t *req);
 esp_err_t web_server_api_history_files_handler(httpd_req_t *req);
 esp_err_t web_server_api_history_archive_handler(httpd_req_t *req);
@@ -159,6 +181,8 @@ esp_err_t web_server_api_metrics_runtime_handler(httpd_req_t *req);
 esp_err_t web_server_api_event_bus_metrics_handler(httpd_req_t *req);
 esp_err_t web_server_api_system_tasks_handler(httpd_req_t *req);
 esp_err_t web_server_api_system_modules_handler(httpd_req_t *req);
+esp_err_t web_server_api_websocket_metrics_handler(httpd_req_t *req);
+esp_err_t web_server_api_cache_metrics_handler(httpd_req_t *req);
 
 #if CONFIG_TINYBMS_WEB_AUTH_BASIC_ENABLE
 esp_err_t web_server_api_security_csrf_get_handler(httpd_req_t *req);
@@ -175,10 +199,50 @@ esp_err_t web_server_static_get_handler(httpd_req_t *req);
 // ============================================================================
 
 /**
- * @brief Mount SPIFFS filesystem
+ * @brief Mount SPIFFS filesystem (also loads the asset manifest)
  */
 esp_err_t web_server_mount_spiffs(void);
 
+/**
+ * @brief (Re)load `etags.txt`, the build-time ETag and .gz variant manifest
+ */
+void web_server_static_load_manifest(void);
+
+/**
+ * @brief Whether an If-None-Match header value matches @p etag (quoted)
+ *
+ * Handles lists, `*` and weak (`W/`) tags as RFC 9110 requires for
+ * If-None-Match.
+ */
+bool web_server_static_etag_matches(const char *if_none_match, const char *etag);
+
+/**
+ * @brief Whether an Accept-Encoding header value allows gzip
+ */
+bool web_server_static_accepts_gzip(const char *accept_encoding);
+
+/**
+ * @brief Content hash as build_web_assets.py computes it (16 hex digits)
+ *
+ * @param out_hex At least 17 bytes
+ */
+bool web_server_static_hash_content(const void *data, size_t length, char *out_hex);
+
+/**
+ * @brief Retag a manifest entry with the hash of the file actually stored
+ *
+ * When @p file_hash differs, @p manifest_hash is overwritten and the .gz
+ * variant, built from the old content, is disabled.
+ *
+ * @return true when the entry was stale
+ */
+bool web_server_static_reconcile_hash(char *manifest_hash, bool *has_gzip, const char *file_hash);
+
+/**
+ * @brief Quoted strong ETag of a representation, e.g. "9f86d081884c7d65-gz"
+ */
+bool web_server_static_format_etag(const char *hash, bool gzip, char *buffer, size_t buffer_size);
+
 // ============================================================================
 // WebSocket handlers (from web_server_websocket.c)
 // ============================================================================
@@ -195,8 +259,44 @@ void web_server_websocket_cleanup(void);
 
 /**
  * @brief Broadcast event to appropriate WebSocket clients
+ *
+ * @param snapshot Buffer of an APP_EVENT_ID_TELEMETRY_SAMPLE event
+ *                 (monitoring_snapshot_from_event()), NULL otherwise
+ */
+void web_server_websocket_broadcast_event(uint32_t event_id,
+                                          const char *payload,
+                                          size_t length,
+                                          monitoring_snapshot_t *snapshot);
+
+/**
+ * @brief Send-queue counters of one connected WebSocket client
+ */
+typedef struct {
+    int fd;
+    const char *channel;    /**< "telemetry", "events", "uart", "can" or "alerts". */
+    const char *format;     /**< "json", "binary" or "delta". */
+    uint32_t queued;        /**< Messages waiting in the client's queue. */
+    uint32_t sent;
+    uint32_t bytes_sent;
+    uint32_t keyframes;     /**< Full snapshots sent to a delta client. */
+    uint32_t interval_ms;   /**< Requested telemetry interval, 0 for every sample. */
+    uint32_t skipped;       /**< Samples decimated away by the client's rate. */
+    uint32_t dropped;       /**< Overwritten (drop-oldest) or refused messages. */
+    uint32_t lag_ms;        /**< Age of the oldest message not yet delivered. */
+    uint32_t max_lag_ms;
+} web_server_ws_client_stats_t;
+
+/**
+ * @brief Snapshot the send queues of all WebSocket clients
+ *
+ * @param out Array filled with up to @p capacity entries (may be NULL)
+ * @param capacity Size of @p out
+ * @param out_evictions Clients disconnected for lag or overflow since boot (optional)
+ * @return Number of connected clients, which may exceed @p capacity
  */
-void web_server_websocket_broadcast_event(uint32_t event_id, const char *payload, size_t length);
+size_t web_server_websocket_get_client_stats(web_server_ws_client_stats_t *out,
+                                             size_t capacity,
+                                             uint32_t *out_evictions);
 
 #ifdef __cplusplus
 }
@@ -7,7 +7,22 @@
  * - Static file serving (HTML, CSS, JS, images, etc.)
  * - Content-type detection
  * - Path traversal protection
- * - Caching headers
+ * - Caching headers, precompressed (.gz) variants and ETag revalidation
+ *
+ * tools/build_web_assets.py stages the partition image: it adds a `.gz`
+ * variant next to each text asset and writes `etags.txt`, which maps every
+ * served path to a strong ETag computed at build time. The manifest is loaded
+ * once at mount; without it files are served uncompressed and untagged. Each
+ * listed file is hashed at load: a file replaced by hand without regenerating
+ * etags.txt gets the tag of its actual content and loses its stale .gz
+ * variant, so clients holding the old tag receive the new file.
+ * Paths too long for a SPIFFS object name are stored flattened under /_/ and
+ * the manifest gives their stored name, so they are only reachable with it.
+ *
+ * With CONFIG_TINYBMS_WEB_EMBED_ASSETS the same files are also compiled into
+ * a rodata table (web_server_assets.h) and sent straight from flash. A SPIFFS
+ * file whose content differs from the embedded copy overrides it, and is
+ * tagged with the hash of that content.
  */
 
 #include "web_server.h"
@@ -15,6 +30,8 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <sys/stat.h>
@@ -25,14 +42,50 @@
 #include "esp_http_server.h"
 #include "esp_spiffs.h"
 
+#include "sdkconfig.h"
+
+#include "mbedtls/sha256.h"
+
+#if CONFIG_TINYBMS_WEB_EMBED_ASSETS
+#include "web_server_assets.h"
+#endif
+
 #define WEB_SERVER_FS_BASE_PATH "/spiffs"
 #define WEB_SERVER_WEB_ROOT     WEB_SERVER_FS_BASE_PATH
 #define WEB_SERVER_INDEX_PATH   WEB_SERVER_WEB_ROOT "/index.html"
 #define WEB_SERVER_MAX_PATH     256
 #define WEB_SERVER_FILE_BUFSZ   1024
+#define WEB_SERVER_MANIFEST_PATH     WEB_SERVER_WEB_ROOT "/etags.txt"
+#define WEB_SERVER_MANIFEST_MAX_SIZE 8192
+#define WEB_SERVER_ETAG_HASH_LEN     16
+#define WEB_SERVER_ETAG_MAX          (WEB_SERVER_ETAG_HASH_LEN + 6)  // quotes, "-gz", NUL
+#define WEB_SERVER_COND_HDR_MAX      256
+// Request header forcing the SPIFFS path (benchmarks); echoed in responses
+#define WEB_SERVER_SOURCE_HEADER     "X-Asset-Source"
 
 static const char *TAG = "web_server_static";
 
+typedef struct {
+    const char *path;   // Points into s_manifest_text
+    char *hash;         // Idem, rewritten when the stored file differs
+    const char *file;   // Name on SPIFFS, differs from path when flattened
+    bool has_gzip;
+} web_server_asset_meta_t;
+
+// Immutable after web_server_mount_spiffs(), read by the httpd task only
+static char *s_manifest_text = NULL;
+static web_server_asset_meta_t *s_assets = NULL;
+static size_t s_asset_count = 0;
+
+#if CONFIG_TINYBMS_WEB_EMBED_ASSETS
+// One flag per embedded asset, set when SPIFFS holds a different version
+static bool *s_embedded_overridden = NULL;
+static void web_server_static_scan_overrides(void);
+#endif
+
+static void web_server_static_verify_manifest(void);
+static bool web_server_static_hash_file(const char *fs_path, uint8_t *buffer, size_t buffer_size, char *out_hex);
+
 // ============================================================================
 // SPIFFS mount
 // ============================================================================
@@ -64,9 +117,442 @@ esp_err_t web_server_mount_spiffs(void)
         ESP_LOGI(TAG, "SPIFFS mounted: %u/%u bytes used", (unsigned)used, (unsigned)total);
     }
 
+    web_server_static_load_manifest();
+#if CONFIG_TINYBMS_WEB_EMBED_ASSETS
+    web_server_static_scan_overrides();
+#endif
     return ESP_OK;
 }
 
+// ============================================================================
+// Asset manifest (build-time ETags and .gz variants)
+// ============================================================================
+
+static int web_server_asset_compare(const void *lhs, const void *rhs)
+{
+    const web_server_asset_meta_t *a = (const web_server_asset_meta_t *)lhs;
+    const web_server_asset_meta_t *b = (const web_server_asset_meta_t *)rhs;
+    return strcmp(a->path, b->path);
+}
+
+static size_t web_server_manifest_parse(char *text, web_server_asset_meta_t *assets, size_t capacity)
+{
+    size_t count = 0;
+    char *save = NULL;
+    for (char *line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        char *fields_save = NULL;
+        char *path = strtok_r(line, " \r", &fields_save);
+        char *hash = strtok_r(NULL, " \r", &fields_save);
+        if (path == NULL || hash == NULL || path[0] != '/' || strlen(hash) != WEB_SERVER_ETAG_HASH_LEN) {
+            continue;
+        }
+        // Optional "gz" flag, then optional "@<stored name>"
+        bool has_gzip = false;
+        const char *file = path;
+        for (char *field = strtok_r(NULL, " \r", &fields_save); field != NULL;
+             field = strtok_r(NULL, " \r", &fields_save)) {
+            if (strcmp(field, "gz") == 0) {
+                has_gzip = true;
+            } else if (field[0] == '@' && field[1] == '/') {
+                file = field + 1;
+            }
+        }
+        if (assets != NULL && count < capacity) {
+            assets[count].path = path;
+            assets[count].hash = hash;
+            assets[count].file = file;
+            assets[count].has_gzip = has_gzip;
+        }
+        ++count;
+    }
+    return count;
+}
+
+void web_server_static_load_manifest(void)
+{
+    free(s_assets);
+    free(s_manifest_text);
+    s_assets = NULL;
+    s_manifest_text = NULL;
+    s_asset_count = 0;
+
+    struct stat st = {0};
+    if (stat(WEB_SERVER_MANIFEST_PATH, &st) != 0 || st.st_size <= 0 || st.st_size > WEB_SERVER_MANIFEST_MAX_SIZE) {
+        ESP_LOGW(TAG, "No asset manifest, serving without ETag or gzip variants");
+        return;
+    }
+
+    FILE *file = fopen(WEB_SERVER_MANIFEST_PATH, "r");
+    if (file == NULL) {
+        return;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char *text = malloc(size + 1U);
+    if (text == NULL) {
+        fclose(file);
+        return;
+    }
+    size_t read_bytes = fread(text, 1, size, file);
+    fclose(file);
+    text[read_bytes] = '\0';
+
+    // Count lines first so the table is a single allocation
+    size_t capacity = 1;
+    for (size_t i = 0; i < read_bytes; ++i) {
+        if (text[i] == '\n') {
+            ++capacity;
+        }
+    }
+
+    web_server_asset_meta_t *assets = calloc(capacity, sizeof(*assets));
+    if (assets == NULL) {
+        free(text);
+        return;
+    }
+
+    size_t count = web_server_manifest_parse(text, assets, capacity);
+    if (count > capacity) {
+        count = capacity;
+    }
+    qsort(assets, count, sizeof(*assets), web_server_asset_compare);
+
+    s_manifest_text = text;
+    s_assets = assets;
+    s_asset_count = count;
+    ESP_LOGI(TAG, "Asset manifest loaded: %u entries", (unsigned)count);
+
+    web_server_static_verify_manifest();
+}
+
+// Hash every listed file so a tag never outlives the content it names. A
+// lone .gz cannot be checked against the uncompressed hash and keeps its tag.
+static void web_server_static_verify_manifest(void)
+{
+    uint8_t *buffer = malloc(WEB_SERVER_FILE_BUFSZ);
+    if (buffer == NULL) {
+        return;
+    }
+
+    size_t stale = 0;
+    for (size_t i = 0; i < s_asset_count; ++i) {
+        web_server_asset_meta_t *asset = &s_assets[i];
+        char fs_path[WEB_SERVER_MAX_PATH];
+        int written = snprintf(fs_path, sizeof(fs_path), "%s%s", WEB_SERVER_WEB_ROOT, asset->file);
+        if (written <= 0 || (size_t)written >= sizeof(fs_path)) {
+            continue;
+        }
+
+        char hash[WEB_SERVER_ETAG_HASH_LEN + 1U];
+        struct stat st = {0};
+        if (stat(fs_path, &st) != 0 || !web_server_static_hash_file(fs_path, buffer, WEB_SERVER_FILE_BUFSZ, hash)) {
+            continue;
+        }
+        if (web_server_static_reconcile_hash(asset->hash, &asset->has_gzip, hash)) {
+            ++stale;
+            ESP_LOGW(TAG, "%s changed since etags.txt was built, retagged", asset->path);
+        }
+    }
+    free(buffer);
+
+    if (stale > 0U) {
+        ESP_LOGI(TAG, "%u manifest entries retagged from SPIFFS content", (unsigned)stale);
+    }
+}
+
+// ETag the way build_web_assets.py computes it: first 64 bits of the SHA-256
+// of the content, in hex
+static void web_server_static_format_hash(const unsigned char *digest, char *out_hex)
+{
+    for (size_t i = 0; i < WEB_SERVER_ETAG_HASH_LEN / 2U; ++i) {
+        snprintf(out_hex + 2U * i, 3, "%02x", digest[i]);
+    }
+}
+
+bool web_server_static_hash_content(const void *data, size_t length, char *out_hex)
+{
+    if ((data == NULL && length > 0U) || out_hex == NULL) {
+        return false;
+    }
+
+    unsigned char digest[32];
+    if (mbedtls_sha256_ret((const unsigned char *)data, length, digest, 0) != 0) {
+        return false;
+    }
+    web_server_static_format_hash(digest, out_hex);
+    return true;
+}
+
+static bool web_server_static_hash_file(const char *fs_path, uint8_t *buffer, size_t buffer_size, char *out_hex)
+{
+    FILE *file = fopen(fs_path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    bool ok = mbedtls_sha256_starts_ret(&ctx, 0) == 0;
+    size_t read_bytes = 0;
+    while (ok && (read_bytes = fread(buffer, 1, buffer_size, file)) > 0) {
+        ok = mbedtls_sha256_update_ret(&ctx, buffer, read_bytes) == 0;
+    }
+    ok = ok && !ferror(file);
+    fclose(file);
+
+    unsigned char digest[32];
+    ok = ok && mbedtls_sha256_finish_ret(&ctx, digest) == 0;
+    mbedtls_sha256_free(&ctx);
+    if (!ok) {
+        return false;
+    }
+
+    web_server_static_format_hash(digest, out_hex);
+    return true;
+}
+
+bool web_server_static_reconcile_hash(char *manifest_hash, bool *has_gzip, const char *file_hash)
+{
+    if (manifest_hash == NULL || file_hash == NULL || strlen(file_hash) != WEB_SERVER_ETAG_HASH_LEN ||
+        strcmp(manifest_hash, file_hash) == 0) {
+        return false;
+    }
+
+    // Same length, so the manifest text is patched in place. The .gz variant
+    // was built from the old content and is no longer served.
+    memcpy(manifest_hash, file_hash, WEB_SERVER_ETAG_HASH_LEN);
+    if (has_gzip != NULL) {
+        *has_gzip = false;
+    }
+    return true;
+}
+
+bool web_server_static_format_etag(const char *hash, bool gzip, char *buffer, size_t buffer_size)
+{
+    if (hash == NULL || buffer == NULL || buffer_size == 0U) {
+        return false;
+    }
+    int written = snprintf(buffer, buffer_size, "\"%s%s\"", hash, gzip ? "-gz" : "");
+    return written > 0 && (size_t)written < buffer_size;
+}
+
+static const web_server_asset_meta_t *web_server_find_asset(const char *uri_path)
+{
+    if (s_asset_count == 0) {
+        return NULL;
+    }
+    web_server_asset_meta_t key = {.path = uri_path};
+    return bsearch(&key, s_assets, s_asset_count, sizeof(*s_assets), web_server_asset_compare);
+}
+
+#if CONFIG_TINYBMS_WEB_EMBED_ASSETS
+
+static int web_server_embedded_compare(const void *key, const void *element)
+{
+    return strcmp((const char *)key, ((const web_server_embedded_asset_t *)element)->path);
+}
+
+static const web_server_embedded_asset_t *web_server_find_embedded(const char *uri_path, size_t *out_index)
+{
+    const web_server_embedded_asset_t *asset = bsearch(uri_path,
+                                                       g_web_server_embedded_assets,
+                                                       g_web_server_embedded_asset_count,
+                                                       sizeof(g_web_server_embedded_assets[0]),
+                                                       web_server_embedded_compare);
+    if (asset != NULL && out_index != NULL) {
+        *out_index = (size_t)(asset - g_web_server_embedded_assets);
+    }
+    return asset;
+}
+
+// A SPIFFS file under an embedded path overrides it unless its content
+// hashes to the embedded ETag. Listed files were already hashed by
+// web_server_static_verify_manifest(), so their entry holds the tag of their
+// actual content and is what the SPIFFS path sends. A lone .gz cannot be
+// checked against the uncompressed hash and always overrides.
+static void web_server_static_scan_overrides(void)
+{
+    free(s_embedded_overridden);
+    s_embedded_overridden = calloc(g_web_server_embedded_asset_count, sizeof(bool));
+    if (s_embedded_overridden == NULL) {
+        return;
+    }
+
+    uint8_t *buffer = malloc(WEB_SERVER_FILE_BUFSZ);
+    if (buffer == NULL) {
+        return;
+    }
+
+    size_t overrides = 0;
+    for (size_t index = 0; index < g_web_server_embedded_asset_count; ++index) {
+        const web_server_embedded_asset_t *embedded = &g_web_server_embedded_assets[index];
+        const web_server_asset_meta_t *meta = web_server_find_asset(embedded->path);
+        char fs_path[WEB_SERVER_MAX_PATH];
+        int written = snprintf(fs_path,
+                               sizeof(fs_path),
+                               "%s%s",
+                               WEB_SERVER_WEB_ROOT,
+                               (meta != NULL) ? meta->file : embedded->path);
+        if (written <= 0 || (size_t)written + 3U >= sizeof(fs_path)) {
+            continue;
+        }
+
+        struct stat st = {0};
+        bool overridden = false;
+        if (stat(fs_path, &st) == 0) {
+            char hash[WEB_SERVER_ETAG_HASH_LEN + 1U];
+            if (meta != NULL) {
+                overridden = strcmp(meta->hash, embedded->etag) != 0;
+            } else {
+                overridden = !web_server_static_hash_file(fs_path, buffer, WEB_SERVER_FILE_BUFSZ, hash) ||
+                             strcmp(hash, embedded->etag) != 0;
+            }
+        } else {
+            strcat(fs_path, ".gz");
+            overridden = stat(fs_path, &st) == 0;
+        }
+
+        if (overridden) {
+            s_embedded_overridden[index] = true;
+            ++overrides;
+            ESP_LOGI(TAG, "SPIFFS overrides embedded %s", embedded->path);
+        }
+    }
+    free(buffer);
+
+    ESP_LOGI(TAG,
+             "%u embedded assets, %u overridden from SPIFFS",
+             (unsigned)g_web_server_embedded_asset_count,
+             (unsigned)overrides);
+}
+
+#endif  // CONFIG_TINYBMS_WEB_EMBED_ASSETS
+
+// ============================================================================
+// Conditional request helpers
+// ============================================================================
+
+bool web_server_static_etag_matches(const char *if_none_match, const char *etag)
+{
+    if (if_none_match == NULL || etag == NULL) {
+        return false;
+    }
+
+    size_t etag_len = strlen(etag);
+    const char *cursor = if_none_match;
+    while (*cursor != '\0') {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == ',') {
+            ++cursor;
+        }
+        if (*cursor == '\0') {
+            break;
+        }
+        if (*cursor == '*') {
+            return true;
+        }
+        // If-None-Match uses the weak comparison: W/"x" matches "x"
+        if (strncmp(cursor, "W/", 2) == 0) {
+            cursor += 2;
+        }
+        const char *end = cursor;
+        if (*end == '"') {
+            end = strchr(end + 1, '"');
+            end = (end != NULL) ? end + 1 : cursor + strlen(cursor);
+        } else {
+            while (*end != '\0' && *end != ',' && *end != ' ') {
+                ++end;
+            }
+        }
+        if ((size_t)(end - cursor) == etag_len && strncmp(cursor, etag, etag_len) == 0) {
+            return true;
+        }
+        cursor = end;
+    }
+    return false;
+}
+
+bool web_server_static_accepts_gzip(const char *accept_encoding)
+{
+    if (accept_encoding == NULL) {
+        return false;
+    }
+
+    const char *cursor = accept_encoding;
+    while (*cursor != '\0') {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == ',') {
+            ++cursor;
+        }
+        const char *name = cursor;
+        while (*cursor != '\0' && *cursor != ',' && *cursor != ';' && *cursor != ' ') {
+            ++cursor;
+        }
+        size_t name_len = (size_t)(cursor - name);
+
+        // Optional weight; q=0 (any number of zero decimals) refuses the coding
+        bool refused = false;
+        const char *params_end = strchr(cursor, ',');
+        if (params_end == NULL) {
+            params_end = cursor + strlen(cursor);
+        }
+        const char *q = strstr(cursor, "q=");
+        if (q != NULL && q < params_end) {
+            q += 2;
+            refused = (*q == '0');
+            for (const char *d = q + 1; refused && d < params_end && *d != ' ' && *d != ';'; ++d) {
+                if (*d != '.' && *d != '0') {
+                    refused = false;
+                }
+            }
+        }
+
+        bool gzip = (name_len == 4 && strncasecmp(name, "gzip", 4) == 0) ||
+                    (name_len == 1 && name[0] == '*');
+        if (gzip && !refused) {
+            return true;
+        }
+        cursor = params_end;
+    }
+    return false;
+}
+
+static bool web_server_get_header(httpd_req_t *req, const char *name, char *buffer, size_t size)
+{
+    size_t length = httpd_req_get_hdr_value_len(req, name);
+    if (length == 0 || length >= size) {
+        return false;
+    }
+    return httpd_req_get_hdr_value_str(req, name, buffer, size) == ESP_OK;
+}
+
+static bool web_server_client_accepts_gzip(httpd_req_t *req)
+{
+    char header[WEB_SERVER_COND_HDR_MAX];
+    return web_server_get_header(req, "Accept-Encoding", header, sizeof(header)) &&
+           web_server_static_accepts_gzip(header);
+}
+
+// Sets the validators of the representation about to be sent and answers
+// 304 when the client already holds it. @p etag must outlive the response.
+static bool web_server_send_not_modified(httpd_req_t *req, const char *etag, bool vary, esp_err_t *out_err)
+{
+    if (vary) {
+        httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    }
+    httpd_resp_set_hdr(req, "ETag", etag);
+
+    char header[WEB_SERVER_COND_HDR_MAX];
+    if (!web_server_get_header(req, "If-None-Match", header, sizeof(header)) ||
+        !web_server_static_etag_matches(header, etag)) {
+        return false;
+    }
+
+    web_server_set_security_headers(req);
+    httpd_resp_set_hdr(req, "Cache-Control", "max-age=60, public");
+    httpd_resp_set_status(req, "304 Not Modified");
+    *out_err = httpd_resp_send(req, NULL, 0);
+    return true;
+}
+
 // ============================================================================
 // Content-type detection
 // ============================================================================
@@ -182,7 +668,9 @@ static bool web_server_uri_is_secure(const char *uri)
 // File serving
 // ============================================================================
 
-static esp_err_t web_server_send_file(httpd_req_t *req, const char *path)
+// @p path is the file to stream; the content type comes from @p type_path so a
+// .gz variant is labelled with the type of the original asset.
+static esp_err_t web_server_send_file(httpd_req_t *req, const char *path, const char *type_path)
 {
     int fd = open(path, O_RDONLY);
     if (fd < 0) {
@@ -192,7 +680,7 @@ static esp_err_t web_server_send_file(httpd_req_t *req, const char *path)
     }
 
     web_server_set_security_headers(req);
-    httpd_resp_set_type(req, web_server_content_type(path));
+    httpd_resp_set_type(req, web_server_content_type(type_path));
     httpd_resp_set_hdr(req, "Cache-Control", "max-age=60, public");
 
     char buffer[WEB_SERVER_FILE_BUFSZ];
@@ -221,6 +709,41 @@ static esp_err_t web_server_send_file(httpd_req_t *req, const char *path)
     return ESP_OK;
 }
 
+#if CONFIG_TINYBMS_WEB_EMBED_ASSETS
+
+static esp_err_t web_server_send_embedded(httpd_req_t *req,
+                                          const web_server_embedded_asset_t *asset,
+                                          const char *path)
+{
+    char etag[WEB_SERVER_ETAG_MAX];
+    web_server_static_format_etag(asset->etag, asset->gzip, etag, sizeof(etag));
+
+    httpd_resp_set_hdr(req, WEB_SERVER_SOURCE_HEADER, "flash");
+    esp_err_t err = ESP_OK;
+    if (web_server_send_not_modified(req, etag, asset->gzip, &err)) {
+        return err;
+    }
+
+    web_server_set_security_headers(req);
+    httpd_resp_set_type(req, web_server_content_type(path));
+    httpd_resp_set_hdr(req, "Cache-Control", "max-age=60, public");
+    if (asset->gzip) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+
+    // Straight from the flash mapping: no file handle and no copy buffer
+    return httpd_resp_send(req, (const char *)asset->data, (ssize_t)asset->size);
+}
+
+static bool web_server_wants_spiffs(httpd_req_t *req)
+{
+    char source[16];
+    return web_server_get_header(req, WEB_SERVER_SOURCE_HEADER, source, sizeof(source)) &&
+           strcasecmp(source, "spiffs") == 0;
+}
+
+#endif  // CONFIG_TINYBMS_WEB_EMBED_ASSETS
+
 // ============================================================================
 // Request handler
 // ============================================================================
@@ -235,22 +758,78 @@ esp_err_t web_server_static_get_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
-    if (strcmp(uri, "/") == 0) {
+    // A query string (cache busting) does not select a different file
+    size_t uri_len = strcspn(uri, "?#");
+    if (uri_len == 1U && uri[0] == '/') {
         uri = WEB_SERVER_INDEX_PATH + strlen(WEB_SERVER_WEB_ROOT);
+        uri_len = strlen(uri);
     }
 
-    int written = snprintf(filepath, sizeof(filepath), "%s%s", WEB_SERVER_WEB_ROOT, uri);
+    int written = snprintf(filepath, sizeof(filepath), "%s%.*s", WEB_SERVER_WEB_ROOT, (int)uri_len, uri);
     if (written <= 0 || written >= (int)sizeof(filepath)) {
         httpd_resp_send_err(req, HTTPD_414_URI_TOO_LONG, "Path too long");
         return ESP_FAIL;
     }
+    const char *path = filepath + strlen(WEB_SERVER_WEB_ROOT);
+
+#if CONFIG_TINYBMS_WEB_EMBED_ASSETS
+    size_t embedded_index = 0;
+    const web_server_embedded_asset_t *embedded = web_server_find_embedded(path, &embedded_index);
+    if (embedded != NULL &&
+        (s_embedded_overridden == NULL || !s_embedded_overridden[embedded_index]) &&
+        (!embedded->gzip || web_server_client_accepts_gzip(req)) &&
+        !web_server_wants_spiffs(req)) {
+        return web_server_send_embedded(req, embedded, path);
+    }
+    // Otherwise SPIFFS: override, identity copy for a client refusing gzip, or benchmark
+#endif
 
-    struct stat st = {0};
-    if (stat(filepath, &st) != 0) {
-        ESP_LOGW(TAG, "Static asset not found: %s", filepath);
-        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
-        return ESP_FAIL;
+    httpd_resp_set_hdr(req, WEB_SERVER_SOURCE_HEADER, "spiffs");
+
+    const web_server_asset_meta_t *asset = web_server_find_asset(path);
+    if (asset == NULL) {
+        struct stat st = {0};
+        if (stat(filepath, &st) != 0) {
+            ESP_LOGW(TAG, "Static asset not found: %s", filepath);
+            httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not found");
+            return ESP_FAIL;
+        }
+        return web_server_send_file(req, filepath, filepath);
+    }
+
+    // Flattened files are opened by their stored name, typed by the URI
+    char type_path[WEB_SERVER_MAX_PATH];
+    memcpy(type_path, filepath, (size_t)written + 1U);
+    if (asset->file != asset->path) {
+        written = snprintf(filepath, sizeof(filepath), "%s%s", WEB_SERVER_WEB_ROOT, asset->file);
+        if (written <= 0 || written >= (int)sizeof(filepath)) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Invalid manifest");
+            return ESP_FAIL;
+        }
+    }
+
+    bool gzip = asset->has_gzip && web_server_client_accepts_gzip(req);
+
+    // Strong tag per representation: the gzip variant gets its own. The hash
+    // is the one of the stored file (see web_server_static_verify_manifest())
+    char etag[WEB_SERVER_ETAG_MAX];
+    web_server_static_format_etag(asset->hash, gzip, etag, sizeof(etag));
+
+    esp_err_t err = ESP_OK;
+    if (web_server_send_not_modified(req, etag, asset->has_gzip, &err)) {
+        return err;
+    }
+
+    if (gzip) {
+        char gzpath[WEB_SERVER_MAX_PATH];
+        written = snprintf(gzpath, sizeof(gzpath), "%s.gz", filepath);
+        if (written > 0 && written < (int)sizeof(gzpath)) {
+            httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+            return web_server_send_file(req, gzpath, type_path);
+        }
+        // Path too long for the variant: fall back to the identity file
+        web_server_static_format_etag(asset->hash, false, etag, sizeof(etag));
     }
 
-    return web_server_send_file(req, filepath);
+    return web_server_send_file(req, filepath, type_path);
 }
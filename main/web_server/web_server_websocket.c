@@ -4,7 +4,13 @@
  *
  * This file contains functionality for:
  * - WebSocket client management (add, remove, broadcast)
- * - Telemetry streaming (/ws/telemetry)
+ * - Bounded per-client send queues drained from the httpd task, with
+ *   eviction of clients lagging beyond CONFIG_TINYBMS_WEB_WS_LAG_BUDGET_MS
+ * - Telemetry streaming (/ws/telemetry), JSON or the packed binary
+ *   subprotocol of telemetry_binary.h, optionally as delta frames
+ *   (/ws/telemetry?mode=delta) between periodic keyframes, decimated per
+ *   client (?rate=1 or a {"rate_hz":1} control message) with optional
+ *   min/max/avg of the skipped samples
  * - Event streaming (/ws/events)
  * - UART data streaming (/ws/uart)
  * - CAN data streaming (/ws/can)
@@ -13,28 +19,53 @@
 #include "web_server.h"
 #include "web_server_internal.h"
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
+#include "cJSON.h"
 #include "monitoring.h"
+#include "telemetry_binary.h"
+#include "ws_client_queue.h"
+#include "ws_rate_limiter.h"
 
 static const char *TAG = "web_server_ws";
 
+#define MAX_BROADCAST_CLIENTS 32
+
 // ============================================================================
 // WebSocket client structure
 // ============================================================================
 
 typedef struct ws_client {
     int fd;
+    bool send_scheduled;        // A drain work item is queued on the httpd task
+    bool binary;                // Negotiated TELEMETRY_BINARY_SUBPROTOCOL
+    bool delta;                 // Binary client that asked for delta frames
+    ws_client_queue_t queue;
+    uint32_t bytes_sent;
+    uint8_t *delta_state;       // Snapshot frame image the delta client holds
+    size_t delta_state_length;  // 0 forces a keyframe on the next push
+    int64_t keyframe_us;
+    uint32_t keyframes;
+    uint32_t delta_dropped;     // queue.dropped when the client was last in sync
+    ws_rate_limiter_t rate;     // Telemetry decimation, full rate by default
     struct ws_client *next;
 } ws_client_t;
 
+typedef struct {
+    ws_client_t **list;
+    int fd;
+} ws_send_work_t;
+
 // ============================================================================
 // Global state (WebSocket clients)
 // ============================================================================
@@ -46,9 +77,37 @@ static ws_client_t *s_uart_clients = NULL;
 static ws_client_t *s_can_clients = NULL;
 static ws_client_t *s_alert_clients = NULL;
 
+static uint32_t s_ws_evictions = 0;
+
+typedef struct {
+    ws_client_t **list;
+    const char *name;
+    ws_client_queue_policy_t policy;
+} ws_channel_t;
+
+// Telemetry streams only care about the latest samples; events must not be
+// silently lost, so a client that cannot keep up with them is disconnected.
+static const ws_channel_t s_ws_channels[] = {
+    {&s_telemetry_clients, "telemetry", WS_CLIENT_QUEUE_DROP_OLDEST},
+    {&s_uart_clients, "uart", WS_CLIENT_QUEUE_DROP_OLDEST},
+    {&s_can_clients, "can", WS_CLIENT_QUEUE_DROP_OLDEST},
+    {&s_event_clients, "events", WS_CLIENT_QUEUE_REJECT},
+    {&s_alert_clients, "alerts", WS_CLIENT_QUEUE_REJECT},
+};
+
 // External reference to httpd handle from core
 extern httpd_handle_t g_server;
 
+static const ws_channel_t *ws_channel_for_list(ws_client_t **list)
+{
+    for (size_t i = 0; i < sizeof(s_ws_channels) / sizeof(s_ws_channels[0]); ++i) {
+        if (s_ws_channels[i].list == list) {
+            return &s_ws_channels[i];
+        }
+    }
+    return NULL;
+}
+
 // ============================================================================
 // Client list management
 // ============================================================================
@@ -66,6 +125,8 @@ static void ws_client_list_free(ws_client_t **list)
     ws_client_t *current = *list;
     while (current != NULL) {
         ws_client_t *next = current->next;
+        ws_client_queue_clear(&current->queue);
+        free(current->delta_state);
         free(current);
         current = next;
     }
@@ -96,23 +157,31 @@ static void ws_client_list_add(ws_client_t **list, int fd)
         return;
     }
 
+    const ws_channel_t *channel = ws_channel_for_list(list);
     client->fd = fd;
+    ws_client_queue_init(&client->queue,
+                         CONFIG_TINYBMS_WEB_WS_QUEUE_DEPTH,
+                         (channel != NULL) ? channel->policy : WS_CLIENT_QUEUE_DROP_OLDEST);
     client->next = *list;
     *list = client;
 
     xSemaphoreGive(g_server_mutex);
 }
 
-static void ws_client_list_remove(ws_client_t **list, int fd)
+// Caller holds g_server_mutex
+static ws_client_t *ws_client_list_find_locked(ws_client_t **list, int fd)
 {
-    if (list == NULL || g_server_mutex == NULL) {
-        return;
-    }
-
-    if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
-        return;
+    for (ws_client_t *iter = *list; iter != NULL; iter = iter->next) {
+        if (iter->fd == fd) {
+            return iter;
+        }
     }
+    return NULL;
+}
 
+// Caller holds g_server_mutex
+static void ws_client_list_unlink_locked(ws_client_t **list, int fd)
+{
     ws_client_t *prev = NULL;
     ws_client_t *iter = *list;
     while (iter != NULL) {
@@ -122,103 +191,733 @@ static void ws_client_list_remove(ws_client_t **list, int fd)
             } else {
                 prev->next = iter->next;
             }
+            ws_client_queue_clear(&iter->queue);
+            free(iter->delta_state);
             free(iter);
-            break;
+            return;
         }
         prev = iter;
         iter = iter->next;
     }
+}
+
+static void ws_client_list_remove(ws_client_t **list, int fd)
+{
+    if (list == NULL || g_server_mutex == NULL) {
+        return;
+    }
+
+    if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+
+    ws_client_list_unlink_locked(list, fd);
 
     xSemaphoreGive(g_server_mutex);
 }
 
-static void ws_client_list_broadcast(ws_client_t **list, const char *payload, size_t length)
+// Runs on the httpd task: drains one client's queue, one frame at a time, so
+// the mutex is never held across a socket write.
+static void ws_client_send_work(void *arg)
 {
-    if (list == NULL || payload == NULL || length == 0 || g_server_mutex == NULL || g_server == NULL) {
+    ws_send_work_t work = *(ws_send_work_t *)arg;
+    free(arg);
+
+    for (;;) {
+        if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(WEB_SERVER_MUTEX_TIMEOUT_MS)) != pdTRUE) {
+            // send_scheduled stays set; the lag budget evicts the client if this persists
+            ESP_LOGW(TAG, "WebSocket send: failed to acquire mutex for client %d", work.fd);
+            return;
+        }
+
+        ws_client_t *client = ws_client_list_find_locked(work.list, work.fd);
+        ws_message_t *message = (client != NULL) ? ws_client_queue_pop(&client->queue, esp_timer_get_time()) : NULL;
+        if (message == NULL) {
+            if (client != NULL) {
+                client->send_scheduled = false;
+            }
+            xSemaphoreGive(g_server_mutex);
+            return;
+        }
+        client->bytes_sent += (uint32_t)message->length;
+        xSemaphoreGive(g_server_mutex);
+
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .fragmented = false,
+            .type = message->binary ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)message->data,
+            .len = message->length,
+        };
+        esp_err_t err = httpd_ws_send_frame_async(g_server, work.fd, &frame);
+        ws_message_release(message);
+
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to send to websocket client %d: %s", work.fd, esp_err_to_name(err));
+            ws_client_list_remove(work.list, work.fd);
+            return;
+        }
+    }
+}
+
+// Caller holds g_server_mutex
+static void ws_client_evict_locked(ws_client_t **list, ws_client_t *client, const char *reason)
+{
+    const ws_channel_t *channel = ws_channel_for_list(list);
+    int fd = client->fd;
+    ESP_LOGW(TAG,
+             "Evicting %s WebSocket client %d: %s (lag %u ms, dropped %u)",
+             (channel != NULL) ? channel->name : "?",
+             fd,
+             reason,
+             (unsigned)ws_client_queue_lag_ms(&client->queue, esp_timer_get_time()),
+             (unsigned)client->queue.dropped);
+    ws_client_list_unlink_locked(list, fd);
+    s_ws_evictions++;
+    (void)httpd_sess_trigger_close(g_server, fd);
+}
+
+static void ws_client_list_set_format(ws_client_t **list, int fd, bool binary, bool delta)
+{
+    if (list == NULL || g_server_mutex == NULL) {
         return;
     }
 
-    size_t payload_length = length;
-    if (payload_length > 0 && payload[payload_length - 1] == '\0') {
-        payload_length -= 1;
+    if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+
+    ws_client_t *client = ws_client_list_find_locked(list, fd);
+    if (client != NULL) {
+        client->binary = binary;
+        client->delta = binary && delta;
+    }
+
+    xSemaphoreGive(g_server_mutex);
+}
+
+// Which encodings the next telemetry sample needs, so unused ones are skipped
+static void ws_client_list_telemetry_needs(ws_client_t **list, bool *out_packed, bool *out_metrics)
+{
+    *out_packed = false;
+    *out_metrics = false;
+    if (list == NULL || g_server_mutex == NULL ||
+        xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+
+    for (ws_client_t *iter = *list; iter != NULL; iter = iter->next) {
+        *out_packed = *out_packed || iter->binary;
+        *out_metrics = *out_metrics || iter->rate.aggregate;
+    }
+
+    xSemaphoreGive(g_server_mutex);
+}
+
+// Caller holds g_server_mutex. Queues @p message for @p client and records
+// its fd in @p wake_fds when a drain must be scheduled.
+// @return false when the client was evicted (and freed) instead
+static bool ws_client_enqueue_locked(ws_client_t **list,
+                                     ws_client_t *client,
+                                     ws_message_t *message,
+                                     int64_t now_us,
+                                     int *wake_fds,
+                                     size_t *wake_count)
+{
+    if (!ws_client_queue_push(&client->queue, message)) {
+        ws_client_evict_locked(list, client, "send queue full");
+        return false;
+    }
+    if (ws_client_queue_lag_ms(&client->queue, now_us) > CONFIG_TINYBMS_WEB_WS_LAG_BUDGET_MS) {
+        ws_client_evict_locked(list, client, "lag budget exceeded");
+        return false;
+    }
+    if (!client->send_scheduled && *wake_count < MAX_BROADCAST_CLIENTS) {
+        client->send_scheduled = true;
+        wake_fds[(*wake_count)++] = client->fd;
+    }
+    return true;
+}
+
+static void ws_client_schedule_sends(ws_client_t **list, const int *wake_fds, size_t wake_count)
+{
+    // At most one drain item per client is ever waiting in the httpd work queue
+    for (size_t i = 0; i < wake_count; i++) {
+        ws_send_work_t *work = malloc(sizeof(*work));
+        if (work != NULL) {
+            work->list = list;
+            work->fd = wake_fds[i];
+            if (httpd_queue_work(g_server, ws_client_send_work, work) == ESP_OK) {
+                continue;
+            }
+            free(work);
+        }
+
+        ESP_LOGW(TAG, "Failed to schedule send for websocket client %d", wake_fds[i]);
+        if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            ws_client_t *client = ws_client_list_find_locked(list, wake_fds[i]);
+            if (client != NULL) {
+                client->send_scheduled = false;
+            }
+            xSemaphoreGive(g_server_mutex);
+        }
+    }
+}
+
+// Queues @p payload for the clients of @p list using the given encoding
+static void ws_client_list_broadcast_frame(ws_client_t **list, const void *payload, size_t payload_length, bool binary)
+{
+    if (list == NULL || payload == NULL || payload_length == 0 || g_server_mutex == NULL || g_server == NULL) {
+        return;
     }
 
-    if (payload_length == 0) {
+    int64_t now_us = esp_timer_get_time();
+    ws_message_t *message = ws_message_create(payload, payload_length, now_us);
+    if (message == NULL) {
+        ESP_LOGW(TAG, "WebSocket broadcast: no memory for %zu byte message", payload_length);
         return;
     }
+    message->binary = binary;
 
-    #define MAX_BROADCAST_CLIENTS 32
-    int client_fds[MAX_BROADCAST_CLIENTS];
-    size_t client_count = 0;
-    size_t total_clients = 0;
+    int wake_fds[MAX_BROADCAST_CLIENTS];
+    size_t wake_count = 0;
 
     if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
         ESP_LOGW(TAG, "WebSocket broadcast: failed to acquire mutex (timeout), event dropped");
+        ws_message_release(message);
         return;
     }
 
-    for (ws_client_t *iter = *list; iter != NULL; iter = iter->next) {
-        total_clients++;
-        if (client_count < MAX_BROADCAST_CLIENTS) {
-            client_fds[client_count++] = iter->fd;
+    ws_client_t *iter = *list;
+    while (iter != NULL) {
+        ws_client_t *client = iter;
+        iter = iter->next;
+
+        if (client->binary != binary) {
+            continue;
         }
+        (void)ws_client_enqueue_locked(list, client, message, now_us, wake_fds, &wake_count);
     }
 
     xSemaphoreGive(g_server_mutex);
+    ws_message_release(message);
+
+    ws_client_schedule_sends(list, wake_fds, wake_count);
+}
 
-    if (total_clients > MAX_BROADCAST_CLIENTS) {
-        ESP_LOGW(TAG, "WebSocket client limit reached: %zu total clients, only %d will receive broadcasts",
-                 total_clients, MAX_BROADCAST_CLIENTS);
+// Caller holds g_server_mutex. Makes @p frame the state the client holds.
+static bool ws_client_delta_store_locked(ws_client_t *client, const uint8_t *frame, size_t length)
+{
+    if (client->delta_state == NULL || client->delta_state_length != length) {
+        uint8_t *state = realloc(client->delta_state, length);
+        if (state == NULL) {
+            client->delta_state_length = 0;
+            return false;
+        }
+        client->delta_state = state;
     }
+    memcpy(client->delta_state, frame, length);
+    client->delta_state_length = length;
+    return true;
+}
 
-    httpd_ws_frame_t frame = {
-        .final = true,
-        .fragmented = false,
-        .type = HTTPD_WS_TYPE_TEXT,
-        .payload = (uint8_t *)payload,
-        .len = payload_length,
-    };
+typedef struct {
+    monitoring_snapshot_t *snapshot;  // Event buffer behind json
+    const char *json;           // {"battery":...}
+    size_t json_length;
+    const uint8_t *packed;      // NULL when no client uses the binary subprotocol
+    size_t packed_length;
+    const float *metrics;       // NULL when no client aggregates
+} ws_telemetry_sample_t;
+
+// Telemetry broadcasts only run on the ws_event task, whose stack is too
+// small for these buffers.
+static struct {
+    uint8_t packed[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    uint8_t delta[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    char window[WS_RATE_LIMITER_WINDOW_MAX_SIZE];
+} s_telemetry_scratch;
+
+// Messages shared by every client receiving the same bytes, created on first use
+static ws_message_t *ws_message_shared(ws_message_t **slot, const void *payload, size_t length, bool binary, int64_t now_us)
+{
+    if (*slot == NULL) {
+        *slot = ws_message_create(payload, length, now_us);
+        if (*slot != NULL) {
+            (*slot)->binary = binary;
+        }
+    }
+    return *slot;
+}
 
-    for (size_t i = 0; i < client_count; i++) {
-        esp_err_t err = httpd_ws_send_frame_async(g_server, client_fds[i], &frame);
-        if (err != ESP_OK) {
-            ESP_LOGW(TAG, "Failed to send to websocket client %d: %s", client_fds[i], esp_err_to_name(err));
-            ws_client_list_remove(list, client_fds[i]);
+// The {"battery":...} text is sent from the monitoring buffer it was
+// rendered in, which the message keeps alive
+static ws_message_t *ws_telemetry_json_shared(ws_message_t **slot, const ws_telemetry_sample_t *sample, int64_t now_us)
+{
+    if (*slot == NULL && monitoring_snapshot_retain(sample->snapshot)) {
+        *slot = ws_message_wrap(sample->json,
+                                sample->json_length,
+                                monitoring_snapshot_release,
+                                sample->snapshot,
+                                now_us);
+        if (*slot == NULL) {
+            monitoring_snapshot_release(sample->snapshot);
         }
     }
+    return *slot;
 }
 
-static void web_server_broadcast_battery_snapshot(ws_client_t **list, const char *payload, size_t length)
+// {"battery":...,"window":{...}} for a JSON client that aggregates
+static ws_message_t *ws_telemetry_json_with_window(const ws_telemetry_sample_t *sample,
+                                                   const char *window,
+                                                   size_t window_length,
+                                                   int64_t now_us)
 {
-    if (list == NULL || payload == NULL || length == 0) {
+    static const char k_window_key[] = ",\"window\":";
+    size_t prefix_length = sample->json_length - 1U;  // Without the closing brace
+    ws_message_t *message = ws_message_alloc(prefix_length + sizeof(k_window_key) - 1U + window_length + 1U, now_us);
+    if (message == NULL) {
+        return NULL;
+    }
+
+    uint8_t *out = message->payload;
+    memcpy(out, sample->json, prefix_length);
+    out += prefix_length;
+    memcpy(out, k_window_key, sizeof(k_window_key) - 1U);
+    out += sizeof(k_window_key) - 1U;
+    memcpy(out, window, window_length);
+    out[window_length] = '}';
+    return message;
+}
+
+// Caller holds g_server_mutex. Picks the keyframe or delta frame for a delta
+// client; returns a new reference, or NULL when nothing is to be sent.
+static ws_message_t *ws_client_delta_message_locked(ws_client_t *client,
+                                                    const ws_telemetry_sample_t *sample,
+                                                    ws_message_t **keyframe,
+                                                    int64_t now_us,
+                                                    bool *out_is_keyframe)
+{
+    int64_t keyframe_interval_us = (int64_t)CONFIG_TINYBMS_WEB_WS_KEYFRAME_INTERVAL_MS * 1000;
+
+    // A frame dropped from the queue leaves the client out of sync
+    bool resync = client->delta_state_length == 0 ||
+                  client->queue.dropped != client->delta_dropped ||
+                  now_us - client->keyframe_us >= keyframe_interval_us;
+    if (!resync) {
+        size_t delta_length = 0;
+        telemetry_binary_delta_t result = telemetry_binary_write_delta(client->delta_state,
+                                                                       client->delta_state_length,
+                                                                       sample->packed,
+                                                                       sample->packed_length,
+                                                                       s_telemetry_scratch.delta,
+                                                                       sizeof(s_telemetry_scratch.delta),
+                                                                       &delta_length);
+        if (result == TELEMETRY_BINARY_DELTA_UNCHANGED) {
+            return NULL;
+        }
+        if (result == TELEMETRY_BINARY_DELTA_WRITTEN) {
+            ws_message_t *message = ws_message_create(s_telemetry_scratch.delta, delta_length, now_us);
+            if (message == NULL) {
+                client->delta_state_length = 0;
+                return NULL;
+            }
+            message->binary = true;
+            *out_is_keyframe = false;
+            return message;
+        }
+    }
+
+    ws_message_t *message = ws_message_shared(keyframe, sample->packed, sample->packed_length, true, now_us);
+    if (message == NULL || !ws_client_delta_store_locked(client, sample->packed, sample->packed_length)) {
+        return NULL;
+    }
+    ws_message_retain(message);
+    client->keyframe_us = now_us;
+    client->keyframes++;
+    *out_is_keyframe = true;
+    return message;
+}
+
+// One pass over the telemetry clients: each gets the sample in its own
+// format when its rate is due. Delta clients get a frame relative to what
+// they last received, so their bandwidth follows the change rate; the JSON
+// text and the binary snapshot (also the delta keyframe) are shared.
+static void ws_client_list_broadcast_telemetry(ws_client_t **list, const ws_telemetry_sample_t *sample)
+{
+    if (list == NULL || sample == NULL || g_server_mutex == NULL || g_server == NULL) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    ws_message_t *json = NULL;
+    ws_message_t *packed = NULL;
+    int wake_fds[MAX_BROADCAST_CLIENTS];
+    size_t wake_count = 0;
+
+    if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        ESP_LOGW(TAG, "WebSocket telemetry broadcast: failed to acquire mutex (timeout), sample dropped");
+        return;
+    }
+
+    ws_client_t *iter = *list;
+    while (iter != NULL) {
+        ws_client_t *client = iter;
+        iter = iter->next;
+
+        if (client->binary && sample->packed == NULL) {
+            continue;
+        }
+        if (!ws_rate_limiter_offer(&client->rate, now_us, sample->metrics)) {
+            continue;
+        }
+
+        size_t window_length = 0;
+        bool has_window = ws_rate_limiter_write_window(&client->rate,
+                                                       now_us,
+                                                       s_telemetry_scratch.window,
+                                                       sizeof(s_telemetry_scratch.window),
+                                                       &window_length);
+
+        if (!client->binary) {
+            ws_message_t *message = NULL;
+            if (has_window) {
+                message = ws_telemetry_json_with_window(sample, s_telemetry_scratch.window, window_length, now_us);
+            } else if (ws_telemetry_json_shared(&json, sample, now_us) != NULL) {
+                message = json;
+                ws_message_retain(message);
+            }
+            if (message != NULL) {
+                (void)ws_client_enqueue_locked(list, client, message, now_us, wake_fds, &wake_count);
+                ws_message_release(message);
+            }
+            continue;
+        }
+
+        // Binary clients get the window as a text frame ahead of the snapshot
+        uint32_t dropped_before = client->queue.dropped;
+        if (has_window) {
+            static const char prefix[] = "{\"type\":\"window\",\"window\":";
+            ws_message_t *window = ws_message_alloc(sizeof(prefix) - 1U + window_length + 1U, now_us);
+            if (window != NULL) {
+                memcpy(window->payload, prefix, sizeof(prefix) - 1U);
+                memcpy(window->payload + sizeof(prefix) - 1U, s_telemetry_scratch.window, window_length);
+                window->payload[window->length - 1U] = '}';
+                bool queued = ws_client_enqueue_locked(list, client, window, now_us, wake_fds, &wake_count);
+                ws_message_release(window);
+                if (!queued) {
+                    continue;
+                }
+            }
+        }
+
+        bool is_keyframe = true;
+        ws_message_t *message = NULL;
+        if (client->delta) {
+            message = ws_client_delta_message_locked(client, sample, &packed, now_us, &is_keyframe);
+        } else if (ws_message_shared(&packed, sample->packed, sample->packed_length, true, now_us) != NULL) {
+            message = packed;
+            ws_message_retain(message);
+        }
+        if (message == NULL) {
+            continue;
+        }
+
+        bool queued = ws_client_enqueue_locked(list, client, message, now_us, wake_fds, &wake_count);
+        ws_message_release(message);
+        // A delta that pushed an older frame out is not enough to stay in sync
+        if (queued && client->delta && (is_keyframe || client->queue.dropped == dropped_before)) {
+            client->delta_dropped = client->queue.dropped;
+        }
+    }
+
+    xSemaphoreGive(g_server_mutex);
+    ws_message_release(json);
+    ws_message_release(packed);
+
+    ws_client_schedule_sends(list, wake_fds, wake_count);
+}
+
+static void ws_client_list_broadcast(ws_client_t **list, const char *payload, size_t length)
+{
+    if (payload == NULL || length == 0) {
         return;
     }
 
     size_t payload_length = length;
-    if (payload_length > 0U && payload[payload_length - 1U] == '\0') {
-        payload_length -= 1U;
+    if (payload_length > 0 && payload[payload_length - 1] == '\0') {
+        payload_length -= 1;
+    }
+
+    ws_client_list_broadcast_frame(list, payload, payload_length, false);
+}
+
+size_t web_server_websocket_get_client_stats(web_server_ws_client_stats_t *out,
+                                             size_t capacity,
+                                             uint32_t *out_evictions)
+{
+    size_t count = 0;
+    if (g_server_mutex == NULL ||
+        xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(WEB_SERVER_MUTEX_TIMEOUT_MS)) != pdTRUE) {
+        return 0;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    for (size_t c = 0; c < sizeof(s_ws_channels) / sizeof(s_ws_channels[0]); ++c) {
+        for (ws_client_t *iter = *s_ws_channels[c].list; iter != NULL; iter = iter->next) {
+            if (out != NULL && count < capacity) {
+                web_server_ws_client_stats_t *stats = &out[count];
+                stats->fd = iter->fd;
+                stats->channel = s_ws_channels[c].name;
+                stats->format = iter->delta ? "delta" : (iter->binary ? "binary" : "json");
+                stats->bytes_sent = iter->bytes_sent;
+                stats->keyframes = iter->keyframes;
+                stats->interval_ms = iter->rate.interval_ms;
+                stats->skipped = iter->rate.skipped;
+                stats->queued = iter->queue.count;
+                stats->sent = iter->queue.sent;
+                stats->dropped = iter->queue.dropped;
+                stats->lag_ms = ws_client_queue_lag_ms(&iter->queue, now_us);
+                stats->max_lag_ms = iter->queue.max_lag_ms;
+            }
+            count++;
+        }
+    }
+    if (out_evictions != NULL) {
+        *out_evictions = s_ws_evictions;
+    }
+
+    xSemaphoreGive(g_server_mutex);
+    return count;
+}
+
+static void web_server_broadcast_battery_snapshot(ws_client_t **list,
+                                                  const char *payload,
+                                                  size_t length,
+                                                  monitoring_snapshot_t *snapshot)
+{
+    if (list == NULL || payload == NULL || length == 0) {
+        return;
+    }
+
+    // Monitoring rendered the wrapped form around the payload, in the buffer
+    // the event handed over as its dispose context
+    ws_telemetry_sample_t sample = {
+        .snapshot = snapshot,
+    };
+    sample.json = monitoring_snapshot_wrapped(snapshot, &sample.json_length);
+    if (sample.json == NULL) {
+        ESP_LOGW(TAG, "Telemetry sample without its snapshot buffer, dropped");
+        return;
+    }
+
+    // The binary snapshot is encoded once for all its subscribers, and also
+    // feeds the min/max/avg windows of aggregating clients
+    bool needs_packed = false;
+    bool needs_metrics = false;
+    ws_client_list_telemetry_needs(list, &needs_packed, &needs_metrics);
+    float metrics[WS_RATE_LIMITER_METRIC_COUNT];
+    if (needs_packed || needs_metrics) {
+        size_t packed_length = 0;
+        esp_err_t err = monitoring_get_status_binary(s_telemetry_scratch.packed,
+                                                     sizeof(s_telemetry_scratch.packed),
+                                                     &packed_length);
+        if (err == ESP_OK) {
+            sample.packed = s_telemetry_scratch.packed;
+            sample.packed_length = packed_length;
+        } else {
+            ESP_LOGW(TAG, "Failed to encode binary telemetry snapshot: %s", esp_err_to_name(err));
+        }
+    }
+    if (needs_metrics && sample.packed != NULL) {
+        for (size_t i = 0; i < WS_RATE_LIMITER_METRIC_COUNT; ++i) {
+            double value = 0.0;
+            (void)telemetry_binary_read_field(sample.packed,
+                                              sample.packed_length,
+                                              ws_rate_limiter_metric_name(i),
+                                              &value);
+            metrics[i] = (float)value;
+        }
+        sample.metrics = metrics;
+    }
+
+    ws_client_list_broadcast_telemetry(list, &sample);
+}
+
+// Whether the handshake offered @p protocol in Sec-WebSocket-Protocol
+static bool web_server_ws_requested_subprotocol(httpd_req_t *req, const char *protocol)
+{
+    char header[128];
+    size_t length = httpd_req_get_hdr_value_len(req, "Sec-WebSocket-Protocol");
+    if (length == 0 || length >= sizeof(header) ||
+        httpd_req_get_hdr_value_str(req, "Sec-WebSocket-Protocol", header, sizeof(header)) != ESP_OK) {
+        return false;
+    }
+
+    char *save = NULL;
+    for (char *token = strtok_r(header, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save)) {
+        while (*token == ' ' || *token == '\t') {
+            ++token;
+        }
+        size_t token_length = strlen(token);
+        while (token_length > 0 && (token[token_length - 1] == ' ' || token[token_length - 1] == '\t')) {
+            token[--token_length] = '\0';
+        }
+        if (strcmp(token, protocol) == 0) {
+            return true;
+        }
     }
+    return false;
+}
+
+// The welcome snapshot is the first keyframe of a delta client
+static void ws_client_list_seed_delta(ws_client_t **list, int fd, const uint8_t *packed, size_t packed_length)
+{
+    if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;
+    }
+
+    ws_client_t *client = ws_client_list_find_locked(list, fd);
+    if (client != NULL && client->delta && ws_client_delta_store_locked(client, packed, packed_length)) {
+        client->keyframe_us = esp_timer_get_time();
+        client->keyframes++;
+        client->delta_dropped = client->queue.dropped;
+    }
+
+    xSemaphoreGive(g_server_mutex);
+}
+
+typedef struct {
+    bool delta;                 // ?mode=delta, binary subprotocol only
+    uint32_t interval_ms;       // ?rate=<Hz>, 0 for every sample
+    bool aggregate;             // ?aggregate=1
+} ws_telemetry_options_t;
+
+static void web_server_ws_telemetry_options(httpd_req_t *req, ws_telemetry_options_t *options)
+{
+    memset(options, 0, sizeof(*options));
 
-    if (payload_length == 0U) {
+    char query[96];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
         return;
     }
 
-    // Account for JSON wrapper overhead: {"battery":} = 12 bytes + safety margin
-    #define WRAPPER_OVERHEAD 20
-    if (payload_length > MONITORING_SNAPSHOT_MAX_SIZE - WRAPPER_OVERHEAD) {
-        ESP_LOGW(TAG, "Telemetry snapshot too large to wrap (%zu bytes, max %d with wrapper)",
-                 payload_length, MONITORING_SNAPSHOT_MAX_SIZE - WRAPPER_OVERHEAD);
+    char value[16];
+    if (httpd_query_key_value(query, "mode", value, sizeof(value)) == ESP_OK) {
+        options->delta = (strcmp(value, "delta") == 0);
+    }
+    if (httpd_query_key_value(query, "rate", value, sizeof(value)) == ESP_OK &&
+        !ws_rate_limiter_parse_rate(value, &options->interval_ms)) {
+        ESP_LOGW(TAG, "Ignoring invalid telemetry rate '%s'", value);
+        options->interval_ms = 0U;
+    }
+    if (httpd_query_key_value(query, "aggregate", value, sizeof(value)) == ESP_OK) {
+        options->aggregate = (strcmp(value, "1") == 0 || strcmp(value, "true") == 0);
+    }
+}
+
+static void ws_client_list_set_rate(ws_client_t **list, int fd, uint32_t interval_ms, bool aggregate)
+{
+    if (list == NULL || g_server_mutex == NULL) {
         return;
     }
 
-    char wrapped[MONITORING_SNAPSHOT_MAX_SIZE + 32U];
-    int written = snprintf(wrapped, sizeof(wrapped), "{\"battery\":%.*s}", (int)payload_length, payload);
-    if (written <= 0 || (size_t)written >= sizeof(wrapped)) {
-        ESP_LOGW(TAG, "Failed to wrap telemetry snapshot for broadcast");
+    if (xSemaphoreTake(g_server_mutex, pdMS_TO_TICKS(50)) != pdTRUE) {
         return;
     }
 
-    ws_client_list_broadcast(list, wrapped, (size_t)written);
+    ws_client_t *client = ws_client_list_find_locked(list, fd);
+    if (client != NULL) {
+        ws_rate_limiter_configure(&client->rate, interval_ms, aggregate);
+    }
+
+    xSemaphoreGive(g_server_mutex);
+}
+
+// {"rate_hz":1,"aggregate":true} on /ws/telemetry changes the client's rate;
+// the reply echoes the applied settings.
+static esp_err_t web_server_ws_telemetry_control(httpd_req_t *req, ws_client_t **list, const char *text, size_t length)
+{
+    cJSON *root = cJSON_ParseWithLength(text, length);
+    if (root == NULL) {
+        return ESP_OK;
+    }
+
+    const cJSON *rate = cJSON_GetObjectItemCaseSensitive(root, "rate_hz");
+    if (!cJSON_IsNumber(rate)) {
+        cJSON_Delete(root);
+        return ESP_OK;
+    }
+
+    char reply[128];
+    uint32_t interval_ms = 0;
+    bool aggregate = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(root, "aggregate"));
+    if (ws_rate_limiter_interval_from_hz(rate->valuedouble, &interval_ms)) {
+        ws_client_list_set_rate(list, httpd_req_to_sockfd(req), interval_ms, aggregate);
+        snprintf(reply,
+                 sizeof(reply),
+                 "{\"type\":\"rate\",\"interval_ms\":%u,\"aggregate\":%s}",
+                 (unsigned)interval_ms,
+                 (aggregate && interval_ms > 0U) ? "true" : "false");
+    } else {
+        snprintf(reply,
+                 sizeof(reply),
+                 "{\"type\":\"error\",\"message\":\"rate_hz must be 0 or within %.4f..%u Hz\"}",
+                 1000.0 / WS_RATE_LIMITER_MAX_INTERVAL_MS,
+                 (unsigned)(1000U / WS_RATE_LIMITER_MIN_INTERVAL_MS));
+    }
+    cJSON_Delete(root);
+
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .fragmented = false,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)reply,
+        .len = strlen(reply),
+    };
+    return httpd_ws_send_frame(req, &frame);
+}
+
+static esp_err_t web_server_telemetry_send_binary_welcome(httpd_req_t *req, ws_client_t **list)
+{
+    char *schema = malloc(TELEMETRY_BINARY_SCHEMA_MAX_SIZE);
+    if (schema == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t schema_length = 0;
+    esp_err_t err = ESP_FAIL;
+    if (telemetry_binary_write_schema(schema, TELEMETRY_BINARY_SCHEMA_MAX_SIZE, &schema_length)) {
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .fragmented = false,
+            .type = HTTPD_WS_TYPE_TEXT,
+            .payload = (uint8_t *)schema,
+            .len = schema_length,
+        };
+        err = httpd_ws_send_frame(req, &frame);
+    }
+    free(schema);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t packed[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    size_t packed_length = 0;
+    if (monitoring_get_status_binary(packed, sizeof(packed), &packed_length) == ESP_OK) {
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .fragmented = false,
+            .type = HTTPD_WS_TYPE_BINARY,
+            .payload = packed,
+            .len = packed_length,
+        };
+        err = httpd_ws_send_frame(req, &frame);
+        if (err == ESP_OK) {
+            ws_client_list_seed_delta(list, httpd_req_to_sockfd(req), packed, packed_length);
+        }
+    }
+    return err;
 }
 
 // ============================================================================
@@ -292,10 +991,13 @@ static esp_err_t web_server_ws_receive(httpd_req_t *req, ws_client_t **list)
 
     if (frame.type == HTTPD_WS_TYPE_TEXT && frame.payload != NULL) {
         ESP_LOGD(TAG, "WS message: %.*s", frame.len, frame.payload);
+        if (list == &s_telemetry_clients) {
+            err = web_server_ws_telemetry_control(req, list, (const char *)frame.payload, frame.len);
+        }
     }
 
     free(frame.payload);
-    return ESP_OK;
+    return err;
 }
 
 // ============================================================================
@@ -307,7 +1009,33 @@ esp_err_t web_server_telemetry_ws_handler(httpd_req_t *req)
     if (req->method == HTTP_GET) {
         int fd = httpd_req_to_sockfd(req);
         ws_client_list_add(&s_telemetry_clients, fd);
-        ESP_LOGI(TAG, "Telemetry WebSocket client connected: %d", fd);
+
+        ws_telemetry_options_t options;
+        web_server_ws_telemetry_options(req, &options);
+        if (options.interval_ms > 0U) {
+            ws_client_list_set_rate(&s_telemetry_clients, fd, options.interval_ms, options.aggregate);
+        }
+
+        if (web_server_ws_requested_subprotocol(req, TELEMETRY_BINARY_SUBPROTOCOL)) {
+            ws_client_list_set_format(&s_telemetry_clients, fd, true, options.delta);
+            ESP_LOGI(TAG,
+                     "Telemetry WebSocket client connected: %d (%s%s, every %u ms)",
+                     fd,
+                     TELEMETRY_BINARY_SUBPROTOCOL,
+                     options.delta ? ", delta" : "",
+                     (unsigned)options.interval_ms);
+            esp_err_t err = web_server_telemetry_send_binary_welcome(req, &s_telemetry_clients);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to send binary telemetry schema: %s", esp_err_to_name(err));
+            }
+            return ESP_OK;
+        }
+
+        if (options.delta) {
+            ESP_LOGW(TAG, "Telemetry client %d asked for delta mode without %s, sending JSON",
+                     fd, TELEMETRY_BINARY_SUBPROTOCOL);
+        }
+        ESP_LOGI(TAG, "Telemetry WebSocket client connected: %d (every %u ms)", fd, (unsigned)options.interval_ms);
 
         char buffer[MONITORING_SNAPSHOT_MAX_SIZE];
         size_t length = 0;
@@ -416,7 +1144,10 @@ void web_server_websocket_cleanup(void)
 // Event broadcast function (called from event task in core)
 // ============================================================================
 
-void web_server_websocket_broadcast_event(uint32_t event_id, const char *payload, size_t length)
+void web_server_websocket_broadcast_event(uint32_t event_id,
+                                          const char *payload,
+                                          size_t length,
+                                          monitoring_snapshot_t *snapshot)
 {
     if (payload == NULL || length == 0) {
         return;
@@ -424,7 +1155,7 @@ void web_server_websocket_broadcast_event(uint32_t event_id, const char *payload
 
     switch (event_id) {
     case APP_EVENT_ID_TELEMETRY_SAMPLE:
-        web_server_broadcast_battery_snapshot(&s_telemetry_clients, payload, length);
+        web_server_broadcast_battery_snapshot(&s_telemetry_clients, payload, length, snapshot);
         break;
     case APP_EVENT_ID_UI_NOTIFICATION:
     case APP_EVENT_ID_CONFIG_UPDATED:
@@ -452,6 +1183,7 @@ void web_server_websocket_broadcast_event(uint32_t event_id, const char *payload
         break;
     case APP_EVENT_ID_CAN_FRAME_RAW:
     case APP_EVENT_ID_CAN_FRAME_DECODED:
+    case APP_EVENT_ID_CAN_FRAME_BATCH:
         ws_client_list_broadcast(&s_can_clients, payload, length);
         break;
     case APP_EVENT_ID_ALERT_TRIGGERED:
@@ -0,0 +1,176 @@
+/**
+ * @file ws_client_queue.c
+ * @brief Bounded per-client outbound queue for WebSocket broadcasts
+ */
+
+#include "ws_client_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+ws_message_t *ws_message_alloc(size_t length, int64_t now_us)
+{
+    if (length == 0U) {
+        return NULL;
+    }
+
+    ws_message_t *message = malloc(sizeof(ws_message_t) + length);
+    if (message == NULL) {
+        return NULL;
+    }
+
+    message->refs = 1U;
+    message->created_us = now_us;
+    message->binary = false;
+    message->length = length;
+    message->data = message->payload;
+    message->release = NULL;
+    message->release_context = NULL;
+    return message;
+}
+
+ws_message_t *ws_message_create(const void *payload, size_t length, int64_t now_us)
+{
+    if (payload == NULL) {
+        return NULL;
+    }
+
+    ws_message_t *message = ws_message_alloc(length, now_us);
+    if (message != NULL) {
+        memcpy(message->payload, payload, length);
+    }
+    return message;
+}
+
+ws_message_t *ws_message_wrap(const void *data,
+                              size_t length,
+                              ws_message_release_fn_t release,
+                              void *context,
+                              int64_t now_us)
+{
+    if (data == NULL || length == 0U) {
+        return NULL;
+    }
+
+    ws_message_t *message = malloc(sizeof(ws_message_t));
+    if (message == NULL) {
+        return NULL;
+    }
+
+    message->refs = 1U;
+    message->created_us = now_us;
+    message->binary = false;
+    message->length = length;
+    message->data = (const uint8_t *)data;
+    message->release = release;
+    message->release_context = context;
+    return message;
+}
+
+void ws_message_retain(ws_message_t *message)
+{
+    if (message != NULL) {
+        __atomic_add_fetch(&message->refs, 1U, __ATOMIC_RELAXED);
+    }
+}
+
+void ws_message_release(ws_message_t *message)
+{
+    if (message != NULL && __atomic_sub_fetch(&message->refs, 1U, __ATOMIC_ACQ_REL) == 0U) {
+        if (message->release != NULL) {
+            message->release(message->release_context);
+        }
+        free(message);
+    }
+}
+
+void ws_client_queue_init(ws_client_queue_t *queue, size_t capacity, ws_client_queue_policy_t policy)
+{
+    if (queue == NULL) {
+        return;
+    }
+
+    memset(queue, 0, sizeof(*queue));
+    if (capacity == 0U) {
+        capacity = 1U;
+    }
+    if (capacity > WS_CLIENT_QUEUE_CAPACITY_MAX) {
+        capacity = WS_CLIENT_QUEUE_CAPACITY_MAX;
+    }
+    queue->capacity = (uint8_t)capacity;
+    queue->policy = policy;
+}
+
+static ws_message_t *ws_client_queue_take_head(ws_client_queue_t *queue)
+{
+    ws_message_t *message = queue->slots[queue->head];
+    queue->slots[queue->head] = NULL;
+    queue->head = (uint8_t)((queue->head + 1U) % queue->capacity);
+    queue->count--;
+    return message;
+}
+
+bool ws_client_queue_push(ws_client_queue_t *queue, ws_message_t *message)
+{
+    if (queue == NULL || message == NULL || queue->capacity == 0U) {
+        return false;
+    }
+
+    if (queue->count >= queue->capacity) {
+        if (queue->policy == WS_CLIENT_QUEUE_REJECT) {
+            queue->dropped++;
+            return false;
+        }
+        // The lag clock keeps running: the client never got the dropped sample
+        ws_message_release(ws_client_queue_take_head(queue));
+        queue->dropped++;
+    }
+
+    if (queue->pending_since_us == 0) {
+        queue->pending_since_us = message->created_us;
+    }
+
+    ws_message_retain(message);
+    queue->slots[(queue->head + queue->count) % queue->capacity] = message;
+    queue->count++;
+    return true;
+}
+
+ws_message_t *ws_client_queue_pop(ws_client_queue_t *queue, int64_t now_us)
+{
+    if (queue == NULL || queue->count == 0U) {
+        return NULL;
+    }
+
+    uint32_t lag_ms = ws_client_queue_lag_ms(queue, now_us);
+    if (lag_ms > queue->max_lag_ms) {
+        queue->max_lag_ms = lag_ms;
+    }
+
+    ws_message_t *message = ws_client_queue_take_head(queue);
+    queue->pending_since_us = (queue->count > 0U) ? queue->slots[queue->head]->created_us : 0;
+    queue->sent++;
+    return message;
+}
+
+uint32_t ws_client_queue_lag_ms(const ws_client_queue_t *queue, int64_t now_us)
+{
+    if (queue == NULL || queue->pending_since_us == 0 || now_us <= queue->pending_since_us) {
+        return 0U;
+    }
+    int64_t lag_ms = (now_us - queue->pending_since_us) / 1000;
+    return (lag_ms > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)lag_ms;
+}
+
+void ws_client_queue_clear(ws_client_queue_t *queue)
+{
+    if (queue == NULL) {
+        return;
+    }
+
+    while (queue->count > 0U) {
+        ws_message_release(ws_client_queue_take_head(queue));
+    }
+    queue->head = 0U;
+    queue->pending_since_us = 0;
+}
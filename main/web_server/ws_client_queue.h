@@ -0,0 +1,143 @@
+/**
+ * @file ws_client_queue.h
+ * @brief Bounded per-client outbound queue for WebSocket broadcasts
+ *
+ * A broadcast allocates one reference-counted message and pushes it into the
+ * queue of every subscribed client; the httpd task drains each queue on its
+ * own, so one slow client never delays the others nor piles up work items.
+ *
+ * Features:
+ * - Fixed capacity per client (CONFIG_TINYBMS_WEB_WS_QUEUE_DEPTH)
+ * - Drop-oldest for telemetry streams, reject for event streams
+ * - Lag = age of the oldest message the client has not received, dropped
+ *   messages included, so a stalled client is detected even when drop-oldest
+ *   keeps its queue fresh
+ *
+ * The queue is not thread safe; web_server_websocket.c guards it with
+ * g_server_mutex.
+ */
+
+#ifndef WS_CLIENT_QUEUE_H
+#define WS_CLIENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Messages queued per client before the overflow policy applies
+ */
+#ifndef CONFIG_TINYBMS_WEB_WS_QUEUE_DEPTH
+#define CONFIG_TINYBMS_WEB_WS_QUEUE_DEPTH 8
+#endif
+
+/**
+ * @brief Lag after which a client is disconnected (milliseconds)
+ */
+#ifndef CONFIG_TINYBMS_WEB_WS_LAG_BUDGET_MS
+#define CONFIG_TINYBMS_WEB_WS_LAG_BUDGET_MS 3000
+#endif
+
+#define WS_CLIENT_QUEUE_CAPACITY_MAX 32U
+
+typedef void (*ws_message_release_fn_t)(void *context);
+
+/**
+ * @brief Shared, immutable payload of one broadcast
+ */
+typedef struct {
+    uint32_t refs;
+    int64_t created_us;
+    bool binary;            /**< Sent as a binary frame instead of text. */
+    size_t length;
+    const uint8_t *data;    /**< Bytes sent: @ref payload, or a borrowed buffer. */
+    ws_message_release_fn_t release;  /**< Drops the borrowed buffer with the last reference. */
+    void *release_context;
+    uint8_t payload[];      /**< Own storage, empty for a borrowed buffer. */
+} ws_message_t;
+
+typedef enum {
+    WS_CLIENT_QUEUE_DROP_OLDEST = 0,  /**< Full queue discards its oldest message. */
+    WS_CLIENT_QUEUE_REJECT,           /**< Full queue refuses the new message. */
+} ws_client_queue_policy_t;
+
+typedef struct {
+    ws_message_t *slots[WS_CLIENT_QUEUE_CAPACITY_MAX];
+    uint8_t head;
+    uint8_t count;
+    uint8_t capacity;
+    ws_client_queue_policy_t policy;
+    int64_t pending_since_us;   /**< Creation time of the oldest undelivered message, 0 when caught up. */
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t max_lag_ms;
+} ws_client_queue_t;
+
+/**
+ * @brief Allocate a message holding a copy of @p payload, with one reference
+ */
+ws_message_t *ws_message_create(const void *payload, size_t length, int64_t now_us);
+
+/**
+ * @brief Allocate a text message of @p length bytes for the caller to fill
+ */
+ws_message_t *ws_message_alloc(size_t length, int64_t now_us);
+
+/**
+ * @brief Message sending @p data in place, with one reference
+ *
+ * @p release(@p context) runs when the last reference goes. On failure
+ * (NULL) it is not called and the caller still owns @p data.
+ */
+ws_message_t *ws_message_wrap(const void *data,
+                              size_t length,
+                              ws_message_release_fn_t release,
+                              void *context,
+                              int64_t now_us);
+
+void ws_message_retain(ws_message_t *message);
+
+/**
+ * @brief Drop one reference, freeing the message with the last one
+ */
+void ws_message_release(ws_message_t *message);
+
+/**
+ * @brief Initialise an empty queue (capacity clamped to 1..WS_CLIENT_QUEUE_CAPACITY_MAX)
+ */
+void ws_client_queue_init(ws_client_queue_t *queue, size_t capacity, ws_client_queue_policy_t policy);
+
+/**
+ * @brief Queue @p message, taking a reference on success
+ *
+ * @return false when a REJECT queue is full (the message is not queued and
+ *         counted as dropped)
+ */
+bool ws_client_queue_push(ws_client_queue_t *queue, ws_message_t *message);
+
+/**
+ * @brief Dequeue the oldest message, transferring its reference to the caller
+ *
+ * @return NULL when the queue is empty
+ */
+ws_message_t *ws_client_queue_pop(ws_client_queue_t *queue, int64_t now_us);
+
+/**
+ * @brief Age of the oldest message the client has not received, in ms
+ */
+uint32_t ws_client_queue_lag_ms(const ws_client_queue_t *queue, int64_t now_us);
+
+/**
+ * @brief Release every queued message
+ */
+void ws_client_queue_clear(ws_client_queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WS_CLIENT_QUEUE_H
@@ -0,0 +1,179 @@
+/**
+ * @file ws_rate_limiter.c
+ * @brief Per-client decimation of the /ws/telemetry stream
+ */
+
+#include "ws_rate_limiter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Keys of the JSON snapshot, so clients read windows with the same names
+static const char *const s_metric_names[WS_RATE_LIMITER_METRIC_COUNT] = {
+    "pack_voltage_v",
+    "pack_current_a",
+    "power_w",
+    "state_of_charge_pct",
+    "average_temperature_c",
+    "min_cell_mv",
+    "max_cell_mv",
+};
+
+static void ws_rate_limiter_reset_window(ws_rate_limiter_t *limiter, int64_t now_us)
+{
+    limiter->window_start_us = now_us;
+    limiter->window_samples = 0U;
+    memset(limiter->metrics, 0, sizeof(limiter->metrics));
+}
+
+void ws_rate_limiter_configure(ws_rate_limiter_t *limiter, uint32_t interval_ms, bool aggregate)
+{
+    if (limiter == NULL) {
+        return;
+    }
+
+    limiter->interval_ms = interval_ms;
+    limiter->aggregate = aggregate && interval_ms > 0U;  // Nothing is skipped at full rate
+    limiter->next_due_us = 0;
+    ws_rate_limiter_reset_window(limiter, 0);
+}
+
+bool ws_rate_limiter_offer(ws_rate_limiter_t *limiter, int64_t now_us, const float *metrics)
+{
+    if (limiter == NULL) {
+        return true;
+    }
+
+    if (limiter->aggregate && metrics != NULL) {
+        // A window runs from the previous send, or from the first sample
+        if (limiter->window_start_us == 0) {
+            limiter->window_start_us = now_us;
+        }
+        for (size_t i = 0; i < WS_RATE_LIMITER_METRIC_COUNT; ++i) {
+            ws_rate_metric_t *metric = &limiter->metrics[i];
+            float value = isfinite(metrics[i]) ? metrics[i] : 0.0f;
+            if (limiter->window_samples == 0U || value < metric->min) {
+                metric->min = value;
+            }
+            if (limiter->window_samples == 0U || value > metric->max) {
+                metric->max = value;
+            }
+            metric->sum += value;
+        }
+        limiter->window_samples++;
+    }
+
+    if (limiter->interval_ms == 0U) {
+        return true;
+    }
+
+    // Samples arrive with poll jitter: accept one slightly early rather than
+    // slipping a whole poll period, and keep the schedule on its grid.
+    int64_t interval_us = (int64_t)limiter->interval_ms * 1000;
+    if (limiter->next_due_us != 0 && now_us < limiter->next_due_us - interval_us / 8) {
+        limiter->skipped++;
+        return false;
+    }
+
+    if (limiter->next_due_us == 0 || now_us - limiter->next_due_us > interval_us) {
+        limiter->next_due_us = now_us + interval_us;
+    } else {
+        limiter->next_due_us += interval_us;
+    }
+    return true;
+}
+
+bool ws_rate_limiter_write_window(ws_rate_limiter_t *limiter,
+                                  int64_t now_us,
+                                  char *buffer,
+                                  size_t buffer_size,
+                                  size_t *out_length)
+{
+    if (limiter == NULL || buffer == NULL || buffer_size == 0U || !limiter->aggregate ||
+        limiter->window_samples == 0U) {
+        return false;
+    }
+
+    int64_t duration_ms = (now_us - limiter->window_start_us) / 1000;
+    int written = snprintf(buffer,
+                           buffer_size,
+                           "{\"samples\":%u,\"duration_ms\":%lld",
+                           (unsigned)limiter->window_samples,
+                           (long long)((duration_ms > 0) ? duration_ms : 0));
+    if (written < 0 || (size_t)written >= buffer_size) {
+        return false;
+    }
+    size_t offset = (size_t)written;
+
+    for (size_t i = 0; i < WS_RATE_LIMITER_METRIC_COUNT; ++i) {
+        const ws_rate_metric_t *metric = &limiter->metrics[i];
+        written = snprintf(buffer + offset,
+                           buffer_size - offset,
+                           ",\"%s\":{\"min\":%.3f,\"max\":%.3f,\"avg\":%.3f}",
+                           s_metric_names[i],
+                           (double)metric->min,
+                           (double)metric->max,
+                           metric->sum / (double)limiter->window_samples);
+        if (written < 0 || (size_t)written >= buffer_size - offset) {
+            return false;
+        }
+        offset += (size_t)written;
+    }
+
+    if (offset + 2U > buffer_size) {
+        return false;
+    }
+    buffer[offset++] = '}';
+    buffer[offset] = '\0';
+
+    ws_rate_limiter_reset_window(limiter, now_us);
+    if (out_length != NULL) {
+        *out_length = offset;
+    }
+    return true;
+}
+
+bool ws_rate_limiter_interval_from_hz(double rate_hz, uint32_t *out_interval_ms)
+{
+    if (out_interval_ms == NULL || !isfinite(rate_hz) || rate_hz < 0.0) {
+        return false;
+    }
+
+    if (rate_hz == 0.0) {
+        *out_interval_ms = 0U;
+        return true;
+    }
+
+    double interval_ms = round(1000.0 / rate_hz);
+    if (interval_ms < WS_RATE_LIMITER_MIN_INTERVAL_MS || interval_ms > WS_RATE_LIMITER_MAX_INTERVAL_MS) {
+        return false;
+    }
+    *out_interval_ms = (uint32_t)interval_ms;
+    return true;
+}
+
+bool ws_rate_limiter_parse_rate(const char *text, uint32_t *out_interval_ms)
+{
+    if (text == NULL || out_interval_ms == NULL || text[0] == '\0') {
+        return false;
+    }
+
+    if (strcmp(text, "max") == 0) {
+        *out_interval_ms = 0U;
+        return true;
+    }
+
+    char *end = NULL;
+    double rate_hz = strtod(text, &end);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    return ws_rate_limiter_interval_from_hz(rate_hz, out_interval_ms);
+}
+
+const char *ws_rate_limiter_metric_name(size_t index)
+{
+    return (index < WS_RATE_LIMITER_METRIC_COUNT) ? s_metric_names[index] : NULL;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file ws_rate_limiter.h
+ * @brief Per-client decimation of the /ws/telemetry stream
+ *
+ * Each telemetry client may ask for a lower rate than the UART poll rate
+ * (10 Hz, 1 Hz, 0.2 Hz...). Samples are offered to the client's limiter as
+ * they arrive; only those falling on the client's schedule are sent. With
+ * aggregation enabled, the skipped samples are summarised as min/max/avg of
+ * the key metrics, so a slow subscriber still sees current peaks.
+ *
+ * The limiter is not thread safe; web_server_websocket.c guards it with
+ * g_server_mutex.
+ */
+
+#ifndef WS_RATE_LIMITER_H
+#define WS_RATE_LIMITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WS_RATE_LIMITER_METRIC_COUNT   7U
+#define WS_RATE_LIMITER_WINDOW_MAX_SIZE 640U
+#define WS_RATE_LIMITER_MIN_INTERVAL_MS 20U
+#define WS_RATE_LIMITER_MAX_INTERVAL_MS 60000U
+
+typedef struct {
+    float min;
+    float max;
+    double sum;
+} ws_rate_metric_t;
+
+typedef struct {
+    uint32_t interval_ms;       /**< 0 = every sample. */
+    bool aggregate;             /**< Summarise skipped samples (min/max/avg). */
+    int64_t next_due_us;        /**< 0 until the first sample is sent. */
+    int64_t window_start_us;
+    uint32_t window_samples;
+    uint32_t skipped;
+    ws_rate_metric_t metrics[WS_RATE_LIMITER_METRIC_COUNT];
+} ws_rate_limiter_t;
+
+/**
+ * @brief Set the client's rate; the next offered sample is sent
+ */
+void ws_rate_limiter_configure(ws_rate_limiter_t *limiter, uint32_t interval_ms, bool aggregate);
+
+/**
+ * @brief Offer one sample to the client
+ *
+ * @param metrics WS_RATE_LIMITER_METRIC_COUNT values in
+ *                ws_rate_limiter_metric_name() order, folded into the window
+ *                when aggregating (may be NULL)
+ * @return true when this sample is due for the client
+ */
+bool ws_rate_limiter_offer(ws_rate_limiter_t *limiter, int64_t now_us, const float *metrics);
+
+/**
+ * @brief Write the window summarised since the previous send, then restart it
+ *
+ * Output: {"samples":4,"duration_ms":1000,"pack_voltage_v":{"min":..,"max":..,"avg":..},...}
+ *
+ * @return false when the client does not aggregate, the window is empty or
+ *         @p buffer is too small
+ */
+bool ws_rate_limiter_write_window(ws_rate_limiter_t *limiter,
+                                  int64_t now_us,
+                                  char *buffer,
+                                  size_t buffer_size,
+                                  size_t *out_length);
+
+/**
+ * @brief Parse a rate in Hz ("10", "1", "0.2"; "0" or "max" for every sample)
+ *
+ * @return false when @p text is not a rate between
+ *         1000 / WS_RATE_LIMITER_MAX_INTERVAL_MS and
+ *         1000 / WS_RATE_LIMITER_MIN_INTERVAL_MS Hz
+ */
+bool ws_rate_limiter_parse_rate(const char *text, uint32_t *out_interval_ms);
+
+/**
+ * @brief Interval for @p rate_hz, with the same bounds as ws_rate_limiter_parse_rate()
+ */
+bool ws_rate_limiter_interval_from_hz(double rate_hz, uint32_t *out_interval_ms);
+
+/**
+ * @brief Snapshot key of the aggregated metric @p index
+ */
+const char *ws_rate_limiter_metric_name(size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WS_RATE_LIMITER_H
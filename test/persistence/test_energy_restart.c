@@ -4,6 +4,7 @@
 
 #include "can_publisher.h"
 #include "conversion_table.h"
+#include "storage/nvs_energy.h"
 #include "uart_bms.h"
 #include "esp_err.h"
 
@@ -72,3 +73,91 @@ TEST_CASE("energy_counters_restored_after_restart", "[persistence][energy]")
     TEST_ASSERT_EQUAL_UINT32(expected_out, encoded_out);
 }
 
+
+TEST_CASE("energy_fixed_point_restore_is_exact", "[persistence][energy]")
+{
+    can_publisher_conversion_reset_state();
+
+    // 51.2 V x 3.3 A over 1.25 s leaves a sub-mWh remainder at every step
+    uart_bms_live_data_t sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.pack_voltage_v = 51.2f;
+    sample.pack_current_a = 3.3f;
+    for (uint32_t i = 0; i < 20U; ++i) {
+        sample.timestamp_ms = 1000U + (uint64_t)i * 1250U;
+        can_publisher_conversion_ingest_sample(&sample);
+    }
+    sample.pack_current_a = -1.7f;
+    for (uint32_t i = 20U; i < 30U; ++i) {
+        sample.timestamp_ms = 1000U + (uint64_t)i * 1250U;
+        can_publisher_conversion_ingest_sample(&sample);
+    }
+
+    double charged_before = 0.0;
+    double discharged_before = 0.0;
+    can_publisher_conversion_get_energy_state(&charged_before, &discharged_before);
+    TEST_ASSERT_TRUE(charged_before > 0.0);
+    TEST_ASSERT_TRUE(discharged_before > 0.0);
+
+    TEST_ASSERT_EQUAL(ESP_OK, can_publisher_conversion_persist_energy_state());
+
+    nvs_energy_state_t stored = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_load(&stored));
+    // 19 intervals of 168.96 W x 1250 ms, then 10 of 87.04 W x 1250 ms (uW x ms = nJ)
+    const uint64_t expected_in_nj = 19ULL * 168960000ULL * 1250ULL;
+    const uint64_t expected_out_nj = 10ULL * 87040000ULL * 1250ULL;
+    TEST_ASSERT_EQUAL_UINT64(expected_in_nj / NVS_ENERGY_NJ_PER_MWH, stored.charged_mwh);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(expected_in_nj % NVS_ENERGY_NJ_PER_MWH), stored.charged_remainder_nj);
+    TEST_ASSERT_EQUAL_UINT64(expected_out_nj / NVS_ENERGY_NJ_PER_MWH, stored.discharged_mwh);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)(expected_out_nj % NVS_ENERGY_NJ_PER_MWH), stored.discharged_remainder_nj);
+
+    can_publisher_conversion_set_energy_state(0.0, 0.0);
+    TEST_ASSERT_EQUAL(ESP_OK, can_publisher_conversion_restore_energy_state());
+
+    double charged_after = 0.0;
+    double discharged_after = 0.0;
+    can_publisher_conversion_get_energy_state(&charged_after, &discharged_after);
+    TEST_ASSERT_EQUAL_DOUBLE(charged_before, charged_after);
+    TEST_ASSERT_EQUAL_DOUBLE(discharged_before, discharged_after);
+}
+
+TEST_CASE("energy_store_coalesces_identical_states", "[persistence][energy]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_init());
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_clear());
+
+    nvs_energy_state_t state = {
+        .charged_mwh = 123456U,
+        .discharged_mwh = 6543U,
+        .charged_remainder_nj = 17U,
+        .discharged_remainder_nj = (uint32_t)(NVS_ENERGY_NJ_PER_MWH - 1U),
+    };
+    uint32_t writes = nvs_energy_write_count();
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_store(&state));
+    TEST_ASSERT_EQUAL_UINT32(writes + 1U, nvs_energy_write_count());
+
+    // Same state again: nothing reaches flash
+    for (uint32_t i = 0; i < 8U; ++i) {
+        TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_store(&state));
+    }
+    TEST_ASSERT_EQUAL_UINT32(writes + 1U, nvs_energy_write_count());
+
+    state.charged_remainder_nj += 1U;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_store(&state));
+    TEST_ASSERT_EQUAL_UINT32(writes + 2U, nvs_energy_write_count());
+
+    nvs_energy_state_t loaded = {0};
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_load(&loaded));
+    TEST_ASSERT_EQUAL_MEMORY(&state, &loaded, sizeof(state));
+
+    nvs_energy_state_t invalid = state;
+    invalid.charged_remainder_nj = (uint32_t)NVS_ENERGY_NJ_PER_MWH;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, nvs_energy_store(&invalid));
+
+    // Clearing forgets the cached record, so the next store writes again
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_clear());
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, nvs_energy_load(&loaded));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_store(&state));
+    TEST_ASSERT_EQUAL_UINT32(writes + 3U, nvs_energy_write_count());
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_energy_clear());
+}
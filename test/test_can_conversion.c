@@ -4,9 +4,13 @@
 #include "conversion_table.h"
 #include "cvl_controller.h"
 
+#include <inttypes.h>
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
 
+#include "esp_timer.h"
+
 #ifdef __has_include
 #  if __has_include("sdkconfig.h")
 #    include "sdkconfig.h"
@@ -224,6 +228,36 @@ TEST_CASE("can_conversion_charge_limits_from_cvl", "[can][unit]")
     TEST_ASSERT_EQUAL_UINT16((uint16_t)lrintf(cvl_result.result.dcl_limit_a * 10.0f), dcl_raw);
 }
 
+TEST_CASE("can_conversion_cvl_skips_unchanged_samples", "[can][unit]")
+{
+    uart_bms_live_data_t data = make_nominal_sample();
+    data.timestamp_ms = 1000U;
+
+    can_publisher_cvl_init();
+    can_publisher_cvl_prepare(&data);
+    can_publisher_cvl_prepare(&data);
+
+    // Pack current is not observed while cell protection is idle
+    data.pack_current_a += 3.0f;
+    data.timestamp_ms = 1100U;
+    can_publisher_cvl_prepare(&data);
+
+    can_publisher_cvl_stats_t stats;
+    can_publisher_cvl_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(3U, stats.evaluations + stats.skipped);
+    TEST_ASSERT_TRUE(stats.skipped >= 1U);
+
+    can_publisher_cvl_result_t cvl_result;
+    TEST_ASSERT_TRUE(can_publisher_cvl_get_latest(&cvl_result));
+    TEST_ASSERT_EQUAL_UINT64(1100U, cvl_result.timestamp_ms);
+
+    uint32_t evaluations = stats.evaluations;
+    data.state_of_charge_pct += 1.0f;
+    can_publisher_cvl_prepare(&data);
+    can_publisher_cvl_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(evaluations + 1U, stats.evaluations);
+}
+
 TEST_CASE("can_conversion_soc_soh_range_handling", "[can][unit]")
 {
     uart_bms_live_data_t data = make_nominal_sample();
@@ -648,3 +682,278 @@ TEST_CASE("can_conversion_installed_capacity_sources", "[can][unit]")
     TEST_ASSERT_TRUE(channel->fill_fn(&data, &frame));
     TEST_ASSERT_EQUAL_UINT16(20, (uint16_t)(frame.data[0] | ((uint16_t)frame.data[1] << 8))); // 16 * 2.5 * 0.5
 }
+
+TEST_CASE("can_conversion_identity_inputs_track_static_fields", "[can][unit]")
+{
+    uart_bms_live_data_t data = make_nominal_sample();
+    can_publisher_identity_inputs_t first;
+    can_publisher_identity_inputs_t second;
+
+    can_publisher_conversion_capture_identity(&data, &first);
+
+    // Live telemetry does not affect the identification frames.
+    data.pack_voltage_v = 48.0f;
+    data.state_of_charge_pct = 12.0f;
+    data.timestamp_ms += 1000U;
+    can_publisher_conversion_capture_identity(&data, &second);
+    TEST_ASSERT_EQUAL_MEMORY(&first, &second, sizeof(first));
+
+    set_register(&data, 0x01F8U, 0x4C46U);
+    can_publisher_conversion_capture_identity(&data, &second);
+    TEST_ASSERT_TRUE(memcmp(&first, &second, sizeof(first)) != 0);
+
+    data = make_nominal_sample();
+    data.serial_number[0] = 'X';
+    can_publisher_conversion_capture_identity(&data, &second);
+    TEST_ASSERT_TRUE(memcmp(&first, &second, sizeof(first)) != 0);
+
+    for (size_t i = 0; i < g_can_publisher_channel_count; ++i) {
+        const can_publisher_channel_t *channel = &g_can_publisher_channels[i];
+        if (channel->pgn == PGN_INSTALLED_CAP || channel->pgn == PGN_ENERGY_COUNTERS) {
+            TEST_ASSERT_BITS_HIGH(CAN_PUBLISHER_INPUT_LIVE, channel->inputs);
+        }
+    }
+}
+
+// Hand-written encoders the generated program replaced, kept as a reference
+static uint16_t reference_u16(float value, float scale, float offset, uint16_t max_value)
+{
+    double scaled = ((double)value + (double)offset) * (double)scale;
+    if (!isfinite(scaled)) {
+        return 0U;
+    }
+    long rounded = lrint(scaled);
+    return (rounded < 0L) ? 0U : (rounded > (long)max_value) ? max_value : (uint16_t)rounded;
+}
+
+static int16_t reference_i16(float value, float scale)
+{
+    double scaled = (double)value * (double)scale;
+    if (!isfinite(scaled)) {
+        return 0;
+    }
+    long rounded = lrint(scaled);
+    return (rounded < INT16_MIN) ? INT16_MIN : (rounded > INT16_MAX) ? INT16_MAX : (int16_t)rounded;
+}
+
+static void put_u16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)(value & 0xFFU);
+    data[1] = (uint8_t)(value >> 8U);
+}
+
+static bool reference_encode(const uart_bms_live_data_t *data, can_publisher_frame_t *frame)
+{
+    memset(frame->data, 0, sizeof(frame->data));
+    switch (frame->id) {
+        case PGN_SOC_SOH:
+            put_u16(&frame->data[0], reference_u16(data->state_of_charge_pct, 1.0f, 0.0f, 100U));
+            put_u16(&frame->data[2], reference_u16(data->state_of_health_pct, 1.0f, 0.0f, 100U));
+            return true;
+        case PGN_VOLTAGE_CURRENT:
+            put_u16(&frame->data[0], reference_u16(data->pack_voltage_v, 100.0f, 0.0f, 0xFFFFU));
+            put_u16(&frame->data[2], (uint16_t)reference_i16(data->pack_current_a, 10.0f));
+            put_u16(&frame->data[4], (uint16_t)reference_i16(data->mosfet_temperature_c, 10.0f));
+            return true;
+        case PGN_CELL_EXTREMES:
+            put_u16(&frame->data[0], data->min_cell_mv);
+            put_u16(&frame->data[2], data->max_cell_mv);
+            put_u16(&frame->data[4], reference_u16(data->pack_temperature_min_c, 1.0f, 273.15f, 0xFFFFU));
+            put_u16(&frame->data[6], reference_u16(data->pack_temperature_max_c, 1.0f, 273.15f, 0xFFFFU));
+            return true;
+        default:
+            return false;
+    }
+}
+
+static const uint16_t s_program_pgns[] = {PGN_SOC_SOH, PGN_VOLTAGE_CURRENT, PGN_CELL_EXTREMES};
+
+TEST_CASE("can_conversion_program_matches_reference_encoders", "[can][unit]")
+{
+    static const float values[] = {0.0f, -0.04f, 0.05f, 12.345f, -40.5f, 99.6f, 150.0f, 400.0f, -5000.0f, 1.0e6f, NAN};
+    const size_t value_count = sizeof(values) / sizeof(values[0]);
+
+    for (size_t p = 0; p < sizeof(s_program_pgns) / sizeof(s_program_pgns[0]); ++p) {
+        const can_publisher_channel_t *channel = find_channel(s_program_pgns[p]);
+        TEST_ASSERT_NOT_NULL(channel);
+
+        for (size_t i = 0; i < value_count; ++i) {
+            uart_bms_live_data_t data = make_nominal_sample();
+            float v = values[i];
+            float w = values[(i + 3U) % value_count];
+            data.state_of_charge_pct = v;
+            data.state_of_health_pct = w;
+            data.pack_voltage_v = v;
+            data.pack_current_a = w;
+            data.mosfet_temperature_c = v;
+            data.pack_temperature_min_c = w;
+            data.pack_temperature_max_c = v;
+            data.min_cell_mv = (uint16_t)(i * 6000U);
+            data.max_cell_mv = (uint16_t)(65535U - i);
+
+            can_publisher_frame_t actual = {.id = channel->can_id, .dlc = channel->dlc};
+            can_publisher_frame_t expected = {.id = channel->can_id, .dlc = channel->dlc};
+            TEST_ASSERT_TRUE(channel->fill_fn(&data, &actual));
+            TEST_ASSERT_TRUE(reference_encode(&data, &expected));
+            if (s_program_pgns[p] == PGN_SOC_SOH) {
+                // High resolution SOC comes from registers, covered separately
+                actual.data[4] = 0U;
+                actual.data[5] = 0U;
+            }
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(expected.data, actual.data, 8);
+        }
+    }
+}
+
+#define CAN_PROGRAM_BENCH_ITERATIONS 2000U
+
+TEST_CASE("can_conversion_program_encode_benchmark", "[can][perf]")
+{
+    uart_bms_live_data_t data = make_nominal_sample();
+
+    for (size_t p = 0; p < sizeof(s_program_pgns) / sizeof(s_program_pgns[0]); ++p) {
+        const can_publisher_channel_t *channel = find_channel(s_program_pgns[p]);
+        TEST_ASSERT_NOT_NULL(channel);
+        can_publisher_frame_t frame = {.id = channel->can_id, .dlc = channel->dlc};
+
+        int64_t start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < CAN_PROGRAM_BENCH_ITERATIONS; ++i) {
+            data.pack_current_a = (float)(i & 0xFFU) * 0.1f;
+            channel->fill_fn(&data, &frame);
+        }
+        int64_t program_us = esp_timer_get_time() - start_us;
+
+        start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < CAN_PROGRAM_BENCH_ITERATIONS; ++i) {
+            data.pack_current_a = (float)(i & 0xFFU) * 0.1f;
+            reference_encode(&data, &frame);
+        }
+        int64_t reference_us = esp_timer_get_time() - start_us;
+
+        printf("0x%03X encode: program %" PRId64 " ns/frame, hand-written %" PRId64 " ns/frame\n",
+               (unsigned)channel->can_id,
+               program_us * 1000 / (int64_t)CAN_PROGRAM_BENCH_ITERATIONS,
+               reference_us * 1000 / (int64_t)CAN_PROGRAM_BENCH_ITERATIONS);
+    }
+}
+
+// Encoder cost per PGN over varied samples, so changes to conversion_table.c
+// can be measured. Each result is printed as a `can_encode_bench,<pgn>,<ns>`
+// line; tools/can_encode_bench.py compares a captured log against
+// test/reference/can_encode_baseline.csv and flags regressions. The budgets
+// below are coarse ceilings that fail the test on gross regressions; they can
+// be overridden with -D for a given target.
+#define CAN_ENCODE_BENCH_SAMPLES    16U
+#define CAN_ENCODE_BENCH_ITERATIONS 4000U
+
+#ifndef CAN_ENCODE_BENCH_FRAME_BUDGET_NS
+#define CAN_ENCODE_BENCH_FRAME_BUDGET_NS 20000U
+#endif
+
+#ifndef CAN_ENCODE_BENCH_TABLE_BUDGET_NS
+#define CAN_ENCODE_BENCH_TABLE_BUDGET_NS 200000U
+#endif
+
+static uint32_t bench_next_random(uint32_t *state)
+{
+    // xorshift32, deterministic across runs
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static float bench_random_range(uint32_t *state, float min, float max)
+{
+    float unit = (float)(bench_next_random(state) & 0xFFFFU) / 65535.0f;
+    return min + (max - min) * unit;
+}
+
+static void bench_build_samples(uart_bms_live_data_t *samples, size_t count)
+{
+    uint32_t state = 0x2545F491U;
+    for (size_t i = 0; i < count; ++i) {
+        uart_bms_live_data_t *data = &samples[i];
+        *data = make_nominal_sample();
+        data->timestamp_ms = 1000U + (uint64_t)i * 250U;
+        data->pack_voltage_v = bench_random_range(&state, 40.0f, 58.0f);
+        data->pack_current_a = bench_random_range(&state, -150.0f, 120.0f);
+        data->state_of_charge_pct = bench_random_range(&state, 0.0f, 100.0f);
+        data->state_of_health_pct = bench_random_range(&state, 70.0f, 100.0f);
+        data->min_cell_mv = (uint16_t)bench_random_range(&state, 2600.0f, 3400.0f);
+        data->max_cell_mv = (uint16_t)(data->min_cell_mv + (bench_next_random(&state) % 400U));
+        data->mosfet_temperature_c = bench_random_range(&state, -10.0f, 80.0f);
+        data->pack_temperature_min_c = bench_random_range(&state, -20.0f, 30.0f);
+        data->pack_temperature_max_c = data->pack_temperature_min_c + bench_random_range(&state, 0.0f, 25.0f);
+        data->average_temperature_c = (data->pack_temperature_min_c + data->pack_temperature_max_c) * 0.5f;
+    }
+}
+
+TEST_CASE("can_conversion_encoder_benchmark", "[can][perf]")
+{
+    static uart_bms_live_data_t samples[CAN_ENCODE_BENCH_SAMPLES];
+    bench_build_samples(samples, CAN_ENCODE_BENCH_SAMPLES);
+
+    can_publisher_conversion_reset_state();
+    can_publisher_cvl_init();
+
+    uint32_t worst_ns = 0U;
+    uint32_t worst_id = 0U;
+    for (size_t c = 0; c < g_can_publisher_channel_count; ++c) {
+        const can_publisher_channel_t *channel = &g_can_publisher_channels[c];
+        can_publisher_frame_t frame = {.id = channel->can_id, .dlc = channel->dlc};
+
+        // First call outside the timed loop: caches, lazy state, flash pages
+        (void)channel->fill_fn(&samples[0], &frame);
+
+        uint32_t produced = 0U;
+        int64_t start_us = esp_timer_get_time();
+        for (uint32_t i = 0; i < CAN_ENCODE_BENCH_ITERATIONS; ++i) {
+            if (channel->fill_fn(&samples[i % CAN_ENCODE_BENCH_SAMPLES], &frame)) {
+                produced++;
+            }
+        }
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        uint32_t ns_per_frame = (uint32_t)(elapsed_us * 1000 / (int64_t)CAN_ENCODE_BENCH_ITERATIONS);
+
+        printf("can_encode_bench,0x%03" PRIX32 ",%" PRIu32 "\n", channel->can_id, ns_per_frame);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(CAN_ENCODE_BENCH_ITERATIONS, produced, "encoder dropped a sample");
+        if (ns_per_frame > worst_ns) {
+            worst_ns = ns_per_frame;
+            worst_id = channel->can_id;
+        }
+    }
+
+    // Whole table per sample, as can_publisher_on_bms_update() encodes it
+    can_publisher_frame_t frames[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    size_t channels = g_can_publisher_channel_count;
+    if (channels > CAN_PUBLISHER_MAX_BUFFER_SLOTS) {
+        channels = CAN_PUBLISHER_MAX_BUFFER_SLOTS;
+    }
+    for (size_t c = 0; c < channels; ++c) {
+        frames[c].id = g_can_publisher_channels[c].can_id;
+        frames[c].dlc = g_can_publisher_channels[c].dlc;
+    }
+
+    const uint32_t table_passes = CAN_ENCODE_BENCH_ITERATIONS / 10U;
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < table_passes; ++i) {
+        const uart_bms_live_data_t *sample = &samples[i % CAN_ENCODE_BENCH_SAMPLES];
+        for (size_t c = 0; c < channels; ++c) {
+            (void)g_can_publisher_channels[c].fill_fn(sample, &frames[c]);
+        }
+    }
+    int64_t table_us = esp_timer_get_time() - start_us;
+    uint32_t table_ns = (uint32_t)(table_us * 1000 / (int64_t)table_passes);
+
+    printf("can_encode_bench,table,%" PRIu32 "\n", table_ns);
+    printf("encoder benchmark: %zu channels, table %" PRIu32 " ns/pass, slowest 0x%03" PRIX32 " at %" PRIu32 " ns/frame\n",
+           channels, table_ns, worst_id, worst_ns);
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(CAN_ENCODE_BENCH_FRAME_BUDGET_NS, worst_ns,
+                                             "encoder above per-frame budget");
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(CAN_ENCODE_BENCH_TABLE_BUDGET_NS, table_ns,
+                                             "channel table above per-pass budget");
+}
@@ -1,11 +1,28 @@
 #include "unity.h"
 
+#include "can_config_defaults.h"
 #include "can_publisher.h"
+#include "can_victron.h"
+#include "config_manager.h"
 #include "conversion_table.h"
 #include "cvl_controller.h"
 
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "uart_test_vectors.h"
+
+#define CAN_PUBLISHER_BENCH_ITERATIONS 1000U
+#define CAN_ALARM_PGN 0x35AU
+#define CAN_DISPATCH_BENCH_RUN_MS 4500U
+#define CAN_DISPATCH_BENCH_TX_US 20U
+
 static uart_bms_live_data_t make_sample(void)
 {
     uart_bms_live_data_t data;
@@ -96,3 +113,371 @@ TEST_CASE("can_publisher_populates_buffer_for_all_channels", "[can][integration]
         TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[i].data, buffer.slots[i].data, channel->dlc);
     }
 }
+
+TEST_CASE("can_publisher_slot_sequence_settles_even", "[can][integration]")
+{
+    uart_bms_live_data_t sample = make_sample();
+
+    can_publisher_conversion_reset_state();
+    can_publisher_cvl_init();
+
+    can_publisher_buffer_t buffer = { .slots = {0}, .slot_valid = {0}, .capacity = g_can_publisher_channel_count };
+    can_publisher_registry_t registry = {
+        .channels = g_can_publisher_channels,
+        .channel_count = g_can_publisher_channel_count,
+        .buffer = &buffer,
+    };
+
+    can_publisher_on_bms_update(&sample, &registry);
+
+    for (size_t i = 0; i < g_can_publisher_channel_count; ++i) {
+        TEST_ASSERT_TRUE(buffer.slot_valid[i]);
+        TEST_ASSERT_NOT_EQUAL(0U, buffer.slot_sequence[i]);
+        TEST_ASSERT_EQUAL_UINT32(0U, buffer.slot_sequence[i] & 1U);
+    }
+}
+
+static uint32_t s_seqlock_target_id = 0;
+static uint32_t s_seqlock_target_sends = 0;
+static uint32_t s_seqlock_sends = 0;
+
+static esp_err_t seqlock_frame_stub(uint32_t can_id, const uint8_t *data, size_t length, const char *description)
+{
+    (void)data;
+    (void)length;
+    (void)description;
+    ++s_seqlock_sends;
+    if (can_id == s_seqlock_target_id) {
+        ++s_seqlock_target_sends;
+    }
+    return ESP_OK;
+}
+
+// A reader finding the slot sequence odd sees the writer mid-update: it must
+// retry, give up after the retry budget and leave the frame for the next pass
+// rather than send bytes the writer may be overwriting.
+TEST_CASE("can_publisher_slot_read_defers_while_write_in_progress", "[can][integration]")
+{
+    uart_bms_live_data_t sample = make_sample();
+
+    config_manager_init();
+    static const char immediate[] = "{\"can\":{\"publisher\":{\"period_ms\":0}}}";
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_set_config_json(immediate, sizeof(immediate) - 1U));
+    can_publisher_init(NULL, seqlock_frame_stub);
+
+    // Identification frames are resent from their cached slot between changes
+    size_t target = g_can_publisher_channel_count;
+    for (size_t i = 0; i < g_can_publisher_channel_count; ++i) {
+        uint32_t inputs = g_can_publisher_channels[i].inputs;
+        if (inputs != 0U && (inputs & CAN_PUBLISHER_INPUT_LIVE) == 0U) {
+            target = i;
+            break;
+        }
+    }
+    TEST_ASSERT_TRUE(target < g_can_publisher_channel_count);
+    s_seqlock_target_id = g_can_publisher_channels[target].can_id;
+
+    can_publisher_buffer_t buffer = { .slots = {0}, .slot_valid = {0}, .capacity = g_can_publisher_channel_count };
+    can_publisher_registry_t registry = {
+        .channels = g_can_publisher_channels,
+        .channel_count = g_can_publisher_channel_count,
+        .buffer = &buffer,
+    };
+
+    s_seqlock_target_sends = 0;
+    can_publisher_on_bms_update(&sample, &registry);
+    TEST_ASSERT_EQUAL_UINT32(1U, s_seqlock_target_sends);
+    TEST_ASSERT_EQUAL_UINT32(0U, buffer.slot_sequence[target] & 1U);
+
+    can_publisher_buffer_diagnostics_t before = {0};
+    can_publisher_get_buffer_diagnostics(&before);
+
+    // Writer preempted between its two sequence increments
+    uint32_t settled = buffer.slot_sequence[target];
+    buffer.slot_sequence[target] = settled + 1U;
+
+    s_seqlock_target_sends = 0;
+    s_seqlock_sends = 0;
+    can_publisher_on_bms_update(&sample, &registry);
+
+    can_publisher_buffer_diagnostics_t during = {0};
+    can_publisher_get_buffer_diagnostics(&during);
+    TEST_ASSERT_EQUAL_UINT32(0U, s_seqlock_target_sends);
+    TEST_ASSERT_NOT_EQUAL(0U, s_seqlock_sends);
+    TEST_ASSERT_TRUE(during.torn_reads > before.torn_reads);
+    TEST_ASSERT_EQUAL_UINT32(before.skipped_reads + 1U, during.skipped_reads);
+
+    // Writer done: the deferred frame goes out on the next pass, no new retries
+    buffer.slot_sequence[target] = settled + 2U;
+    s_seqlock_target_sends = 0;
+    can_publisher_on_bms_update(&sample, &registry);
+
+    can_publisher_buffer_diagnostics_t after = {0};
+    can_publisher_get_buffer_diagnostics(&after);
+    TEST_ASSERT_EQUAL_UINT32(1U, s_seqlock_target_sends);
+    TEST_ASSERT_EQUAL_UINT32(during.torn_reads, after.torn_reads);
+    TEST_ASSERT_EQUAL_UINT32(during.skipped_reads, after.skipped_reads);
+
+    can_publisher_deinit();
+}
+
+TEST_CASE("can_publisher_bms_update_pass_benchmark", "[can][perf]")
+{
+    uint8_t raw_frame[128] = {0};
+    size_t frame_len = build_uart_test_frame(raw_frame, sizeof(raw_frame));
+    TEST_ASSERT_NOT_EQUAL(0U, frame_len);
+
+    static uart_bms_live_data_t sample;
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_decode_frame(raw_frame, frame_len, &sample));
+    sample.timestamp_ms = 4000U;
+
+    size_t channels = g_can_publisher_channel_count;
+    if (channels > CAN_PUBLISHER_MAX_BUFFER_SLOTS) {
+        channels = CAN_PUBLISHER_MAX_BUFFER_SLOTS;
+    }
+
+    can_publisher_conversion_reset_state();
+    can_publisher_cvl_init();
+
+    can_publisher_buffer_t buffer = { .slots = {0}, .slot_valid = {0}, .capacity = channels };
+    can_publisher_registry_t registry = {
+        .channels = g_can_publisher_channels,
+        .channel_count = g_can_publisher_channel_count,
+        .buffer = &buffer,
+    };
+
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < CAN_PUBLISHER_BENCH_ITERATIONS; ++i) {
+        sample.timestamp_ms += 250U;
+        can_publisher_on_bms_update(&sample, &registry);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    printf("can_publisher_on_bms_update: %" PRId64 " us/pass over %u passes (%zu channels)\n",
+           elapsed_us / (int64_t)CAN_PUBLISHER_BENCH_ITERATIONS,
+           (unsigned)CAN_PUBLISHER_BENCH_ITERATIONS,
+           g_can_publisher_channel_count);
+
+    for (size_t i = 0; i < channels; ++i) {
+        TEST_ASSERT_TRUE(buffer.slot_valid[i]);
+    }
+}
+
+// Periodic mode with a 1 s alarm period: an over-temperature sample must reach
+// the frame publisher well before the next regular 0x35A deadline.
+static volatile int64_t s_alarm_wire_us = 0;
+static volatile bool s_alarm_armed = false;
+static volatile uint32_t s_alarm_sends = 0;
+
+static esp_err_t alarm_frame_stub(uint32_t can_id, const uint8_t *data, size_t length, const char *description)
+{
+    (void)data;
+    (void)length;
+    (void)description;
+    if (can_id == CAN_ALARM_PGN && s_alarm_armed) {
+        if (s_alarm_wire_us == 0) {
+            s_alarm_wire_us = esp_timer_get_time();
+        }
+        ++s_alarm_sends;
+    }
+    return ESP_OK;
+}
+
+TEST_CASE("can_publisher_alarm_change_sent_out_of_band", "[can][integration]")
+{
+    uint8_t nominal[160];
+    uint8_t alarm[160];
+    uint16_t values[UART_BMS_REGISTER_WORD_COUNT];
+    memcpy(values, kUartTestSampleValues, sizeof(values));
+    size_t nominal_len = build_uart_test_frame_from_values(values, nominal, sizeof(nominal));
+    values[29] = 900U;  // Internal (MOSFET) temperature register 0x0030: 90.0 C
+    size_t alarm_len = build_uart_test_frame_from_values(values, alarm, sizeof(alarm));
+    TEST_ASSERT_NOT_EQUAL(0U, nominal_len);
+    TEST_ASSERT_NOT_EQUAL(0U, alarm_len);
+
+    // The second sample must actually change the alarm bytes
+    const can_publisher_channel_t *channel = NULL;
+    size_t alarm_index = 0;
+    for (size_t i = 0; i < g_can_publisher_channel_count; ++i) {
+        if (g_can_publisher_channels[i].can_id == CAN_ALARM_PGN) {
+            channel = &g_can_publisher_channels[i];
+            alarm_index = i;
+        }
+    }
+    TEST_ASSERT_NOT_NULL(channel);
+    static uart_bms_live_data_t decoded;
+    can_publisher_frame_t before = {.id = channel->can_id, .dlc = channel->dlc};
+    can_publisher_frame_t after = {.id = channel->can_id, .dlc = channel->dlc};
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_decode_frame(nominal, nominal_len, &decoded));
+    TEST_ASSERT_TRUE(channel->fill_fn(&decoded, &before));
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_decode_frame(alarm, alarm_len, &decoded));
+    TEST_ASSERT_TRUE(channel->fill_fn(&decoded, &after));
+    TEST_ASSERT_TRUE(memcmp(before.data, after.data, sizeof(before.data)) != 0);
+
+    config_manager_init();
+    static const char periodic[] = "{\"can\":{\"publisher\":{\"period_ms\":1000}}}";
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_set_config_json(periodic, sizeof(periodic) - 1U));
+    can_publisher_init(NULL, alarm_frame_stub);
+
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_process_frame(nominal, nominal_len));
+    // Past the guard and the first scheduled round
+    vTaskDelay(pdMS_TO_TICKS(1500));
+
+    s_alarm_wire_us = 0;
+    s_alarm_sends = 0;
+    s_alarm_armed = true;
+    int64_t arrival_us = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_process_frame(alarm, alarm_len));
+    for (int i = 0; i < 50 && s_alarm_wire_us == 0; ++i) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    // The out-of-band send restarts the period: no regular repeat follows it
+    vTaskDelay(pdMS_TO_TICKS(500));
+    s_alarm_armed = false;
+
+    TEST_ASSERT_NOT_EQUAL(0, s_alarm_wire_us);
+    TEST_ASSERT_EQUAL_UINT32(1U, s_alarm_sends);
+    int64_t latency_us = s_alarm_wire_us - arrival_us;
+    printf("0x35A alarm-to-wire: %" PRId64 " us\n", latency_us);
+    TEST_ASSERT_TRUE(latency_us < (int64_t)(CONFIG_TINYBMS_CAN_ON_CHANGE_GUARD_MS + 100U) * 1000);
+
+    can_publisher_channel_stats_t stats[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+    size_t count = can_publisher_get_channel_stats(stats, CAN_PUBLISHER_MAX_BUFFER_SLOTS);
+    TEST_ASSERT_TRUE(alarm_index < count);
+    TEST_ASSERT_TRUE(stats[alarm_index].change_latency_count >= 1U);
+
+    can_publisher_deinit();
+    static const char immediate[] = "{\"can\":{\"publisher\":{\"period_ms\":0}}}";
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_set_config_json(immediate, sizeof(immediate) - 1U));
+}
+
+// Stand-in for the CAN driver: one TX mutex taken per publisher call and a
+// fixed cost per frame queued, as can_victron_publish_frame(s) do on target.
+static SemaphoreHandle_t s_bench_tx_mutex = NULL;
+static uint32_t s_bench_lock_acquisitions = 0;
+static uint64_t s_bench_lock_hold_us = 0;
+
+static void bench_queue_frame(void)
+{
+    int64_t until = esp_timer_get_time() + CAN_DISPATCH_BENCH_TX_US;
+    while (esp_timer_get_time() < until) {
+    }
+}
+
+static esp_err_t bench_frame_stub(uint32_t can_id, const uint8_t *data, size_t length, const char *description)
+{
+    (void)can_id;
+    (void)data;
+    (void)length;
+    (void)description;
+    xSemaphoreTake(s_bench_tx_mutex, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    bench_queue_frame();
+    s_bench_lock_hold_us += (uint64_t)(esp_timer_get_time() - start_us);
+    ++s_bench_lock_acquisitions;
+    xSemaphoreGive(s_bench_tx_mutex);
+    return ESP_OK;
+}
+
+static esp_err_t bench_batch_stub(const can_victron_tx_frame_t *frames, size_t count, size_t *out_sent)
+{
+    (void)frames;
+    xSemaphoreTake(s_bench_tx_mutex, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < count; ++i) {
+        bench_queue_frame();
+    }
+    s_bench_lock_hold_us += (uint64_t)(esp_timer_get_time() - start_us);
+    ++s_bench_lock_acquisitions;
+    xSemaphoreGive(s_bench_tx_mutex);
+    *out_sent = count;
+    return ESP_OK;
+}
+
+static bool bench_event_stub(const event_bus_event_t *event, TickType_t timeout)
+{
+    (void)timeout;
+    if (event->dispose != NULL) {
+        event->dispose(event->dispose_context);
+    }
+    return true;
+}
+
+typedef struct {
+    can_publisher_dispatch_stats_t dispatch;
+    uint32_t lock_acquisitions;
+    uint64_t lock_hold_us;
+} bench_dispatch_result_t;
+
+static void bench_run_scheduler(bool batched, const uint8_t *frame, size_t frame_len, bench_dispatch_result_t *out)
+{
+    s_bench_lock_acquisitions = 0;
+    s_bench_lock_hold_us = 0;
+
+    can_publisher_set_batch_publisher(batched ? bench_batch_stub : NULL);
+    can_publisher_init(bench_event_stub, bench_frame_stub);
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_process_frame(frame, frame_len));
+    vTaskDelay(pdMS_TO_TICKS(CAN_DISPATCH_BENCH_RUN_MS));
+
+    can_publisher_get_dispatch_stats(&out->dispatch);
+    xSemaphoreTake(s_bench_tx_mutex, portMAX_DELAY);
+    out->lock_acquisitions = s_bench_lock_acquisitions;
+    out->lock_hold_us = s_bench_lock_hold_us;
+    xSemaphoreGive(s_bench_tx_mutex);
+    can_publisher_deinit();
+
+    TEST_ASSERT_NOT_EQUAL(0U, out->dispatch.frames);
+    printf("%s dispatch: %u frames in %u passes, %u driver calls, %" PRIu64 " us dispatch (%" PRIu64
+           " us/frame), lock held %" PRIu64 " us over %u acquisitions\n",
+           batched ? "batched" : "per-frame",
+           (unsigned)out->dispatch.frames,
+           (unsigned)out->dispatch.passes,
+           (unsigned)out->dispatch.publisher_calls,
+           out->dispatch.total_dispatch_us,
+           out->dispatch.total_dispatch_us / out->dispatch.frames,
+           out->lock_hold_us,
+           (unsigned)out->lock_acquisitions);
+}
+
+// Same channel catalogue and sample, per-frame then batched: channels sharing a
+// period must leave together, so the batched run takes the TX lock once per
+// period class instead of once per frame.
+TEST_CASE("can_publisher_batch_dispatch_benchmark", "[can][perf]")
+{
+    uint8_t raw_frame[160];
+    size_t frame_len = build_uart_test_frame(raw_frame, sizeof(raw_frame));
+    TEST_ASSERT_NOT_EQUAL(0U, frame_len);
+
+    if (s_bench_tx_mutex == NULL) {
+        s_bench_tx_mutex = xSemaphoreCreateMutex();
+    }
+    TEST_ASSERT_NOT_NULL(s_bench_tx_mutex);
+
+    config_manager_init();
+    static const char periodic[] = "{\"can\":{\"publisher\":{\"period_ms\":1000}}}";
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_set_config_json(periodic, sizeof(periodic) - 1U));
+
+    bench_dispatch_result_t per_frame = {0};
+    bench_dispatch_result_t batched = {0};
+    bench_run_scheduler(false, raw_frame, frame_len, &per_frame);
+    bench_run_scheduler(true, raw_frame, frame_len, &batched);
+
+    static const char immediate[] = "{\"can\":{\"publisher\":{\"period_ms\":0}}}";
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_set_config_json(immediate, sizeof(immediate) - 1U));
+
+    // One driver call, hence one lock acquisition, per frame without batching
+    TEST_ASSERT_EQUAL_UINT32(per_frame.dispatch.frames, per_frame.dispatch.publisher_calls);
+    TEST_ASSERT_EQUAL_UINT32(per_frame.dispatch.frames, per_frame.lock_acquisitions);
+
+    // Batched: a call carries a whole period class (out-of-band changes
+    // still go one frame per call)
+    TEST_ASSERT_EQUAL_UINT32(batched.dispatch.publisher_calls, batched.lock_acquisitions);
+    TEST_ASSERT_TRUE(batched.dispatch.frames > 2U * batched.dispatch.publisher_calls);
+
+    // Per frame sent, the lock is taken far less often and dispatch costs less
+    uint64_t per_frame_us = per_frame.dispatch.total_dispatch_us / per_frame.dispatch.frames;
+    uint64_t batched_us = batched.dispatch.total_dispatch_us / batched.dispatch.frames;
+    TEST_ASSERT_TRUE((uint64_t)batched.lock_acquisitions * per_frame.dispatch.frames <
+                     (uint64_t)per_frame.lock_acquisitions * batched.dispatch.frames);
+    TEST_ASSERT_TRUE(batched_us <= per_frame_us);
+}
@@ -2,6 +2,8 @@
 
 #include "app_events.h"
 #include "can_victron.h"
+#include "can_victron_capture.h"
+#include "can_victron_occupancy.h"
 #include "event_bus.h"
 
 #include <string.h>
@@ -17,7 +19,13 @@ static size_t s_event_count = 0;
 static bool capture_event(const event_bus_event_t *event, TickType_t timeout)
 {
     (void)timeout;
-    if (event == NULL || s_event_count >= (sizeof(s_events) / sizeof(s_events[0]))) {
+    if (event == NULL) {
+        return false;
+    }
+    if (s_event_count >= (sizeof(s_events) / sizeof(s_events[0]))) {
+        if (event->dispose != NULL) {
+            event->dispose(event->dispose_context);
+        }
         return false;
     }
 
@@ -34,6 +42,10 @@ static bool capture_event(const event_bus_event_t *event, TickType_t timeout)
     }
     slot->payload[length] = '\0';
 
+    // Stands in for the bus, which owns payloads carrying a dispose callback
+    if (event->dispose != NULL) {
+        event->dispose(event->dispose_context);
+    }
     s_event_count++;
     return true;
 }
@@ -72,3 +84,97 @@ TEST_CASE("can_victron_publish_frame exposes timestamp fields", "[can][victron]"
 
     can_victron_set_event_publisher(NULL);
 }
+
+TEST_CASE("can_victron_publish_frames emits one batch event", "[can][victron]")
+{
+    memset(s_events, 0, sizeof(s_events));
+    s_event_count = 0;
+
+    can_victron_set_event_publisher(capture_event);
+
+    const can_victron_tx_frame_t frames[2] = {
+        {.can_id = 0x351U, .length = 2U, .data = {0xAB, 0xCD}, .description = NULL},
+        {.can_id = 0x35AU, .length = 1U, .data = {0x01}, .description = NULL},
+    };
+    size_t sent = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, can_victron_publish_frames(frames, 2U, &sent));
+    TEST_ASSERT_EQUAL_UINT32(2U, (uint32_t)sent);
+
+    TEST_ASSERT_EQUAL_UINT32(1U, (uint32_t)s_event_count);
+    TEST_ASSERT_EQUAL(APP_EVENT_ID_CAN_FRAME_BATCH, s_events[0].id);
+    TEST_ASSERT_NOT_EQUAL(0, strstr(s_events[0].payload, "\"type\":\"can_batch\""));
+    TEST_ASSERT_NOT_EQUAL(0, strstr(s_events[0].payload, "\"id\":\"00000351\",\"dlc\":2,\"data\":\"ABCD\""));
+    TEST_ASSERT_NOT_EQUAL(0, strstr(s_events[0].payload, "\"id\":\"0000035A\",\"dlc\":1,\"data\":\"01\""));
+
+    const can_victron_tx_frame_t invalid = {.can_id = 0x800U, .length = 0U};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, can_victron_publish_frames(&invalid, 1U, &sent));
+    TEST_ASSERT_EQUAL_UINT32(0U, (uint32_t)sent);
+
+    can_victron_set_event_publisher(NULL);
+}
+
+TEST_CASE("can_victron capture ring exports candump lines", "[can][victron][capture]")
+{
+    can_victron_capture_clear();
+
+    const uint8_t data[3] = {0x0A, 0xB0, 0xFF};
+    TEST_ASSERT_EQUAL(ESP_OK, can_victron_publish_frame(0x356U, data, sizeof(data), NULL));
+    can_victron_capture_record(true, 0x305U, NULL, 0U, true, 61234U);
+
+    can_victron_capture_record_t records[4];
+    TEST_ASSERT_EQUAL_UINT32(2U, (uint32_t)can_victron_capture_snapshot(records, 4U));
+    TEST_ASSERT_EQUAL_HEX16(0x356U, records[0].can_id);
+    TEST_ASSERT_EQUAL_UINT8(0U, records[0].flags & CAN_VICTRON_CAPTURE_FLAG_RX);
+    TEST_ASSERT_EQUAL_UINT8(3U, records[0].dlc);
+
+    char line[CAN_VICTRON_CAPTURE_CANDUMP_LINE_MAX];
+    size_t length = can_victron_capture_format_candump(&records[0], "can0", line, sizeof(line));
+    TEST_ASSERT_TRUE(length > 0U);
+    TEST_ASSERT_NOT_EQUAL(0, strstr(line, ") can0 356#0AB0FF\n"));
+
+    length = can_victron_capture_format_candump(&records[1], "can0", line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("(61.234000) can0 305#R\n", line);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)strlen(line), (uint32_t)length);
+
+    can_victron_capture_stats_t stats;
+    can_victron_capture_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.recorded);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.available);
+}
+
+TEST_CASE("can_victron occupancy wheel keeps exact 1/10/60 s windows", "[can][victron][occupancy]")
+{
+    static can_victron_occupancy_wheel_t wheel;
+    can_victron_occupancy_reset(&wheel);
+
+    // 70 s of traffic: second n carries n frames of 100 bits
+    for (uint32_t second = 0; second < 70U; ++second) {
+        for (uint32_t frame = 0; frame < second; ++frame) {
+            can_victron_occupancy_add(&wheel, 1000000ULL + second * 1000ULL + frame, 100U);
+        }
+    }
+    can_victron_occupancy_advance(&wheel, 1000000ULL + 70000ULL);
+
+    can_victron_occupancy_window_t window;
+    can_victron_occupancy_get(&wheel, 1U, 500000U, &window);
+    TEST_ASSERT_EQUAL_UINT32(1U, window.window_s);
+    TEST_ASSERT_EQUAL_FLOAT(69.0f, window.frames_per_s);
+
+    // Seconds 60..69 hold 645 frames
+    can_victron_occupancy_get(&wheel, 10U, 500000U, &window);
+    TEST_ASSERT_EQUAL_FLOAT(64.5f, window.frames_per_s);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 64500.0f / 5000000.0f * 100.0f, window.occupancy_pct);
+
+    // Seconds 10..69 hold 2370 frames
+    can_victron_occupancy_get(&wheel, 60U, 500000U, &window);
+    TEST_ASSERT_EQUAL_UINT32(60U, window.window_s);
+    TEST_ASSERT_EQUAL_FLOAT(39.5f, window.frames_per_s);
+
+    // Idle time drains the windows
+    can_victron_occupancy_advance(&wheel, 1000000ULL + 75000ULL);
+    can_victron_occupancy_get(&wheel, 1U, 500000U, &window);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.frames_per_s);
+    can_victron_occupancy_advance(&wheel, 1000000ULL + 200000ULL);
+    can_victron_occupancy_get(&wheel, 60U, 500000U, &window);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.occupancy_pct);
+}
@@ -102,6 +102,47 @@ TEST_CASE("queue full causes publish failure", "[event_bus]")
     event_bus_deinit();
 }
 
+static unsigned s_dispose_count = 0;
+
+static void test_dispose(void *context)
+{
+    (void)context;
+    s_dispose_count++;
+}
+
+TEST_CASE("publish disposes the payload once on every outcome", "[event_bus]")
+{
+    const event_bus_event_t event = {
+        .id = 4,
+        .payload = "owned",
+        .payload_size = 6,
+        .dispose = test_dispose,
+    };
+
+    // Bus not initialised: nobody received it
+    event_bus_deinit();
+    s_dispose_count = 0;
+    TEST_ASSERT_FALSE(event_bus_publish(&event, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, s_dispose_count);
+
+    // Queue full: only the delivered copy holds it
+    event_bus_init();
+    event_bus_subscription_handle_t subscriber = event_bus_subscribe(1, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(subscriber);
+    s_dispose_count = 0;
+    TEST_ASSERT_TRUE(event_bus_publish(&event, 0));
+    TEST_ASSERT_FALSE(event_bus_publish(&event, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, s_dispose_count);
+
+    event_bus_event_t received = {0};
+    TEST_ASSERT_TRUE(event_bus_receive(subscriber, &received, pdMS_TO_TICKS(10)));
+    event_bus_release(&received);
+    TEST_ASSERT_EQUAL_UINT32(2, s_dispose_count);
+
+    event_bus_unsubscribe(subscriber);
+    event_bus_deinit();
+}
+
 TEST_CASE("unsubscribe stops further deliveries", "[event_bus]")
 {
     reset_bus();
@@ -0,0 +1,106 @@
+#include "unity.h"
+
+#include "json_writer.h"
+
+#include <string.h>
+
+#include "cJSON.h"
+
+typedef struct {
+    char output[512];
+    size_t length;
+    size_t chunks;
+    size_t largest_chunk;
+} json_writer_sink_t;
+
+static esp_err_t json_writer_test_flush(void *context, const char *data, size_t length)
+{
+    json_writer_sink_t *sink = (json_writer_sink_t *)context;
+    if (sink->length + length >= sizeof(sink->output)) {
+        return ESP_FAIL;
+    }
+    memcpy(sink->output + sink->length, data, length);
+    sink->length += length;
+    sink->output[sink->length] = '\0';
+    sink->chunks++;
+    if (length > sink->largest_chunk) {
+        sink->largest_chunk = length;
+    }
+    return ESP_OK;
+}
+
+TEST_CASE("json_writer_buffer_mode_reports_overflow", "[serialization]")
+{
+    char buffer[16];
+    size_t length = 0;
+    json_writer_t writer;
+
+    json_writer_init(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(json_writer_printf(&writer, "{\"a\":%d}", 42));
+    TEST_ASSERT_EQUAL(ESP_OK, json_writer_finish(&writer, &length));
+    TEST_ASSERT_EQUAL_STRING("{\"a\":42}", buffer);
+    TEST_ASSERT_EQUAL_UINT32(8U, length);
+
+    // Without a flush callback, the buffer is the size limit
+    json_writer_init(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(json_writer_printf(&writer, "[1,2,3,4,5"));
+    TEST_ASSERT_FALSE(json_writer_printf(&writer, ",6,7,8,9]"));
+    TEST_ASSERT_FALSE(json_writer_ok(&writer));
+    TEST_ASSERT_FALSE(json_writer_printf(&writer, "]"));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, json_writer_finish(&writer, &length));
+}
+
+TEST_CASE("json_writer_streams_documents_larger_than_window", "[serialization]")
+{
+    json_writer_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    char window[32];
+    json_writer_t writer;
+
+    json_writer_init(&writer, window, sizeof(window), json_writer_test_flush, &sink);
+    json_writer_printf(&writer, "{\"values\":[");
+    for (int i = 0; i < 40; ++i) {
+        json_writer_printf(&writer, "%s%d", (i == 0) ? "" : ",", i * 1000);
+    }
+    json_writer_printf(&writer, "],\"note\":");
+    json_writer_string(&writer, "a long label that is longer than the window \"quoted\"\n");
+    json_writer_printf(&writer, "}");
+
+    size_t length = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, json_writer_finish(&writer, &length));
+    TEST_ASSERT_EQUAL_UINT32(sink.length, length);
+    TEST_ASSERT_TRUE(sink.chunks > 1U);
+    TEST_ASSERT_TRUE(sink.largest_chunk < sizeof(window));
+
+    cJSON *root = cJSON_Parse(sink.output);
+    TEST_ASSERT_NOT_NULL(root);
+    const cJSON *values = cJSON_GetObjectItem(root, "values");
+    TEST_ASSERT_EQUAL_INT(40, cJSON_GetArraySize(values));
+    TEST_ASSERT_EQUAL_INT(39000, cJSON_GetArrayItem(values, 39)->valueint);
+    TEST_ASSERT_EQUAL_STRING("a long label that is longer than the window \"quoted\"\n",
+                             cJSON_GetObjectItem(root, "note")->valuestring);
+    cJSON_Delete(root);
+}
+
+TEST_CASE("json_writer_escapes_strings_and_keeps_flush_errors", "[serialization]")
+{
+    char buffer[64];
+    json_writer_t writer;
+
+    json_writer_init(&writer, buffer, sizeof(buffer), NULL, NULL);
+    json_writer_string(&writer, "tab\tback\\slash\x01");
+    json_writer_printf(&writer, ",");
+    json_writer_string(&writer, NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, json_writer_finish(&writer, NULL));
+    TEST_ASSERT_EQUAL_STRING("\"tab\\tback\\\\slash\\u0001\",null", buffer);
+
+    // A failing sink stops the document and its error is reported
+    json_writer_sink_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.length = sizeof(sink.output) - 1U;
+    char window[16];
+    json_writer_init(&writer, window, sizeof(window), json_writer_test_flush, &sink);
+    json_writer_printf(&writer, "[\"0123456789\"");
+    TEST_ASSERT_FALSE(json_writer_printf(&writer, ",\"0123456789\"]"));
+    TEST_ASSERT_EQUAL(ESP_FAIL, json_writer_finish(&writer, NULL));
+}
@@ -6,6 +6,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 static size_t count_json_array_entries(const char *array_token)
@@ -100,3 +101,84 @@ TEST_CASE("monitoring_publishes_diagnostics_snapshot", "[monitoring]")
 
     monitoring_set_event_publisher(NULL);
 }
+
+static event_bus_event_t s_held_telemetry = {0};
+
+// Keeps the telemetry event like a subscriber that has not released it yet
+static bool monitoring_test_hold_stub(const event_bus_event_t *event, TickType_t timeout)
+{
+    (void)timeout;
+
+    if (event == NULL) {
+        return false;
+    }
+    if (event->id == APP_EVENT_ID_TELEMETRY_SAMPLE) {
+        s_held_telemetry = *event;
+    }
+    return true;
+}
+
+TEST_CASE("monitoring_telemetry_snapshot_is_wrapped_and_refcounted", "[monitoring]")
+{
+    monitoring_init();
+    memset(&s_held_telemetry, 0, sizeof(s_held_telemetry));
+    monitoring_set_event_publisher(monitoring_test_hold_stub);
+
+    TEST_ASSERT_EQUAL(ESP_OK, monitoring_publish_telemetry_snapshot());
+    TEST_ASSERT_EQUAL(APP_EVENT_ID_TELEMETRY_SAMPLE, s_held_telemetry.id);
+    TEST_ASSERT_NOT_NULL(s_held_telemetry.dispose);
+
+    // The payload is the raw snapshot, inside its {"battery":...} form
+    const char *body = (const char *)s_held_telemetry.payload;
+    size_t body_length = s_held_telemetry.payload_size;
+    TEST_ASSERT_NOT_NULL(body);
+    TEST_ASSERT_EQUAL('{', body[0]);
+    TEST_ASSERT_EQUAL('}', body[body_length - 1U]);
+
+    // The buffer handle travels as the dispose context, not behind the payload
+    monitoring_snapshot_t *snapshot = monitoring_snapshot_from_event(&s_held_telemetry);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_EQUAL_PTR(s_held_telemetry.dispose_context, snapshot);
+
+    size_t wrapped_length = 0;
+    const char *wrapped = monitoring_snapshot_wrapped(snapshot, &wrapped_length);
+    TEST_ASSERT_NOT_NULL(wrapped);
+    TEST_ASSERT_EQUAL_UINT32(MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH + body_length + 1U, wrapped_length);
+    TEST_ASSERT_EQUAL_UINT32(wrapped_length, strlen(wrapped));
+    TEST_ASSERT_EQUAL_MEMORY(MONITORING_SNAPSHOT_WRAP_PREFIX, wrapped, MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH);
+    TEST_ASSERT_EQUAL_PTR(wrapped + MONITORING_SNAPSHOT_WRAP_PREFIX_LENGTH, body);
+    TEST_ASSERT_EQUAL('}', wrapped[wrapped_length - 1U]);
+
+    // A WebSocket message holding its own reference outlives the event
+    TEST_ASSERT_TRUE(monitoring_snapshot_retain(snapshot));
+    s_held_telemetry.dispose(s_held_telemetry.dispose_context);
+    TEST_ASSERT_EQUAL_PTR(wrapped, monitoring_snapshot_wrapped(snapshot, NULL));
+    monitoring_snapshot_release(snapshot);
+
+    monitoring_set_event_publisher(NULL);
+    monitoring_deinit();
+}
+
+TEST_CASE("monitoring_snapshot_ignores_foreign_events", "[monitoring]")
+{
+    static char foreign[64];
+    memset(foreign, 0, sizeof(foreign));
+
+    // Same id but another owner, or another id: no handle is recovered
+    event_bus_event_t event = {
+        .id = APP_EVENT_ID_TELEMETRY_SAMPLE,
+        .payload = foreign,
+        .payload_size = sizeof(foreign),
+        .dispose = free,
+        .dispose_context = foreign,
+    };
+    TEST_ASSERT_NULL(monitoring_snapshot_from_event(&event));
+    event.id = APP_EVENT_ID_UI_NOTIFICATION;
+    event.dispose = monitoring_snapshot_release;
+    TEST_ASSERT_NULL(monitoring_snapshot_from_event(&event));
+    TEST_ASSERT_NULL(monitoring_snapshot_from_event(NULL));
+
+    TEST_ASSERT_NULL(monitoring_snapshot_wrapped(NULL, NULL));
+    TEST_ASSERT_FALSE(monitoring_snapshot_retain(NULL));
+    monitoring_snapshot_release(NULL);  // Ignored, nothing to free
+}
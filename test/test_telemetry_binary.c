@@ -0,0 +1,312 @@
+#include "unity.h"
+
+#include "telemetry_binary.h"
+#include "monitoring.h"
+#include "uart_bms.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cJSON.h"
+#include "esp_timer.h"
+
+#include "uart_test_vectors.h"
+
+#define TELEMETRY_COST_ITERATIONS 200U
+
+static uint64_t read_le(const uint8_t *data, size_t width)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value |= (uint64_t)data[i] << (8U * i);
+    }
+    return value;
+}
+
+static size_t wire_width(const char *type)
+{
+    if (strcmp(type, "u8") == 0) {
+        return 1U;
+    }
+    if (strcmp(type, "u16") == 0 || strcmp(type, "i16") == 0) {
+        return 2U;
+    }
+    if (strcmp(type, "u64") == 0) {
+        return 8U;
+    }
+    return 4U;
+}
+
+static double wire_value(const uint8_t *data, const char *type)
+{
+    uint64_t raw = read_le(data, wire_width(type));
+    if (strcmp(type, "i16") == 0) {
+        return (double)(int16_t)raw;
+    }
+    if (strcmp(type, "i32") == 0) {
+        return (double)(int32_t)raw;
+    }
+    return (double)raw;
+}
+
+// Decodes @p name from @p frame the way a client would: walking the schema
+static bool decode_field(const cJSON *schema, const uint8_t *frame, const char *name, double *out)
+{
+    size_t offset = 4U;
+    const cJSON *fields = cJSON_GetObjectItem(schema, "fields");
+    const cJSON *field = NULL;
+    cJSON_ArrayForEach(field, fields) {
+        const char *type = cJSON_GetObjectItem(field, "type")->valuestring;
+        if (strcmp(cJSON_GetObjectItem(field, "name")->valuestring, name) == 0) {
+            *out = wire_value(frame + offset, type) / cJSON_GetObjectItem(field, "scale")->valuedouble;
+            return true;
+        }
+        offset += wire_width(type);
+    }
+    return false;
+}
+
+TEST_CASE("telemetry_binary_schema_round_trip", "[telemetry][binary]")
+{
+    uart_bms_live_data_t data = {0};
+    data.timestamp_ms = 123456789ULL;
+    data.pack_voltage_v = 52.345f;
+    data.pack_current_a = -12.5f;
+    data.state_of_charge_pct = 87.25f;
+    data.average_temperature_c = -5.5f;
+    data.max_cell_mv = 3412U;
+    data.cycle_count = 321U;
+    data.firmware_version = 7U;
+    for (size_t i = 0; i < UART_BMS_CELL_COUNT; ++i) {
+        data.cell_voltage_mv[i] = (uint16_t)(3300U + i);
+    }
+    data.cell_balancing[0] = 1U;
+    data.cell_balancing[9] = 1U;
+    data.register_count = 2U;
+    data.registers[0].address = 0x0024U;
+    data.registers[0].raw_value = 5234U;
+    data.registers[1].address = 0x0030U;
+    data.registers[1].raw_value = 0xFFFFU;
+
+    telemetry_binary_extras_t extras = {
+        .power_w = -654.3f,
+        .energy_charged_wh = 1000U,
+        .is_charging = 0U,
+        .history_available = 1U,
+    };
+
+    uint8_t frame[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, &extras, frame, sizeof(frame), &length));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_BINARY_FRAME_SNAPSHOT, frame[0]);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_BINARY_VERSION, frame[1]);
+    TEST_ASSERT_EQUAL_UINT32(telemetry_binary_field_count(), read_le(&frame[2], 2));
+
+    char schema_text[TELEMETRY_BINARY_SCHEMA_MAX_SIZE];
+    size_t schema_length = 0;
+    TEST_ASSERT_TRUE(telemetry_binary_write_schema(schema_text, sizeof(schema_text), &schema_length));
+    cJSON *schema = cJSON_Parse(schema_text);
+    TEST_ASSERT_NOT_NULL(schema);
+    TEST_ASSERT_EQUAL_UINT32(telemetry_binary_field_count(),
+                             cJSON_GetArraySize(cJSON_GetObjectItem(schema, "fields")));
+
+    double value = 0.0;
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "timestamp_ms", &value));
+    TEST_ASSERT_EQUAL_DOUBLE(123456789.0, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "pack_voltage_v", &value));
+    TEST_ASSERT_DOUBLE_WITHIN(0.0005, 52.345, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "pack_current_a", &value));
+    TEST_ASSERT_DOUBLE_WITHIN(0.0005, -12.5, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "power_w", &value));
+    TEST_ASSERT_DOUBLE_WITHIN(0.05, -654.3, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "state_of_charge_pct", &value));
+    TEST_ASSERT_DOUBLE_WITHIN(0.005, 87.25, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "average_temperature_c", &value));
+    TEST_ASSERT_DOUBLE_WITHIN(0.005, -5.5, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "max_cell_mv", &value));
+    TEST_ASSERT_EQUAL_DOUBLE(3412.0, value);
+    TEST_ASSERT_TRUE(decode_field(schema, frame, "history_available", &value));
+    TEST_ASSERT_EQUAL_DOUBLE(1.0, value);
+
+    // Arrays follow the scalar block
+    size_t offset = 4U;
+    const cJSON *field = NULL;
+    cJSON_ArrayForEach(field, cJSON_GetObjectItem(schema, "fields")) {
+        offset += wire_width(cJSON_GetObjectItem(field, "type")->valuestring);
+    }
+    TEST_ASSERT_EQUAL_UINT8(UART_BMS_CELL_COUNT, frame[offset]);
+    offset += 1U;
+    TEST_ASSERT_EQUAL_UINT32(3300U, read_le(&frame[offset], 2));
+    TEST_ASSERT_EQUAL_UINT32(3315U, read_le(&frame[offset + 30U], 2));
+    offset += UART_BMS_CELL_COUNT * 2U;
+    TEST_ASSERT_EQUAL_HEX8(0x01, frame[offset]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, frame[offset + 1U]);
+    offset += (UART_BMS_CELL_COUNT + 7U) / 8U;
+    TEST_ASSERT_EQUAL_UINT32(2U, read_le(&frame[offset], 2));
+    TEST_ASSERT_EQUAL_UINT32(0x0024U, read_le(&frame[offset + 2U], 2));
+    TEST_ASSERT_EQUAL_UINT32(5234U, read_le(&frame[offset + 4U], 2));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFU, read_le(&frame[offset + 8U], 2));
+    TEST_ASSERT_EQUAL_UINT32(offset + 10U, length);
+
+    cJSON_Delete(schema);
+}
+
+TEST_CASE("telemetry_binary_rejects_short_buffer", "[telemetry][binary]")
+{
+    uart_bms_live_data_t data = {0};
+    data.register_count = UART_BMS_MAX_REGISTERS;
+
+    uint8_t frame[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    size_t length = 0;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, frame, sizeof(frame), &length));
+    TEST_ASSERT_FALSE(telemetry_binary_write_snapshot(&data, NULL, frame, length - 1U, NULL));
+}
+
+static void fill_delta_sample(uart_bms_live_data_t *data)
+{
+    memset(data, 0, sizeof(*data));
+    data->timestamp_ms = 1000U;
+    data->pack_voltage_v = 52.000f;
+    data->state_of_charge_pct = 80.0f;
+    for (size_t i = 0; i < UART_BMS_CELL_COUNT; ++i) {
+        data->cell_voltage_mv[i] = 3300U;
+    }
+    data->register_count = 1U;
+    data->registers[0].address = 0x0024U;
+    data->registers[0].raw_value = 5200U;
+}
+
+static bool delta_slot_set(const uint8_t *delta, size_t slot)
+{
+    return (delta[4U + slot / 8U] & (1U << (slot % 8U))) != 0U;
+}
+
+TEST_CASE("telemetry_binary_delta_sends_changes_beyond_deadband", "[telemetry][binary]")
+{
+    uart_bms_live_data_t data;
+    fill_delta_sample(&data);
+
+    uint8_t state[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    uint8_t current[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    uint8_t delta[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    size_t state_length = 0;
+    size_t current_length = 0;
+    size_t delta_length = 0;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, state, sizeof(state), &state_length));
+
+    // Jitter within the deadbands, plus the always-moving timestamp
+    data.timestamp_ms = 2000U;
+    data.pack_voltage_v = 52.010f;
+    data.cell_voltage_mv[3] = 3302U;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, current, sizeof(current), &current_length));
+    TEST_ASSERT_EQUAL(TELEMETRY_BINARY_DELTA_UNCHANGED,
+                      telemetry_binary_write_delta(state, state_length, current, current_length,
+                                                   delta, sizeof(delta), &delta_length));
+
+    data.timestamp_ms = 3000U;
+    data.state_of_charge_pct = 81.0f;
+    data.cell_voltage_mv[3] = 3305U;
+    data.registers[0].raw_value = 5210U;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, current, sizeof(current), &current_length));
+    TEST_ASSERT_EQUAL(TELEMETRY_BINARY_DELTA_WRITTEN,
+                      telemetry_binary_write_delta(state, state_length, current, current_length,
+                                                   delta, sizeof(delta), &delta_length));
+
+    size_t fields = telemetry_binary_field_count();
+    size_t slots = fields + UART_BMS_CELL_COUNT + 1U + 1U;
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_BINARY_FRAME_DELTA, delta[0]);
+    TEST_ASSERT_EQUAL_UINT32(slots, read_le(&delta[2], 2));
+    TEST_ASSERT_TRUE(delta_slot_set(delta, 0U));             // timestamp_ms rides along
+    TEST_ASSERT_FALSE(delta_slot_set(delta, 1U));            // pack_voltage_v still within 20 mV
+    TEST_ASSERT_TRUE(delta_slot_set(delta, 5U));             // state_of_charge_pct
+    TEST_ASSERT_TRUE(delta_slot_set(delta, fields + 3U));    // cell 3
+    TEST_ASSERT_FALSE(delta_slot_set(delta, fields + 4U));
+    TEST_ASSERT_TRUE(delta_slot_set(delta, slots - 1U));     // register value
+
+    size_t values = 4U + (slots + 7U) / 8U;
+    TEST_ASSERT_EQUAL_UINT32(values + 8U + 2U + 2U + 2U, delta_length);
+    TEST_ASSERT_EQUAL_UINT32(3000U, read_le(&delta[values], 8));
+    TEST_ASSERT_EQUAL_UINT32(8100U, read_le(&delta[values + 8U], 2));
+    TEST_ASSERT_EQUAL_UINT32(3305U, read_le(&delta[values + 10U], 2));
+    TEST_ASSERT_EQUAL_UINT32(5210U, read_le(&delta[values + 12U], 2));
+
+    // The state now holds what the client has: the voltage drift accumulates
+    // against the last sent value and eventually crosses the deadband
+    data.pack_voltage_v = 52.015f;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, current, sizeof(current), &current_length));
+    TEST_ASSERT_EQUAL(TELEMETRY_BINARY_DELTA_UNCHANGED,
+                      telemetry_binary_write_delta(state, state_length, current, current_length,
+                                                   delta, sizeof(delta), &delta_length));
+    data.pack_voltage_v = 52.025f;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, current, sizeof(current), &current_length));
+    TEST_ASSERT_EQUAL(TELEMETRY_BINARY_DELTA_WRITTEN,
+                      telemetry_binary_write_delta(state, state_length, current, current_length,
+                                                   delta, sizeof(delta), &delta_length));
+    TEST_ASSERT_TRUE(delta_slot_set(delta, 1U));
+}
+
+TEST_CASE("telemetry_binary_delta_requests_keyframe_on_layout_change", "[telemetry][binary]")
+{
+    uart_bms_live_data_t data;
+    fill_delta_sample(&data);
+
+    uint8_t state[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    uint8_t current[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    uint8_t delta[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    size_t state_length = 0;
+    size_t current_length = 0;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, state, sizeof(state), &state_length));
+
+    data.registers[0].address = 0x0030U;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, current, sizeof(current), &current_length));
+    TEST_ASSERT_EQUAL(TELEMETRY_BINARY_DELTA_KEYFRAME,
+                      telemetry_binary_write_delta(state, state_length, current, current_length,
+                                                   delta, sizeof(delta), NULL));
+
+    data.register_count = 2U;
+    TEST_ASSERT_TRUE(telemetry_binary_write_snapshot(&data, NULL, current, sizeof(current), &current_length));
+    TEST_ASSERT_EQUAL(TELEMETRY_BINARY_DELTA_KEYFRAME,
+                      telemetry_binary_write_delta(state, state_length, current, current_length,
+                                                   delta, sizeof(delta), NULL));
+}
+
+TEST_CASE("telemetry_binary_vs_json_cost", "[telemetry][binary][perf]")
+{
+    monitoring_init();
+
+    uint8_t raw[160];
+    size_t raw_length = build_uart_test_frame_from_values(kUartTestSampleValues, raw, sizeof(raw));
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_process_frame(raw, raw_length));
+
+    char json[MONITORING_SNAPSHOT_MAX_SIZE];
+    uint8_t packed[TELEMETRY_BINARY_SNAPSHOT_MAX_SIZE];
+    size_t json_length = 0;
+    size_t packed_length = 0;
+
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < TELEMETRY_COST_ITERATIONS; ++i) {
+        TEST_ASSERT_EQUAL(ESP_OK, monitoring_get_status_json(json, sizeof(json), &json_length));
+    }
+    int64_t json_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    for (size_t i = 0; i < TELEMETRY_COST_ITERATIONS; ++i) {
+        TEST_ASSERT_EQUAL(ESP_OK, monitoring_get_status_binary(packed, sizeof(packed), &packed_length));
+    }
+    int64_t binary_us = esp_timer_get_time() - start_us;
+
+    // The JSON path is additionally wrapped as {"battery":...} before sending
+    printf("telemetry push   bytes   us/encode\n");
+    printf("json          %7u  %10.1f\n",
+           (unsigned)(json_length + 12U),
+           (double)json_us / TELEMETRY_COST_ITERATIONS);
+    printf("binary        %7u  %10.1f\n",
+           (unsigned)packed_length,
+           (double)binary_us / TELEMETRY_COST_ITERATIONS);
+
+    TEST_ASSERT_TRUE(packed_length * 3U < json_length);
+    TEST_ASSERT_TRUE(binary_us < json_us);
+
+    monitoring_deinit();
+}
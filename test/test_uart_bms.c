@@ -42,6 +42,7 @@ TEST_CASE("uart_bms_process_frame publishes event and notifies listeners", "[uar
         event_bus_subscribe(2, NULL, NULL);
     TEST_ASSERT_NOT_NULL(subscriber);
 
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_listeners_init());
     TEST_ASSERT_EQUAL(ESP_OK, uart_bms_register_listener(test_listener, NULL));
 
     uint8_t frame[128] = {0};
@@ -125,3 +126,14 @@ TEST_CASE("uart_bms_process_frame rejects invalid crc", "[uart_bms]")
 
     TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, uart_bms_process_frame(frame, frame_len));
 }
+
+TEST_CASE("uart_bms_poll_index_matches_poll_addresses", "[uart_bms]")
+{
+    for (size_t i = 0; i < UART_BMS_REGISTER_WORD_COUNT; ++i) {
+        TEST_ASSERT_EQUAL_UINT32(i, uart_bms_protocol_poll_index(g_uart_bms_poll_addresses[i]));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(UART_BMS_POLL_INDEX_NONE, uart_bms_protocol_poll_index(0x0010));
+    TEST_ASSERT_EQUAL_UINT32(UART_BMS_POLL_INDEX_NONE, uart_bms_protocol_poll_index(0x0200));
+    TEST_ASSERT_EQUAL_UINT32(UART_BMS_POLL_INDEX_NONE, uart_bms_protocol_poll_index(0xFFFF));
+}
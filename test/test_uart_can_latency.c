@@ -0,0 +1,323 @@
+#include "unity.h"
+
+#include "can_publisher.h"
+#include "config_manager.h"
+#include "conversion_table.h"
+#include "uart_bms.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "uart_test_vectors.h"
+
+// End-to-end latency from a TinyBMS frame entering uart_bms_process_frame()
+// to each Victron frame being handed to the CAN driver (stubbed here), in
+// immediate and periodic publisher modes, and the ingest ceiling as the
+// offered poll rate increases. Runs on target only, in the Unity test app
+// (test/): the IDF linux target cannot build its dependencies.
+
+#define LATENCY_SAMPLE_CAPACITY 8192U
+#define LATENCY_STEP_DURATION_MS 500U
+#define LATENCY_PERIODIC_RUN_MS 6000U
+#define LATENCY_PERIODIC_PERIOD_MS 100U
+
+typedef struct {
+    uint32_t can_id;
+    bool pending;
+    int64_t arrival_us;
+    uint32_t delivered;
+    uint32_t coalesced;     // Newer sample arrived before this one was sent
+    uint64_t total_us;
+    uint32_t max_us;
+} latency_channel_t;
+
+typedef struct {
+    uint32_t offered_hz;    // 0 = unpaced
+    float achieved_hz;
+    uint32_t process_avg_us;
+    uint32_t process_max_us;
+    float cpu_pct;          // Share of wall time spent inside uart_bms_process_frame()
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t delivered;
+    uint32_t coalesced;
+} latency_step_t;
+
+static latency_channel_t s_channels[CAN_PUBLISHER_MAX_BUFFER_SLOTS];
+static size_t s_channel_count = 0;
+static uint32_t s_samples[LATENCY_SAMPLE_CAPACITY];
+static size_t s_sample_count = 0;
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void latency_reset(void)
+{
+    portENTER_CRITICAL(&s_latency_lock);
+    memset(s_channels, 0, sizeof(s_channels));
+    s_channel_count = 0;
+    for (size_t i = 0; i < g_can_publisher_channel_count && i < CAN_PUBLISHER_MAX_BUFFER_SLOTS; ++i) {
+        s_channels[i].can_id = g_can_publisher_channels[i].can_id;
+        s_channel_count++;
+    }
+    s_sample_count = 0;
+    portEXIT_CRITICAL(&s_latency_lock);
+}
+
+static void latency_mark_arrival(int64_t arrival_us)
+{
+    portENTER_CRITICAL(&s_latency_lock);
+    for (size_t i = 0; i < s_channel_count; ++i) {
+        if (s_channels[i].pending) {
+            s_channels[i].coalesced++;
+        }
+        s_channels[i].pending = true;
+        s_channels[i].arrival_us = arrival_us;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+}
+
+static esp_err_t latency_frame_stub(uint32_t can_id, const uint8_t *data, size_t length, const char *description)
+{
+    (void)data;
+    (void)length;
+    (void)description;
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_latency_lock);
+    for (size_t i = 0; i < s_channel_count; ++i) {
+        latency_channel_t *channel = &s_channels[i];
+        if (channel->can_id != can_id) {
+            continue;
+        }
+        if (channel->pending) {
+            uint32_t latency_us = (uint32_t)(now_us - channel->arrival_us);
+            channel->pending = false;
+            channel->delivered++;
+            channel->total_us += latency_us;
+            if (latency_us > channel->max_us) {
+                channel->max_us = latency_us;
+            }
+            if (s_sample_count < LATENCY_SAMPLE_CAPACITY) {
+                s_samples[s_sample_count++] = latency_us;
+            }
+        }
+        break;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+    return ESP_OK;
+}
+
+static int compare_u32(const void *lhs, const void *rhs)
+{
+    uint32_t a = *(const uint32_t *)lhs;
+    uint32_t b = *(const uint32_t *)rhs;
+    return (a > b) - (a < b);
+}
+
+// Recorded-trace stand-in: the reference frame with cell voltages drifting so
+// every sample changes the live PGNs.
+static size_t latency_build_frame(uint32_t sequence, uint8_t *frame, size_t frame_size)
+{
+    uint16_t values[UART_BMS_REGISTER_WORD_COUNT];
+    memcpy(values, kUartTestSampleValues, sizeof(values));
+    for (size_t i = 0; i < 16U; ++i) {
+        values[i] = (uint16_t)(values[i] + (sequence % 32U) * 10U);
+    }
+    return build_uart_test_frame_from_values(values, frame, frame_size);
+}
+
+static void latency_wait_until(int64_t deadline_us)
+{
+    int64_t remaining_us = deadline_us - esp_timer_get_time();
+    if (remaining_us <= 0) {
+        return;
+    }
+    TickType_t ticks = pdMS_TO_TICKS((uint32_t)(remaining_us / 1000));
+    vTaskDelay((ticks > 0) ? ticks : 1);
+}
+
+static void latency_run_step(bool periodic, uint32_t rate_hz, uint32_t duration_ms, latency_step_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->offered_hz = rate_hz;
+    latency_reset();
+
+    uint8_t frame[160];
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + (int64_t)duration_ms * 1000;
+    int64_t period_us = (rate_hz > 0U) ? (1000000 / (int64_t)rate_hz) : 0;
+    int64_t next_us = start_us;
+    uint64_t busy_us = 0;
+    uint32_t processed = 0;
+
+    while (esp_timer_get_time() < end_us) {
+        size_t length = latency_build_frame(processed, frame, sizeof(frame));
+        int64_t arrival_us = esp_timer_get_time();
+
+        // Immediate mode dispatches inside the call, so the channels must be
+        // pending before it. In periodic mode they are armed once the slots
+        // hold the new sample, so a send of the previous one is not counted.
+        if (!periodic) {
+            latency_mark_arrival(arrival_us);
+        }
+        TEST_ASSERT_EQUAL(ESP_OK, uart_bms_process_frame(frame, length));
+        if (periodic) {
+            latency_mark_arrival(arrival_us);
+        }
+
+        uint32_t spent_us = (uint32_t)(esp_timer_get_time() - arrival_us);
+        busy_us += spent_us;
+        if (spent_us > out->process_max_us) {
+            out->process_max_us = spent_us;
+        }
+        processed++;
+
+        if (period_us > 0) {
+            next_us += period_us;
+            latency_wait_until(next_us);
+        } else if (periodic) {
+            taskYIELD();
+        }
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    out->achieved_hz = (float)processed * 1000000.0f / (float)elapsed_us;
+    out->process_avg_us = (processed > 0U) ? (uint32_t)(busy_us / processed) : 0U;
+    out->cpu_pct = (float)busy_us * 100.0f / (float)elapsed_us;
+
+    portENTER_CRITICAL(&s_latency_lock);
+    size_t count = s_sample_count;
+    for (size_t i = 0; i < s_channel_count; ++i) {
+        out->delivered += s_channels[i].delivered;
+        out->coalesced += s_channels[i].coalesced;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+
+    if (count > 0U) {
+        qsort(s_samples, count, sizeof(s_samples[0]), compare_u32);
+        out->p50_us = s_samples[count / 2U];
+        out->p99_us = s_samples[(count * 99U) / 100U];
+        out->max_us = s_samples[count - 1U];
+    }
+}
+
+static void latency_print_step(const char *mode, const latency_step_t *step)
+{
+    char offered[12];
+    if (step->offered_hz > 0U) {
+        snprintf(offered, sizeof(offered), "%u", (unsigned)step->offered_hz);
+    } else {
+        snprintf(offered, sizeof(offered), "max");
+    }
+    printf("%-9s %6s Hz -> %8.1f Hz  process avg %5u us max %6u us  cpu %5.1f%%  "
+           "latency p50 %7u p99 %7u max %7u us  frames %6u coalesced %6u\n",
+           mode,
+           offered,
+           (double)step->achieved_hz,
+           (unsigned)step->process_avg_us,
+           (unsigned)step->process_max_us,
+           (double)step->cpu_pct,
+           (unsigned)step->p50_us,
+           (unsigned)step->p99_us,
+           (unsigned)step->max_us,
+           (unsigned)step->delivered,
+           (unsigned)step->coalesced);
+}
+
+static void latency_set_publisher_period(uint32_t period_ms)
+{
+    char payload[64];
+    int written = snprintf(payload, sizeof(payload), "{\"can\":{\"publisher\":{\"period_ms\":%u}}}", (unsigned)period_ms);
+    TEST_ASSERT_TRUE(written > 0 && (size_t)written < sizeof(payload));
+    TEST_ASSERT_EQUAL(ESP_OK, config_manager_set_config_json(payload, (size_t)written));
+}
+
+static uint32_t s_saved_period_ms = 0U;
+
+static void latency_setup(uint32_t period_ms)
+{
+    config_manager_init();
+    TEST_ASSERT_EQUAL(ESP_OK, uart_bms_listeners_init());
+
+    // Conserver la période configurée pour ne pas la laisser aux tests suivants
+    const config_manager_can_settings_t *settings = config_manager_get_can_settings();
+    TEST_ASSERT_NOT_NULL(settings);
+    s_saved_period_ms = settings->publisher.period_ms;
+
+    latency_set_publisher_period(period_ms);
+    can_publisher_init(NULL, latency_frame_stub);
+}
+
+static void latency_teardown(void)
+{
+    can_publisher_deinit();
+    latency_set_publisher_period(s_saved_period_ms);
+}
+
+static const uint32_t s_latency_rates_hz[] = {10U, 50U, 100U, 200U, 500U, 1000U, 0U};
+
+TEST_CASE("uart_to_can_latency_immediate_mode", "[can][perf][latency]")
+{
+    latency_setup(0U);
+
+    latency_step_t ceiling = {0};
+    for (size_t i = 0; i < sizeof(s_latency_rates_hz) / sizeof(s_latency_rates_hz[0]); ++i) {
+        latency_step_t step;
+        latency_run_step(false, s_latency_rates_hz[i], LATENCY_STEP_DURATION_MS, &step);
+        latency_print_step("immediate", &step);
+
+        if (s_latency_rates_hz[i] == 10U) {
+            TEST_ASSERT_TRUE(step.achieved_hz >= 8.0f);
+            for (size_t c = 0; c < s_channel_count; ++c) {
+                TEST_ASSERT_TRUE_MESSAGE(s_channels[c].delivered > 0U, "channel never dispatched");
+            }
+        }
+        if (s_latency_rates_hz[i] == 0U) {
+            ceiling = step;
+        }
+    }
+    printf("immediate ingest ceiling: %.0f frames/s (%u us per frame incl. %u CAN frames)\n",
+           (double)ceiling.achieved_hz,
+           (unsigned)ceiling.process_avg_us,
+           (unsigned)s_channel_count);
+
+    latency_teardown();
+}
+
+TEST_CASE("uart_to_can_latency_periodic_mode", "[can][perf][latency]")
+{
+    latency_setup(LATENCY_PERIODIC_PERIOD_MS);
+
+    // Long enough for the 5 s identity channels to be sent at least once
+    latency_step_t step;
+    latency_run_step(true, 10U, LATENCY_PERIODIC_RUN_MS, &step);
+    latency_print_step("periodic", &step);
+
+    printf("  PGN     frames  avg us    max us  coalesced\n");
+    for (size_t c = 0; c < s_channel_count; ++c) {
+        const latency_channel_t *channel = &s_channels[c];
+        uint32_t avg_us = (channel->delivered > 0U) ? (uint32_t)(channel->total_us / channel->delivered) : 0U;
+        printf("  0x%03" PRIX32 "  %6u  %7u  %8u  %9u\n",
+               channel->can_id,
+               (unsigned)channel->delivered,
+               (unsigned)avg_us,
+               (unsigned)channel->max_us,
+               (unsigned)channel->coalesced);
+        if (g_can_publisher_channels[c].period_ms <= 2000U) {
+            TEST_ASSERT_TRUE_MESSAGE(channel->delivered > 0U, "periodic channel never dispatched");
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(s_latency_rates_hz) / sizeof(s_latency_rates_hz[0]); ++i) {
+        latency_run_step(true, s_latency_rates_hz[i], LATENCY_STEP_DURATION_MS, &step);
+        latency_print_step("periodic", &step);
+    }
+
+    latency_teardown();
+}
@@ -0,0 +1,129 @@
+#include "unity.h"
+
+#include "web_server_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned s_render_count = 0;
+static esp_err_t s_render_result = ESP_OK;
+
+static esp_err_t web_server_cache_test_render(char *buffer, size_t buffer_size, size_t *out_length)
+{
+    if (s_render_result != ESP_OK) {
+        return s_render_result;
+    }
+    s_render_count++;
+    int written = snprintf(buffer, buffer_size, "{\"render\":%u}", s_render_count);
+    *out_length = (size_t)written;
+    return ESP_OK;
+}
+
+TEST_CASE("web_server_cache_renders_once_per_generation", "[web_server][cache]")
+{
+    char storage[64];
+    web_server_cache_entry_t entry;
+    web_server_cache_init(&entry, "status", storage, sizeof(storage));
+    s_render_count = 0;
+    s_render_result = ESP_OK;
+
+    bool hit = true;
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 7U, 0U, web_server_cache_test_render, &hit));
+    TEST_ASSERT_FALSE(hit);
+    for (int i = 0; i < 4; ++i) {
+        TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 7U, 0U, web_server_cache_test_render, &hit));
+        TEST_ASSERT_TRUE(hit);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1U, s_render_count);
+    TEST_ASSERT_EQUAL_STRING("{\"render\":1}", entry.body);
+    TEST_ASSERT_EQUAL_UINT32(strlen(entry.body), entry.length);
+
+    // A new sample or configuration update re-renders
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 8U, 0U, web_server_cache_test_render, &hit));
+    TEST_ASSERT_FALSE(hit);
+    TEST_ASSERT_EQUAL_STRING("{\"render\":2}", entry.body);
+
+    TEST_ASSERT_EQUAL_UINT32(4U, entry.hits);
+    TEST_ASSERT_EQUAL_UINT32(2U, entry.misses);
+    TEST_ASSERT_TRUE(web_server_cache_hit_rate(&entry) > 66.0f);
+    TEST_ASSERT_TRUE(web_server_cache_hit_rate(&entry) < 67.0f);
+
+    web_server_cache_invalidate(&entry);
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 8U, 0U, web_server_cache_test_render, &hit));
+    TEST_ASSERT_FALSE(hit);
+    TEST_ASSERT_EQUAL_UINT32(3U, s_render_count);
+}
+
+TEST_CASE("web_server_cache_etag_follows_generation", "[web_server][cache]")
+{
+    char storage[64];
+    char first[WEB_SERVER_CACHE_ETAG_MAX];
+    char second[WEB_SERVER_CACHE_ETAG_MAX];
+    web_server_cache_entry_t entry;
+    web_server_cache_init(&entry, "config", storage, sizeof(storage));
+    s_render_result = ESP_OK;
+
+    // No tag until something is cached
+    TEST_ASSERT_FALSE(web_server_cache_format_etag(&entry, 0x1a2b3c4dU, first, sizeof(first)));
+
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 42U, 0U, web_server_cache_test_render, NULL));
+    TEST_ASSERT_TRUE(web_server_cache_format_etag(&entry, 0x1a2b3c4dU, first, sizeof(first)));
+    TEST_ASSERT_EQUAL_STRING("\"config-1a2b3c4d-42-1\"", first);
+
+    // Another boot restarts generations but not the epoch
+    TEST_ASSERT_TRUE(web_server_cache_format_etag(&entry, 0x00000001U, second, sizeof(second)));
+    TEST_ASSERT_TRUE(strcmp(first, second) != 0);
+
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 43U, 0U, web_server_cache_test_render, NULL));
+    TEST_ASSERT_TRUE(web_server_cache_format_etag(&entry, 0x1a2b3c4dU, second, sizeof(second)));
+    TEST_ASSERT_TRUE(strcmp(first, second) != 0);
+}
+
+TEST_CASE("web_server_cache_drops_failed_renders", "[web_server][cache]")
+{
+    char storage[8];
+    web_server_cache_entry_t entry;
+    web_server_cache_init(&entry, "status", storage, sizeof(storage));
+
+    s_render_result = ESP_ERR_TIMEOUT;
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, web_server_cache_refresh(&entry, 1U, 0U, web_server_cache_test_render, NULL));
+    TEST_ASSERT_FALSE(entry.valid);
+
+    // Rendering "{"render":N}" into 8 bytes overflows
+    s_render_result = ESP_OK;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE,
+                      web_server_cache_refresh(&entry, 1U, 0U, web_server_cache_test_render, NULL));
+    TEST_ASSERT_FALSE(entry.valid);
+    TEST_ASSERT_EQUAL_UINT32(2U, entry.misses);
+    TEST_ASSERT_EQUAL_UINT32(0U, entry.hits);
+}
+
+TEST_CASE("web_server_cache_max_age_rerenders_same_generation", "[web_server][cache]")
+{
+    char storage[64];
+    char first[WEB_SERVER_CACHE_ETAG_MAX];
+    char second[WEB_SERVER_CACHE_ETAG_MAX];
+    web_server_cache_entry_t entry;
+    web_server_cache_init(&entry, "status", storage, sizeof(storage));
+    web_server_cache_set_max_age(&entry, 1000U);
+    s_render_count = 0;
+    s_render_result = ESP_OK;
+
+    bool hit = false;
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 5U, 10000U, web_server_cache_test_render, &hit));
+    TEST_ASSERT_FALSE(hit);
+    TEST_ASSERT_TRUE(web_server_cache_format_etag(&entry, 1U, first, sizeof(first)));
+
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 5U, 10999U, web_server_cache_test_render, &hit));
+    TEST_ASSERT_TRUE(hit);
+
+    // The BMS went silent: same generation, but the body must not freeze
+    TEST_ASSERT_EQUAL(ESP_OK, web_server_cache_refresh(&entry, 5U, 11000U, web_server_cache_test_render, &hit));
+    TEST_ASSERT_FALSE(hit);
+    TEST_ASSERT_EQUAL_UINT32(2U, s_render_count);
+    TEST_ASSERT_EQUAL_STRING("{\"render\":2}", entry.body);
+
+    // ... and a client holding the previous tag gets the new body, not a 304
+    TEST_ASSERT_TRUE(web_server_cache_format_etag(&entry, 1U, second, sizeof(second)));
+    TEST_ASSERT_TRUE(strcmp(first, second) != 0);
+}
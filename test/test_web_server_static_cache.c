@@ -0,0 +1,96 @@
+#include "unity.h"
+
+#include "web_server_internal.h"
+
+#include <string.h>
+
+TEST_CASE("web_server_static_if_none_match", "[web_server][static]")
+{
+    TEST_ASSERT_TRUE(web_server_static_etag_matches("\"9f86d081884c7d65\"", "\"9f86d081884c7d65\""));
+    TEST_ASSERT_TRUE(web_server_static_etag_matches("W/\"9f86d081884c7d65\"", "\"9f86d081884c7d65\""));
+    TEST_ASSERT_TRUE(web_server_static_etag_matches("\"0000\", \"9f86d081884c7d65\"", "\"9f86d081884c7d65\""));
+    TEST_ASSERT_TRUE(web_server_static_etag_matches("*", "\"9f86d081884c7d65\""));
+
+    // The gzip and identity representations carry distinct strong tags
+    TEST_ASSERT_FALSE(web_server_static_etag_matches("\"9f86d081884c7d65-gz\"", "\"9f86d081884c7d65\""));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches("\"9f86d081884c7d65\"", "\"9f86d081884c7d65-gz\""));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches("\"9f86d081\"", "\"9f86d081884c7d65\""));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches("", "\"9f86d081884c7d65\""));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches(NULL, "\"9f86d081884c7d65\""));
+}
+
+TEST_CASE("web_server_static_accept_encoding", "[web_server][static]")
+{
+    TEST_ASSERT_TRUE(web_server_static_accepts_gzip("gzip, deflate, br"));
+    TEST_ASSERT_TRUE(web_server_static_accepts_gzip("br;q=0, gzip"));
+    TEST_ASSERT_TRUE(web_server_static_accepts_gzip("gzip;q=0.5"));
+    TEST_ASSERT_TRUE(web_server_static_accepts_gzip("*"));
+
+    TEST_ASSERT_FALSE(web_server_static_accepts_gzip("deflate, br"));
+    TEST_ASSERT_FALSE(web_server_static_accepts_gzip("gzip;q=0"));
+    TEST_ASSERT_FALSE(web_server_static_accepts_gzip("gzip;q=0.000"));
+    TEST_ASSERT_FALSE(web_server_static_accepts_gzip("identity;q=1, *;q=0"));
+    TEST_ASSERT_FALSE(web_server_static_accepts_gzip("x-gzip"));
+    TEST_ASSERT_FALSE(web_server_static_accepts_gzip(NULL));
+}
+
+TEST_CASE("web_server_static_override_gets_its_own_etag", "[web_server][static]")
+{
+    static const char kBuilt[] = "<html>built</html>";
+    static const char kOverride[] = "<html>replaced by hand</html>";
+
+    // Manifest entry as build_web_assets.py wrote it for the built asset
+    char manifest_hash[17];
+    TEST_ASSERT_TRUE(web_server_static_hash_content(kBuilt, sizeof(kBuilt) - 1U, manifest_hash));
+    char old_identity[24];
+    char old_gzip[24];
+    TEST_ASSERT_TRUE(web_server_static_format_etag(manifest_hash, false, old_identity, sizeof(old_identity)));
+    TEST_ASSERT_TRUE(web_server_static_format_etag(manifest_hash, true, old_gzip, sizeof(old_gzip)));
+
+    // SPIFFS holds different bytes under the same path
+    char file_hash[17];
+    TEST_ASSERT_TRUE(web_server_static_hash_content(kOverride, sizeof(kOverride) - 1U, file_hash));
+    bool has_gzip = true;
+    TEST_ASSERT_TRUE(web_server_static_reconcile_hash(manifest_hash, &has_gzip, file_hash));
+    TEST_ASSERT_EQUAL_STRING(file_hash, manifest_hash);
+    TEST_ASSERT_FALSE(has_gzip);
+
+    // Neither tag a client kept for the built asset may yield a 304
+    char etag[24];
+    TEST_ASSERT_TRUE(web_server_static_format_etag(manifest_hash, has_gzip, etag, sizeof(etag)));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches(old_identity, etag));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches(old_gzip, etag));
+    TEST_ASSERT_TRUE(web_server_static_etag_matches(etag, etag));
+}
+
+TEST_CASE("web_server_static_changed_file_is_resent", "[web_server][static]")
+{
+    static const char kV1[] = "body{color:red}";
+    static const char kV2[] = "body{color:blue}";
+
+    char manifest_hash[17];
+    TEST_ASSERT_TRUE(web_server_static_hash_content(kV1, sizeof(kV1) - 1U, manifest_hash));
+    char client_tag[24];
+    TEST_ASSERT_TRUE(web_server_static_format_etag(manifest_hash, true, client_tag, sizeof(client_tag)));
+
+    // Unchanged file: the entry keeps its tag and the client gets a 304
+    char file_hash[17];
+    bool has_gzip = true;
+    TEST_ASSERT_TRUE(web_server_static_hash_content(kV1, sizeof(kV1) - 1U, file_hash));
+    TEST_ASSERT_FALSE(web_server_static_reconcile_hash(manifest_hash, &has_gzip, file_hash));
+    TEST_ASSERT_TRUE(has_gzip);
+    char etag[24];
+    TEST_ASSERT_TRUE(web_server_static_format_etag(manifest_hash, has_gzip, etag, sizeof(etag)));
+    TEST_ASSERT_TRUE(web_server_static_etag_matches(client_tag, etag));
+
+    // File changed without regenerating etags.txt: the stale tag gets a 200
+    TEST_ASSERT_TRUE(web_server_static_hash_content(kV2, sizeof(kV2) - 1U, file_hash));
+    TEST_ASSERT_TRUE(web_server_static_reconcile_hash(manifest_hash, &has_gzip, file_hash));
+    TEST_ASSERT_TRUE(web_server_static_format_etag(manifest_hash, has_gzip, etag, sizeof(etag)));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches(client_tag, etag));
+    TEST_ASSERT_FALSE(web_server_static_etag_matches("W/\"00\", \"0000000000000000\"", etag));
+
+    // The hash is the build script's: first 64 bits of SHA-256, in hex
+    TEST_ASSERT_TRUE(web_server_static_hash_content("test", 4U, file_hash));
+    TEST_ASSERT_EQUAL_STRING("9f86d081884c7d65", file_hash);
+}
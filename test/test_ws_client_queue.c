@@ -0,0 +1,144 @@
+#include "unity.h"
+
+#include "ws_client_queue.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static ws_message_t *make_message(const char *text, int64_t created_us)
+{
+    ws_message_t *message = ws_message_create(text, strlen(text), created_us);
+    TEST_ASSERT_NOT_NULL(message);
+    return message;
+}
+
+TEST_CASE("ws_client_queue_drop_oldest_keeps_latest", "[web_server][websocket]")
+{
+    ws_client_queue_t queue;
+    ws_client_queue_init(&queue, 3, WS_CLIENT_QUEUE_DROP_OLDEST);
+
+    for (int i = 0; i < 5; ++i) {
+        char text[8];
+        snprintf(text, sizeof(text), "m%d", i);
+        ws_message_t *message = make_message(text, 1000000 + i * 100000);
+        TEST_ASSERT_TRUE(ws_client_queue_push(&queue, message));
+        ws_message_release(message);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(3, queue.count);
+    TEST_ASSERT_EQUAL_UINT32(2, queue.dropped);
+
+    // m0 was never delivered, so the lag is measured from it
+    TEST_ASSERT_EQUAL_UINT32(500, ws_client_queue_lag_ms(&queue, 1500000));
+
+    const char *expected[] = {"m2", "m3", "m4"};
+    for (size_t i = 0; i < 3; ++i) {
+        ws_message_t *message = ws_client_queue_pop(&queue, 1500000);
+        TEST_ASSERT_NOT_NULL(message);
+        TEST_ASSERT_EQUAL_UINT32(2, message->length);
+        TEST_ASSERT_EQUAL_MEMORY(expected[i], message->payload, 2);
+        ws_message_release(message);
+    }
+
+    TEST_ASSERT_NULL(ws_client_queue_pop(&queue, 1500000));
+    TEST_ASSERT_EQUAL_UINT32(3, queue.sent);
+    TEST_ASSERT_EQUAL_UINT32(500, queue.max_lag_ms);
+    TEST_ASSERT_EQUAL_UINT32(0, ws_client_queue_lag_ms(&queue, 2000000));
+}
+
+TEST_CASE("ws_client_queue_reject_when_full", "[web_server][websocket]")
+{
+    ws_client_queue_t queue;
+    ws_client_queue_init(&queue, 2, WS_CLIENT_QUEUE_REJECT);
+
+    ws_message_t *first = make_message("a", 1000);
+    ws_message_t *second = make_message("b", 2000);
+    ws_message_t *third = make_message("c", 3000);
+
+    TEST_ASSERT_TRUE(ws_client_queue_push(&queue, first));
+    TEST_ASSERT_TRUE(ws_client_queue_push(&queue, second));
+    TEST_ASSERT_FALSE(ws_client_queue_push(&queue, third));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.dropped);
+
+    // A refused message keeps only the caller's reference
+    TEST_ASSERT_EQUAL_UINT32(1, third->refs);
+    TEST_ASSERT_EQUAL_UINT32(2, first->refs);
+
+    ws_message_t *head = ws_client_queue_pop(&queue, 5000);
+    TEST_ASSERT_EQUAL_PTR(first, head);
+    ws_message_release(head);
+
+    // Lag now runs from the next undelivered message
+    TEST_ASSERT_EQUAL_UINT32(8, ws_client_queue_lag_ms(&queue, 10000));
+
+    ws_client_queue_clear(&queue);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.count);
+    TEST_ASSERT_EQUAL_UINT32(1, second->refs);
+
+    ws_message_release(first);
+    ws_message_release(second);
+    ws_message_release(third);
+}
+
+TEST_CASE("ws_client_queue_shared_message_refcount", "[web_server][websocket]")
+{
+    ws_client_queue_t clients[4];
+    for (size_t i = 0; i < 4; ++i) {
+        ws_client_queue_init(&clients[i], CONFIG_TINYBMS_WEB_WS_QUEUE_DEPTH, WS_CLIENT_QUEUE_DROP_OLDEST);
+    }
+
+    // One allocation per broadcast, whatever the number of clients
+    ws_message_t *message = make_message("{\"battery\":{}}", 42);
+    for (size_t i = 0; i < 4; ++i) {
+        TEST_ASSERT_TRUE(ws_client_queue_push(&clients[i], message));
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, message->refs);
+    ws_message_release(message);
+
+    for (size_t i = 0; i < 4; ++i) {
+        ws_message_t *popped = ws_client_queue_pop(&clients[i], 100);
+        TEST_ASSERT_EQUAL_PTR(message, popped);
+        ws_message_release(popped);
+    }
+}
+
+static unsigned s_borrowed_releases = 0;
+
+static void ws_client_queue_test_release(void *context)
+{
+    TEST_ASSERT_EQUAL_STRING("owner", (const char *)context);
+    s_borrowed_releases++;
+}
+
+TEST_CASE("ws_client_queue_wrapped_message_borrows_buffer", "[web_server][websocket]")
+{
+    static const char snapshot[] = "{\"battery\":{\"soc\":80}}";
+    char owner[] = "owner";
+    ws_client_queue_t queue;
+    ws_client_queue_init(&queue, 2, WS_CLIENT_QUEUE_DROP_OLDEST);
+    s_borrowed_releases = 0;
+
+    // The frame is sent from the producer's buffer, not a copy
+    ws_message_t *message =
+        ws_message_wrap(snapshot, sizeof(snapshot) - 1U, ws_client_queue_test_release, owner, 7);
+    TEST_ASSERT_NOT_NULL(message);
+    TEST_ASSERT_EQUAL_PTR(snapshot, message->data);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(snapshot) - 1U, message->length);
+
+    TEST_ASSERT_TRUE(ws_client_queue_push(&queue, message));
+    ws_message_release(message);
+    TEST_ASSERT_EQUAL_UINT32(0, s_borrowed_releases);
+
+    ws_message_t *popped = ws_client_queue_pop(&queue, 10);
+    TEST_ASSERT_EQUAL_PTR(message, popped);
+    ws_message_release(popped);
+    TEST_ASSERT_EQUAL_UINT32(1, s_borrowed_releases);
+
+    // Owned messages point at their own storage
+    ws_message_t *copy = make_message("abc", 1);
+    TEST_ASSERT_EQUAL_PTR(copy->payload, copy->data);
+    ws_message_release(copy);
+
+    TEST_ASSERT_NULL(ws_message_wrap(NULL, 4, ws_client_queue_test_release, owner, 1));
+    TEST_ASSERT_EQUAL_UINT32(1, s_borrowed_releases);
+}
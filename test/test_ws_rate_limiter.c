@@ -0,0 +1,93 @@
+#include "unity.h"
+
+#include "ws_rate_limiter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cJSON.h"
+
+TEST_CASE("ws_rate_limiter_decimates_jittery_samples", "[web_server][websocket]")
+{
+    ws_rate_limiter_t limiter;
+    memset(&limiter, 0, sizeof(limiter));
+    ws_rate_limiter_configure(&limiter, 1000U, false);
+
+    // 4 Hz polling with +/-10 ms of jitter, for 10 seconds
+    uint32_t sent = 0;
+    for (int i = 0; i < 40; ++i) {
+        int64_t now_us = 5000000 + (int64_t)i * 250000 + ((i % 2 == 0) ? -10000 : 10000);
+        if (ws_rate_limiter_offer(&limiter, now_us, NULL)) {
+            sent++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(10U, sent);
+    TEST_ASSERT_EQUAL_UINT32(30U, limiter.skipped);
+
+    // Full rate lets everything through
+    ws_rate_limiter_configure(&limiter, 0U, true);
+    TEST_ASSERT_FALSE(limiter.aggregate);
+    TEST_ASSERT_TRUE(ws_rate_limiter_offer(&limiter, 20000000, NULL));
+    TEST_ASSERT_TRUE(ws_rate_limiter_offer(&limiter, 20000001, NULL));
+}
+
+TEST_CASE("ws_rate_limiter_summarises_skipped_samples", "[web_server][websocket]")
+{
+    ws_rate_limiter_t limiter;
+    memset(&limiter, 0, sizeof(limiter));
+    ws_rate_limiter_configure(&limiter, 1000U, true);
+
+    float metrics[WS_RATE_LIMITER_METRIC_COUNT] = {0};
+    char window[WS_RATE_LIMITER_WINDOW_MAX_SIZE];
+    size_t length = 0;
+
+    // The first sample goes out alone
+    metrics[0] = 52.0f;
+    TEST_ASSERT_TRUE(ws_rate_limiter_offer(&limiter, 1000000, metrics));
+    TEST_ASSERT_TRUE(ws_rate_limiter_write_window(&limiter, 1000000, window, sizeof(window), &length));
+
+    const float voltages[] = {51.0f, 53.0f, 52.5f, 51.5f};
+    bool due = false;
+    for (size_t i = 0; i < 4; ++i) {
+        metrics[0] = voltages[i];
+        metrics[1] = -10.0f * (float)(i + 1U);
+        due = ws_rate_limiter_offer(&limiter, 1250000 + (int64_t)i * 250000, metrics);
+    }
+    TEST_ASSERT_TRUE(due);
+    TEST_ASSERT_TRUE(ws_rate_limiter_write_window(&limiter, 2000000, window, sizeof(window), &length));
+    TEST_ASSERT_EQUAL_UINT32(strlen(window), length);
+
+    cJSON *root = cJSON_Parse(window);
+    TEST_ASSERT_NOT_NULL(root);
+    TEST_ASSERT_EQUAL_INT(4, cJSON_GetObjectItem(root, "samples")->valueint);
+    TEST_ASSERT_EQUAL_INT(1000, cJSON_GetObjectItem(root, "duration_ms")->valueint);
+    const cJSON *voltage = cJSON_GetObjectItem(root, ws_rate_limiter_metric_name(0));
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, 51.0, cJSON_GetObjectItem(voltage, "min")->valuedouble);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, 53.0, cJSON_GetObjectItem(voltage, "max")->valuedouble);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, 52.0, cJSON_GetObjectItem(voltage, "avg")->valuedouble);
+    const cJSON *current = cJSON_GetObjectItem(root, ws_rate_limiter_metric_name(1));
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, -40.0, cJSON_GetObjectItem(current, "min")->valuedouble);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, -25.0, cJSON_GetObjectItem(current, "avg")->valuedouble);
+    cJSON_Delete(root);
+
+    // Nothing left to summarise until the next sample
+    TEST_ASSERT_FALSE(ws_rate_limiter_write_window(&limiter, 2000000, window, sizeof(window), &length));
+}
+
+TEST_CASE("ws_rate_limiter_parses_rates", "[web_server][websocket]")
+{
+    uint32_t interval_ms = 1U;
+    TEST_ASSERT_TRUE(ws_rate_limiter_parse_rate("10", &interval_ms));
+    TEST_ASSERT_EQUAL_UINT32(100U, interval_ms);
+    TEST_ASSERT_TRUE(ws_rate_limiter_parse_rate("0.2", &interval_ms));
+    TEST_ASSERT_EQUAL_UINT32(5000U, interval_ms);
+    TEST_ASSERT_TRUE(ws_rate_limiter_parse_rate("max", &interval_ms));
+    TEST_ASSERT_EQUAL_UINT32(0U, interval_ms);
+
+    TEST_ASSERT_FALSE(ws_rate_limiter_parse_rate("", &interval_ms));
+    TEST_ASSERT_FALSE(ws_rate_limiter_parse_rate("1hz", &interval_ms));
+    TEST_ASSERT_FALSE(ws_rate_limiter_parse_rate("-1", &interval_ms));
+    TEST_ASSERT_FALSE(ws_rate_limiter_parse_rate("1000", &interval_ms));
+    TEST_ASSERT_FALSE(ws_rate_limiter_parse_rate("0.001", &interval_ms));
+}
@@ -32,7 +32,12 @@ static uint16_t compute_crc16(const uint8_t *data, size_t length)
 
 size_t build_uart_test_frame(uint8_t *frame, size_t frame_size)
 {
-    if (frame == NULL || frame_size == 0U) {
+    return build_uart_test_frame_from_values(kUartTestSampleValues, frame, frame_size);
+}
+
+size_t build_uart_test_frame_from_values(const uint16_t *values, uint8_t *frame, size_t frame_size)
+{
+    if (values == NULL || frame == NULL || frame_size == 0U) {
         return 0;
     }
 
@@ -47,8 +52,8 @@ size_t build_uart_test_frame(uint8_t *frame, size_t frame_size)
     frame[2] = (uint8_t)payload_len;
 
     for (size_t i = 0; i < kUartTestRegisterCount; ++i) {
-        frame[3 + i * 2] = (uint8_t)(kUartTestSampleValues[i] & 0xFFU);
-        frame[4 + i * 2] = (uint8_t)(kUartTestSampleValues[i] >> 8);
+        frame[3 + i * 2] = (uint8_t)(values[i] & 0xFFU);
+        frame[4 + i * 2] = (uint8_t)(values[i] >> 8);
     }
 
     uint16_t crc = compute_crc16(frame, total_len - 2U);
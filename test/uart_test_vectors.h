@@ -7,3 +7,4 @@ extern const uint16_t kUartTestRegisterCount;
 extern const uint16_t kUartTestSampleValues[];
 
 size_t build_uart_test_frame(uint8_t *frame, size_t frame_size);
+size_t build_uart_test_frame_from_values(const uint16_t *values, uint8_t *frame, size_t frame_size);
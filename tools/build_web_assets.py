@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+"""Stage the web UI for the SPIFFS partition image.
+
+Copies the served files of ``web/`` into a staging directory (the build runs
+it into ``build/www``) and, for text assets, adds a gzip variant next to the
+original (``dashboard.js`` -> ``dashboard.js.gz``) when it is actually
+smaller.  ``web_server_static.c`` serves the ``.gz`` file with
+``Content-Encoding: gzip`` to clients that accept it.
+
+It also writes ``etags.txt``, one line per served file::
+
+    /dashboard.js 9f86d081884c7d65 gz
+    /src/components/alerts/index.html 5e884898da280471 gz @/_/0c5a1ad6b2b1b4e3
+
+The tag is the first 64 bits of the SHA-256 of the uncompressed file, so it is
+stable across builds and changes only with the content.  The firmware loads
+the manifest once at mount and answers ``If-None-Match`` with 304 without
+touching the file.
+
+SPIFFS stores the whole path as the object name, limited to 31 characters.
+A file whose path (plus ``.gz``) would not fit is flattened to
+``/_/<hash of its URI>`` in the image, and its manifest line records that
+stored name after ``@``; the firmware resolves the URI through the manifest.
+A name that still does not fit is an error.
+
+With ``--embed-c`` it also emits a C source holding the same assets as a
+rodata table sorted by path (``web_server_assets.h``), for
+``CONFIG_TINYBMS_WEB_EMBED_ASSETS``.  Each entry stores the gzip variant when
+one exists, otherwise the raw file, and is sent straight from flash.
+
+Documentation, tests and Node tooling are not staged.  Gzip output uses a
+zero mtime so identical inputs produce identical images.
+"""
+
+from __future__ import annotations
+
+import argparse
+import fnmatch
+import gzip
+import hashlib
+import shutil
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import List, Optional
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+DEFAULT_SOURCE = REPO_ROOT / "web"
+MANIFEST_NAME = "etags.txt"
+
+COMPRESSIBLE_SUFFIXES = {".html", ".js", ".css", ".json", ".svg", ".txt", ".map"}
+EXCLUDED_PATTERNS = [
+    "*.md",
+    "package.json",
+    "package-lock.json",
+    "jest.config.js",
+    ".gitignore",
+    ".eslintrc*",
+    "node_modules/*",
+    "test/*",
+    "build/*",
+    "dist/*",
+]
+# Keep the variant only when it saves at least this fraction of the original
+MIN_SAVING = 0.10
+# CONFIG_SPIFFS_OBJ_NAME_LEN (32) includes the terminating NUL
+SPIFFS_NAME_MAX = 31
+# Directory of the flattened files, see stored_name()
+FLAT_DIR = "/_"
+
+
+@dataclass
+class Asset:
+    uri: str
+    relative: str
+    etag: str
+    data: bytes
+    compressed: Optional[bytes]
+    stored: str  # Name in the SPIFFS image, the URI unless flattened
+
+
+def is_excluded(relative: str) -> bool:
+    return any(fnmatch.fnmatch(relative, pattern) for pattern in EXCLUDED_PATTERNS)
+
+
+def stored_name(uri: str, compressible: bool) -> str:
+    """The URI when it fits SPIFFS with its .gz variant, else /_/<hash>."""
+    if len(uri) + (3 if compressible else 0) <= SPIFFS_NAME_MAX:
+        return uri
+    return f"{FLAT_DIR}/{hashlib.sha256(uri.encode('utf-8')).hexdigest()[:16]}"
+
+
+def collect(source: Path, spiffs_names: bool) -> List[Asset]:
+    """Served files, sorted by path in byte order (the C table is bsearch'ed)."""
+    assets: List[Asset] = []
+    for path in sorted(p for p in source.rglob("*") if p.is_file()):
+        relative = path.relative_to(source).as_posix()
+        if is_excluded(relative):
+            continue
+
+        uri = "/" + relative
+        data = path.read_bytes()
+        compressed = None
+        compressible = path.suffix.lower() in COMPRESSIBLE_SUFFIXES
+        if compressible:
+            candidate = gzip.compress(data, compresslevel=9, mtime=0)
+            if len(candidate) <= len(data) * (1.0 - MIN_SAVING):
+                compressed = candidate
+
+        stored = stored_name(uri, compressible) if spiffs_names else uri
+        assets.append(Asset(uri, relative, hashlib.sha256(data).hexdigest()[:16], data, compressed, stored))
+    assets.sort(key=lambda asset: asset.uri.encode("utf-8"))
+    return assets
+
+
+def stage(source: Path, output: Path) -> int:
+    if output.exists():
+        shutil.rmtree(output)
+    output.mkdir(parents=True)
+
+    manifest: List[str] = []
+    original_total = 0
+    served_total = 0
+    flattened = 0
+    errors = 0
+
+    for asset in collect(source, spiffs_names=True):
+        longest = asset.stored + (".gz" if asset.compressed is not None else "")
+        if len(longest) > SPIFFS_NAME_MAX:
+            print(f"error: {longest} exceeds the SPIFFS name limit ({SPIFFS_NAME_MAX})", file=sys.stderr)
+            errors += 1
+            continue
+
+        target = output / asset.stored.lstrip("/")
+        target.parent.mkdir(parents=True, exist_ok=True)
+        target.write_bytes(asset.data)
+        if asset.compressed is not None:
+            target.with_name(target.name + ".gz").write_bytes(asset.compressed)
+
+        line = f"{asset.uri} {asset.etag}{' gz' if asset.compressed is not None else ''}"
+        if asset.stored != asset.uri:
+            line += f" @{asset.stored}"
+            flattened += 1
+        manifest.append(line)
+        original_total += len(asset.data)
+        served_total += len(asset.compressed if asset.compressed is not None else asset.data)
+
+    (output / MANIFEST_NAME).write_text("\n".join(manifest) + "\n", encoding="utf-8")
+
+    print(f"staged {len(manifest)} files into {output} ({flattened} flattened into {FLAT_DIR}/): "
+          f"{original_total} bytes raw, {served_total} bytes served to gzip clients")
+    return 1 if errors else 0
+
+
+def c_string(text: str) -> str:
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def emit_c(source: Path, output: Path) -> None:
+    assets = collect(source, spiffs_names=False)
+    lines = [
+        "// Generated by tools/build_web_assets.py from web/, do not edit.",
+        "",
+        '#include "web_server_assets.h"',
+        "",
+    ]
+    total = 0
+    for index, asset in enumerate(assets):
+        body = asset.compressed if asset.compressed is not None else asset.data
+        total += len(body)
+        lines.append(f"// {asset.uri} ({len(asset.data)} bytes{', gzip ' + str(len(body)) if asset.compressed is not None else ''})")
+        lines.append(f"static const uint8_t s_asset_{index}[{len(body)}] = {{")
+        for offset in range(0, len(body), 16):
+            chunk = body[offset:offset + 16]
+            lines.append("    " + ", ".join(f"0x{byte:02x}" for byte in chunk) + ",")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("const web_server_embedded_asset_t g_web_server_embedded_assets[] = {")
+    for index, asset in enumerate(assets):
+        body = asset.compressed if asset.compressed is not None else asset.data
+        gz = "true" if asset.compressed is not None else "false"
+        lines.append(f"    {{ {c_string(asset.uri)}, s_asset_{index}, {len(body)}U, {c_string(asset.etag)}, {gz} }},")
+    lines.append("};")
+    lines.append("")
+    lines.append(f"const size_t g_web_server_embedded_asset_count = {len(assets)}U;")
+    lines.append("")
+
+    output.parent.mkdir(parents=True, exist_ok=True)
+    text = "\n".join(lines)
+    # Avoid touching the file (and recompiling) when nothing changed
+    if not output.exists() or output.read_text(encoding="utf-8") != text:
+        output.write_text(text, encoding="utf-8")
+    print(f"embedded {len(assets)} assets into {output}: {total} bytes of rodata")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--source", type=Path, default=DEFAULT_SOURCE)
+    parser.add_argument("--output", type=Path, help="staging directory for the SPIFFS image")
+    parser.add_argument("--embed-c", type=Path, help="emit the rodata asset table to this C file")
+    args = parser.parse_args()
+    if args.output is None and args.embed_c is None:
+        parser.error("nothing to do: pass --output and/or --embed-c")
+
+    status = 0
+    if args.output is not None:
+        status = stage(args.source, args.output)
+    if args.embed_c is not None:
+        emit_c(args.source, args.embed_c)
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,110 @@
+"""Compare CAN encoder benchmark results against a recorded baseline.
+
+The ``can_conversion_encoder_benchmark`` Unity case prints one
+``can_encode_bench,<pgn>,<ns>`` line per Victron channel plus a ``table``
+line for a full pass over the channel table.  This script extracts those
+lines from a captured test log (``idf.py monitor`` output, or stdout of the
+``linux`` target build) and compares them with
+``test/reference/can_encode_baseline.csv``.
+
+Usage::
+
+    python tools/can_encode_bench.py run.log                # compare
+    python tools/can_encode_bench.py run.log --threshold 10 # stricter
+    python tools/can_encode_bench.py run.log --update       # record baseline
+
+The exit status is 1 when any entry is slower than the baseline by more than
+the threshold, so the script can gate a CI job.  Baselines are only
+meaningful for the target they were recorded on.
+"""
+
+from __future__ import annotations
+
+import argparse
+import csv
+import re
+import sys
+from pathlib import Path
+from typing import Dict
+
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+DEFAULT_BASELINE = REPO_ROOT / "test" / "reference" / "can_encode_baseline.csv"
+LINE_PATTERN = re.compile(r"can_encode_bench,(0x[0-9A-Fa-f]+|table),(\d+)")
+
+
+def parse_log(path: Path) -> Dict[str, int]:
+    results: Dict[str, int] = {}
+    for line in path.read_text(encoding="utf-8", errors="replace").splitlines():
+        match = LINE_PATTERN.search(line)
+        if match:
+            key = match.group(1)
+            key = key if key == "table" else "0x%03X" % int(key, 16)
+            results[key] = int(match.group(2))
+    return results
+
+
+def load_baseline(path: Path) -> Dict[str, int]:
+    with path.open(newline="", encoding="utf-8") as handle:
+        return {row["pgn"]: int(row["ns_per_frame"]) for row in csv.DictReader(handle)}
+
+
+def write_baseline(path: Path, results: Dict[str, int]) -> None:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with path.open("w", newline="", encoding="utf-8") as handle:
+        writer = csv.writer(handle)
+        writer.writerow(["pgn", "ns_per_frame"])
+        for key in sorted(results):
+            writer.writerow([key, results[key]])
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("log", type=Path, help="captured Unity output")
+    parser.add_argument("--baseline", type=Path, default=DEFAULT_BASELINE)
+    parser.add_argument("--threshold", type=float, default=15.0,
+                        help="allowed slowdown in percent (default: 15)")
+    parser.add_argument("--update", action="store_true",
+                        help="overwrite the baseline with this run")
+    args = parser.parse_args()
+
+    results = parse_log(args.log)
+    if not results:
+        print(f"no can_encode_bench lines in {args.log}", file=sys.stderr)
+        return 2
+
+    if args.update:
+        write_baseline(args.baseline, results)
+        print(f"baseline written: {args.baseline} ({len(results)} entries)")
+        return 0
+
+    if not args.baseline.exists():
+        print(f"missing baseline {args.baseline}; record one with --update", file=sys.stderr)
+        return 2
+
+    baseline = load_baseline(args.baseline)
+    regressions = 0
+    print(f"{'PGN':>6} {'base ns':>9} {'run ns':>9} {'delta':>8}")
+    for key in sorted(set(baseline) | set(results)):
+        base = baseline.get(key)
+        current = results.get(key)
+        if base is None or current is None:
+            print(f"{key:>6} {base if base is not None else '-':>9} "
+                  f"{current if current is not None else '-':>9} {'n/a':>8}")
+            continue
+        delta = (current - base) * 100.0 / base if base > 0 else 0.0
+        flag = ""
+        if delta > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{key:>6} {base:>9} {current:>9} {delta:>+7.1f}%{flag}")
+
+    if regressions:
+        print(f"{regressions} entr{'y' if regressions == 1 else 'ies'} slower than "
+              f"baseline by more than {args.threshold:.0f}%", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
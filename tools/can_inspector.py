@@ -5,9 +5,17 @@ from __future__ import annotations
 
 import argparse
 import csv
+import struct
+import urllib.request
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Dict, Iterable, List, Optional
+from typing import Dict, Iterable, Iterator, List, Optional
+
+CAPTURE_MAGIC = b"TBCANCAP"
+CAPTURE_HEADER = struct.Struct("<8sHHI")
+CAPTURE_RECORD = struct.Struct("<IHBB8s")
+CAPTURE_FLAG_RX = 0x01
+CAPTURE_FLAG_RTR = 0x02
 
 
 @dataclass
@@ -132,9 +140,49 @@ def parse_candump_line(line: str) -> Optional[tuple[float, int, str]]:
     return timestamp, identifier, data_hex
 
 
+def parse_capture_binary(blob: bytes,
+                         include_rx: bool = False) -> Iterator[tuple[float, int, str]]:
+    """Decode a gateway capture (/api/can/capture?format=bin or can_capture.bin)."""
+    if len(blob) < CAPTURE_HEADER.size:
+        raise SystemExit("Capture too short")
+    magic, version, record_size, _ = CAPTURE_HEADER.unpack_from(blob, 0)
+    if magic != CAPTURE_MAGIC or version != 1 or record_size != CAPTURE_RECORD.size:
+        raise SystemExit("Not a TinyBMS CAN capture (bad header)")
+
+    for offset in range(CAPTURE_HEADER.size, len(blob) - record_size + 1, record_size):
+        timestamp_ms, can_id, flags, dlc, data = CAPTURE_RECORD.unpack_from(blob, offset)
+        if (flags & CAPTURE_FLAG_RX) and not include_rx:
+            continue
+        payload = "R" if flags & CAPTURE_FLAG_RTR else data[:min(dlc, 8)].hex().upper()
+        yield timestamp_ms / 1000.0, can_id, payload
+
+
+def iter_capture(source: str, include_rx: bool = False) -> Iterator[tuple[float, int, str]]:
+    """Yield (timestamp, identifier, data_hex) from a file or a gateway URL."""
+    if source.startswith(("http://", "https://")):
+        url = source
+        if "/api/" not in url:
+            url = url.rstrip("/") + "/api/can/capture?format=bin"
+        with urllib.request.urlopen(url, timeout=10) as response:
+            blob = response.read()
+    else:
+        blob = Path(source).read_bytes()
+
+    if blob.startswith(CAPTURE_MAGIC):
+        yield from parse_capture_binary(blob, include_rx)
+        return
+
+    for line in blob.decode("utf-8", errors="replace").splitlines():
+        parsed = parse_candump_line(line)
+        if parsed:
+            yield parsed
+
+
 def _parse_args(argv: Optional[List[str]] = None) -> argparse.Namespace:
     parser = argparse.ArgumentParser(description=__doc__)
-    parser.add_argument("log", type=Path, help="candump -L log file")
+    parser.add_argument("log",
+                        help="candump -L log, gateway binary capture (can_capture.bin) "
+                             "or gateway URL (http://<ip>, fetches /api/can/capture)")
     parser.add_argument("--expected",
                         type=Path,
                         default=Path("test/reference/can_expected_snapshot.csv"),
@@ -146,6 +194,9 @@ def _parse_args(argv: Optional[List[str]] = None) -> argparse.Namespace:
                         type=int,
                         default=100,
                         help="Allowed timing difference in milliseconds")
+    parser.add_argument("--include-rx",
+                        action="store_true",
+                        help="Also inspect frames received by the gateway (binary captures)")
     return parser.parse_args(argv)
 
 
@@ -154,13 +205,8 @@ def main(argv: Optional[List[str]] = None) -> int:
     expectations = load_expectations(args.expected, args.scenario)
     inspector = CanLogInspector(expectations, args.tolerance_ms)
 
-    with args.log.open("r", encoding="utf-8") as fp:
-        for line in fp:
-            parsed = parse_candump_line(line)
-            if not parsed:
-                continue
-            timestamp, identifier, data_hex = parsed
-            inspector.consume(timestamp, identifier, data_hex)
+    for timestamp, identifier, data_hex in iter_capture(args.log, args.include_rx):
+        inspector.consume(timestamp, identifier, data_hex)
 
     failures = inspector.summarize()
     if failures:
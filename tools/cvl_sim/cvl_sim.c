@@ -0,0 +1,429 @@
+/*
+ * cvl_sim - host harness for main/can_publisher/cvl_logic.c
+ *
+ * Drives cvl_compute_limits() through a synthetic multi-day solar
+ * charge/discharge profile (16S LFP pack, charger limited by the computed
+ * CVL/CCL) and reports:
+ *   - every CVL state transition with its timestamp, SOC and CVL,
+ *   - the CVL trajectory as CSV (optional, --csv),
+ *   - the time spent in each state,
+ *   - ns per evaluation, measured by replaying the recorded inputs,
+ *   - how many samples the controller's incremental path would reuse.
+ *
+ * Build and run from the repository root:
+ *   cc -O2 -std=c11 -Wall -Imain/can_publisher tools/cvl_sim/cvl_sim.c \
+ *      main/can_publisher/cvl_logic.c -lm -o cvl_sim
+ *   ./cvl_sim --days 7 --step-ms 100 --csv cvl.csv
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cvl_logic.h"
+
+#define SIM_SERIES_CELLS        16U
+#define SIM_CAPACITY_AH         280.0
+#define SIM_CELL_RESISTANCE_OHM 0.00025
+#define SIM_OVERVOLTAGE_MV      56700U
+#define SIM_BASE_CCL_A          120.0f
+#define SIM_BASE_DCL_A          140.0f
+#define SIM_BENCH_CAPACITY      (1U << 20)
+#define SIM_BENCH_MIN_NS        200000000ULL
+#define SIM_PI                  3.14159265358979323846
+
+// Mirrors s_cvl_default_config in cvl_controller.c
+static const cvl_config_snapshot_t s_config = {
+    .enabled = true,
+    .bulk_soc_threshold = 90.0f,
+    .transition_soc_threshold = 95.0f,
+    .float_soc_threshold = 98.0f,
+    .float_exit_soc = 95.0f,
+    .float_approach_offset_mv = 50.0f,
+    .float_offset_mv = 100.0f,
+    .minimum_ccl_in_float_a = 5.0f,
+    .imbalance_hold_threshold_mv = 100U,
+    .imbalance_release_threshold_mv = 50U,
+    .bulk_target_voltage_v = (float)SIM_OVERVOLTAGE_MV / 1000.0f,
+    .series_cell_count = SIM_SERIES_CELLS,
+    .cell_max_voltage_v = 3.65f,
+    .cell_safety_threshold_v = 3.50f,
+    .cell_safety_release_v = 3.47f,
+    .cell_min_float_voltage_v = 3.20f,
+    .cell_protection_kp = 120.0f,
+    .dynamic_current_nominal_a = 157.0f,
+    .max_recovery_step_v = 0.4f,
+    .sustain_soc_entry_percent = 5.0f,
+    .sustain_soc_exit_percent = 8.0f,
+    .sustain_voltage_v = 0.0f,
+    .sustain_per_cell_voltage_v = 3.125f,
+    .sustain_ccl_limit_a = 5.0f,
+    .sustain_dcl_limit_a = 5.0f,
+    .imbalance_drop_per_mv = 0.0005f,
+    .imbalance_drop_max_v = 2.0f,
+};
+
+static const char *const s_state_names[] = {
+    "BULK", "TRANSITION", "FLOAT_APPROACH", "FLOAT", "IMBALANCE_HOLD", "SUSTAIN",
+};
+
+typedef struct {
+    double days;
+    uint32_t step_ms;
+    double start_soc;
+    uint32_t seed;
+    const char *csv_path;
+    uint32_t csv_interval_s;
+    bool quiet;
+} sim_options_t;
+
+typedef struct {
+    double soc;               // 0..1
+    double imbalance_mv;      // cell spread grows near full charge
+} sim_battery_t;
+
+// ---------------------------------------------------------------------------
+// Battery and profile model
+// ---------------------------------------------------------------------------
+
+static uint32_t s_rng_state = 1U;
+
+static double rng_uniform(void)
+{
+    // xorshift32, deterministic for a given --seed
+    s_rng_state ^= s_rng_state << 13;
+    s_rng_state ^= s_rng_state >> 17;
+    s_rng_state ^= s_rng_state << 5;
+    return (double)s_rng_state / 4294967296.0;
+}
+
+static double cell_ocv(double soc)
+{
+    static const double points[][2] = {
+        {0.00, 2.90}, {0.05, 3.15}, {0.10, 3.22}, {0.30, 3.27}, {0.60, 3.30},
+        {0.90, 3.33}, {0.95, 3.36}, {0.98, 3.40}, {0.995, 3.45}, {1.00, 3.55},
+    };
+    const size_t count = sizeof(points) / sizeof(points[0]);
+    if (soc <= points[0][0]) {
+        return points[0][1];
+    }
+    for (size_t i = 1; i < count; ++i) {
+        if (soc <= points[i][0]) {
+            double t = (soc - points[i - 1][0]) / (points[i][0] - points[i - 1][0]);
+            return points[i - 1][1] + t * (points[i][1] - points[i - 1][1]);
+        }
+    }
+    return points[count - 1][1];
+}
+
+static double imbalance_target_mv(double soc)
+{
+    // Balanced in the flat part of the curve, diverging on the top knee
+    double knee = (soc > 0.95) ? (soc - 0.95) / 0.05 : 0.0;
+    return 15.0 + 160.0 * knee * knee;
+}
+
+// Solar charge and household load for a given time of day, in amps
+static double profile_current(double t_s, double day_cloudiness)
+{
+    double hour = fmod(t_s / 3600.0, 24.0);
+    double solar = 0.0;
+    if (hour > 7.0 && hour < 19.0) {
+        solar = 150.0 * sin(SIM_PI * (hour - 7.0) / 12.0) * (1.0 - day_cloudiness);
+    }
+    double load = 12.0;
+    if (hour >= 18.0 && hour < 22.0) {
+        load += 45.0;
+    } else if (hour >= 7.0 && hour < 8.0) {
+        load += 30.0;
+    }
+    return solar - load;
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void format_sim_time(double t_s, char *buffer, size_t size)
+{
+    uint64_t total = (uint64_t)t_s;
+    snprintf(buffer,
+             size,
+             "d%llu %02llu:%02llu:%02llu",
+             (unsigned long long)(total / 86400ULL),
+             (unsigned long long)((total / 3600ULL) % 24ULL),
+             (unsigned long long)((total / 60ULL) % 60ULL),
+             (unsigned long long)(total % 60ULL));
+}
+
+// Same masking rule as cvl_controller_mask_unused_inputs()
+static void mask_unused_inputs(cvl_inputs_t *inputs, const cvl_runtime_state_t *runtime)
+{
+    inputs->pack_voltage_v = 0.0f;
+    if (!runtime->cell_protection_active && inputs->max_cell_voltage_v < s_config.cell_safety_threshold_v) {
+        inputs->pack_current_a = 0.0f;
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [--days N] [--step-ms MS] [--start-soc PCT] [--seed N]\n"
+            "          [--csv FILE] [--csv-interval S] [--quiet]\n",
+            argv0);
+}
+
+static bool parse_options(int argc, char **argv, sim_options_t *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--quiet") == 0) {
+            options->quiet = true;
+            continue;
+        }
+        if (value == NULL) {
+            return false;
+        }
+        if (strcmp(arg, "--days") == 0) {
+            options->days = atof(value);
+        } else if (strcmp(arg, "--step-ms") == 0) {
+            options->step_ms = (uint32_t)strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--start-soc") == 0) {
+            options->start_soc = atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options->seed = (uint32_t)strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--csv") == 0) {
+            options->csv_path = value;
+        } else if (strcmp(arg, "--csv-interval") == 0) {
+            options->csv_interval_s = (uint32_t)strtoul(value, NULL, 10);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options->days > 0.0 && options->step_ms > 0U && options->start_soc >= 0.0 &&
+           options->start_soc <= 100.0 && options->csv_interval_s > 0U;
+}
+
+// ---------------------------------------------------------------------------
+// Simulation
+// ---------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    sim_options_t options = {
+        .days = 3.0,
+        .step_ms = 100U,
+        .start_soc = 40.0,
+        .seed = 1U,
+        .csv_path = NULL,
+        .csv_interval_s = 60U,
+        .quiet = false,
+    };
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+    s_rng_state = (options.seed != 0U) ? options.seed : 1U;
+
+    FILE *csv = NULL;
+    if (options.csv_path != NULL) {
+        csv = fopen(options.csv_path, "w");
+        if (csv == NULL) {
+            perror(options.csv_path);
+            return 1;
+        }
+        fprintf(csv, "time_s,soc_pct,current_a,max_cell_v,imbalance_mv,state,cvl_v,ccl_a,dcl_a,protection\n");
+    }
+
+    const double dt_s = (double)options.step_ms / 1000.0;
+    const uint64_t total_samples = (uint64_t)(options.days * 86400.0 / dt_s);
+    const uint64_t bench_stride = (total_samples + SIM_BENCH_CAPACITY - 1U) / SIM_BENCH_CAPACITY;
+
+    cvl_inputs_t *bench_inputs = calloc(SIM_BENCH_CAPACITY, sizeof(*bench_inputs));
+    if (bench_inputs == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t bench_count = 0;
+
+    sim_battery_t battery = {.soc = options.start_soc / 100.0, .imbalance_mv = 15.0};
+    cvl_runtime_state_t runtime = {.state = CVL_STATE_BULK, .cvl_voltage_v = 0.0f, .cell_protection_active = false};
+    cvl_computation_result_t result = {
+        .state = CVL_STATE_BULK,
+        .cvl_voltage_v = s_config.bulk_target_voltage_v,
+        .ccl_limit_a = SIM_BASE_CCL_A,
+        .dcl_limit_a = SIM_BASE_DCL_A,
+    };
+
+    double state_seconds[sizeof(s_state_names) / sizeof(s_state_names[0])] = {0};
+    uint64_t transitions = 0;
+    uint64_t protection_entries = 0;
+    uint64_t reusable = 0;
+    float cvl_min = INFINITY;
+    float cvl_max = -INFINITY;
+    double cloudiness = 0.0;
+    uint64_t next_csv_ms = 0;
+    cvl_inputs_t last_masked;
+    bool have_last = false;
+    bool settled = false;
+
+    for (uint64_t n = 0; n < total_samples; ++n) {
+        const double t_s = (double)n * dt_s;
+        const uint64_t t_ms = n * options.step_ms;
+        if (n == 0 || fmod(t_s, 86400.0) < dt_s) {
+            cloudiness = 0.6 * rng_uniform();
+        }
+
+        // Current requested by the profile, then limited by the BMS outputs
+        double current = profile_current(t_s, cloudiness) + (rng_uniform() - 0.5) * 2.0;
+        if (current > 0.0) {
+            current = fmin(current, (double)result.ccl_limit_a);
+            double ocv_pack = cell_ocv(battery.soc) * SIM_SERIES_CELLS;
+            double headroom = ((double)result.cvl_voltage_v - ocv_pack) /
+                              (SIM_CELL_RESISTANCE_OHM * SIM_SERIES_CELLS);
+            current = fmax(0.0, fmin(current, headroom));
+        } else {
+            current = fmax(current, -(double)result.dcl_limit_a);
+        }
+
+        battery.soc += current * dt_s / (SIM_CAPACITY_AH * 3600.0);
+        battery.soc = fmin(1.0, fmax(0.0, battery.soc));
+        double target = imbalance_target_mv(battery.soc);
+        battery.imbalance_mv += (target - battery.imbalance_mv) * fmin(1.0, dt_s / 600.0);
+
+        double cell_v = cell_ocv(battery.soc) + current * SIM_CELL_RESISTANCE_OHM;
+        uint16_t max_cell_mv = (uint16_t)lrint((cell_v + battery.imbalance_mv / 2000.0) * 1000.0);
+        uint16_t min_cell_mv = (uint16_t)lrint((cell_v - battery.imbalance_mv / 2000.0) * 1000.0);
+
+        // Quantised like the TinyBMS registers
+        cvl_inputs_t inputs = {
+            .soc_percent = (float)(lrint(battery.soc * 10000.0) / 100.0),
+            .cell_imbalance_mv = (unsigned int)(max_cell_mv - min_cell_mv),
+            .pack_voltage_v = (float)(lrint(cell_v * SIM_SERIES_CELLS * 100.0) / 100.0),
+            .base_ccl_limit_a = SIM_BASE_CCL_A,
+            .base_dcl_limit_a = SIM_BASE_DCL_A,
+            .pack_current_a = (float)(lrint(current * 10.0) / 10.0),
+            .max_cell_voltage_v = (float)max_cell_mv / 1000.0f,
+        };
+
+        cvl_inputs_t masked = inputs;
+        mask_unused_inputs(&masked, &runtime);
+        if (have_last && settled && memcmp(&masked, &last_masked, sizeof(masked)) == 0) {
+            reusable++;
+        }
+        last_masked = masked;
+        have_last = true;
+
+        if ((n % bench_stride) == 0U && bench_count < SIM_BENCH_CAPACITY) {
+            bench_inputs[bench_count++] = inputs;
+        }
+
+        cvl_compute_limits(&inputs, &s_config, &runtime, &result);
+
+        settled = (result.state == runtime.state) && (result.cvl_voltage_v == runtime.cvl_voltage_v) &&
+                  (result.cell_protection_active == runtime.cell_protection_active);
+
+        if (n > 0 && result.state != runtime.state) {
+            transitions++;
+            if (!options.quiet) {
+                char when[32];
+                format_sim_time(t_s, when, sizeof(when));
+                printf("%s  %-14s -> %-14s soc=%6.2f%% cvl=%6.3fV ccl=%6.1fA imbalance=%umV\n",
+                       when,
+                       s_state_names[runtime.state],
+                       s_state_names[result.state],
+                       (double)inputs.soc_percent,
+                       (double)result.cvl_voltage_v,
+                       (double)result.ccl_limit_a,
+                       inputs.cell_imbalance_mv);
+            }
+        }
+        if (result.cell_protection_active && !runtime.cell_protection_active) {
+            protection_entries++;
+        }
+
+        state_seconds[result.state] += dt_s;
+        cvl_min = fminf(cvl_min, result.cvl_voltage_v);
+        cvl_max = fmaxf(cvl_max, result.cvl_voltage_v);
+
+        if (csv != NULL && t_ms >= next_csv_ms) {
+            fprintf(csv,
+                    "%.1f,%.2f,%.1f,%.3f,%u,%s,%.3f,%.1f,%.1f,%d\n",
+                    t_s,
+                    (double)inputs.soc_percent,
+                    (double)inputs.pack_current_a,
+                    (double)inputs.max_cell_voltage_v,
+                    inputs.cell_imbalance_mv,
+                    s_state_names[result.state],
+                    (double)result.cvl_voltage_v,
+                    (double)result.ccl_limit_a,
+                    (double)result.dcl_limit_a,
+                    result.cell_protection_active ? 1 : 0);
+            next_csv_ms += (uint64_t)options.csv_interval_s * 1000ULL;
+        }
+
+        runtime.state = result.state;
+        runtime.cvl_voltage_v = result.cvl_voltage_v;
+        runtime.cell_protection_active = result.cell_protection_active;
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+
+    // Replay the recorded inputs back to back to time cvl_compute_limits()
+    uint64_t bench_evaluations = 0;
+    uint64_t bench_ns = 0;
+    volatile float sink = 0.0f;
+    while (bench_count > 0 && bench_ns < SIM_BENCH_MIN_NS) {
+        cvl_runtime_state_t replay = {.state = CVL_STATE_BULK, .cvl_voltage_v = 0.0f, .cell_protection_active = false};
+        cvl_computation_result_t out;
+        uint64_t start = monotonic_ns();
+        for (size_t i = 0; i < bench_count; ++i) {
+            cvl_compute_limits(&bench_inputs[i], &s_config, &replay, &out);
+            replay.state = out.state;
+            replay.cvl_voltage_v = out.cvl_voltage_v;
+            replay.cell_protection_active = out.cell_protection_active;
+        }
+        bench_ns += monotonic_ns() - start;
+        bench_evaluations += bench_count;
+        sink += out.cvl_voltage_v;
+    }
+    (void)sink;
+    free(bench_inputs);
+
+    printf("\nsimulated        %.2f days, %llu samples at %u ms\n",
+           options.days,
+           (unsigned long long)total_samples,
+           options.step_ms);
+    printf("transitions      %llu (cell protection entries: %llu)\n",
+           (unsigned long long)transitions,
+           (unsigned long long)protection_entries);
+    printf("cvl range        %.3f .. %.3f V\n", (double)cvl_min, (double)cvl_max);
+    for (size_t i = 0; i < sizeof(state_seconds) / sizeof(state_seconds[0]); ++i) {
+        printf("  %-14s %8.2f h\n", s_state_names[i], state_seconds[i] / 3600.0);
+    }
+    printf("reusable samples %.1f%% (incremental path would skip cvl_compute_limits)\n",
+           (total_samples > 0U) ? 100.0 * (double)reusable / (double)total_samples : 0.0);
+    if (bench_evaluations > 0U) {
+        printf("evaluation       %.1f ns/eval (%llu replayed evaluations)\n",
+               (double)bench_ns / (double)bench_evaluations,
+               (unsigned long long)bench_evaluations);
+    }
+    return 0;
+}
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""Generate the table-driven Victron encoder program.
+
+Reads ``docs/UART_CAN_mapping.json`` and emits
+``main/can_publisher/conversion_program_generated.h``: a packed list of field
+operations (source, offset, scale, bit position, clamp) executed by
+``encode_program_frame()`` in ``conversion_table.c``.
+
+A PGN is compiled into the program when every one of its mapping rows is a
+``Direct`` field whose TinyBMS value is bound in ``SOURCE_BINDINGS`` below.
+Computed PGNs (CVL/CCL/DCL, alarms, strings, energy) stay hand-written.
+Adding a linear PGN is therefore a mapping change plus, for a new TinyBMS
+value, one binding line.
+
+The header is committed. The build runs ``--check``, which exits non-zero
+when the header is stale, and never rewrites it; run this script by hand
+after editing the mapping.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import re
+import sys
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+DEFAULT_MAPPING = REPO_ROOT / "docs" / "UART_CAN_mapping.json"
+DEFAULT_OUTPUT = REPO_ROOT / "main" / "can_publisher" / "conversion_program_generated.h"
+
+FIELDS_COLUMN = "Victron_Champs_principaux_(Bytes,_Scale,_Unit,_Offset)"
+
+
+@dataclass(frozen=True)
+class Binding:
+    """Where a mapped TinyBMS value lives in uart_bms_live_data_t."""
+
+    source: str                 # F32, U16 or REG_U32
+    target: str                 # struct field name or register address
+    unit_factor: float = 1.0    # one source LSB expressed in the mapping unit
+    encoding: Optional[str] = None  # force "u16"/"i16" instead of the mapping's signedness
+
+
+# Keyed by (TinyBMS_Name, Victron field label).
+SOURCE_BINDINGS: Dict[Tuple[str, str], Binding] = {
+    ("State Of Charge", "SOC"): Binding("F32", "state_of_charge_pct"),
+    ("State Of Health", "SOH"): Binding("F32", "state_of_health_pct"),
+    # Register 46 counts 0.000001 %, as the mapping's "x0.0001 -> 0.01%" states
+    ("State Of Charge", "High res SOC"): Binding("REG_U32", "0x002EU", unit_factor=0.000001),
+    # Sent unsigned so packs above 327 V keep encoding
+    ("Battery Pack Voltage", "Voltage"): Binding("F32", "pack_voltage_v", encoding="u16"),
+    ("Battery Pack Current", "Current"): Binding("F32", "pack_current_a"),
+    ("Internal Temperature", "Temp"): Binding("F32", "mosfet_temperature_c"),
+    ("Min Cell Voltage", "Min cell V"): Binding("U16", "min_cell_mv"),
+    ("Max Cell Voltage", "Max cell V"): Binding("U16", "max_cell_mv"),
+    ("Min Pack Temperature", "Min temp"): Binding("F32", "pack_temperature_min_c"),
+    ("Max Pack Temperature", "Max temp"): Binding("F32", "pack_temperature_max_c"),
+}
+
+FIELD_RE = re.compile(
+    r"^Bytes?\s+(?P<first>\d+)(?:-(?P<last>\d+))?:\s*(?P<label>[^(]+?)\s*\((?P<attrs>[^)]*)\)\s*$"
+)
+SCALE_RE = re.compile(r"scale=(?P<value>[0-9.]+)\s*(?P<unit>[^,\s]*)\s*(?P<signed>signed)?")
+OFFSET_RE = re.compile(r"offset=(?P<value>[-+0-9.]+)")
+CONVERSION_OFFSET_RE = re.compile(r"^\s*(?P<value>[-+][0-9.]+)\s*→")
+INTERVAL_RE = re.compile(r"^\s*(?P<value>[0-9.]+)\s*(?P<unit>ms|s)\s*$")
+
+
+@dataclass
+class Operation:
+    label: str
+    binding: Binding
+    bit_offset: int
+    bit_width: int
+    offset: float
+    scale: float
+    minimum: int
+    maximum: int
+
+
+@dataclass
+class Frame:
+    can_id: int
+    description: str
+    period_ms: int
+    operations: List[Operation]
+
+
+class MappingError(ValueError):
+    pass
+
+
+def parse_operation(record: Dict[str, Optional[str]]) -> Optional[Operation]:
+    text = record.get(FIELDS_COLUMN) or ""
+    match = FIELD_RE.match(text.strip())
+    if match is None:
+        return None
+    label = match.group("label").strip()
+    binding = SOURCE_BINDINGS.get((record.get("TinyBMS_Name") or "", label))
+    if binding is None or record.get("Mapping_Type") != "Direct":
+        return None
+
+    attrs = match.group("attrs")
+    if "big-endian" in attrs:
+        raise MappingError(f"{label}: big-endian fields are not supported by the interpreter")
+    scale_match = SCALE_RE.search(attrs)
+    if scale_match is None:
+        raise MappingError(f"{label}: no scale in '{attrs}'")
+
+    first = int(match.group("first"))
+    last = int(match.group("last") or first)
+    width = (last - first + 1) * 8
+    if width > 32 or last > 7:
+        raise MappingError(f"{label}: unsupported byte range {first}-{last}")
+
+    can_scale = float(scale_match.group("value"))
+    unit = scale_match.group("unit")
+    signed = scale_match.group("signed") is not None
+    if binding.encoding is not None:
+        signed = binding.encoding.startswith("i")
+
+    offset = 0.0
+    offset_match = OFFSET_RE.search(attrs)
+    if offset_match is not None:
+        offset = float(offset_match.group("value"))
+    conversion = CONVERSION_OFFSET_RE.match(record.get("Scale_Tiny_To_CAN") or "")
+    if conversion is not None:
+        offset += float(conversion.group("value"))
+
+    if signed:
+        minimum, maximum = -(1 << (width - 1)), (1 << (width - 1)) - 1
+    else:
+        minimum, maximum = 0, (1 << width) - 1
+    if unit == "%":
+        maximum = min(maximum, int(round(100.0 / can_scale)))
+
+    return Operation(
+        label=label,
+        binding=binding,
+        bit_offset=first * 8,
+        bit_width=width,
+        offset=offset / binding.unit_factor,
+        scale=binding.unit_factor / can_scale,
+        minimum=minimum,
+        maximum=maximum,
+    )
+
+
+def parse_period_ms(text: Optional[str]) -> int:
+    match = INTERVAL_RE.match(text or "")
+    if match is None:
+        return 0
+    value = float(match.group("value"))
+    return int(value if match.group("unit") == "ms" else value * 1000.0)
+
+
+def build_frames(records: List[Dict[str, Optional[str]]]) -> List[Frame]:
+    grouped: Dict[int, List[Dict[str, Optional[str]]]] = {}
+    for record in records:
+        can_id = record.get("Victron_ID_0x3xx")
+        if can_id:
+            grouped.setdefault(int(can_id, 16), []).append(record)
+
+    frames: List[Frame] = []
+    for can_id in sorted(grouped):
+        rows = grouped[can_id]
+        operations = [parse_operation(row) for row in rows]
+        if not operations or any(op is None for op in operations):
+            continue
+        frames.append(
+            Frame(
+                can_id=can_id,
+                description="/".join(op.label for op in operations if op is not None),
+                period_ms=parse_period_ms(rows[0].get("Victron_Intervalle_typique")),
+                operations=[op for op in operations if op is not None],
+            )
+        )
+    return frames
+
+
+def c_float(value: float) -> str:
+    text = format(float(value), ".9g")
+    if "e" not in text and "." not in text:
+        text += ".0"
+    return text + "f"
+
+
+def render(frames: List[Frame], mapping_path: Path) -> str:
+    try:
+        source_name = mapping_path.resolve().relative_to(REPO_ROOT).as_posix()
+    except ValueError:
+        source_name = mapping_path.name
+    lines = [
+        "// Generated by tools/gen_can_program.py from " + source_name + ". Do not edit.",
+        "#pragma once",
+        "",
+        "#include <assert.h>",
+        "#include <stddef.h>",
+        "",
+        '#include "conversion_program.h"',
+        '#include "uart_bms.h"',
+        "",
+    ]
+
+    fields = sorted(
+        {(op.binding.source, op.binding.target) for frame in frames for op in frame.operations if op.binding.source != "REG_U32"}
+    )
+    for source, target in fields:
+        size = 4 if source == "F32" else 2
+        lines.append(
+            f"static_assert(sizeof(((uart_bms_live_data_t *)0)->{target}) == {size}U, "
+            f'"{target} type changed, regenerate the CAN program");'
+        )
+    lines.append("")
+
+    lines.append(f"#define CAN_PROGRAM_FRAME_COUNT {len(frames)}U")
+    lines.append("")
+    lines.append("static const can_program_op_t s_can_program_ops[] = {")
+    for frame in frames:
+        lines.append(f"    // 0x{frame.can_id:03X} {frame.description}")
+        for op in frame.operations:
+            if op.binding.source == "REG_U32":
+                source_offset = op.binding.target
+            else:
+                source_offset = f"(uint16_t)offsetof(uart_bms_live_data_t, {op.binding.target})"
+            lines.append(
+                f"    {{.source_offset = {source_offset}, .source = CAN_PROGRAM_SOURCE_{op.binding.source}, "
+                f".bit_offset = {op.bit_offset}U, .bit_width = {op.bit_width}U, "
+                f".offset = {c_float(op.offset)}, .scale = {c_float(op.scale)}, "
+                f".min = {op.minimum}, .max = {op.maximum}}}, // {op.label}"
+            )
+    lines.append("};")
+    lines.append("")
+
+    lines.append("static const can_program_frame_t s_can_program_frames[CAN_PROGRAM_FRAME_COUNT] = {")
+    index = 0
+    for frame in frames:
+        lines.append(
+            f"    {{.can_id = 0x{frame.can_id:03X}U, .first_op = {index}U, .op_count = {len(frame.operations)}U}},"
+        )
+        index += len(frame.operations)
+    lines.append("};")
+    lines.append("")
+
+    lines.append("// Channel registry rows, expanded in conversion_table.c")
+    lines.append("#define CAN_PROGRAM_CHANNELS(fill) \\")
+    for position, frame in enumerate(frames):
+        description = "Victron " + frame.description.replace('"', "'")
+        continuation = " \\" if position + 1 < len(frames) else ""
+        lines.append(
+            f"    {{.pgn = 0x{frame.can_id:03X}U, .can_id = 0x{frame.can_id:03X}U, .dlc = 8, .fill_fn = (fill), "
+            f'.description = "{description}", .period_ms = {frame.period_ms}U, '
+            f".inputs = CAN_PUBLISHER_INPUT_LIVE}},{continuation}"
+        )
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--mapping", type=Path, default=DEFAULT_MAPPING)
+    parser.add_argument("--output", type=Path, default=DEFAULT_OUTPUT)
+    parser.add_argument("--check", action="store_true", help="fail if the output is out of date")
+    args = parser.parse_args(argv)
+
+    records = json.loads(args.mapping.read_text(encoding="utf-8"))
+    if not isinstance(records, list):
+        print(f"{args.mapping}: expected a list of mapping records", file=sys.stderr)
+        return 1
+    try:
+        frames = build_frames(records)
+    except MappingError as exc:
+        print(f"{args.mapping}: {exc}", file=sys.stderr)
+        return 1
+
+    content = render(frames, args.mapping)
+    current = args.output.read_text(encoding="utf-8") if args.output.exists() else None
+    if args.check:
+        if current != content:
+            print(f"{args.output} is out of date, run tools/gen_can_program.py", file=sys.stderr)
+            return 1
+        return 0
+    if current != content:
+        args.output.write_text(content, encoding="utf-8")
+    pgns = ", ".join(f"0x{frame.can_id:03X}" for frame in frames)
+    print(f"{args.output.name}: {len(frames)} PGNs ({pgns})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
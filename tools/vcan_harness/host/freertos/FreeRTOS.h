@@ -0,0 +1,8 @@
+// Host stand-in for FreeRTOS.h (tools/vcan_harness only): types used by event_bus.h
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
@@ -0,0 +1,4 @@
+// Host stand-in for the generated sdkconfig.h (tools/vcan_harness only)
+#pragma once
+
+#define CONFIG_TINYBMS_CAN_DRIVER_SOCKETCAN 1
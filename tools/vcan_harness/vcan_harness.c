@@ -0,0 +1,380 @@
+/*
+ * vcan_harness - host harness for main/can_victron/can_victron_driver_socketcan.c
+ *
+ * The firmware itself does not build for the IDF linux target (http_server,
+ * wifi, spiffs and the UART driver have no linux port), so the SocketCAN
+ * backend is exercised here on its own, against a vcan interface. The harness
+ * plays the gateway side of the bus with the same backend calls can_victron.c
+ * makes (start, transmit, wait_rx, receive, get_status):
+ *   - publishes a Victron frame set at --rate-hz and answers 0x305 requests,
+ *   - counts bus-off / recovery / overrun events and the backend counters,
+ *   - prints one status line per second and a summary at exit.
+ * tools/vcan_loadtest.sh plays the GX side and the fault scenarios.
+ *
+ * --selftest checks the backend against a peer socket on the same interface
+ * (TX, filtered RX, RTR, interface down/up) and exits non-zero on failure.
+ *
+ * Build and run from the repository root:
+ *   cc -O2 -std=gnu11 -Wall -Itools/vcan_harness/host -Imain/can_victron \
+ *      -Imain/event_bus -Imain/include tools/vcan_harness/vcan_harness.c \
+ *      main/can_victron/can_victron_driver_socketcan.c -o vcan_harness
+ *   sudo tools/vcan_loadtest.sh setup
+ *   ./vcan_harness --selftest
+ *   ./vcan_harness --duration 60 --rate-hz 200 & tools/vcan_loadtest.sh saturate
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+#include "can_victron_driver.h"
+
+#define HARNESS_KEEPALIVE_ID    0x305U
+#define HARNESS_HANDSHAKE_ID    0x307U
+#define HARNESS_TX_TIMEOUT_MS   10U
+#define HARNESS_KEEPALIVE_LOSS_MS 3000U
+
+// Victron frames the publisher sends every cycle (content is irrelevant here)
+static const uint32_t s_frame_ids[] = {0x351U, 0x355U, 0x356U, 0x35AU, 0x35EU, 0x35FU, 0x372U, 0x373U};
+
+typedef struct {
+    uint64_t tx_ok;
+    uint64_t tx_failed;
+    uint64_t rx_frames;
+    uint64_t keepalive_requests;
+    uint64_t handshakes;
+    uint32_t bus_off_events;
+    uint32_t recovered_events;
+    uint32_t overrun_events;
+    uint64_t last_keepalive_ms;
+    bool keepalive_ok;
+} harness_stats_t;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    default:
+        return "ESP_FAIL";
+    }
+}
+
+static uint64_t harness_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static can_victron_driver_config_t harness_config(const char *iface)
+{
+    // Same filter as can_victron.c: 0x305 and 0x307 only
+    can_victron_driver_config_t config = {
+        .interface = iface,
+        .bitrate_bps = 500000U,
+        .tx_queue_len = 32U,
+        .rx_queue_len = 32U,
+        .rx_filter_id = HARNESS_KEEPALIVE_ID,
+        .rx_filter_mask = 0x7FFU & ~(uint32_t)(HARNESS_KEEPALIVE_ID ^ HARNESS_HANDSHAKE_ID),
+    };
+    return config;
+}
+
+static void harness_handle_events(const can_victron_driver_t *driver, uint32_t events, harness_stats_t *stats)
+{
+    if ((events & CAN_VICTRON_DRIVER_EVENT_BUS_OFF) != 0U) {
+        stats->bus_off_events++;
+    }
+    if ((events & CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED) != 0U) {
+        stats->recovered_events++;
+    }
+    if ((events & CAN_VICTRON_DRIVER_EVENT_RX_OVERRUN) != 0U) {
+        stats->overrun_events++;
+    }
+    if ((events & CAN_VICTRON_DRIVER_EVENT_RX) == 0U) {
+        return;
+    }
+
+    can_victron_driver_frame_t frame;
+    while (driver->receive(&frame) == ESP_OK) {
+        stats->rx_frames++;
+        if (frame.extended) {
+            continue;
+        }
+        if (frame.identifier == HARNESS_KEEPALIVE_ID) {
+            stats->keepalive_requests++;
+            stats->last_keepalive_ms = harness_now_ms();
+            stats->keepalive_ok = true;
+            if (frame.rtr) {
+                can_victron_driver_frame_t reply = {.identifier = HARNESS_KEEPALIVE_ID, .dlc = 1U};
+                if (driver->transmit(&reply, HARNESS_TX_TIMEOUT_MS) == ESP_OK) {
+                    stats->tx_ok++;
+                } else {
+                    stats->tx_failed++;
+                }
+            }
+        } else if (frame.identifier == HARNESS_HANDSHAKE_ID) {
+            stats->handshakes++;
+        }
+    }
+}
+
+static void harness_print_status(const can_victron_driver_t *driver, uint64_t elapsed_ms, const harness_stats_t *stats)
+{
+    can_victron_driver_status_t status = {0};
+    (void)driver->get_status(&status);
+    printf("t=%5.1fs tx_ok=%llu tx_failed=%llu rx=%llu keepalive_ok=%d bus_off=%u recovered=%u "
+           "overruns=%u rx_missed=%u state=%d\n",
+           (double)elapsed_ms / 1000.0,
+           (unsigned long long)stats->tx_ok,
+           (unsigned long long)stats->tx_failed,
+           (unsigned long long)stats->rx_frames,
+           stats->keepalive_ok ? 1 : 0,
+           (unsigned)stats->bus_off_events,
+           (unsigned)stats->recovered_events,
+           (unsigned)stats->overrun_events,
+           (unsigned)status.rx_missed_count,
+           (int)status.state);
+    fflush(stdout);
+}
+
+static int harness_run(const char *iface, uint32_t duration_s, uint32_t rate_hz)
+{
+    const can_victron_driver_t *driver = can_victron_driver_default();
+    can_victron_driver_config_t config = harness_config(iface);
+    esp_err_t err = driver->start(&config);
+    if (err != ESP_OK) {
+        fprintf(stderr, "start(%s) failed: %s\n", iface, esp_err_to_name(err));
+        return 1;
+    }
+
+    harness_stats_t stats = {0};
+    uint64_t start_ms = harness_now_ms();
+    uint64_t next_tx_ms = start_ms;
+    uint64_t next_report_ms = start_ms + 1000U;
+    uint64_t end_ms = start_ms + (uint64_t)duration_s * 1000U;
+    uint32_t period_ms = (rate_hz > 0U) ? (1000U / rate_hz) : 0U;
+    size_t next_frame = 0;
+
+    for (uint64_t now = start_ms; now < end_ms; now = harness_now_ms()) {
+        if (now >= next_tx_ms) {
+            can_victron_driver_frame_t frame = {
+                .identifier = s_frame_ids[next_frame],
+                .dlc = 8U,
+            };
+            memcpy(frame.data, &now, sizeof(now));
+            next_frame = (next_frame + 1U) % (sizeof(s_frame_ids) / sizeof(s_frame_ids[0]));
+            if (driver->transmit(&frame, HARNESS_TX_TIMEOUT_MS) == ESP_OK) {
+                stats.tx_ok++;
+            } else {
+                stats.tx_failed++;
+            }
+            next_tx_ms += period_ms;
+            if (next_tx_ms < now) {
+                next_tx_ms = now;  // Fell behind (bus saturated): do not burst
+            }
+        }
+
+        uint64_t wake_ms = (next_tx_ms < next_report_ms) ? next_tx_ms : next_report_ms;
+        uint32_t wait_ms = (wake_ms > now) ? (uint32_t)(wake_ms - now) : 0U;
+        uint32_t events = 0;
+        err = driver->wait_rx(wait_ms, &events);
+        if (err == ESP_OK) {
+            harness_handle_events(driver, events, &stats);
+        }
+
+        now = harness_now_ms();
+        if (stats.keepalive_ok && now - stats.last_keepalive_ms > HARNESS_KEEPALIVE_LOSS_MS) {
+            stats.keepalive_ok = false;
+        }
+        if (now >= next_report_ms) {
+            harness_print_status(driver, now - start_ms, &stats);
+            next_report_ms += 1000U;
+        }
+    }
+
+    harness_print_status(driver, harness_now_ms() - start_ms, &stats);
+    printf("summary: keepalive_requests=%llu handshakes=%llu bus_off=%u recovered=%u overruns=%u\n",
+           (unsigned long long)stats.keepalive_requests,
+           (unsigned long long)stats.handshakes,
+           (unsigned)stats.bus_off_events,
+           (unsigned)stats.recovered_events,
+           (unsigned)stats.overrun_events);
+    driver->stop();
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Self test
+// ---------------------------------------------------------------------------
+
+static int s_failures = 0;
+
+#define HARNESS_CHECK(cond)                                                   \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            ++s_failures;                                                     \
+        }                                                                     \
+    } while (0)
+
+static int harness_peer_open(const char *iface)
+{
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        return -1;
+    }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, iface, sizeof(ifr.ifr_name) - 1U);
+    struct sockaddr_can addr = {.can_family = AF_CAN};
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        close(fd);
+        return -1;
+    }
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool harness_peer_read(int fd, struct can_frame *cf, int timeout_ms)
+{
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    return poll(&pfd, 1, timeout_ms) > 0 && read(fd, cf, sizeof(*cf)) == (ssize_t)sizeof(*cf);
+}
+
+static bool harness_driver_read(const can_victron_driver_t *driver, can_victron_driver_frame_t *frame)
+{
+    uint32_t events = 0;
+    return driver->wait_rx(200U, &events) == ESP_OK && (events & CAN_VICTRON_DRIVER_EVENT_RX) != 0U &&
+           driver->receive(frame) == ESP_OK;
+}
+
+static bool harness_set_link(const char *iface, bool up)
+{
+    char command[64];
+    snprintf(command, sizeof(command), "ip link set %s %s", up ? "up" : "down", iface);
+    return system(command) == 0;
+}
+
+static int harness_selftest(const char *iface)
+{
+    const can_victron_driver_t *driver = can_victron_driver_default();
+    can_victron_driver_config_t config = harness_config(iface);
+    esp_err_t err = driver->start(&config);
+    if (err != ESP_OK) {
+        fprintf(stderr, "start(%s) failed: %s (run tools/vcan_loadtest.sh setup)\n", iface, esp_err_to_name(err));
+        return 1;
+    }
+    int peer = harness_peer_open(iface);
+    if (peer < 0) {
+        fprintf(stderr, "peer socket on %s failed: %s\n", iface, strerror(errno));
+        driver->stop();
+        return 1;
+    }
+
+    // Transmit reaches the bus unchanged
+    can_victron_driver_frame_t out = {.identifier = 0x351U, .dlc = 8U, .data = {1, 2, 3, 4, 5, 6, 7, 8}};
+    HARNESS_CHECK(driver->transmit(&out, HARNESS_TX_TIMEOUT_MS) == ESP_OK);
+    struct can_frame cf;
+    HARNESS_CHECK(harness_peer_read(peer, &cf, 200));
+    HARNESS_CHECK(cf.can_id == 0x351U && cf.can_dlc == 8U && memcmp(cf.data, out.data, 8U) == 0);
+
+    // The filter drops foreign IDs and keeps 0x305 (RTR) and 0x307
+    struct can_frame foreign = {.can_id = 0x123U, .can_dlc = 1U};
+    struct can_frame request = {.can_id = HARNESS_KEEPALIVE_ID | CAN_RTR_FLAG};
+    struct can_frame handshake = {.can_id = HARNESS_HANDSHAKE_ID, .can_dlc = 8U, .data = {0, 0, 0, 0, 'V', 'I', 'C', 0}};
+    HARNESS_CHECK(write(peer, &foreign, sizeof(foreign)) == (ssize_t)sizeof(foreign));
+    HARNESS_CHECK(write(peer, &request, sizeof(request)) == (ssize_t)sizeof(request));
+    HARNESS_CHECK(write(peer, &handshake, sizeof(handshake)) == (ssize_t)sizeof(handshake));
+
+    can_victron_driver_frame_t in;
+    HARNESS_CHECK(harness_driver_read(driver, &in));
+    HARNESS_CHECK(in.identifier == HARNESS_KEEPALIVE_ID && in.rtr && !in.extended);
+    HARNESS_CHECK(harness_driver_read(driver, &in));
+    HARNESS_CHECK(in.identifier == HARNESS_HANDSHAKE_ID && in.dlc == 8U && in.data[4] == 'V');
+    HARNESS_CHECK(driver->receive(&in) == ESP_ERR_TIMEOUT);
+
+    // Interface down is reported as bus-off, and recovery on the next frame
+    if (harness_set_link(iface, false)) {
+        err = driver->transmit(&out, HARNESS_TX_TIMEOUT_MS);
+        HARNESS_CHECK(err != ESP_OK);
+        uint32_t events = 0;
+        HARNESS_CHECK(driver->wait_rx(100U, &events) == ESP_OK);
+        HARNESS_CHECK((events & CAN_VICTRON_DRIVER_EVENT_BUS_OFF) != 0U);
+        can_victron_driver_status_t status = {0};
+        HARNESS_CHECK(driver->get_status(&status) == ESP_OK && status.state == TWAI_STATE_BUS_OFF);
+
+        HARNESS_CHECK(harness_set_link(iface, true));
+        HARNESS_CHECK(driver->transmit(&out, HARNESS_TX_TIMEOUT_MS) == ESP_OK);
+        events = 0;
+        HARNESS_CHECK(driver->wait_rx(100U, &events) == ESP_OK);
+        HARNESS_CHECK((events & CAN_VICTRON_DRIVER_EVENT_BUS_RECOVERED) != 0U);
+    } else {
+        fprintf(stderr, "skipped bus-off check: ip link needs root\n");
+    }
+
+    close(peer);
+    driver->stop();
+    printf("selftest on %s: %s\n", iface, (s_failures == 0) ? "ok" : "FAILED");
+    return (s_failures == 0) ? 0 : 1;
+}
+
+static void harness_usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [--iface vcan0] [--duration 60] [--rate-hz 100] [--selftest]\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *iface = "vcan0";
+    uint32_t duration_s = 60U;
+    uint32_t rate_hz = 100U;
+    bool selftest = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--iface") == 0 && i + 1 < argc) {
+            iface = argv[++i];
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            duration_s = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rate-hz") == 0 && i + 1 < argc) {
+            rate_hz = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--selftest") == 0) {
+            selftest = true;
+        } else {
+            harness_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // TINYBMS_CAN_IFACE still overrides inside the backend, as on the target
+    return selftest ? harness_selftest(iface) : harness_run(iface, duration_s, rate_hz);
+}
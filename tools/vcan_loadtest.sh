@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+if [[ "${1:-}" == "-h" || "${1:-}" == "--help" || $# -eq 0 ]]; then
+    cat <<'USAGE'
+Usage: vcan_loadtest.sh <scenario> [interface] [duration_s]
+
+Drives a virtual CAN bus for tools/vcan_harness, which runs the SocketCAN
+backend of the Victron CAN driver on the host. The firmware as a whole does
+not build for the IDF linux target, so the harness stands in for the gateway
+side (interface selected by --iface or TINYBMS_CAN_IFACE).
+
+Scenarios:
+  setup       Create and bring up the vcan interface (needs root)
+  keepalive   Answer as a GX device: 0x305 RTR every second, 0x307 handshake
+  loss        Send keepalives for half the duration, then go silent
+  saturate    Flood the bus with random standard frames (cangen -g 0)
+  busoff      Take the interface down for 5 s, then bring it back up
+
+Arguments:
+  interface   vcan interface (default: vcan0)
+  duration_s  Scenario length in seconds (default: 60)
+
+Watch the gateway side in the harness output, one line per second
+(tx_failed, keepalive_ok, bus_off, recovered, rx_missed), or with candump.
+Run the harness self test first: ./vcan_harness --selftest (root for the
+bus-off check).
+USAGE
+    exit 0
+fi
+
+SCENARIO="$1"
+INTERFACE="${2:-vcan0}"
+DURATION="${3:-60}"
+
+require() {
+    if ! command -v "$1" >/dev/null 2>&1; then
+        echo "Error: $1 is not installed or not in PATH" >&2
+        exit 1
+    fi
+}
+
+send_keepalives() {
+    local seconds="$1"
+    cansend "${INTERFACE}" "307#0000000056494300"
+    for ((i = 0; i < seconds; i++)); do
+        cansend "${INTERFACE}" "305#R"
+        sleep 1
+    done
+}
+
+case "${SCENARIO}" in
+    setup)
+        modprobe vcan
+        if ! ip link show "${INTERFACE}" >/dev/null 2>&1; then
+            ip link add dev "${INTERFACE}" type vcan
+        fi
+        ip link set up "${INTERFACE}"
+        echo "${INTERFACE} ready" >&2
+        ;;
+    keepalive)
+        require cansend
+        send_keepalives "${DURATION}"
+        ;;
+    loss)
+        require cansend
+        send_keepalives "$((DURATION / 2))"
+        echo "Keepalives stopped, waiting $((DURATION - DURATION / 2)) s" >&2
+        sleep "$((DURATION - DURATION / 2))"
+        ;;
+    saturate)
+        require cangen
+        echo "Flooding ${INTERFACE} for ${DURATION} s" >&2
+        timeout "${DURATION}" cangen "${INTERFACE}" -g 0 -I r -L 8 -D r -i || true
+        ;;
+    busoff)
+        ip link set down "${INTERFACE}"
+        echo "${INTERFACE} down" >&2
+        sleep 5
+        ip link set up "${INTERFACE}"
+        echo "${INTERFACE} up" >&2
+        ;;
+    *)
+        echo "Unknown scenario: ${SCENARIO}" >&2
+        exit 1
+        ;;
+esac
@@ -0,0 +1,110 @@
+"""Compare static asset delivery from flash (rodata) and from SPIFFS.
+
+With ``CONFIG_TINYBMS_WEB_EMBED_ASSETS`` the gateway serves ``web/`` from a
+table compiled into the firmware and tags each response with
+``X-Asset-Source: flash``.  Sending ``X-Asset-Source: spiffs`` in the request
+forces the SPIFFS path for the same URI, so both paths can be measured
+against the same device and the same files.
+
+For each asset the script issues ``--repeat`` sequential GET requests per
+source on a fresh connection each time (as a browser cold load would) and
+reports the median time to first byte and the throughput of the body::
+
+    python tools/web_asset_bench.py --host 192.168.4.1
+    python tools/web_asset_bench.py --host 192.168.4.1 --path /index.html --repeat 20
+
+Assets default to the ones listed in ``etags.txt`` on the device.  Requests
+advertise ``Accept-Encoding: gzip`` so both paths send the variant the
+browser would receive.
+"""
+
+from __future__ import annotations
+
+import argparse
+import http.client
+import statistics
+import sys
+import time
+from dataclasses import dataclass
+from typing import List, Optional
+
+
+@dataclass
+class Sample:
+    ttfb_ms: float
+    total_ms: float
+    size: int
+    source: str
+
+
+def fetch(host: str, port: int, path: str, source: Optional[str], timeout: float) -> Sample:
+    headers = {"Accept-Encoding": "gzip", "Connection": "close"}
+    if source == "spiffs":
+        headers["X-Asset-Source"] = "spiffs"
+
+    connection = http.client.HTTPConnection(host, port, timeout=timeout)
+    try:
+        start = time.perf_counter()
+        connection.request("GET", path, headers=headers)
+        response = connection.getresponse()
+        first = response.read(1)
+        ttfb = time.perf_counter() - start
+        body = first + response.read()
+        total = time.perf_counter() - start
+        if response.status != 200:
+            raise RuntimeError(f"{path}: HTTP {response.status}")
+        return Sample(ttfb * 1000.0, total * 1000.0, len(body),
+                      response.getheader("X-Asset-Source", "unknown"))
+    finally:
+        connection.close()
+
+
+def list_assets(host: str, port: int, timeout: float) -> List[str]:
+    connection = http.client.HTTPConnection(host, port, timeout=timeout)
+    try:
+        connection.request("GET", "/etags.txt")
+        response = connection.getresponse()
+        text = response.read().decode("utf-8", errors="replace")
+        if response.status != 200:
+            raise RuntimeError(f"/etags.txt: HTTP {response.status}, pass --path explicitly")
+    finally:
+        connection.close()
+    return [line.split()[0] for line in text.splitlines() if line.startswith("/")]
+
+
+def measure(host: str, port: int, path: str, source: Optional[str], repeat: int, timeout: float):
+    samples = [fetch(host, port, path, source, timeout) for _ in range(repeat)]
+    ttfb = statistics.median(sample.ttfb_ms for sample in samples)
+    total = statistics.median(sample.total_ms for sample in samples)
+    size = samples[-1].size
+    rate = size / 1024.0 / (total / 1000.0) if total > 0 else 0.0
+    return samples[-1].source, size, ttfb, rate
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--path", action="append", help="asset to measure (repeatable)")
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--timeout", type=float, default=10.0)
+    args = parser.parse_args()
+
+    paths = args.path or list_assets(args.host, args.port, args.timeout)
+    print(f"{'asset':32} {'bytes':>8}  {'flash ttfb':>10} {'KiB/s':>8}  {'spiffs ttfb':>11} {'KiB/s':>8}")
+
+    for path in paths:
+        flash_source, size, flash_ttfb, flash_rate = measure(
+            args.host, args.port, path, None, args.repeat, args.timeout)
+        spiffs_source, _, spiffs_ttfb, spiffs_rate = measure(
+            args.host, args.port, path, "spiffs", args.repeat, args.timeout)
+        note = "" if flash_source == "flash" else f"  (served from {flash_source})"
+        print(f"{path:32} {size:8d}  {flash_ttfb:8.1f}ms {flash_rate:8.1f}  "
+              f"{spiffs_ttfb:9.1f}ms {spiffs_rate:8.1f}{note}")
+        if spiffs_source != "spiffs":
+            print(f"warning: {path} did not honour X-Asset-Source: spiffs", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
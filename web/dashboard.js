@@ -2031,6 +2031,18 @@ function handleUartMessage(data) {
 }
 
 function handleCanMessage(data) {
+    if (data && data.type === 'can_batch' && Array.isArray(data.frames)) {
+        data.frames.forEach((frame) => {
+            handleCanMessage({
+                type: 'can_raw',
+                direction: data.direction,
+                timestamp_ms: data.timestamp_ms,
+                ...frame,
+            });
+        });
+        return;
+    }
+
     state.canRealtime.frames.raw.push(data);
     if (state.canRealtime.frames.raw.length > MAX_STORED_FRAMES) {
         state.canRealtime.frames.raw.shift();